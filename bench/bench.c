@@ -0,0 +1,224 @@
+/**
+ * @file bench.c
+ * @brief 基準測試共用模組實作
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 clock_gettime） */
+
+#include "bench.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** 預設重複次數 */
+#define BENCH_DEFAULT_REPEAT 3
+
+/** 建置設定（依編譯器是否最佳化判斷） */
+#ifdef __OPTIMIZE__
+#define BENCH_PROFILE "release"
+#else
+#define BENCH_PROFILE "debug"
+#endif
+
+/* ============================================================================
+ * 內部狀態
+ * ============================================================================ */
+
+static const char *g_suite = "bench";
+static bool g_quick = false;
+static unsigned g_repeat = BENCH_DEFAULT_REPEAT;
+static const char *g_filter = NULL;
+static int g_argc = 0;
+static char **g_argv = NULL;
+
+/* ============================================================================
+ * 初始化與選項實作
+ * ============================================================================ */
+
+/**
+ * @brief 印出使用說明
+ */
+static void print_usage(const char *usage) {
+    fprintf(stderr, "用法: bench_%s [選項]\n", g_suite);
+    fprintf(stderr, "  --quick         縮小規模（快速檢查）\n");
+    fprintf(stderr, "  --repeat N      每個量測重複 N 次並回報最短的一次（預設 %d）\n",
+            BENCH_DEFAULT_REPEAT);
+    fprintf(stderr, "  --filter TEXT   只執行名稱包含 TEXT 的量測\n");
+    if (usage != NULL) {
+        fputs(usage, stderr);
+    }
+    fprintf(stderr, "結果以 JSON Lines 輸出到 stdout，摘要輸出到 stderr\n");
+}
+
+/**
+ * @brief 解析共用選項並設定測試組名稱
+ */
+void bench_init(int argc, char **argv, const char *suite, const char *usage) {
+    g_suite = suite;
+    g_argc = argc;
+    g_argv = argv;
+    
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--quick") == 0) {
+            g_quick = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(usage);
+            exit(0);
+        } else if (strncmp(arg, "--", 2) == 0 && i + 1 < argc) {
+            if (strcmp(arg, "--repeat") == 0) {
+                int repeat = atoi(argv[i + 1]);
+                g_repeat = (repeat > 0) ? (unsigned)repeat : 1;
+            } else if (strcmp(arg, "--filter") == 0) {
+                g_filter = argv[i + 1];
+            }
+            i++;
+        } else {
+            fprintf(stderr, "錯誤: 無法辨識的參數 %s\n", arg);
+            print_usage(usage);
+            exit(2);
+        }
+    }
+}
+
+/**
+ * @brief 是否以縮小規模執行
+ */
+bool bench_quick(void) {
+    return g_quick;
+}
+
+/**
+ * @brief 每個量測重複的次數
+ */
+unsigned bench_repeat(void) {
+    return g_repeat;
+}
+
+/**
+ * @brief 量測名稱是否符合 --filter
+ */
+bool bench_selected(const char *name) {
+    return g_filter == NULL || strstr(name, g_filter) != NULL;
+}
+
+/**
+ * @brief 取得測試組專屬選項的值
+ */
+const char *bench_option(const char *name) {
+    for (int i = 1; i + 1 < g_argc; i++) {
+        const char *arg = g_argv[i];
+        if (strncmp(arg, "--", 2) == 0 && strcmp(arg + 2, name) == 0) {
+            return g_argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 解析數量字串
+ */
+bool bench_parse_size(const char *text, size_t *out) {
+    if (text == NULL || text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    
+    char *end = NULL;
+    unsigned long long value = strtoull(text, &end, 10);
+    unsigned shift = 0;
+    switch (*end) {
+        case 'K': case 'k': shift = 10; end++; break;
+        case 'M': case 'm': shift = 20; end++; break;
+        case 'G': case 'g': shift = 30; end++; break;
+        default: break;
+    }
+    if (*end != '\0' || value > (SIZE_MAX >> shift)) {
+        return false;
+    }
+    *out = (size_t)(value << shift);
+    return true;
+}
+
+/**
+ * @brief 取得數量選項的值
+ */
+size_t bench_option_size(const char *name, size_t fallback) {
+    const char *text = bench_option(name);
+    if (text == NULL) {
+        return fallback;
+    }
+    
+    size_t value = 0;
+    if (!bench_parse_size(text, &value)) {
+        fprintf(stderr, "錯誤: --%s 的值無效: %s\n", name, text);
+        exit(2);
+    }
+    return value;
+}
+
+/* ============================================================================
+ * 量測與輸出實作
+ * ============================================================================ */
+
+/**
+ * @brief 目前的單調時鐘時間（奈秒）
+ */
+uint64_t bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 輸出一筆量測結果
+ */
+void bench_report(const char *name, uint64_t ops, uint64_t bytes, uint64_t ns) {
+    double seconds = (double)ns / 1e9;
+    double ops_rate = (seconds > 0) ? (double)ops / seconds : 0;
+    double byte_rate = (seconds > 0) ? (double)bytes / seconds : 0;
+    
+    /* 名稱由各測試程式產生，只含英數字與 _/.，不需跳脫 */
+    printf("{\"suite\":\"%s\",\"case\":\"%s\",\"ops\":%llu,\"bytes\":%llu,"
+           "\"seconds\":%.9f,\"ops_per_sec\":%.1f,\"bytes_per_sec\":%.1f,\"profile\":\"%s\"}\n",
+           g_suite, name, (unsigned long long)ops, (unsigned long long)bytes,
+           seconds, ops_rate, byte_rate, BENCH_PROFILE);
+    fflush(stdout);
+    
+    if (bytes > 0) {
+        fprintf(stderr, "%-10s %-32s %10.3f ms %14.0f ops/s %10.1f MiB/s\n",
+                g_suite, name, seconds * 1e3, ops_rate, byte_rate / (1024.0 * 1024.0));
+    } else {
+        fprintf(stderr, "%-10s %-32s %10.3f ms %14.0f ops/s\n",
+                g_suite, name, seconds * 1e3, ops_rate);
+    }
+}
+
+/**
+ * @brief 以最短的顯示形式格式化數量
+ */
+const char *bench_format_size(size_t value, char *buf, size_t size) {
+    if (value != 0 && value % (1u << 30) == 0) {
+        snprintf(buf, size, "%zuG", value >> 30);
+    } else if (value != 0 && value % (1u << 20) == 0) {
+        snprintf(buf, size, "%zuM", value >> 20);
+    } else if (value != 0 && value % (1u << 10) == 0) {
+        snprintf(buf, size, "%zuK", value >> 10);
+    } else {
+        snprintf(buf, size, "%zu", value);
+    }
+    return buf;
+}
+
+/**
+ * @brief 印出失敗原因並結束程式
+ */
+void bench_fail(const char *what) {
+    fprintf(stderr, "bench_%s: %s 失敗\n", g_suite, what);
+    error_print(stderr);
+    exit(1);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file bench.h
+ * @brief 基準測試共用模組標頭檔
+ *
+ * 每個 bench_*.c 為獨立程式，透過本模組取得：
+ * - 共用命令列選項：--quick（縮小規模）、--repeat N（取最佳值）、--filter 子字串
+ * - 量測結果的機器可讀輸出：每個量測一行 JSON（JSON Lines）輸出到 stdout，
+ *   同時在 stderr 顯示一行易讀摘要
+ *
+ * 輸出欄位：suite、case、ops、bytes、seconds、ops_per_sec、bytes_per_sec、profile。
+ * 追蹤回歸時以 suite + case 為鍵比較 ops_per_sec 或 bytes_per_sec。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * 初始化與選項
+ * ============================================================================ */
+
+/**
+ * @brief 解析共用選項並設定測試組名稱
+ *
+ * 無法辨識的 --name value 選項保留給 bench_option() 查詢；
+ * 收到 --help 時印出共用選項與 usage 後結束。
+ *
+ * @param argc  參數數量
+ * @param argv  參數陣列
+ * @param suite 測試組名稱（輸出的 suite 欄位）
+ * @param usage 測試組專屬選項說明（可為 NULL）
+ */
+void bench_init(int argc, char **argv, const char *suite, const char *usage);
+
+/**
+ * @brief 是否以縮小規模執行（--quick）
+ */
+bool bench_quick(void);
+
+/**
+ * @brief 每個量測重複的次數（--repeat，預設 3），回報最短的一次
+ */
+unsigned bench_repeat(void);
+
+/**
+ * @brief 量測名稱是否符合 --filter（未指定時全部符合）
+ */
+bool bench_selected(const char *name);
+
+/**
+ * @brief 取得測試組專屬選項 --name 的值
+ *
+ * @return 選項值，未指定回傳 NULL
+ */
+const char *bench_option(const char *name);
+
+/**
+ * @brief 取得數量選項 --name 的值（接受 K、M、G 後綴，以 1024 為單位）
+ *
+ * @param name     選項名稱（不含 --）
+ * @param fallback 未指定時的預設值
+ * @return 選項值；格式錯誤時印出錯誤並結束程式
+ */
+size_t bench_option_size(const char *name, size_t fallback);
+
+/**
+ * @brief 解析數量字串（如 "4096"、"10M"、"4G"）
+ *
+ * @return 成功回傳 true
+ */
+bool bench_parse_size(const char *text, size_t *out);
+
+/* ============================================================================
+ * 量測與輸出
+ * ============================================================================ */
+
+/**
+ * @brief 目前的單調時鐘時間（奈秒）
+ */
+uint64_t bench_now(void);
+
+/**
+ * @brief 輸出一筆量測結果
+ *
+ * @param name  量測名稱（輸出的 case 欄位，如 "create_flat/100K"）
+ * @param ops   完成的操作數
+ * @param bytes 處理的位元組數（不適用時為 0）
+ * @param ns    耗時（奈秒）
+ */
+void bench_report(const char *name, uint64_t ops, uint64_t bytes, uint64_t ns);
+
+/**
+ * @brief 以最短的顯示形式格式化數量（如 10M、4G、1536）
+ *
+ * @param value 數量
+ * @param buf   輸出緩衝區
+ * @param size  緩衝區大小
+ * @return buf
+ */
+const char *bench_format_size(size_t value, char *buf, size_t size);
+
+/**
+ * @brief 印出失敗原因（含目前的錯誤訊息）並結束程式
+ */
+void bench_fail(const char *what);
+
+#endif // BENCH_H
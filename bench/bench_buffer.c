@@ -0,0 +1,121 @@
+/**
+ * @file bench_buffer.c
+ * @brief 編輯器緩衝區基準測試
+ *
+ * 以產生的多行文字文件量測：
+ * - load/<size>：從記憶體載入並切分成行
+ * - random_line/<size>：以隨機行號取得行（行號索引樹）
+ * - sequential_line/<size>：依序以行號取得每一行（上次查詢位置的快取）
+ * - serialize/<size>：將整個緩衝區序列化回連續記憶體
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "bench.h"
+#include "workload.h"
+#include "buffer.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+
+/** 預設文件大小（--quick 時為八分之一） */
+#define DEFAULT_SIZE (64u * 1024u * 1024u)
+
+/** 隨機取行的次數 */
+#define RANDOM_LOOKUPS (1u << 20)
+
+static const char *const g_usage =
+    "  --size N        文件大小（預設 64M）\n"
+    "  --seed N        亂數種子（預設 1）\n";
+
+/** 防止編譯器略過查詢結果 */
+static volatile size_t g_sink;
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv, "buffer", g_usage);
+    size_t size = bench_option_size("size", bench_quick() ? DEFAULT_SIZE / 8 : DEFAULT_SIZE);
+    uint64_t seed = bench_option_size("seed", 1);
+    
+    char *text = workload_text(size, seed);
+    buffer_t *buf = buffer_create(NULL);
+    if (text == NULL || buf == NULL) {
+        bench_fail("初始化");
+    }
+    
+    char label[16];
+    char name[64];
+    bench_format_size(size, label, sizeof(label));
+    
+    /* 載入在每次重複時重做，最後一次的結果供後續量測使用 */
+    uint64_t best = UINT64_MAX;
+    for (unsigned r = 0; r < bench_repeat(); r++) {
+        uint64_t start = bench_now();
+        if (!buffer_load_from_memory(buf, text, size)) {
+            bench_fail("buffer_load_from_memory");
+        }
+        uint64_t elapsed = bench_now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+    size_t lines = buffer_get_line_count(buf);
+    snprintf(name, sizeof(name), "load/%s", label);
+    if (bench_selected(name)) {
+        bench_report(name, lines, size, best);
+    }
+    
+    snprintf(name, sizeof(name), "random_line/%s", label);
+    if (bench_selected(name)) {
+        best = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            workload_rng_t rng;
+            workload_rng_seed(&rng, seed + r);
+            size_t sum = 0;
+            uint64_t start = bench_now();
+            for (size_t i = 0; i < RANDOM_LOOKUPS; i++) {
+                line_t *line = buffer_get_line(buf, workload_rng_below(&rng, lines));
+                sum += line->length;
+            }
+            uint64_t elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+            g_sink = sum;
+        }
+        bench_report(name, RANDOM_LOOKUPS, 0, best);
+    }
+    
+    snprintf(name, sizeof(name), "sequential_line/%s", label);
+    if (bench_selected(name)) {
+        best = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            size_t sum = 0;
+            uint64_t start = bench_now();
+            for (size_t i = 0; i < lines; i++) {
+                sum += buffer_get_line(buf, i)->length;
+            }
+            uint64_t elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+            g_sink = sum;
+        }
+        bench_report(name, lines, 0, best);
+    }
+    
+    snprintf(name, sizeof(name), "serialize/%s", label);
+    if (bench_selected(name)) {
+        best = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            size_t out_size = 0;
+            uint64_t start = bench_now();
+            char *out = buffer_serialize_to_memory(buf, &out_size);
+            uint64_t elapsed = bench_now() - start;
+            if (out == NULL) {
+                bench_fail("buffer_serialize_to_memory");
+            }
+            best = (elapsed < best) ? elapsed : best;
+            safe_free(out);
+        }
+        bench_report(name, lines, size, best);
+    }
+    
+    buffer_destroy(buf);
+    safe_free(text);
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file bench_chacha20.c
+ * @brief ChaCha20 吞吐量基準測試
+ *
+ * 對不同的訊息大小量測：
+ * - xor/<size>：單一上下文依序加密（執行期選用的 SIMD 或純量後端）
+ * - parallel/<size>：以執行緒池平行加密（1 MiB 以上的訊息）
+ *
+ * 小訊息重複加密直到處理量達到總量，結果包含每次呼叫的固定成本。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "bench.h"
+#include "chacha20.h"
+#include "threadpool.h"
+#include "memory.h"
+#include <stdio.h>
+
+/** 每個量測處理的總位元組數（--quick 時為四分之一） */
+#define DEFAULT_TOTAL (256u * 1024u * 1024u)
+
+/** 平行量測的最小訊息大小 */
+#define PARALLEL_MIN_SIZE (1u << 20)
+
+static const char *const g_usage =
+    "  --total N       每個量測處理的總量（預設 256M）\n"
+    "  --threads N     平行量測的執行緒數（預設 YUNFS_THREADS 或 CPU 數量）\n";
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv, "chacha20", g_usage);
+    size_t total = bench_option_size("total", bench_quick() ? DEFAULT_TOTAL / 4 : DEFAULT_TOTAL);
+    size_t threads = bench_option_size("threads", threadpool_default_threads());
+    
+    static const size_t sizes[] = { 64, 1024, 16u * 1024u, 1u << 20, 64u << 20 };
+    size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    uint8_t *data = (uint8_t *)safe_malloc(max_size);
+    threadpool_t *pool = threadpool_create(threads);
+    if (data == NULL || pool == NULL) {
+        bench_fail("初始化");
+    }
+    
+    uint8_t key[32];
+    uint8_t nonce[12] = { 0 };
+    for (size_t i = 0; i < sizeof(key); i++) {
+        key[i] = (uint8_t)(i * 7 + 1);
+    }
+    
+    char label[16];
+    char name[64];
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+        size_t rounds = (total > size) ? total / size : 1;
+        bench_format_size(size, label, sizeof(label));
+        
+        snprintf(name, sizeof(name), "xor/%s", label);
+        if (bench_selected(name)) {
+            uint64_t best = UINT64_MAX;
+            for (unsigned r = 0; r < bench_repeat(); r++) {
+                uint64_t start = bench_now();
+                for (size_t i = 0; i < rounds; i++) {
+                    chacha20_ctx_t ctx;
+                    chacha20_ctx_init(&ctx, key, nonce, 0);
+                    chacha20_ctx_xor(&ctx, data, data, size);
+                }
+                uint64_t elapsed = bench_now() - start;
+                best = (elapsed < best) ? elapsed : best;
+            }
+            bench_report(name, rounds, (uint64_t)rounds * size, best);
+        }
+        
+        snprintf(name, sizeof(name), "parallel/%s", label);
+        if (size >= PARALLEL_MIN_SIZE && bench_selected(name)) {
+            uint64_t best = UINT64_MAX;
+            for (unsigned r = 0; r < bench_repeat(); r++) {
+                uint64_t start = bench_now();
+                for (size_t i = 0; i < rounds; i++) {
+                    chacha20_xor_parallel(pool, key, nonce, 0, data, data, size);
+                }
+                uint64_t elapsed = bench_now() - start;
+                best = (elapsed < best) ? elapsed : best;
+            }
+            bench_report(name, rounds, (uint64_t)rounds * size, best);
+        }
+    }
+    
+    threadpool_destroy(pool);
+    safe_free(data);
+    return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file bench_persist.c
+ * @brief 映像檔儲存與載入基準測試
+ *
+ * 對每個映像檔大小產生平衡樹形狀的工作負載（每個檔案平均 64 KiB），量測：
+ * - save_raw/<size>：不壓縮儲存
+ * - save_lz/<size>：LZ 壓縮後儲存
+ * - load/<size>：延遲載入（只讀取並驗證目錄結構）
+ * - load_read/<size>：載入後讀取所有檔案內容（解密全部內容區塊）
+ *
+ * 密鑰衍生使用低成本參數並由工作階段快取，量測結果只反映序列化、壓縮、加密與 I/O。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "bench.h"
+#include "workload.h"
+#include "vfs.h"
+#include "vfs_persist.h"
+#include "kdf.h"
+#include "memory.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** 測試用密碼 */
+#define BENCH_PASSWORD "bench-password"
+
+/** 工作負載的檔案平均大小 */
+#define BENCH_FILE_SIZE (64u * 1024u)
+
+static const char *const g_usage =
+    "  --sizes LIST    映像檔大小，以逗號分隔（預設 10M,100M；--quick 為 10M），最大 4G\n"
+    "  --content KIND  檔案內容：text（可壓縮，預設）或 random（不可壓縮）\n"
+    "  --dir PATH      映像檔暫存目錄（預設 $TMPDIR 或 /tmp）\n";
+
+/**
+ * @brief 讀取映像檔中的所有檔案內容
+ */
+static void read_all(vfs_t *vfs, const workload_spec_t *spec) {
+    char path[WORKLOAD_PATH_MAX];
+    for (size_t i = 0; i < spec->files; i++) {
+        workload_path(spec, i, path);
+        vfs_node_t *node = vfs_find_node(vfs, path);
+        size_t size = 0;
+        if (node == NULL || (vfs_peek_file(node, &size) == NULL && size > 0)) {
+            bench_fail("讀取載入的檔案");
+        }
+    }
+}
+
+/**
+ * @brief 量測一種映像檔大小
+ */
+static void bench_size(size_t bytes, bool random, const char *image) {
+    char label[16];
+    char name[64];
+    bench_format_size(bytes, label, sizeof(label));
+    
+    workload_spec_t spec = workload_default_spec(WORKLOAD_TREE);
+    spec.file_size = BENCH_FILE_SIZE;
+    spec.files = (bytes + BENCH_FILE_SIZE - 1) / BENCH_FILE_SIZE;
+    spec.random = random;
+    
+    uint64_t total = 0;
+    vfs_t *vfs = workload_build(&spec, &total);
+    if (vfs == NULL) {
+        bench_fail("產生工作負載");
+    }
+    
+    /* 先儲存不壓縮版本，最後留下壓縮版本供載入量測 */
+    static const struct { const char *name; bool compress; } modes[] = {
+        { "save_raw", false },
+        { "save_lz", true },
+    };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        vfs_persist_set_compression(modes[m].compress);
+        uint64_t best = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            uint64_t start = bench_now();
+            if (!vfs_save_encrypted(vfs, image, BENCH_PASSWORD)) {
+                bench_fail("vfs_save_encrypted");
+            }
+            uint64_t elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+        }
+        snprintf(name, sizeof(name), "%s/%s", modes[m].name, label);
+        if (bench_selected(name)) {
+            bench_report(name, 1, total, best);
+        }
+    }
+    vfs_destroy(vfs);
+    
+    static const struct { const char *name; bool read; } loads[] = {
+        { "load", false },
+        { "load_read", true },
+    };
+    for (size_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+        snprintf(name, sizeof(name), "%s/%s", loads[l].name, label);
+        if (!bench_selected(name)) {
+            continue;
+        }
+        
+        uint64_t best = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            uint64_t start = bench_now();
+            vfs_t *loaded = vfs_load_encrypted(image, BENCH_PASSWORD);
+            if (loaded == NULL) {
+                bench_fail("vfs_load_encrypted");
+            }
+            if (loads[l].read) {
+                read_all(loaded, &spec);
+            }
+            uint64_t elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+            vfs_destroy(loaded);
+        }
+        bench_report(name, 1, total, best);
+    }
+    remove(image);
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv, "persist", g_usage);
+    
+    const char *sizes = bench_option("sizes");
+    if (sizes == NULL) {
+        sizes = bench_quick() ? "10M" : "10M,100M";
+    }
+    const char *content = bench_option("content");
+    bool random = (content != NULL && strcmp(content, "random") == 0);
+    if (content != NULL && !random && strcmp(content, "text") != 0) {
+        fprintf(stderr, "錯誤: --content 必須為 text 或 random\n");
+        return 2;
+    }
+    
+    const char *dir = bench_option("dir");
+    if (dir == NULL) {
+        dir = getenv("TMPDIR");
+    }
+    if (dir == NULL || dir[0] == '\0') {
+        dir = "/tmp";
+    }
+    char image[WORKLOAD_PATH_MAX];
+    snprintf(image, sizeof(image), "%s/yunfs_bench_persist.img", dir);
+    
+    kdf_params_t params = { 10, KDF_DEFAULT_R, KDF_DEFAULT_P };
+    vfs_persist_set_kdf(&params);
+    
+    /* 依序量測清單中的每個大小 */
+    char *list = safe_strdup(sizes);
+    if (list == NULL) {
+        bench_fail("配置大小清單");
+    }
+    for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+        size_t bytes = 0;
+        if (!bench_parse_size(item, &bytes) || bytes == 0 || bytes > (4ull << 30)) {
+            fprintf(stderr, "錯誤: 映像檔大小無效（1 到 4G）: %s\n", item);
+            return 2;
+        }
+        bench_size(bytes, random, image);
+    }
+    safe_free(list);
+    kdf_cache_clear();
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file bench_screen.c
+ * @brief 編輯器畫面重繪基準測試
+ *
+ * 量測期間 stdout 導向 /dev/null（無法取得視窗大小，使用預設的 24x80），
+ * 每個畫面包含 screen_refresh、狀態列與 screen_flush，量測：
+ * - static：畫面不變（只做比對，不輸出）
+ * - cursor：游標在畫面內左右移動（每次只有游標所在行變化）
+ * - scroll：每個畫面向下捲動一行（所有行變化）
+ * - page：每個畫面向下翻一頁
+ * - redraw：每個畫面先清除螢幕再完整重繪
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 dup、dup2） */
+
+#include "bench.h"
+#include "workload.h"
+#include "screen.h"
+#include "buffer.h"
+#include "memory.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/** 預設畫面數（--quick 時為十分之一） */
+#define DEFAULT_FRAMES 20000u
+
+/** 測試文件大小 */
+#define DOCUMENT_SIZE (8u * 1024u * 1024u)
+
+static const char *const g_usage =
+    "  --frames N      每種情境的畫面數（預設 20000）\n";
+
+/** 重繪情境 */
+typedef enum {
+    CASE_STATIC,
+    CASE_CURSOR,
+    CASE_SCROLL,
+    CASE_PAGE,
+    CASE_REDRAW,
+    CASE_COUNT
+} screen_case_t;
+
+static const char *const g_case_names[CASE_COUNT] = {
+    "static", "cursor", "scroll", "page", "redraw",
+};
+
+/**
+ * @brief 執行一種情境並回傳耗時（奈秒）
+ */
+static uint64_t run_case(screen_case_t kind, buffer_t *buf, size_t frames) {
+    size_t lines = buffer_get_line_count(buf);
+    size_t page = screen_get_size().rows - 2;
+    cursor_t cursor = { 0, 0 };
+    size_t first_line = 0;
+    
+    /* 先畫出第一個畫面，量測只包含之後的變化 */
+    screen_clear();
+    screen_refresh(buf, &cursor, first_line);
+    screen_flush();
+    
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < frames; i++) {
+        switch (kind) {
+            case CASE_STATIC:
+                break;
+            case CASE_CURSOR:
+                cursor.col = i % 40;
+                break;
+            case CASE_SCROLL:
+                cursor.row = (page + i) % lines;
+                break;
+            case CASE_PAGE:
+                cursor.row = (i * page) % lines;
+                break;
+            case CASE_REDRAW:
+                screen_clear();
+                break;
+            case CASE_COUNT:
+                break;
+        }
+        if (cursor.row < first_line || cursor.row >= first_line + page) {
+            first_line = (cursor.row >= page) ? cursor.row - page + 1 : 0;
+        }
+        screen_refresh(buf, &cursor, first_line);
+        screen_show_status("-- bench --", false);
+        screen_flush();
+    }
+    return bench_now() - start;
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv, "screen", g_usage);
+    size_t frames = bench_option_size("frames", bench_quick() ? DEFAULT_FRAMES / 10 : DEFAULT_FRAMES);
+    
+    char *text = workload_text(DOCUMENT_SIZE, 1);
+    buffer_t *buf = buffer_create(NULL);
+    if (text == NULL || buf == NULL || !buffer_load_from_memory(buf, text, DOCUMENT_SIZE)) {
+        bench_fail("載入文件");
+    }
+    safe_free(text);
+    
+    /* 量測期間以 /dev/null 作為終端機，結果在還原 stdout 後輸出 */
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (saved_stdout < 0 || null_fd < 0 || dup2(null_fd, STDOUT_FILENO) < 0) {
+        bench_fail("開啟 /dev/null");
+    }
+    close(null_fd);
+    
+    char count[16];
+    char names[CASE_COUNT][64];
+    bench_format_size(frames, count, sizeof(count));
+    for (size_t c = 0; c < CASE_COUNT; c++) {
+        snprintf(names[c], sizeof(names[c]), "%s/%s", g_case_names[c], count);
+    }
+    
+    uint64_t best[CASE_COUNT];
+    bool ok = screen_init();
+    for (size_t c = 0; c < CASE_COUNT && ok; c++) {
+        best[c] = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat() && bench_selected(names[c]); r++) {
+            uint64_t elapsed = run_case((screen_case_t)c, buf, frames);
+            best[c] = (elapsed < best[c]) ? elapsed : best[c];
+        }
+    }
+    screen_cleanup();
+    
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    if (!ok) {
+        bench_fail("screen_init");
+    }
+    
+    for (size_t c = 0; c < CASE_COUNT; c++) {
+        if (best[c] != UINT64_MAX) {
+            bench_report(names[c], frames, 0, best[c]);
+        }
+    }
+    
+    buffer_destroy(buf);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file bench_search.c
+ * @brief 文字搜尋基準測試
+ *
+ * 以產生的多行文字文件量測搜尋引擎：
+ * - miss_short/<size>、miss_long/<size>：搜尋不存在的短／長模式（純掃描吞吐量）
+ * - count_common/<size>：逐一找出常見單字的所有匹配
+ * - count_phrase/<size>：逐一找出較少見的片語的所有匹配
+ * - buffer_forward/<size>：在緩衝區中以 search_buffer_forward 逐一走訪片語的匹配
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "bench.h"
+#include "workload.h"
+#include "search.h"
+#include "buffer.h"
+#include "memory.h"
+#include <stdio.h>
+
+/** 預設文件大小（--quick 時為八分之一） */
+#define DEFAULT_SIZE (64u * 1024u * 1024u)
+
+static const char *const g_usage =
+    "  --size N        文件大小（預設 64M）\n"
+    "  --seed N        亂數種子（預設 1）\n";
+
+/**
+ * @brief 量測在連續文字中找出所有匹配
+ */
+static void bench_text(const char *name, const char *pattern_text, const char *text, size_t size) {
+    if (!bench_selected(name)) {
+        return;
+    }
+    search_pattern_t *pattern = search_compile(pattern_text);
+    if (pattern == NULL) {
+        bench_fail("search_compile");
+    }
+    
+    uint64_t best = UINT64_MAX;
+    uint64_t matches = 0;
+    for (unsigned r = 0; r < bench_repeat(); r++) {
+        matches = 0;
+        const char *pos = text;
+        const char *end = text + size;
+        uint64_t start = bench_now();
+        while (pos < end) {
+            const char *hit = search_find(pattern, pos, (size_t)(end - pos));
+            if (hit == NULL) {
+                break;
+            }
+            matches++;
+            pos = hit + 1;
+        }
+        uint64_t elapsed = bench_now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+    bench_report(name, matches, size, best);
+    search_free(pattern);
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv, "search", g_usage);
+    size_t size = bench_option_size("size", bench_quick() ? DEFAULT_SIZE / 8 : DEFAULT_SIZE);
+    uint64_t seed = bench_option_size("seed", 1);
+    
+    char *text = workload_text(size, seed);
+    if (text == NULL) {
+        bench_fail("產生文件");
+    }
+    
+    char label[16];
+    char name[64];
+    bench_format_size(size, label, sizeof(label));
+    
+    static const struct { const char *name; const char *pattern; } cases[] = {
+        { "miss_short", "qz" },
+        { "miss_long", "zq_not_in_vocabulary" },
+        { "count_common", "buffer" },
+        { "count_phrase", "journal cache" },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        snprintf(name, sizeof(name), "%s/%s", cases[i].name, label);
+        bench_text(name, cases[i].pattern, text, size);
+    }
+    
+    snprintf(name, sizeof(name), "buffer_forward/%s", label);
+    if (bench_selected(name)) {
+        buffer_t *buf = buffer_create(NULL);
+        search_pattern_t *pattern = search_compile("journal cache");
+        if (buf == NULL || pattern == NULL || !buffer_load_from_memory(buf, text, size)) {
+            bench_fail("載入緩衝區");
+        }
+        
+        uint64_t best = UINT64_MAX;
+        uint64_t matches = 0;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            matches = 0;
+            size_t row = 0;
+            size_t col = 0;
+            uint64_t start = bench_now();
+            while (search_buffer_forward(buf, pattern, row, col, false, &row, &col)) {
+                matches++;
+                col++;
+            }
+            uint64_t elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+        }
+        bench_report(name, matches, size, best);
+        search_free(pattern);
+        buffer_destroy(buf);
+    }
+    
+    safe_free(text);
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file bench_vfs.c
+ * @brief VFS 建立與查詢基準測試
+ *
+ * 對平坦、深層與平衡樹三種形狀分別量測：
+ * - create_<shape>：建立所有檔案（目錄事先建立，不計入耗時）
+ * - lookup_<shape>：以隨機順序查詢每個檔案的完整路徑
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "bench.h"
+#include "workload.h"
+#include "vfs.h"
+#include "memory.h"
+#include <stdio.h>
+
+/** 預設檔案數（--quick 時為十分之一） */
+#define DEFAULT_FILES (100u * 1024u)
+
+static const char *const g_usage =
+    "  --files N       每種形狀的檔案數（預設 100K）\n"
+    "  --depth N       深層形狀的目錄層數（預設 32）\n";
+
+/**
+ * @brief 量測一種形狀的建立與查詢
+ */
+static void bench_shape(const workload_spec_t *spec) {
+    char name[64];
+    char count[16];
+    const char *shape = workload_shape_name(spec->shape);
+    bench_format_size(spec->files, count, sizeof(count));
+    
+    /* 預先產生路徑，量測時不包含格式化的成本 */
+    char **paths = (char **)safe_malloc(spec->files * sizeof(char *));
+    if (paths == NULL) {
+        bench_fail("配置路徑陣列");
+    }
+    char path[WORKLOAD_PATH_MAX];
+    for (size_t i = 0; i < spec->files; i++) {
+        workload_path(spec, i, path);
+        paths[i] = safe_strdup(path);
+        if (paths[i] == NULL) {
+            bench_fail("配置路徑");
+        }
+    }
+    
+    vfs_t *vfs = NULL;
+    uint64_t best = UINT64_MAX;
+    for (unsigned r = 0; r < bench_repeat(); r++) {
+        if (vfs != NULL) {
+            vfs_destroy(vfs);
+        }
+        vfs = vfs_init();
+        if (vfs == NULL) {
+            bench_fail("vfs_init");
+        }
+        for (size_t i = 0; i < spec->files; i++) {
+            if (!workload_make_parents(vfs, paths[i])) {
+                bench_fail("建立目錄");
+            }
+        }
+        
+        uint64_t start = bench_now();
+        for (size_t i = 0; i < spec->files; i++) {
+            if (vfs_create_file(vfs, paths[i], NULL, 0) == NULL) {
+                bench_fail("vfs_create_file");
+            }
+        }
+        uint64_t elapsed = bench_now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+    snprintf(name, sizeof(name), "create_%s/%s", shape, count);
+    if (bench_selected(name)) {
+        bench_report(name, spec->files, 0, best);
+    }
+    
+    snprintf(name, sizeof(name), "lookup_%s/%s", shape, count);
+    if (bench_selected(name)) {
+        /* 以固定種子打亂查詢順序 */
+        size_t *order = (size_t *)safe_malloc(spec->files * sizeof(size_t));
+        if (order == NULL) {
+            bench_fail("配置查詢順序");
+        }
+        workload_rng_t rng;
+        workload_rng_seed(&rng, spec->seed);
+        for (size_t i = 0; i < spec->files; i++) {
+            size_t j = workload_rng_below(&rng, i + 1);
+            order[i] = order[j];
+            order[j] = i;
+        }
+        
+        best = UINT64_MAX;
+        for (unsigned r = 0; r < bench_repeat(); r++) {
+            uint64_t start = bench_now();
+            for (size_t i = 0; i < spec->files; i++) {
+                if (vfs_find_node(vfs, paths[order[i]]) == NULL) {
+                    bench_fail("vfs_find_node");
+                }
+            }
+            uint64_t elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+        }
+        bench_report(name, spec->files, 0, best);
+        safe_free(order);
+    }
+    
+    vfs_destroy(vfs);
+    for (size_t i = 0; i < spec->files; i++) {
+        safe_free(paths[i]);
+    }
+    safe_free(paths);
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv, "vfs", g_usage);
+    size_t files = bench_option_size("files", bench_quick() ? DEFAULT_FILES / 10 : DEFAULT_FILES);
+    size_t depth = bench_option_size("depth", 32);
+    
+    static const workload_shape_t shapes[] = { WORKLOAD_FLAT, WORKLOAD_DEEP, WORKLOAD_TREE };
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        workload_spec_t spec = workload_default_spec(shapes[i]);
+        spec.files = files;
+        if (shapes[i] == WORKLOAD_DEEP) {
+            spec.depth = depth;
+        }
+        bench_shape(&spec);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file gen_workload.c
+ * @brief 工作負載產生工具
+ *
+ * 以可重現的規格產生測試用的加密映像檔或文字文件，例如：
+ *
+ *     YUNFS_PASSWORD=... gen_workload --shape tree --size 1G .yunfs_data
+ *     gen_workload --text --size 64M big.txt
+ *
+ * 產生的映像檔可直接由 yun-fs 載入（密碼由環境變數 YUNFS_PASSWORD 提供）。
+ * 完成後在 stdout 輸出一行 JSON 描述產生的內容與耗時。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "bench.h"
+#include "workload.h"
+#include "vfs.h"
+#include "vfs_persist.h"
+#include "kdf.h"
+#include "error.h"
+#include "memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 印出使用說明
+ */
+static void print_usage(void) {
+    fprintf(stderr, "用法: gen_workload [選項] <輸出檔>\n");
+    fprintf(stderr, "  --shape S       目錄樹形狀：flat、deep、tree（預設 tree）\n");
+    fprintf(stderr, "  --files N       檔案數量（預設 1000）\n");
+    fprintf(stderr, "  --size N        總大小；指定時檔案數量 = 總大小 / 檔案大小\n");
+    fprintf(stderr, "  --file-size N   檔案平均大小（預設 4K）\n");
+    fprintf(stderr, "  --depth N       deep／tree 的目錄層數（預設 32／3）\n");
+    fprintf(stderr, "  --fanout N      tree 每個目錄的子目錄數（預設 16）\n");
+    fprintf(stderr, "  --content KIND  text（可壓縮，預設）或 random（不可壓縮）\n");
+    fprintf(stderr, "  --seed N        亂數種子（預設 1）\n");
+    fprintf(stderr, "  --kdf-cost N    scrypt N 的以 2 為底對數（預設 %d）\n", KDF_DEFAULT_LOG_N);
+    fprintf(stderr, "  --no-compress   儲存時不壓縮\n");
+    fprintf(stderr, "  --text          輸出 --size 大小的多行文字文件，而非映像檔\n");
+    fprintf(stderr, "映像檔的密碼由環境變數 YUNFS_PASSWORD 提供\n");
+}
+
+/**
+ * @brief 解析數量參數，失敗時結束程式
+ */
+static size_t parse_size_arg(const char *option, const char *value) {
+    size_t result = 0;
+    if (value == NULL || !bench_parse_size(value, &result)) {
+        fprintf(stderr, "錯誤: %s 的值無效: %s\n", option, value ? value : "(缺少)");
+        exit(2);
+    }
+    return result;
+}
+
+/**
+ * @brief 寫出文字文件
+ */
+static bool write_text(const char *path, size_t size, uint64_t seed) {
+    char *text = workload_text(size, seed);
+    if (text == NULL) {
+        return false;
+    }
+    
+    FILE *file = fopen(path, "wb");
+    bool ok = (file != NULL && fwrite(text, 1, size, file) == size);
+    if (file != NULL && fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error_set(ERR_IO_ERROR, "無法寫入文字文件: %s", path);
+    }
+    safe_free(text);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    workload_shape_t shape = WORKLOAD_TREE;
+    workload_spec_t spec = workload_default_spec(shape);
+    size_t total = 0;
+    size_t depth = 0;
+    bool text_mode = false;
+    bool compress = true;
+    kdf_params_t params = kdf_default_params();
+    const char *output = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage();
+            return 0;
+        } else if (strcmp(arg, "--text") == 0) {
+            text_mode = true;
+        } else if (strcmp(arg, "--no-compress") == 0) {
+            compress = false;
+        } else if (strcmp(arg, "--shape") == 0) {
+            if (value == NULL || !workload_parse_shape(value, &shape)) {
+                fprintf(stderr, "錯誤: --shape 必須為 flat、deep 或 tree\n");
+                return 2;
+            }
+            i++;
+        } else if (strcmp(arg, "--content") == 0) {
+            if (value == NULL || (strcmp(value, "text") != 0 && strcmp(value, "random") != 0)) {
+                fprintf(stderr, "錯誤: --content 必須為 text 或 random\n");
+                return 2;
+            }
+            spec.random = (strcmp(value, "random") == 0);
+            i++;
+        } else if (strcmp(arg, "--files") == 0) {
+            spec.files = parse_size_arg(arg, value);
+            i++;
+        } else if (strcmp(arg, "--size") == 0) {
+            total = parse_size_arg(arg, value);
+            i++;
+        } else if (strcmp(arg, "--file-size") == 0) {
+            spec.file_size = parse_size_arg(arg, value);
+            i++;
+        } else if (strcmp(arg, "--depth") == 0) {
+            depth = parse_size_arg(arg, value);
+            i++;
+        } else if (strcmp(arg, "--fanout") == 0) {
+            spec.fanout = parse_size_arg(arg, value);
+            i++;
+        } else if (strcmp(arg, "--seed") == 0) {
+            spec.seed = parse_size_arg(arg, value);
+            i++;
+        } else if (strcmp(arg, "--kdf-cost") == 0) {
+            size_t cost = parse_size_arg(arg, value);
+            params.log_n = (cost <= UINT8_MAX) ? (uint8_t)cost : 0;
+            i++;
+        } else if (arg[0] != '-' && output == NULL) {
+            output = arg;
+        } else {
+            fprintf(stderr, "錯誤: 無法辨識的參數 %s\n", arg);
+            print_usage();
+            return 2;
+        }
+    }
+    if (output == NULL) {
+        print_usage();
+        return 2;
+    }
+    
+    /* 形狀決定預設層數，指定的參數覆寫預設值 */
+    workload_spec_t defaults = workload_default_spec(shape);
+    spec.shape = shape;
+    spec.depth = (depth > 0) ? depth : defaults.depth;
+    if (total > 0 && spec.file_size > 0) {
+        spec.files = (total + spec.file_size - 1) / spec.file_size;
+    }
+    
+    uint64_t start = bench_now();
+    uint64_t bytes = 0;
+    bool ok;
+    if (text_mode) {
+        bytes = (total > 0) ? total : spec.file_size;
+        ok = write_text(output, (size_t)bytes, spec.seed);
+    } else {
+        const char *password = getenv("YUNFS_PASSWORD");
+        if (password == NULL || password[0] == '\0') {
+            fprintf(stderr, "錯誤: 請以環境變數 YUNFS_PASSWORD 提供映像檔密碼\n");
+            return 2;
+        }
+        if (!vfs_persist_set_kdf(&params)) {
+            fprintf(stderr, "錯誤: --kdf-cost 無效\n");
+            return 2;
+        }
+        vfs_persist_set_compression(compress);
+        
+        vfs_t *vfs = workload_build(&spec, &bytes);
+        ok = (vfs != NULL && vfs_save_encrypted(vfs, output, password));
+        vfs_destroy(vfs);
+        kdf_cache_clear();
+    }
+    if (!ok) {
+        fprintf(stderr, "錯誤: 無法產生 %s\n", output);
+        error_print(stderr);
+        return 1;
+    }
+    
+    double seconds = (double)(bench_now() - start) / 1e9;
+    printf("{\"tool\":\"gen_workload\",\"output\":\"%s\",\"kind\":\"%s\",\"shape\":\"%s\","
+           "\"files\":%zu,\"bytes\":%llu,\"content\":\"%s\",\"seed\":%llu,\"seconds\":%.3f}\n",
+           output, text_mode ? "text" : "image", workload_shape_name(spec.shape),
+           text_mode ? (size_t)0 : spec.files, (unsigned long long)bytes,
+           spec.random ? "random" : "text", (unsigned long long)spec.seed, seconds);
+    return 0;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file workload.c
+ * @brief 基準測試工作負載產生模組實作
+ *
+ * 文字內容由固定字彙隨機組成、每行 20 到 100 個字元，
+ * 壓縮率與一般原始碼及文件相近；亂數內容則完全無法壓縮。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "workload.h"
+#include "memory.h"
+#include "error.h"
+#include <stdio.h>
+#include <string.h>
+
+/** 文字內容使用的字彙 */
+static const char *const g_words[] = {
+    "the", "file", "system", "buffer", "editor", "search", "cursor", "line",
+    "node", "image", "block", "cipher", "stream", "key", "path", "directory",
+    "write", "read", "save", "load", "undo", "redo", "insert", "delete",
+    "screen", "refresh", "yun", "chacha20", "extent", "index", "cache", "journal",
+    "return", "struct", "size_t", "const", "char", "if", "else", "for",
+    "while", "static", "void", "bool", "true", "false", "NULL", "int",
+    "{", "}", "(", ")", ";", "=", "==", "+", "->", "0", "1", "42", "//", "/*",
+};
+
+/** 字彙數量 */
+#define WORD_COUNT (sizeof(g_words) / sizeof(g_words[0]))
+
+/* ============================================================================
+ * 亂數實作
+ * ============================================================================ */
+
+/**
+ * @brief 以種子初始化亂數產生器
+ */
+void workload_rng_seed(workload_rng_t *rng, uint64_t seed) {
+    /* splitmix64 打散種子，避免相近的種子產生相關的序列 */
+    uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    rng->state = (z != 0) ? z : 1;
+}
+
+/**
+ * @brief 下一個 64 位元亂數
+ */
+uint64_t workload_rng_next(workload_rng_t *rng) {
+    uint64_t x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return x * 0x2545f4914f6cdd1dull;
+}
+
+/**
+ * @brief 介於 0 到 bound-1 的亂數
+ */
+size_t workload_rng_below(workload_rng_t *rng, size_t bound) {
+    return (bound == 0) ? 0 : (size_t)(workload_rng_next(rng) % bound);
+}
+
+/* ============================================================================
+ * 規格實作
+ * ============================================================================ */
+
+/**
+ * @brief 指定形狀的預設規格
+ */
+workload_spec_t workload_default_spec(workload_shape_t shape) {
+    workload_spec_t spec = { shape, 1000, 4096, 32, 16, false, 1 };
+    if (shape == WORKLOAD_TREE) {
+        spec.depth = 3;
+    }
+    return spec;
+}
+
+/**
+ * @brief 解析形狀名稱
+ */
+bool workload_parse_shape(const char *text, workload_shape_t *shape) {
+    static const workload_shape_t shapes[] = { WORKLOAD_FLAT, WORKLOAD_DEEP, WORKLOAD_TREE };
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        if (strcmp(text, workload_shape_name(shapes[i])) == 0) {
+            *shape = shapes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 形狀的名稱
+ */
+const char *workload_shape_name(workload_shape_t shape) {
+    switch (shape) {
+        case WORKLOAD_FLAT: return "flat";
+        case WORKLOAD_DEEP: return "deep";
+        case WORKLOAD_TREE: return "tree";
+    }
+    return "?";
+}
+
+/* ============================================================================
+ * 資料產生實作
+ * ============================================================================ */
+
+/**
+ * @brief 第 index 個檔案的路徑
+ */
+size_t workload_path(const workload_spec_t *spec, size_t index, char *buf) {
+    size_t len = 0;
+    size_t room = WORKLOAD_PATH_MAX - 32;   /* 保留檔名的空間 */
+    
+    if (spec->shape == WORKLOAD_DEEP) {
+        for (size_t level = 0; level < spec->depth && len < room; level++) {
+            len += (size_t)snprintf(buf + len, room - len, "/d%zu", level);
+        }
+    } else if (spec->shape == WORKLOAD_TREE && spec->fanout > 0) {
+        /* 葉目錄編號以 fanout 進位表示，每一位對應一層 */
+        size_t leaves = 1;
+        for (size_t level = 0; level < spec->depth && leaves <= SIZE_MAX / spec->fanout; level++) {
+            leaves *= spec->fanout;
+        }
+        size_t leaf = index % leaves;
+        size_t place = leaves;
+        for (size_t level = 0; level < spec->depth && place >= spec->fanout && len < room; level++) {
+            place /= spec->fanout;
+            len += (size_t)snprintf(buf + len, room - len, "/t%zu", (leaf / place) % spec->fanout);
+        }
+    }
+    if (len > room) {
+        len = room;
+    }
+    
+    len += (size_t)snprintf(buf + len, WORKLOAD_PATH_MAX - len, "/f%zu", index);
+    return len;
+}
+
+/**
+ * @brief 以亂數填入內容
+ */
+void workload_fill(workload_rng_t *rng, bool random, uint8_t *dst, size_t len) {
+    if (random) {
+        size_t pos = 0;
+        while (pos < len) {
+            uint64_t value = workload_rng_next(rng);
+            size_t n = (len - pos < sizeof(value)) ? len - pos : sizeof(value);
+            memcpy(dst + pos, &value, n);
+            pos += n;
+        }
+        return;
+    }
+    
+    size_t pos = 0;
+    size_t line = 0;
+    size_t target = 20 + workload_rng_below(rng, 81);
+    while (pos < len) {
+        if (line >= target) {
+            dst[pos++] = '\n';
+            line = 0;
+            target = 20 + workload_rng_below(rng, 81);
+            continue;
+        }
+        
+        const char *word = g_words[workload_rng_below(rng, WORD_COUNT)];
+        size_t word_len = strlen(word);
+        if (word_len > len - pos) {
+            word_len = len - pos;
+        }
+        memcpy(dst + pos, word, word_len);
+        pos += word_len;
+        line += word_len;
+        if (pos < len) {
+            dst[pos++] = ' ';
+            line++;
+        }
+    }
+}
+
+/**
+ * @brief 產生多行文字文件
+ */
+char *workload_text(size_t bytes, uint64_t seed) {
+    char *text = (char *)safe_malloc_uninit(bytes + 1);
+    if (text == NULL) {
+        return NULL;
+    }
+    
+    workload_rng_t rng;
+    workload_rng_seed(&rng, seed);
+    workload_fill(&rng, false, (uint8_t *)text, bytes);
+    text[bytes] = '\0';
+    return text;
+}
+
+/**
+ * @brief 建立路徑中所有不存在的上層目錄
+ */
+bool workload_make_parents(vfs_t *vfs, const char *path) {
+    char buf[WORKLOAD_PATH_MAX];
+    size_t len = strlen(path);
+    if (len >= sizeof(buf)) {
+        error_set(ERR_INVALID_INPUT, "路徑過長: %s", path);
+        return false;
+    }
+    memcpy(buf, path, len + 1);
+    
+    char *slash = strrchr(buf, '/');
+    if (slash == NULL || slash == buf) {
+        return true;
+    }
+    *slash = '\0';
+    if (vfs_find_node(vfs, buf) != NULL) {
+        return true;
+    }
+    
+    /* 上層目錄不存在：由淺至深逐層建立 */
+    for (char *p = strchr(buf + 1, '/'); ; p = strchr(p + 1, '/')) {
+        if (p != NULL) {
+            *p = '\0';
+        }
+        if (vfs_find_node(vfs, buf) == NULL && vfs_create_dir(vfs, buf) == NULL) {
+            return false;
+        }
+        if (p == NULL) {
+            return true;
+        }
+        *p = '/';
+    }
+}
+
+/**
+ * @brief 依規格建立 VFS
+ */
+vfs_t *workload_build(const workload_spec_t *spec, uint64_t *total_bytes) {
+    vfs_t *vfs = vfs_init();
+    if (vfs == NULL) {
+        return NULL;
+    }
+    
+    size_t max_size = spec->file_size + spec->file_size / 2;
+    uint8_t *data = (uint8_t *)safe_malloc_uninit(max_size + 1);
+    if (data == NULL) {
+        vfs_destroy(vfs);
+        return NULL;
+    }
+    
+    workload_rng_t rng;
+    workload_rng_seed(&rng, spec->seed);
+    uint64_t total = 0;
+    char path[WORKLOAD_PATH_MAX];
+    bool ok = true;
+    
+    for (size_t i = 0; i < spec->files && ok; i++) {
+        size_t size = spec->file_size / 2 + workload_rng_below(&rng, spec->file_size + 1);
+        workload_fill(&rng, spec->random, data, size);
+        workload_path(spec, i, path);
+        ok = workload_make_parents(vfs, path) && vfs_create_file(vfs, path, data, size) != NULL;
+        total += size;
+    }
+    
+    safe_free(data);
+    if (!ok) {
+        vfs_destroy(vfs);
+        return NULL;
+    }
+    if (total_bytes != NULL) {
+        *total_bytes = total;
+    }
+    return vfs;
+}
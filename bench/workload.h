@@ -0,0 +1,152 @@
+/**
+ * @file workload.h
+ * @brief 基準測試工作負載產生模組標頭檔
+ *
+ * 以固定的亂數種子產生可重現的測試資料，提供：
+ * - 目錄樹形狀：平坦（所有檔案在根目錄）、深層（單一長目錄鏈）、平衡樹
+ * - 檔案內容：可壓縮的文字或不可壓縮的亂數位元組
+ * - 編輯器與搜尋使用的多行文字文件
+ *
+ * 相同的規格與種子每次產生完全相同的 VFS，量測結果可在不同版本間比較。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "vfs.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/** 工作負載路徑的最大長度（含結尾的 null 字元） */
+#define WORKLOAD_PATH_MAX 1024
+
+/**
+ * @brief 目錄樹形狀
+ */
+typedef enum {
+    WORKLOAD_FLAT,               /**< 所有檔案位於根目錄 */
+    WORKLOAD_DEEP,               /**< 檔案位於 depth 層巢狀目錄的最底層 */
+    WORKLOAD_TREE                /**< depth 層、每層 fanout 個子目錄的平衡樹，檔案平均分配到葉目錄 */
+} workload_shape_t;
+
+/**
+ * @brief 工作負載規格
+ */
+typedef struct {
+    workload_shape_t shape;      /**< 目錄樹形狀 */
+    size_t files;                /**< 檔案數量 */
+    size_t file_size;            /**< 檔案平均大小（實際大小介於一半到一倍半之間） */
+    size_t depth;                /**< DEEP／TREE 的目錄層數 */
+    size_t fanout;               /**< TREE 每個目錄的子目錄數 */
+    bool random;                 /**< true 為亂數位元組，false 為文字 */
+    uint64_t seed;               /**< 亂數種子 */
+} workload_spec_t;
+
+/**
+ * @brief 亂數產生器（xorshift64*）
+ */
+typedef struct {
+    uint64_t state;              /**< 內部狀態（不可為 0） */
+} workload_rng_t;
+
+/* ============================================================================
+ * 亂數
+ * ============================================================================ */
+
+/**
+ * @brief 以種子初始化亂數產生器
+ */
+void workload_rng_seed(workload_rng_t *rng, uint64_t seed);
+
+/**
+ * @brief 下一個 64 位元亂數
+ */
+uint64_t workload_rng_next(workload_rng_t *rng);
+
+/**
+ * @brief 介於 0 到 bound-1 的亂數（bound 為 0 時回傳 0）
+ */
+size_t workload_rng_below(workload_rng_t *rng, size_t bound);
+
+/* ============================================================================
+ * 規格
+ * ============================================================================ */
+
+/**
+ * @brief 指定形狀的預設規格（1000 個 4 KiB 文字檔，種子 1）
+ */
+workload_spec_t workload_default_spec(workload_shape_t shape);
+
+/**
+ * @brief 解析形狀名稱（"flat"、"deep"、"tree"）
+ *
+ * @return 成功回傳 true
+ */
+bool workload_parse_shape(const char *text, workload_shape_t *shape);
+
+/**
+ * @brief 形狀的名稱
+ */
+const char *workload_shape_name(workload_shape_t shape);
+
+/* ============================================================================
+ * 資料產生
+ * ============================================================================ */
+
+/**
+ * @brief 第 index 個檔案的路徑
+ *
+ * @param spec  工作負載規格
+ * @param index 檔案編號（0 到 files-1）
+ * @param buf   輸出緩衝區（至少 WORKLOAD_PATH_MAX 位元組）
+ * @return 路徑長度
+ */
+size_t workload_path(const workload_spec_t *spec, size_t index, char *buf);
+
+/**
+ * @brief 以亂數填入內容
+ *
+ * @param rng    亂數產生器
+ * @param random true 填入亂數位元組，false 填入以換行分隔的文字
+ * @param dst    輸出緩衝區
+ * @param len    長度
+ */
+void workload_fill(workload_rng_t *rng, bool random, uint8_t *dst, size_t len);
+
+/**
+ * @brief 產生 bytes 位元組的多行文字文件
+ *
+ * @param bytes 文件大小
+ * @param seed  亂數種子
+ * @return 以 null 結尾的文字，失敗回傳 NULL
+ * @note 呼叫者需負責使用 safe_free() 釋放
+ */
+char *workload_text(size_t bytes, uint64_t seed);
+
+/**
+ * @brief 建立路徑中所有不存在的上層目錄
+ *
+ * @param vfs  VFS 實例
+ * @param path 檔案完整路徑
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool workload_make_parents(vfs_t *vfs, const char *path);
+
+/**
+ * @brief 依規格建立 VFS
+ *
+ * @param spec        工作負載規格
+ * @param total_bytes 輸出參數：所有檔案內容的總大小（可為 NULL）
+ * @return VFS 實例，失敗回傳 NULL 並設定錯誤訊息
+ */
+vfs_t *workload_build(const workload_spec_t *spec, uint64_t *total_bytes);
+
+#endif // WORKLOAD_H
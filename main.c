@@ -5,6 +5,7 @@
 #include "src/core/shell.h"
 #include "src/core/editor.h"
 #include "src/utils/error.h"
+#include "src/utils/trace.h"
 
 static shell_t *g_shell = NULL;
 
@@ -15,13 +16,74 @@ static void signal_handler(int sig) {
     (void)sig;
     if (g_shell != NULL) {
         printf("\n收到中斷信號，正在儲存...\n");
-        shell_destroy(g_shell);
+        bool saved = shell_destroy(g_shell);
         g_shell = NULL;
+        exit(saved ? 0 : 1);
     }
     exit(0);
 }
 
+/**
+ * @brief 批次模式：依序執行腳本中的命令，結束時一次儲存 VFS
+ * @param script 腳本路徑，"-" 表示 stdin
+ * @return 程式結束碼（有任何命令失敗或最後儲存失敗時為 1）
+ */
+static int run_batch(const char *script) {
+    FILE *input = stdin;
+    if (strcmp(script, "-") != 0) {
+        input = fopen(script, "r");
+        if (input == NULL) {
+            fprintf(stderr, "錯誤: 無法開啟腳本 %s\n", script);
+            return 1;
+        }
+    }
+    
+    g_shell = shell_create_batch(getenv("YUNFS_PASSWORD"));
+    if (g_shell == NULL) {
+        error_t err = error_get();
+        fprintf(stderr, "錯誤: 無法創建 shell%s%s\n",
+                err.code != ERR_OK ? ": " : "", err.code != ERR_OK ? err.message : "");
+        if (input != stdin) {
+            fclose(input);
+        }
+        return 1;
+    }
+    
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    int failures = shell_run_batch(g_shell, input);
+    bool saved = shell_destroy(g_shell);
+    g_shell = NULL;
+    
+    if (input != stdin) {
+        fclose(input);
+    }
+    return (failures == 0 && saved) ? 0 : 1;
+}
+
+/**
+ * @brief 程式結束時寫出 Chrome trace
+ */
+static void finish_trace(void) {
+    if (!trace_capture_finish()) {
+        fprintf(stderr, "錯誤: %s\n", error_get().message);
+    }
+}
+
 int main(int argc, char *argv[]) {
+    // --trace <檔案>：記錄整個工作階段的事件，結束時寫出 Chrome trace JSON
+    if (argc > 2 && strcmp(argv[1], "--trace") == 0) {
+        if (!trace_capture_start(argv[2], 0)) {
+            fprintf(stderr, "錯誤: %s\n", error_get().message);
+            return 1;
+        }
+        atexit(finish_trace);
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    
     // 檢查是否要啟動編輯器
     if (argc > 1) {
         const char *filename = argv[1];
@@ -32,13 +94,20 @@ int main(int argc, char *argv[]) {
             printf("用法:\n");
             printf("  %s              - 啟動文件系統 shell\n", argv[0]);
             printf("  %s <檔案名稱>   - 使用編輯器打開檔案\n", argv[0]);
+            printf("  %s --batch [腳本] - 以批次模式執行腳本中的命令（省略或 - 時讀取 stdin）\n", argv[0]);
+            printf("                    現有資料的密碼由環境變數 YUNFS_PASSWORD 提供\n");
+            printf("  %s --trace <檔案> [...] - 記錄工作階段的耗時事件，結束時寫出 Chrome trace JSON\n", argv[0]);
             printf("\nShell 命令:\n");
-            printf("  ls, cd, pwd, mkdir, touch, cat, echo, rm, mv, cp, clear, help, exit\n");
+            printf("  ls, cd, pwd, du, df, meminfo, stats, mkdir, touch, cat, echo, grep, rm, mv, cp, import, export, clear, help, exit\n");
             printf("\n編輯器命令:\n");
             printf("  :w, :q, :wq, :q!, :e <檔名>, :b <n>\n");
             return 0;
         }
         
+        if (strcmp(filename, "--batch") == 0) {
+            return run_batch(argc > 2 ? argv[2] : "-");
+        }
+        
         // 啟動編輯器
         editor_t *editor = editor_create();
         if (editor == NULL) {
@@ -69,8 +138,11 @@ int main(int argc, char *argv[]) {
         signal(SIGTERM, signal_handler);
         
         shell_run(g_shell);
-        shell_destroy(g_shell);
+        bool saved = shell_destroy(g_shell);
         g_shell = NULL;
+        if (!saved) {
+            return 1;
+        }
     }
     
     return 0;
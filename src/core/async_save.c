@@ -0,0 +1,229 @@
+/**
+ * @file async_save.c
+ * @brief 背景儲存模組實作
+ *
+ * 寫入執行緒把快照分段寫入暫存檔，每段寫完後更新進度；
+ * 全部寫完並 fsync 後以 rename 取代原檔。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 mkstemp、fsync） */
+
+#include "async_save.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/**
+ * @brief 背景儲存
+ */
+struct async_save {
+    pthread_t thread;          /**< 寫入執行緒 */
+    char *filename;            /**< 目標檔案路徑 */
+    char *temp_path;           /**< 暫存檔路徑（filename.XXXXXX） */
+    char *data;                /**< 快照內容 */
+    size_t size;               /**< 快照大小 */
+    pthread_mutex_t lock;      /**< 保護以下進度狀態 */
+    size_t written;            /**< 已寫入的位元組數 */
+    bool done;                 /**< 寫入執行緒是否已結束 */
+    bool ok;                   /**< 是否成功取代原檔 */
+    char message[256];         /**< 失敗原因 */
+};
+
+/* ============================================================================
+ * 內部輔助函式
+ * ============================================================================ */
+
+/**
+ * @brief 記錄失敗原因並刪除暫存檔
+ */
+static void fail(async_save_t *save, int fd, const char *what) {
+    snprintf(save->message, sizeof(save->message), "%s: %s (%s)",
+             what, save->filename, strerror(errno));
+    if (fd >= 0) {
+        close(fd);
+    }
+    unlink(save->temp_path);
+}
+
+/**
+ * @brief 寫入暫存檔並取代原檔
+ * @return 成功回傳 true，失敗回傳 false 並記錄原因
+ */
+static bool write_and_replace(async_save_t *save) {
+    int fd = mkstemp(save->temp_path);
+    if (fd < 0) {
+        snprintf(save->message, sizeof(save->message), "無法建立暫存檔: %s (%s)",
+                 save->temp_path, strerror(errno));
+        return false;
+    }
+    
+    /* 沿用原檔的權限（mkstemp 一律建立 0600） */
+    struct stat st;
+    if (stat(save->filename, &st) == 0) {
+        fchmod(fd, st.st_mode & 07777);
+    } else {
+        mode_t mask = umask(0);
+        umask(mask);
+        fchmod(fd, 0666 & ~mask);
+    }
+    
+    /* 分段寫入，每段完成後更新進度 */
+    size_t pos = 0;
+    while (pos < save->size) {
+        size_t chunk = save->size - pos;
+        if (chunk > ASYNC_SAVE_CHUNK_SIZE) {
+            chunk = ASYNC_SAVE_CHUNK_SIZE;
+        }
+        
+        ssize_t n = write(fd, save->data + pos, chunk);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail(save, fd, "寫入檔案失敗");
+            return false;
+        }
+        pos += (size_t)n;
+        
+        pthread_mutex_lock(&save->lock);
+        save->written = pos;
+        pthread_mutex_unlock(&save->lock);
+    }
+    
+    /* 確認資料落盤後才取代原檔 */
+    if (fsync(fd) != 0) {
+        fail(save, fd, "寫入檔案失敗");
+        return false;
+    }
+    if (close(fd) != 0) {
+        fail(save, -1, "寫入檔案失敗");
+        return false;
+    }
+    if (rename(save->temp_path, save->filename) != 0) {
+        fail(save, -1, "無法取代檔案");
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 寫入執行緒主函式
+ */
+static void *writer_main(void *arg) {
+    async_save_t *save = (async_save_t *)arg;
+    bool ok = write_and_replace(save);
+    
+    /* 快照不再需要，立即清除明文 */
+    secure_zero(save->data, save->size);
+    safe_free(save->data);
+    save->data = NULL;
+    
+    pthread_mutex_lock(&save->lock);
+    save->ok = ok;
+    save->done = true;
+    pthread_mutex_unlock(&save->lock);
+    
+    return NULL;
+}
+
+/**
+ * @brief 釋放背景儲存實例（不處理執行緒）
+ */
+static void destroy_save(async_save_t *save) {
+    if (save->data != NULL) {
+        secure_zero(save->data, save->size);
+        safe_free(save->data);
+    }
+    pthread_mutex_destroy(&save->lock);
+    safe_free(save->temp_path);
+    safe_free(save->filename);
+    safe_free(save);
+}
+
+/* ============================================================================
+ * 背景儲存函式實作
+ * ============================================================================ */
+
+async_save_t *async_save_start(const char *filename, char *data, size_t size) {
+    /* 參數驗證 */
+    if (filename == NULL || (data == NULL && size > 0)) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        safe_free(data);
+        return NULL;
+    }
+    
+    async_save_t *save = (async_save_t *)safe_malloc(sizeof(async_save_t));
+    if (save == NULL) {
+        secure_zero(data, size);
+        safe_free(data);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&save->lock, NULL);
+    save->data = data;
+    save->size = size;
+    save->filename = safe_strdup(filename);
+    save->temp_path = (char *)safe_malloc(strlen(filename) + 8);
+    if (save->filename == NULL || save->temp_path == NULL) {
+        destroy_save(save);
+        return NULL;
+    }
+    
+    /* 暫存檔與原檔放在同一目錄，rename 才會是原子操作 */
+    sprintf(save->temp_path, "%s.XXXXXX", filename);
+    
+    if (pthread_create(&save->thread, NULL, writer_main, save) != 0) {
+        error_set(ERR_MEMORY, "無法建立寫入執行緒");
+        destroy_save(save);
+        return NULL;
+    }
+    
+    return save;
+}
+
+bool async_save_poll(async_save_t *save, size_t *written, size_t *total) {
+    if (save == NULL) {
+        return true;
+    }
+    
+    pthread_mutex_lock(&save->lock);
+    bool done = save->done;
+    if (written != NULL) {
+        *written = save->written;
+    }
+    pthread_mutex_unlock(&save->lock);
+    
+    if (total != NULL) {
+        *total = save->size;
+    }
+    return done;
+}
+
+bool async_save_finish(async_save_t *save) {
+    if (save == NULL) {
+        return false;
+    }
+    
+    pthread_join(save->thread, NULL);
+    
+    bool ok = save->ok;
+    if (!ok) {
+        error_set(ERR_IO_ERROR, "%s", save->message);
+    }
+    
+    destroy_save(save);
+    return ok;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file async_save.h
+ * @brief 背景儲存模組標頭檔
+ *
+ * 本模組在背景執行緒將緩衝區快照寫入主機檔案，包含：
+ * - 啟動：取得已序列化的快照並建立寫入執行緒
+ * - 查詢：讀取已寫入的位元組數與完成狀態（不會阻塞）
+ * - 結束：等待執行緒並取得結果
+ *
+ * @note 設計考量：
+ *   - 快照在呼叫端（UI 執行緒）序列化為連續記憶體，寫入期間可繼續編輯
+ *   - 先寫入同目錄下的暫存檔並 fsync，再以 rename 原子性地取代原檔，
+ *     寫入中斷時原檔保持完整
+ *   - 暫存檔沿用原檔的權限位元
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef ASYNC_SAVE_H
+#define ASYNC_SAVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/** @brief 每次 write 呼叫的最大位元組數（也是進度更新的粒度） */
+#define ASYNC_SAVE_CHUNK_SIZE (1024u * 1024u)
+
+/**
+ * @brief 進行中的背景儲存（不透明型別）
+ */
+typedef struct async_save async_save_t;
+
+/* ============================================================================
+ * 背景儲存函式
+ * ============================================================================ */
+
+/**
+ * @brief 啟動背景儲存
+ *
+ * @param filename 目標主機檔案路徑
+ * @param data 要寫入的內容（取得所有權，結束時安全清除並釋放）
+ * @param size 內容大小（位元組）
+ * @return 背景儲存實例，失敗回傳 NULL 並設定錯誤訊息（此時 data 也已釋放）
+ * @note 呼叫者需負責使用 async_save_finish() 等待並釋放
+ */
+async_save_t *async_save_start(const char *filename, char *data, size_t size);
+
+/**
+ * @brief 查詢背景儲存的進度
+ *
+ * @param save 背景儲存實例
+ * @param written 輸出參數，已寫入的位元組數（可為 NULL）
+ * @param total 輸出參數，總位元組數（可為 NULL）
+ * @return 寫入執行緒已結束回傳 true
+ */
+bool async_save_poll(async_save_t *save, size_t *written, size_t *total);
+
+/**
+ * @brief 等待背景儲存結束並釋放資源
+ *
+ * @param save 背景儲存實例（可為 NULL，此時回傳 false）
+ * @return 檔案已完整寫入並取代原檔回傳 true，否則回傳 false 並設定錯誤訊息
+ */
+bool async_save_finish(async_save_t *save);
+
+#endif // ASYNC_SAVE_H
@@ -6,7 +6,7 @@
  * 字元插入/刪除，以及檔案讀寫等操作。
  */
 
-#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 getline） */
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 fileno） */
 
 #include "buffer.h"
 #include "../utils/memory.h"
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <sys/stat.h>
 
 /* ============================================================================
  * 私有常數定義
@@ -35,6 +36,36 @@
  */
 static line_t *create_line(const char *text);
 
+/**
+ * @brief 以指定長度建立新的文字行
+ * @param text 行的初始文字內容（不需以 '\0' 結尾）
+ * @param len 文字長度
+ * @return 新建立的行指標，失敗時回傳 NULL
+ */
+static line_t *create_line_n(const char *text, size_t len);
+
+/**
+ * @brief 銷毀所有行並將緩衝區清為零行
+ * @param buf 目標緩衝區
+ */
+static void clear_lines(buffer_t *buf);
+
+/**
+ * @brief 以整塊內容就地建立所有行
+ * @param buf 目標緩衝區（已清空）
+ * @param data 內容（取得所有權，配置大小至少為 size + 1）
+ * @param size 內容大小
+ * @return 成功回傳 true，記憶體不足時回傳 false（緩衝區仍保有一個空行）
+ */
+static bool load_arena(buffer_t *buf, char *data, size_t size);
+
+/**
+ * @brief 載入結束後確保緩衝區至少有一行
+ * @param buf 目標緩衝區
+ * @return 成功回傳 true，記憶體不足時回傳 false
+ */
+static bool ensure_one_line(buffer_t *buf);
+
 /**
  * @brief 銷毀文字行並釋放記憶體
  * @param line 要銷毀的行（可為 NULL）
@@ -51,6 +82,43 @@ static void destroy_line(line_t *line);
  */
 static bool expand_line(line_t *line, size_t min_capacity);
 
+/**
+ * @brief 捨棄行號索引樹（行本身不受影響）
+ * @param buf 目標緩衝區
+ */
+static void index_reset(buffer_t *buf);
+
+/**
+ * @brief 依鏈結串列建立行號索引樹
+ * @param buf 目標緩衝區
+ * @return 成功回傳 true，記憶體不足時回傳 false（仍可走訪串列）
+ */
+static bool index_build(buffer_t *buf);
+
+/**
+ * @brief 為一段連續的行建立獨立的索引樹
+ * @param buf 目標緩衝區（提供優先權亂數）
+ * @param first 第一行
+ * @param count 行數
+ * @return 樹根；count 為 0 或記憶體不足時回傳 NULL
+ */
+static line_t *index_build_chain(buffer_t *buf, line_t *first, size_t count);
+
+/**
+ * @brief 將新行加入索引樹的指定位置
+ * @param buf 目標緩衝區（索引樹已建立）
+ * @param line_num 插入位置
+ * @param line 新行
+ */
+static void index_insert(buffer_t *buf, size_t line_num, line_t *line);
+
+/**
+ * @brief 從索引樹移除指定位置的行
+ * @param buf 目標緩衝區（索引樹已建立）
+ * @param line_num 行號
+ */
+static void index_remove(buffer_t *buf, size_t line_num);
+
 /* ============================================================================
  * 緩衝區生命週期管理實作
  * ============================================================================ */
@@ -67,8 +135,18 @@ buffer_t *buffer_create(const char *filename) {
     buf->head = NULL;
     buf->tail = NULL;
     buf->line_count = 0;
+    buf->index_root = NULL;
+    buf->index_seed = 0x9e3779b9u;
+    buf->finger_line = NULL;
+    buf->finger_num = 0;
+    buf->load_text = NULL;
+    buf->load_lines = NULL;
+    buf->load_bytes = 0;
+    buf->last_used = 0;
+    buf->evicted = false;
     buf->modified = false;
     buf->read_only = false;
+    buf->memory_backed = false;
     
     /* 建立初始空行（緩衝區至少需要一行） */
     line_t *empty_line = create_line("");
@@ -90,13 +168,8 @@ void buffer_destroy(buffer_t *buf) {
         return;
     }
     
-    /* 遍歷並銷毀所有行 */
-    line_t *line = buf->head;
-    while (line != NULL) {
-        line_t *next = line->next;
-        destroy_line(line);
-        line = next;
-    }
+    /* 銷毀所有行與載入區塊 */
+    clear_lines(buf);
     
     safe_free(buf->filename);
     safe_free(buf);
@@ -112,30 +185,39 @@ static line_t *create_line(const char *text) {
         text = "";
     }
     
+    return create_line_n(text, strlen(text));
+}
+
+static line_t *create_line_n(const char *text, size_t len) {
     /* 計算所需容量（至少為初始容量） */
-    size_t len = strlen(text);
     size_t capacity = (len < INITIAL_LINE_CAPACITY) ? INITIAL_LINE_CAPACITY : len + 1;
     
     /* 配置行結構 */
-    line_t *line = (line_t *)safe_malloc(sizeof(line_t));
+    line_t *line = (line_t *)tagged_malloc(MEM_TAG_BUFFER, sizeof(line_t));
     if (line == NULL) {
         return NULL;
     }
     
     /* 配置文字儲存空間 */
-    line->text = (char *)safe_malloc(capacity);
+    line->text = (char *)tagged_malloc(MEM_TAG_BUFFER, capacity);
     if (line->text == NULL) {
-        safe_free(line);
+        tagged_free(MEM_TAG_BUFFER, line, sizeof(line_t));
         return NULL;
     }
     
     /* 複製文字內容並初始化欄位 */
-    strncpy(line->text, text, len);
+    memcpy(line->text, text, len);
     line->text[len] = '\0';
     line->length = len;
     line->capacity = capacity;
     line->next = NULL;
     line->prev = NULL;
+    line->index_left = NULL;
+    line->index_right = NULL;
+    line->index_size = 1;
+    line->index_priority = 0;
+    line->node_in_arena = false;
+    line->text_in_arena = false;
     
     return line;
 }
@@ -148,10 +230,15 @@ static void destroy_line(line_t *line) {
     /* 安全清除文字內容（防止敏感資料殘留於記憶體） */
     if (line->text != NULL) {
         secure_zero(line->text, line->length);
-        safe_free(line->text);
+        if (!line->text_in_arena) {
+            tagged_free(MEM_TAG_BUFFER, line->text, line->capacity);
+        }
     }
     
-    safe_free(line);
+    /* 載入區塊中的行隨區塊一起釋放 */
+    if (!line->node_in_arena) {
+        tagged_free(MEM_TAG_BUFFER, line, sizeof(line_t));
+    }
 }
 
 static bool expand_line(line_t *line, size_t min_capacity) {
@@ -170,8 +257,22 @@ static bool expand_line(line_t *line, size_t min_capacity) {
         new_capacity = min_capacity;
     }
     
+    /* 載入區塊中的文字無法就地擴展，搬到獨立配置的記憶體 */
+    if (line->text_in_arena) {
+        char *moved = (char *)tagged_malloc(MEM_TAG_BUFFER, new_capacity);
+        if (moved == NULL) {
+            return false;
+        }
+        memcpy(moved, line->text, line->length + 1);
+        secure_zero(line->text, line->length);
+        line->text = moved;
+        line->capacity = new_capacity;
+        line->text_in_arena = false;
+        return true;
+    }
+    
     /* 重新配置記憶體 */
-    char *new_text = (char *)safe_realloc(line->text, new_capacity);
+    char *new_text = (char *)tagged_realloc(MEM_TAG_BUFFER, line->text, line->capacity, new_capacity);
     if (new_text == NULL) {
         return false;
     }
@@ -182,25 +283,157 @@ static bool expand_line(line_t *line, size_t min_capacity) {
     return true;
 }
 
+bool buffer_reserve_line(line_t *line, size_t min_capacity) {
+    return expand_line(line, min_capacity);
+}
+
 /* ============================================================================
- * 檔案輸入/輸出實作
+ * 行號索引樹實作
+ *
+ * 以行在文件中的位置為隱含鍵的 treap：每個節點記錄子樹行數，
+ * 依行號下降即可在 O(log N) 找到目標行；插入與刪除以 split/merge 完成。
+ * 索引樹與鏈結串列串起同一組 line_t，串列仍負責循序走訪。
  * ============================================================================ */
 
-bool buffer_load_from_file(buffer_t *buf, const char *filename) {
-    /* 參數驗證 */
-    if (buf == NULL || filename == NULL) {
-        error_set(ERR_INVALID_INPUT, "參數為 NULL");
-        return false;
+static size_t index_size(const line_t *node) {
+    return node ? node->index_size : 0;
+}
+
+static void index_update(line_t *node) {
+    node->index_size = 1 + index_size(node->index_left) + index_size(node->index_right);
+}
+
+/**
+ * @brief 產生下一個 treap 優先權（xorshift32）
+ */
+static uint32_t index_next_priority(buffer_t *buf) {
+    uint32_t x = buf->index_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    buf->index_seed = x;
+    return x;
+}
+
+/**
+ * @brief 合併兩棵樹（a 的所有行都在 b 之前）
+ */
+static line_t *index_merge(line_t *a, line_t *b) {
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
     }
     
-    /* 開啟檔案 */
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        error_set(ERR_FILE_NOT_FOUND, "無法開啟檔案: %s", filename);
-        return false;
+    if (a->index_priority > b->index_priority) {
+        a->index_right = index_merge(a->index_right, b);
+        index_update(a);
+        return a;
+    }
+    b->index_left = index_merge(a, b->index_left);
+    index_update(b);
+    return b;
+}
+
+/**
+ * @brief 將樹分割為前 count 行與其餘行
+ */
+static void index_split(line_t *node, size_t count, line_t **left, line_t **right) {
+    if (node == NULL) {
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+    
+    size_t left_size = index_size(node->index_left);
+    if (count <= left_size) {
+        index_split(node->index_left, count, left, &node->index_left);
+        index_update(node);
+        *right = node;
+    } else {
+        index_split(node->index_right, count - left_size - 1, &node->index_right, right);
+        index_update(node);
+        *left = node;
+    }
+}
+
+static void index_reset(buffer_t *buf) {
+    buf->index_root = NULL;
+}
+
+static bool index_build(buffer_t *buf) {
+    buf->index_root = index_build_chain(buf, buf->head, buf->line_count);
+    return buf->index_root != NULL;
+}
+
+static line_t *index_build_chain(buffer_t *buf, line_t *first, size_t count) {
+    if (count == 0) {
+        return NULL;
+    }
+    
+    /* 以堆疊在 O(N) 內依序建立笛卡兒樹（Cartesian tree） */
+    line_t **stack = (line_t **)safe_malloc(sizeof(line_t *) * count);
+    if (stack == NULL) {
+        error_clear();
+        return NULL;
     }
     
-    /* 清空現有內容 */
+    size_t depth = 0;
+    line_t *line = first;
+    for (size_t i = 0; i < count; i++, line = line->next) {
+        line->index_priority = index_next_priority(buf);
+        line->index_left = NULL;
+        line->index_right = NULL;
+        
+        /* 彈出優先權較低的節點，它們成為新節點的左子樹 */
+        line_t *last = NULL;
+        while (depth > 0 && stack[depth - 1]->index_priority < line->index_priority) {
+            last = stack[--depth];
+            index_update(last);
+        }
+        line->index_left = last;
+        if (depth > 0) {
+            stack[depth - 1]->index_right = line;
+        }
+        stack[depth++] = line;
+    }
+    
+    /* 堆疊中剩下的是最右側路徑，由下往上更新子樹大小 */
+    while (depth > 1) {
+        index_update(stack[--depth]);
+    }
+    index_update(stack[0]);
+    
+    line_t *root = stack[0];
+    safe_free(stack);
+    return root;
+}
+
+static void index_insert(buffer_t *buf, size_t line_num, line_t *line) {
+    line_t *left = NULL;
+    line_t *right = NULL;
+    
+    line->index_priority = index_next_priority(buf);
+    index_split(buf->index_root, line_num, &left, &right);
+    buf->index_root = index_merge(index_merge(left, line), right);
+}
+
+static void index_remove(buffer_t *buf, size_t line_num) {
+    line_t *left = NULL;
+    line_t *middle = NULL;
+    line_t *right = NULL;
+    
+    index_split(buf->index_root, line_num, &left, &right);
+    index_split(right, 1, &middle, &right);
+    buf->index_root = index_merge(left, right);
+}
+
+/* ============================================================================
+ * 載入輔助函式實作
+ * ============================================================================ */
+
+static void clear_lines(buffer_t *buf) {
     line_t *line = buf->head;
     while (line != NULL) {
         line_t *next = line->next;
@@ -208,60 +441,178 @@ bool buffer_load_from_file(buffer_t *buf, const char *filename) {
         line = next;
     }
     
+    /* 行已逐一清除內容，載入區塊可直接釋放 */
+    if (buf->load_bytes > 0) {
+        mem_account_free(MEM_TAG_BUFFER, buf->load_bytes);
+    }
+    safe_free(buf->load_lines);
+    safe_free(buf->load_text);
+    buf->load_lines = NULL;
+    buf->load_text = NULL;
+    buf->load_bytes = 0;
+    
     buf->head = NULL;
     buf->tail = NULL;
     buf->line_count = 0;
+    buf->finger_line = NULL;
+    index_reset(buf);
+}
+
+static bool load_arena(buffer_t *buf, char *data, size_t size) {
+    /* 結尾的換行不產生額外的空行 */
+    size_t text_size = (size > 0 && data[size - 1] == '\n') ? size - 1 : size;
+    char *end = data + text_size;
     
-    /* 逐行讀取檔案 */
-    char *line_buffer = NULL;
-    size_t buffer_size = 0;
-    ssize_t read_len;
+    /* 第一次掃描：以 memchr（標準函式庫以 SIMD 實作）計算行數 */
+    size_t count = (size > 0) ? 1 : 0;
+    for (const char *p = data; p < end && (p = (const char *)memchr(p, '\n', (size_t)(end - p))) != NULL; p++) {
+        count++;
+    }
+    if (count == 0) {
+        safe_free(data);
+        return ensure_one_line(buf);
+    }
     
-    while ((read_len = getline(&line_buffer, &buffer_size, file)) != -1) {
-        /* 移除行尾的換行符號 */
-        if (read_len > 0 && line_buffer[read_len - 1] == '\n') {
-            line_buffer[read_len - 1] = '\0';
-            read_len--;
-        }
+    line_t *lines = (line_t *)safe_calloc(count, sizeof(line_t));
+    if (lines == NULL) {
+        safe_free(data);
+        ensure_one_line(buf);
+        return false;
+    }
+    
+    /* 第二次掃描：把換行換成 '\0'，各行文字直接指向區塊內 */
+    *end = '\0';
+    char *p = data;
+    for (size_t i = 0; i < count; i++) {
+        char *newline = (i + 1 < count) ? (char *)memchr(p, '\n', (size_t)(end - p)) : end;
+        *newline = '\0';
         
-        /* 建立新行並加入鏈結串列 */
-        line_t *new_line = create_line(line_buffer);
-        if (new_line == NULL) {
-            free(line_buffer);
-            fclose(file);
-            return false;
-        }
+        line_t *line = &lines[i];
+        line->text = p;
+        line->length = (size_t)(newline - p);
+        line->capacity = line->length + 1;
+        line->prev = (i > 0) ? &lines[i - 1] : NULL;
+        line->next = (i + 1 < count) ? &lines[i + 1] : NULL;
+        line->index_size = 1;
+        line->node_in_arena = true;
+        line->text_in_arena = true;
         
-        /* 將新行接到串列尾端 */
-        if (buf->head == NULL) {
-            buf->head = new_line;
-            buf->tail = new_line;
-        } else {
-            new_line->prev = buf->tail;
-            buf->tail->next = new_line;
-            buf->tail = new_line;
+        p = newline + 1;
+    }
+    
+    buf->head = &lines[0];
+    buf->tail = &lines[count - 1];
+    buf->line_count = count;
+    buf->load_text = data;
+    buf->load_lines = lines;
+    buf->load_bytes = size + 1 + count * sizeof(line_t);
+    mem_account_alloc(MEM_TAG_BUFFER, buf->load_bytes);
+    return true;
+}
+
+/**
+ * @brief 將已開啟的檔案整個讀入單一區塊
+ *
+ * 一般檔案依大小一次配置；大小未知（如管線）或讀取期間變長時倍增擴展。
+ *
+ * @param file 已開啟的檔案
+ * @param size 輸出參數，內容大小
+ * @return 內容（配置大小至少為 size + 1），失敗回傳 NULL 並設定錯誤訊息
+ */
+static char *read_whole_file(FILE *file, size_t *size) {
+    struct stat st;
+    size_t capacity = 4096;
+    if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        capacity = (size_t)st.st_size + 1;
+    }
+    
+    /* 大區塊由 calloc 直接取得已清零的分頁，不需額外的清零掃描 */
+    char *data = (char *)safe_calloc(capacity, 1);
+    if (data == NULL) {
+        return NULL;
+    }
+    
+    size_t used = 0;
+    for (;;) {
+        used += fread(data + used, 1, capacity - 1 - used, file);
+        if (used < capacity - 1) {
+            break;
         }
         
-        buf->line_count++;
+        char *grown = (char *)safe_realloc(data, capacity * 2);
+        if (grown == NULL) {
+            secure_zero(data, used);
+            safe_free(data);
+            return NULL;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+    
+    if (ferror(file)) {
+        secure_zero(data, used);
+        safe_free(data);
+        error_set(ERR_IO_ERROR, "讀取檔案失敗");
+        return NULL;
+    }
+    
+    *size = used;
+    return data;
+}
+
+static bool ensure_one_line(buffer_t *buf) {
+    if (buf->head != NULL) {
+        return true;
+    }
+    
+    line_t *empty_line = create_line("");
+    if (empty_line == NULL) {
+        return false;
+    }
+    buf->head = empty_line;
+    buf->tail = empty_line;
+    buf->line_count = 1;
+    return true;
+}
+
+/* ============================================================================
+ * 檔案輸入/輸出實作
+ * ============================================================================ */
+
+bool buffer_load_from_file(buffer_t *buf, const char *filename) {
+    /* 參數驗證 */
+    if (buf == NULL || filename == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    /* 開啟檔案 */
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        error_set(ERR_FILE_NOT_FOUND, "無法開啟檔案: %s", filename);
+        return false;
     }
     
-    free(line_buffer);
+    /* 整個檔案一次讀入 */
+    size_t size = 0;
+    char *data = read_whole_file(file, &size);
     fclose(file);
+    if (data == NULL) {
+        return false;
+    }
     
-    /* 確保至少有一行（空檔案的情況） */
-    if (buf->head == NULL) {
-        line_t *empty_line = create_line("");
-        if (empty_line == NULL) {
-            return false;
-        }
-        buf->head = empty_line;
-        buf->tail = empty_line;
-        buf->line_count = 1;
+    /* 清空現有內容並就地切分行（空檔案會得到一個空行） */
+    clear_lines(buf);
+    if (!load_arena(buf, data, size)) {
+        return false;
     }
+    buf->evicted = false;
     
-    /* 更新檔案名稱並清除修改標記 */
-    safe_free(buf->filename);
-    buf->filename = safe_strdup(filename);
+    /* 更新檔案名稱並清除修改標記（filename 可能就是 buf->filename） */
+    if (filename != buf->filename) {
+        safe_free(buf->filename);
+        buf->filename = safe_strdup(filename);
+    }
     buf->modified = false;
     
     return true;
@@ -312,6 +663,70 @@ bool buffer_save_to_file(buffer_t *buf, const char *filename) {
     return true;
 }
 
+/* ============================================================================
+ * 記憶體輸入/輸出實作
+ * ============================================================================ */
+
+bool buffer_load_from_memory(buffer_t *buf, const char *data, size_t size) {
+    /* 參數驗證 */
+    if (buf == NULL || (data == NULL && size > 0)) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    /* 複製到單一載入區塊後就地切分行 */
+    char *copy = (char *)safe_calloc(size + 1, 1);
+    if (copy == NULL) {
+        return false;
+    }
+    if (size > 0) {
+        memcpy(copy, data, size);
+    }
+    
+    clear_lines(buf);
+    if (!load_arena(buf, copy, size)) {
+        return false;
+    }
+    buf->evicted = false;
+    
+    buf->modified = false;
+    return true;
+}
+
+char *buffer_serialize_to_memory(const buffer_t *buf, size_t *size) {
+    /* 參數驗證 */
+    if (buf == NULL || size == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    /* 先計算總長度，只配置一次 */
+    size_t total = 0;
+    for (const line_t *line = buf->head; line != NULL; line = line->next) {
+        if (line->length > SIZE_MAX - total - 2) {
+            error_set(ERR_MEMORY, "緩衝區內容過大");
+            return NULL;
+        }
+        total += line->length + 1;
+    }
+    
+    char *data = (char *)safe_malloc_uninit(total + 1);
+    if (data == NULL) {
+        return NULL;
+    }
+    
+    char *out = data;
+    for (const line_t *line = buf->head; line != NULL; line = line->next) {
+        memcpy(out, line->text, line->length);
+        out += line->length;
+        *out++ = '\n';
+    }
+    *out = '\0';
+    
+    *size = total;
+    return data;
+}
+
 /* ============================================================================
  * 行操作實作
  * ============================================================================ */
@@ -378,6 +793,18 @@ bool buffer_insert_line(buffer_t *buf, size_t line_num, const char *text) {
         }
     }
     
+    /* 同步維護索引樹（插入到最後面時 line_num 可能超出範圍） */
+    if (line_num > buf->line_count) {
+        line_num = buf->line_count;
+    }
+    if (buf->index_root != NULL) {
+        index_insert(buf, line_num, new_line);
+    }
+    
+    /* 新行即為最近存取的位置，其後行號的快取已失效 */
+    buf->finger_line = new_line;
+    buf->finger_num = line_num;
+    
     buf->line_count++;
     buf->modified = true;
     
@@ -407,11 +834,17 @@ bool buffer_delete_line(buffer_t *buf, size_t line_num) {
         return true;
     }
     
-    /* 取得要刪除的行 */
+    /* 取得要刪除的行（行號超出範圍時為最後一行） */
     line_t *line = buffer_get_line(buf, line_num);
     if (line == NULL) {
         return false;
     }
+    if (line_num >= buf->line_count) {
+        line_num = buf->line_count - 1;
+    }
+    if (buf->index_root != NULL) {
+        index_remove(buf, line_num);
+    }
     
     /* 調整鏈結關係 */
     if (line->prev != NULL) {
@@ -426,6 +859,15 @@ bool buffer_delete_line(buffer_t *buf, size_t line_num) {
         buf->tail = line->prev;
     }
     
+    /* 游標快取改指向取代被刪除行位置的鄰行 */
+    if (line->next != NULL) {
+        buf->finger_line = line->next;
+        buf->finger_num = line_num;
+    } else {
+        buf->finger_line = line->prev;
+        buf->finger_num = line_num - 1;
+    }
+    
     /* 銷毀該行並更新計數 */
     destroy_line(line);
     buf->line_count--;
@@ -434,6 +876,141 @@ bool buffer_delete_line(buffer_t *buf, size_t line_num) {
     return true;
 }
 
+bool buffer_splice_lines(buffer_t *buf, size_t line_num, size_t delete_count,
+                         const char *text, size_t len) {
+    /* 參數驗證 */
+    if (buf == NULL) {
+        error_set(ERR_INVALID_INPUT, "緩衝區為 NULL");
+        return false;
+    }
+    
+    /* 檢查唯讀狀態 */
+    if (buf->read_only) {
+        error_set(ERR_PERMISSION, "緩衝區為唯讀");
+        return false;
+    }
+    
+    if (line_num > buf->line_count) {
+        line_num = buf->line_count;
+    }
+    if (delete_count > buf->line_count - line_num) {
+        delete_count = buf->line_count - line_num;
+    }
+    
+    /* 先建立所有新行，配置失敗時緩衝區維持原狀 */
+    line_t *first_new = NULL;
+    line_t *last_new = NULL;
+    size_t insert_count = 0;
+    if (text != NULL) {
+        const char *p = text;
+        const char *end = text + len;
+        for (;;) {
+            const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+            size_t seg_len = (newline != NULL) ? (size_t)(newline - p) : (size_t)(end - p);
+            
+            line_t *line = create_line_n(p, seg_len);
+            if (line == NULL) {
+                while (first_new != NULL) {
+                    line_t *next = first_new->next;
+                    destroy_line(first_new);
+                    first_new = next;
+                }
+                return false;
+            }
+            line->prev = last_new;
+            if (last_new != NULL) {
+                last_new->next = line;
+            } else {
+                first_new = line;
+            }
+            last_new = line;
+            insert_count++;
+            
+            if (newline == NULL) {
+                break;
+            }
+            p = newline + 1;
+        }
+    }
+    
+    if (delete_count == 0 && insert_count == 0) {
+        return true;
+    }
+    
+    /* 找出拼接點：before 之後、after 之前 */
+    line_t *before = (line_num > 0) ? buffer_get_line(buf, line_num - 1) : NULL;
+    line_t *removed = (before != NULL) ? before->next : buf->head;
+    line_t *after = removed;
+    for (size_t i = 0; i < delete_count; i++) {
+        after = after->next;
+    }
+    
+    /* 同步維護索引樹：切出被刪除的區段並換成新行的子樹 */
+    if (buf->index_root != NULL) {
+        line_t *left = NULL;
+        line_t *middle = NULL;
+        line_t *right = NULL;
+        index_split(buf->index_root, line_num, &left, &right);
+        index_split(right, delete_count, &middle, &right);
+        
+        line_t *inserted = index_build_chain(buf, first_new, insert_count);
+        if (inserted == NULL && insert_count > 0) {
+            buf->index_root = NULL;  /* 記憶體不足，之後查詢時重建 */
+        } else {
+            buf->index_root = index_merge(index_merge(left, inserted), right);
+        }
+    }
+    
+    /* 銷毀被刪除的行 */
+    while (removed != after) {
+        line_t *next = removed->next;
+        destroy_line(removed);
+        removed = next;
+    }
+    
+    /* 接上新行（沒有新行時直接連接兩端） */
+    line_t *chain_head = (first_new != NULL) ? first_new : after;
+    line_t *chain_tail = (last_new != NULL) ? last_new : before;
+    if (before != NULL) {
+        before->next = chain_head;
+    } else {
+        buf->head = chain_head;
+    }
+    if (chain_head != NULL) {
+        chain_head->prev = before;
+    }
+    if (after != NULL) {
+        after->prev = chain_tail;
+    } else {
+        buf->tail = chain_tail;
+    }
+    if (chain_tail != NULL) {
+        chain_tail->next = after;
+    }
+    
+    buf->line_count = buf->line_count - delete_count + insert_count;
+    buf->modified = true;
+    
+    /* 緩衝區至少保留一行 */
+    if (buf->head == NULL) {
+        index_reset(buf);
+        if (!ensure_one_line(buf)) {
+            return false;
+        }
+    }
+    
+    /* 游標快取指向拼接位置的行 */
+    if (line_num < buf->line_count) {
+        buf->finger_line = (first_new != NULL) ? first_new : (after != NULL ? after : buf->tail);
+        buf->finger_num = line_num;
+    } else {
+        buf->finger_line = buf->tail;
+        buf->finger_num = buf->line_count - 1;
+    }
+    
+    return true;
+}
+
 line_t *buffer_get_line(buffer_t *buf, size_t line_num) {
     /* 參數驗證 */
     if (buf == NULL || buf->head == NULL) {
@@ -445,12 +1022,59 @@ line_t *buffer_get_line(buffer_t *buf, size_t line_num) {
         return buf->tail;
     }
     
-    /* 從頭遍歷到指定行 */
-    line_t *line = buf->head;
-    for (size_t i = 0; i < line_num && line != NULL; i++) {
-        line = line->next;
+    line_t *line = NULL;
+    
+    if (buf->finger_line != NULL &&
+        (line_num >= buf->finger_num ? line_num - buf->finger_num
+                                     : buf->finger_num - line_num) <= BUFFER_FINGER_DISTANCE) {
+        /* 游標附近：從上次命中的行相對走訪 */
+        line = buf->finger_line;
+        for (size_t i = buf->finger_num; i < line_num; i++) {
+            line = line->next;
+        }
+        for (size_t i = buf->finger_num; i > line_num; i--) {
+            line = line->prev;
+        }
+    } else {
+        /* 大型緩衝區：首次查詢時建立索引樹 */
+        if (buf->index_root == NULL && buf->line_count > BUFFER_INDEX_THRESHOLD) {
+            index_build(buf);
+        }
+        
+        if (buf->index_root != NULL) {
+            /* 依子樹行數下降到目標行 */
+            line_t *node = buf->index_root;
+            size_t rank = line_num;
+            while (node != NULL) {
+                size_t left_size = index_size(node->index_left);
+                if (rank < left_size) {
+                    node = node->index_left;
+                } else if (rank == left_size) {
+                    break;
+                } else {
+                    rank -= left_size + 1;
+                    node = node->index_right;
+                }
+            }
+            line = node;
+        } else if (line_num < buf->line_count / 2) {
+            /* 小型緩衝區：從較近的一端遍歷到指定行 */
+            line = buf->head;
+            for (size_t i = 0; i < line_num && line != NULL; i++) {
+                line = line->next;
+            }
+        } else {
+            line = buf->tail;
+            for (size_t i = buf->line_count - 1; i > line_num && line != NULL; i--) {
+                line = line->prev;
+            }
+        }
     }
     
+    if (line != NULL) {
+        buf->finger_line = line;
+        buf->finger_num = line_num;
+    }
     return line;
 }
 
@@ -533,6 +1157,45 @@ bool buffer_delete_char(buffer_t *buf, size_t line_num, size_t col) {
  * 狀態查詢與設定實作
  * ============================================================================ */
 
+size_t buffer_memory_usage(const buffer_t *buf) {
+    if (buf == NULL) {
+        return 0;
+    }
+    
+    /* 載入區塊整塊計算，其餘行結構與文字各自計算 */
+    size_t total = sizeof(buffer_t) + buf->load_bytes;
+    for (const line_t *line = buf->head; line != NULL; line = line->next) {
+        if (!line->node_in_arena) {
+            total += sizeof(line_t);
+        }
+        if (!line->text_in_arena) {
+            total += line->capacity;
+        }
+    }
+    return total;
+}
+
+bool buffer_evict(buffer_t *buf) {
+    /* 參數驗證 */
+    if (buf == NULL) {
+        error_set(ERR_INVALID_INPUT, "緩衝區為 NULL");
+        return false;
+    }
+    
+    /* 未儲存的修改無法從檔案還原 */
+    if (buf->modified) {
+        error_set(ERR_INVALID_INPUT, "緩衝區有未儲存的修改");
+        return false;
+    }
+    
+    clear_lines(buf);
+    if (!ensure_one_line(buf)) {
+        return false;
+    }
+    buf->evicted = true;
+    return true;
+}
+
 size_t buffer_get_line_count(buffer_t *buf) {
     return buf ? buf->line_count : 0;
 }
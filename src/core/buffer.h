@@ -9,6 +9,8 @@
  *   - 採用鏈結串列而非陣列，以支援頻繁的行插入/刪除
  *   - 每行獨立管理記憶體，避免大區塊重新配置
  *   - 支援安全的記憶體清除（防止敏感資料殘留）
+ *   - 大型緩衝區另以行號索引樹（implicit treap）串起同一組行，
+ *     依行號查詢、插入與刪除皆為 O(log N)
  */
 
 #ifndef BUFFER_H
@@ -16,11 +18,28 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* ============================================================================
  * 資料結構定義
  * ============================================================================ */
 
+/**
+ * @brief 建立行號索引樹的行數門檻
+ *
+ * 行數超過此值的緩衝區在首次依行號查詢時建立索引樹，之後隨插入/刪除維護；
+ * 小型緩衝區直接走訪鏈結串列。
+ */
+#define BUFFER_INDEX_THRESHOLD 256
+
+/**
+ * @brief 從游標快取（finger）相對走訪的最大距離
+ *
+ * 查詢的行號與上次命中的行相距不超過此值時，直接沿鏈結串列走訪，
+ * 讓游標附近的存取（j/k、捲動、畫面重繪）為 O(距離)。
+ */
+#define BUFFER_FINGER_DISTANCE 64
+
 /**
  * @brief 文字行結構
  * 
@@ -33,6 +52,12 @@ typedef struct line {
     size_t capacity;         /**< 已配置的記憶體容量 */
     struct line *next;       /**< 指向下一行的指標 */
     struct line *prev;       /**< 指向上一行的指標 */
+    struct line *index_left;  /**< 行號索引樹：左子樹（較前面的行） */
+    struct line *index_right; /**< 行號索引樹：右子樹（較後面的行） */
+    size_t index_size;       /**< 行號索引樹：子樹行數 */
+    uint32_t index_priority; /**< 行號索引樹：treap 優先權 */
+    bool node_in_arena;      /**< 行結構位於緩衝區的載入區塊（不可個別釋放） */
+    bool text_in_arena;      /**< 文字位於緩衝區的載入區塊（擴展時會先搬到獨立配置） */
 } line_t;
 
 /**
@@ -46,8 +71,18 @@ typedef struct {
     line_t *head;            /**< 指向第一行的指標 */
     line_t *tail;            /**< 指向最後一行的指標 */
     size_t line_count;       /**< 總行數 */
+    line_t *index_root;      /**< 行號索引樹根節點（NULL 表示未建立） */
+    uint32_t index_seed;     /**< 產生 treap 優先權的亂數狀態 */
+    line_t *finger_line;     /**< 上次查詢命中的行（NULL 表示無快取） */
+    size_t finger_num;       /**< finger_line 的行號 */
+    char *load_text;         /**< 載入區塊：所有行的文字（就地以 '\0' 分隔） */
+    line_t *load_lines;      /**< 載入區塊：所有行的結構陣列 */
+    size_t load_bytes;       /**< 載入區塊的總配置大小 */
+    size_t last_used;        /**< 最近使用的時序（由擁有者的緩衝區管理維護） */
+    bool evicted;            /**< 內容已釋放，只保留檔名（由擁有者重新載入） */
     bool modified;           /**< 是否有未儲存的修改 */
     bool read_only;          /**< 是否為唯讀模式 */
+    bool memory_backed;      /**< 內容不對應主機檔案（如 VFS 節點），由擁有者負責存回 */
 } buffer_t;
 
 /* ============================================================================
@@ -85,6 +120,9 @@ void buffer_destroy(buffer_t *buf);
  * 讀取指定檔案的內容，取代緩衝區現有的所有內容。
  * 載入後會清除修改標記。
  * 
+ * 整個檔案一次讀入單一區塊，以 memchr 找出換行後就地切分，
+ * 所有行結構也一次配置；之後刪除的行要到下次載入或銷毀緩衝區時才會釋放。
+ * 
  * @param buf 目標緩衝區
  * @param filename 要載入的檔案路徑
  * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
@@ -105,6 +143,34 @@ bool buffer_load_from_file(buffer_t *buf, const char *filename);
  */
 bool buffer_save_to_file(buffer_t *buf, const char *filename);
 
+/**
+ * @brief 從記憶體載入內容到緩衝區
+ * 
+ * 以換行符號切分 data，取代緩衝區現有的所有內容；
+ * 結尾的換行不會產生額外的空行。載入後會清除修改標記，檔案名稱不變。
+ * 內容會複製到與 buffer_load_from_file() 相同的載入區塊。
+ * 
+ * @param buf 目標緩衝區
+ * @param data 文字內容（可為 NULL，此時 size 必須為 0）
+ * @param size 內容大小（位元組）
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ * 
+ * @warning 此操作會清除緩衝區現有內容
+ */
+bool buffer_load_from_memory(buffer_t *buf, const char *data, size_t size);
+
+/**
+ * @brief 將緩衝區內容序列化為連續記憶體
+ * 
+ * 格式與 buffer_save_to_file() 相同：每行以換行符號結尾。
+ * 回傳的記憶體額外以 '\0' 結尾（不計入 size），不會清除修改標記。
+ * 
+ * @param buf 來源緩衝區
+ * @param size 輸出參數，內容大小（位元組）
+ * @return 內容（需由呼叫者釋放），失敗回傳 NULL 並設定錯誤訊息
+ */
+char *buffer_serialize_to_memory(const buffer_t *buf, size_t *size);
+
 /* ============================================================================
  * 行操作
  * ============================================================================ */
@@ -136,15 +202,49 @@ bool buffer_insert_line(buffer_t *buf, size_t line_num, const char *text);
  */
 bool buffer_delete_line(buffer_t *buf, size_t line_num);
 
+/**
+ * @brief 以單一次拼接取代連續的多行
+ * 
+ * 移除從 line_num 開始的 delete_count 行，並在同一位置插入 text 以 '\n'
+ * 切分出的各行（n 個換行產生 n + 1 行）。所有新行先配置完成才修改緩衝區，
+ * 鏈結串列只拼接一次，索引樹以 split/merge 整段替換，
+ * 因此成本與異動的行數成正比，而非對每一行重複查詢。
+ * 
+ * @param buf 目標緩衝區
+ * @param line_num 起始行號（超過總行數時視為尾端）
+ * @param delete_count 要移除的行數（超出部分忽略）
+ * @param text 新行內容（NULL 表示不插入任何行，"" 插入一個空行）
+ * @param len text 的長度
+ * @return 成功回傳 true，失敗回傳 false 且緩衝區不變
+ * 
+ * @note 緩衝區至少會保留一行（空行）
+ */
+bool buffer_splice_lines(buffer_t *buf, size_t line_num, size_t delete_count,
+                         const char *text, size_t len);
+
 /**
  * @brief 取得指定行的指標
  * 
+ * 與上次查詢的行相距不超過 BUFFER_FINGER_DISTANCE 時從該行相對走訪，
+ * 否則大型緩衝區經由行號索引樹查詢，為 O(log N)。
+ * 
  * @param buf 來源緩衝區
  * @param line_num 行號（從 0 開始）
  * @return 該行的指標，若行號無效則回傳最後一行或 NULL
  */
 line_t *buffer_get_line(buffer_t *buf, size_t line_num);
 
+/**
+ * @brief 確保行的文字容量至少為 min_capacity
+ * 
+ * 位於載入區塊的文字會先搬到獨立配置的記憶體。
+ * 
+ * @param line 目標行
+ * @param min_capacity 最小需要的容量（含結尾的 '\0'）
+ * @return 成功回傳 true，失敗回傳 false
+ */
+bool buffer_reserve_line(line_t *line, size_t min_capacity);
+
 /* ============================================================================
  * 字元操作
  * ============================================================================ */
@@ -180,6 +280,27 @@ bool buffer_delete_char(buffer_t *buf, size_t line_num, size_t col);
  * 狀態查詢與設定
  * ============================================================================ */
 
+/**
+ * @brief 估計緩衝區內容佔用的記憶體
+ * 
+ * 包含行結構、各行文字的配置容量與載入區塊；走訪所有行，為 O(N)。
+ * 
+ * @param buf 來源緩衝區
+ * @return 位元組數，若 buf 為 NULL 則回傳 0
+ */
+size_t buffer_memory_usage(const buffer_t *buf);
+
+/**
+ * @brief 釋放緩衝區內容，只保留檔名等元資料
+ * 
+ * 釋放後緩衝區只剩一個空行並設定 evicted，擁有者需在使用前重新載入
+ * （任一載入函式都會清除 evicted）。
+ * 
+ * @param buf 目標緩衝區
+ * @return 成功回傳 true；有未儲存的修改時回傳 false 並設定錯誤訊息
+ */
+bool buffer_evict(buffer_t *buf);
+
 /**
  * @brief 取得緩衝區總行數
  * @param buf 來源緩衝區
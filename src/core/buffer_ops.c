@@ -10,48 +10,9 @@
 #include "../utils/memory.h"
 #include "../utils/error.h"
 #include <string.h>
+#include <stdint.h>
 #include <ctype.h>
 
-/* ============================================================================
- * 私有輔助函式
- * ============================================================================ */
-
-/**
- * @brief 擴展行的容量（內部使用）
- * 
- * 與 buffer.c 中的 expand_line 邏輯相同，
- * 因為該函式為 static，故在此複製實作。
- * 
- * @param line 目標行
- * @param min_capacity 最小需要的容量
- * @return 成功回傳 true，失敗回傳 false
- */
-static bool expand_line_internal(line_t *line, size_t min_capacity) {
-    if (line == NULL) {
-        return false;
-    }
-    
-    /* 若現有容量已足夠，無需擴展 */
-    if (line->capacity >= min_capacity) {
-        return true;
-    }
-    
-    /* 採用倍增策略 */
-    size_t new_capacity = line->capacity * 2;
-    if (new_capacity < min_capacity) {
-        new_capacity = min_capacity;
-    }
-    
-    char *new_text = (char *)safe_realloc(line->text, new_capacity);
-    if (new_text == NULL) {
-        return false;
-    }
-    
-    line->text = new_text;
-    line->capacity = new_capacity;
-    return true;
-}
-
 /* ============================================================================
  * 字元分類輔助函式實作
  * ============================================================================ */
@@ -105,7 +66,7 @@ bool buffer_join_lines(buffer_t *buf, size_t line_num) {
     
     /* 計算合併後的長度並擴展容量 */
     size_t new_len = line1->length + line2->length;
-    if (!expand_line_internal(line1, new_len + 1)) {
+    if (!buffer_reserve_line(line1, new_len + 1)) {
         return false;
     }
     
@@ -370,7 +331,7 @@ bool buffer_insert_text(buffer_t *buf, size_t line_num, size_t col, const char *
     size_t text_len = strlen(text);
     
     /* 擴展容量 */
-    if (!expand_line_internal(line, line->length + text_len + 1)) {
+    if (!buffer_reserve_line(line, line->length + text_len + 1)) {
         return false;
     }
     
@@ -399,7 +360,7 @@ bool buffer_replace_text(buffer_t *buf, size_t line_num, size_t col_start, size_
     
     /* 若長度有變化，需要調整記憶體 */
     if (diff != 0) {
-        if (!expand_line_internal(line, line->length + diff + 1)) {
+        if (!buffer_reserve_line(line, line->length + diff + 1)) {
             return false;
         }
         memmove(line->text + col_end + diff, line->text + col_end, line->length - col_end + 1);
@@ -415,6 +376,186 @@ bool buffer_replace_text(buffer_t *buf, size_t line_num, size_t col_start, size_
     return true;
 }
 
+/* ============================================================================
+ * 區塊操作實作
+ * ============================================================================ */
+
+bool buffer_insert_block(buffer_t *buf, size_t line_num, size_t col, const char *text, size_t len) {
+    /* 參數驗證 */
+    if (buf == NULL || buf->read_only || (text == NULL && len > 0)) {
+        return false;
+    }
+    
+    line_t *line = buffer_get_line(buf, line_num);
+    if (line == NULL) {
+        return false;
+    }
+    if (line_num >= buf->line_count) {
+        line_num = buf->line_count - 1;
+    }
+    if (col > line->length) {
+        col = line->length;
+    }
+    
+    const char *first_newline = (len > 0) ? (const char *)memchr(text, '\n', len) : NULL;
+    if (first_newline == NULL) {
+        /* 單行：一次擴展容量後插入 */
+        if (!buffer_reserve_line(line, line->length + len + 1)) {
+            return false;
+        }
+        memmove(line->text + col + len, line->text + col, line->length - col + 1);
+        if (len > 0) {
+            memcpy(line->text + col, text, len);
+        }
+        line->length += len;
+        buf->modified = true;
+        return true;
+    }
+    
+    size_t first_len = (size_t)(first_newline - text);
+    size_t suffix_len = line->length - col;
+    
+    /* 先保留原本 col 之後的文字，稍後接到最後一個新行 */
+    char *suffix = (char *)safe_malloc(suffix_len + 1);
+    if (suffix == NULL) {
+        return false;
+    }
+    memcpy(suffix, line->text + col, suffix_len);
+    
+    if (!buffer_reserve_line(line, col + first_len + 1)) {
+        safe_free(suffix);
+        return false;
+    }
+    
+    /* 其餘各段一次拼接到目前行之後 */
+    const char *rest = first_newline + 1;
+    size_t rest_len = len - first_len - 1;
+    size_t new_lines = 1;
+    for (const char *p = rest; (p = (const char *)memchr(p, '\n', (size_t)(text + len - p))) != NULL; p++) {
+        new_lines++;
+    }
+    if (!buffer_splice_lines(buf, line_num + 1, 0, rest, rest_len)) {
+        safe_free(suffix);
+        return false;
+    }
+    
+    /* 目前行保留前段並接上第一段 */
+    memcpy(line->text + col, text, first_len);
+    line->length = col + first_len;
+    line->text[line->length] = '\0';
+    
+    /* 最後一個新行接上原本的後段 */
+    line_t *last = buffer_get_line(buf, line_num + new_lines);
+    bool ok = true;
+    if (suffix_len > 0) {
+        ok = buffer_reserve_line(last, last->length + suffix_len + 1);
+        if (ok) {
+            memcpy(last->text + last->length, suffix, suffix_len);
+            last->length += suffix_len;
+            last->text[last->length] = '\0';
+        }
+    }
+    
+    safe_free(suffix);
+    buf->modified = true;
+    return ok;
+}
+
+bool buffer_delete_range(buffer_t *buf, size_t start_row, size_t start_col, size_t end_row, size_t end_col) {
+    /* 參數驗證 */
+    if (buf == NULL || buf->read_only || end_row < start_row || start_row >= buf->line_count) {
+        return false;
+    }
+    if (end_row >= buf->line_count) {
+        end_row = buf->line_count - 1;
+        end_col = SIZE_MAX;
+    }
+    
+    line_t *first = buffer_get_line(buf, start_row);
+    line_t *last = buffer_get_line(buf, end_row);
+    if (first == NULL || last == NULL) {
+        return false;
+    }
+    if (start_col > first->length) {
+        start_col = first->length;
+    }
+    if (end_col > last->length) {
+        end_col = last->length;
+    }
+    
+    if (start_row == end_row) {
+        /* 同一行：直接移動後段文字 */
+        if (end_col < start_col) {
+            return false;
+        }
+        memmove(first->text + start_col, first->text + end_col, first->length - end_col + 1);
+        first->length -= end_col - start_col;
+        buf->modified = true;
+        return true;
+    }
+    
+    /* 起始行的前段接上結束行的後段，再一次移除中間與結束行 */
+    size_t tail_len = last->length - end_col;
+    if (!buffer_reserve_line(first, start_col + tail_len + 1)) {
+        return false;
+    }
+    memcpy(first->text + start_col, last->text + end_col, tail_len);
+    first->length = start_col + tail_len;
+    first->text[first->length] = '\0';
+    
+    return buffer_splice_lines(buf, start_row + 1, end_row - start_row, NULL, 0);
+}
+
+bool buffer_replace_block(buffer_t *buf, size_t start_row, size_t row_count,
+                          size_t col_start, size_t col_end, const char *text, size_t len) {
+    /* 參數驗證 */
+    if (buf == NULL || buf->read_only || col_end < col_start || start_row >= buf->line_count) {
+        return false;
+    }
+    if (text == NULL) {
+        len = 0;
+    }
+    
+    line_t *line = buffer_get_line(buf, start_row);
+    const char *seg = text;
+    const char *end = (text != NULL) ? text + len : NULL;
+    
+    /* 沿鏈結串列逐行處理，每行只移動一次後段文字 */
+    for (size_t i = 0; i < row_count && line != NULL; i++, line = line->next) {
+        size_t seg_len = 0;
+        if (seg != NULL && seg < end) {
+            const char *newline = (const char *)memchr(seg, '\n', (size_t)(end - seg));
+            seg_len = (newline != NULL) ? (size_t)(newline - seg) : (size_t)(end - seg);
+        }
+        
+        if (line->length < col_start && seg_len == 0) {
+            /* 行太短且沒有新文字：此行不受影響 */
+        } else {
+            size_t pad = (line->length < col_start) ? col_start - line->length : 0;
+            size_t cut_end = (col_end < line->length) ? col_end : line->length;
+            size_t cut_start = (col_start < line->length) ? col_start : line->length;
+            size_t new_length = line->length - (cut_end - cut_start) + pad + seg_len;
+            
+            if (!buffer_reserve_line(line, new_length + 1)) {
+                return false;
+            }
+            memmove(line->text + cut_start + pad + seg_len, line->text + cut_end, line->length - cut_end + 1);
+            memset(line->text + cut_start, ' ', pad);
+            if (seg_len > 0) {
+                memcpy(line->text + cut_start + pad, seg, seg_len);
+            }
+            line->length = new_length;
+            buf->modified = true;
+        }
+        
+        if (seg != NULL && seg < end) {
+            seg += seg_len + 1;
+        }
+    }
+    
+    return true;
+}
+
 /* ============================================================================
  * 文字取得（別名函式）
  * ============================================================================ */
@@ -202,6 +202,63 @@ bool buffer_insert_text(buffer_t *buf, size_t line_num, size_t col, const char *
  */
 bool buffer_replace_text(buffer_t *buf, size_t line_num, size_t col_start, size_t col_end, const char *text);
 
+/* ============================================================================
+ * 區塊操作（貼上與可視模式）
+ *
+ * 以 buffer_splice_lines() 一次拼接所有異動的行，並預先配置所需容量，
+ * 避免逐字元或逐行呼叫時重複的邊界檢查、重新配置與串列走訪。
+ * ============================================================================ */
+
+/**
+ * @brief 在指定位置插入多行文字
+ * 
+ * text 中的每個 '\n' 都會分割行：第一段接在 col 之前的文字後面，
+ * 最後一段接在原本 col 之後的文字前面（對應字元模式的貼上）。
+ * 
+ * @param buf 目標緩衝區
+ * @param line_num 行號
+ * @param col 插入位置（超過行長度時插入到行尾）
+ * @param text 要插入的文字（不需以 null 結尾）
+ * @param len 文字長度
+ * @return 成功回傳 true，失敗回傳 false
+ */
+bool buffer_insert_block(buffer_t *buf, size_t line_num, size_t col, const char *text, size_t len);
+
+/**
+ * @brief 刪除一段跨行的文字範圍
+ * 
+ * 刪除 (start_row, start_col) 到 (end_row, end_col) 之間的文字（不包含結束位置），
+ * 起始行的前段與結束行的後段合併為一行。
+ * 
+ * @param buf 目標緩衝區
+ * @param start_row 起始行號
+ * @param start_col 起始欄位
+ * @param end_row 結束行號（不可小於 start_row）
+ * @param end_col 結束欄位（超過行長度時視為行尾）
+ * @return 成功回傳 true，失敗回傳 false
+ */
+bool buffer_delete_range(buffer_t *buf, size_t start_row, size_t start_col, size_t end_row, size_t end_col);
+
+/**
+ * @brief 替換矩形區塊中的文字欄位
+ * 
+ * 對從 start_row 開始的 row_count 行，將 col_start 到 col_end 之間的文字
+ * 換成 text 中對應的一行（以 '\n' 分隔；行數不足時視為空字串），
+ * 對應 Vim 的區塊可視模式（Ctrl+V）刪除與貼上。
+ * 行長度不足 col_start 且有新文字時以空白補齊。
+ * 
+ * @param buf 目標緩衝區
+ * @param start_row 起始行號
+ * @param row_count 行數
+ * @param col_start 起始欄位
+ * @param col_end 結束欄位（不包含）
+ * @param text 替換的新文字（NULL 表示只刪除該欄位區塊）
+ * @param len 文字長度
+ * @return 成功回傳 true，失敗回傳 false
+ */
+bool buffer_replace_block(buffer_t *buf, size_t start_row, size_t row_count,
+                          size_t col_start, size_t col_end, const char *text, size_t len);
+
 /* ============================================================================
  * 文字取得（與複製相同，為相容性保留）
  * ============================================================================ */
@@ -40,6 +40,13 @@ command_t *command_parse(const char *cmd_str) {
         p++;
     }
     
+    /* /pattern - 搜尋命令（以斜線開頭，其餘全部為模式） */
+    if (*p == '/') {
+        cmd->type = CMD_SEARCH;
+        cmd->arg1 = safe_strdup(p + 1);
+        return cmd;
+    }
+    
     /* 提取命令名稱（直到空白、斜線或字串結尾） */
     char cmd_name[32];
     size_t i = 0;
@@ -132,11 +139,6 @@ command_t *command_parse(const char *cmd_str) {
             cmd->arg1 = safe_strndup(p, len);
         }
     } 
-    else if (cmd_name[0] == '/') {
-        /* /pattern - 搜尋命令（以斜線開頭） */
-        cmd->type = CMD_SEARCH;
-        cmd->arg1 = safe_strdup(cmd_name + 1);  /* 跳過開頭的斜線 */
-    }
     /* 其他情況保持 CMD_UNKNOWN */
     
     return cmd;
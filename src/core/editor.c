@@ -10,8 +10,11 @@
 #include "command.h"
 #include "vim_ops.h"
 #include "buffer_ops.h"
+#include "async_save.h"
 #include "../utils/memory.h"
 #include "../utils/error.h"
+#include "../filesystem/vfs.h"
+#include "../filesystem/path.h"
 #include "../ui/input.h"
 #include "../ui/screen.h"
 #include "../ui/colors.h"
@@ -28,9 +31,6 @@
 /** @brief 最大可開啟的緩衝區數量 */
 #define MAX_BUFFERS 16
 
-/** @brief 緩衝區陣列的初始容量 */
-#define INITIAL_BUFFER_CAPACITY 4
-
 /* ============================================================================
  * 編輯器生命週期管理實作
  * ============================================================================ */
@@ -42,8 +42,8 @@ editor_t *editor_create(void) {
         return NULL;
     }
     
-    /* 配置緩衝區指標陣列 */
-    editor->buffers = (buffer_t **)safe_malloc(sizeof(buffer_t *) * INITIAL_BUFFER_CAPACITY);
+    /* 配置緩衝區指標陣列（一次配置到上限，開啟緩衝區時不需擴展） */
+    editor->buffers = (buffer_t **)safe_malloc(sizeof(buffer_t *) * MAX_BUFFERS);
     if (editor->buffers == NULL) {
         safe_free(editor);
         return NULL;
@@ -60,6 +60,11 @@ editor_t *editor_create(void) {
     editor->running = true;
     editor->repeat_count = 0;
     editor->last_operation = 0;
+    editor->vfs = NULL;
+    editor->pending_save = NULL;
+    editor->pending_save_buffer = NULL;
+    editor->memory_limit = EDITOR_DEFAULT_MEMORY_LIMIT;
+    editor->use_clock = 0;
     
     /* 初始化 Vim 操作上下文 */
     editor->vim_ctx = (vim_context_t *)safe_malloc(sizeof(vim_context_t));
@@ -75,6 +80,9 @@ void editor_destroy(editor_t *editor) {
         return;
     }
     
+    /* 等待背景儲存寫完 */
+    editor_wait_save(editor);
+    
     /* 銷毀所有開啟的緩衝區 */
     for (size_t i = 0; i < editor->buffer_count; i++) {
         if (editor->buffers[i] != NULL) {
@@ -94,6 +102,146 @@ void editor_destroy(editor_t *editor) {
     safe_free(editor);
 }
 
+/* ============================================================================
+ * 緩衝區記憶體管理
+ * ============================================================================ */
+
+/**
+ * @brief 以 VFS 檔案內容取代緩衝區內容
+ * @param buf 目標緩衝區
+ * @param node VFS 檔案節點（NULL 表示新檔案，載入為空白）
+ * @return 成功回傳 true，失敗回傳 false
+ */
+static bool load_vfs_content(buffer_t *buf, vfs_node_t *node) {
+    /* 直接借用檔案內容，由緩衝區複製進自己的配置區 */
+    size_t size = 0;
+    const char *data = (node != NULL) ? (const char *)vfs_peek_file(node, &size) : NULL;
+    if (data == NULL && size > 0) {
+        return false;
+    }
+    
+    return buffer_load_from_memory(buf, data, data != NULL ? size : 0);
+}
+
+/**
+ * @brief 重新載入已釋放的緩衝區
+ * @param editor 編輯器實例
+ * @param buf 已釋放的緩衝區
+ * @return 成功回傳 true，失敗回傳 false
+ */
+static bool reload_buffer(editor_t *editor, buffer_t *buf) {
+    if (buf->memory_backed) {
+        if (editor->vfs == NULL) {
+            return load_vfs_content(buf, NULL);
+        }
+        
+        /* 編輯期間不持有鎖，只在讀取 VFS 內容時取得讀取鎖 */
+        vfs_read_lock(editor->vfs);
+        vfs_node_t *node = vfs_find_node(editor->vfs, buf->filename);
+        bool ok;
+        if (node != NULL && node->type != VFS_FILE) {
+            error_set(ERR_INVALID_INPUT, "不是檔案: %s", buf->filename);
+            ok = false;
+        } else {
+            ok = load_vfs_content(buf, node);
+        }
+        vfs_unlock(editor->vfs);
+        return ok;
+    }
+    
+    if (!buffer_load_from_file(buf, buf->filename)) {
+        /* 檔案已不存在時與開啟新檔案相同，視為空白緩衝區 */
+        error_clear();
+        buf->evicted = false;
+    }
+    return true;
+}
+
+/**
+ * @brief 釋放最久未使用的緩衝區直到符合記憶體上限
+ *
+ * 作用中、有未儲存修改、或正在背景儲存的緩衝區不會被釋放。
+ *
+ * @param editor 編輯器實例
+ */
+static void enforce_memory_limit(editor_t *editor) {
+    size_t usage[MAX_BUFFERS] = {0};
+    size_t total = 0;
+    for (size_t i = 0; i < editor->buffer_count; i++) {
+        if (editor->buffers[i] != NULL && !editor->buffers[i]->evicted) {
+            usage[i] = buffer_memory_usage(editor->buffers[i]);
+            total += usage[i];
+        }
+    }
+    
+    while (total > editor->memory_limit) {
+        /* 找出最久未使用、可以釋放的緩衝區 */
+        size_t victim = editor->buffer_count;
+        for (size_t i = 0; i < editor->buffer_count; i++) {
+            buffer_t *buf = editor->buffers[i];
+            if (i == editor->current_buffer || buf == NULL || buf->evicted || buf->modified ||
+                buf->filename == NULL || buf == editor->pending_save_buffer) {
+                continue;
+            }
+            if (victim == editor->buffer_count || buf->last_used < editor->buffers[victim]->last_used) {
+                victim = i;
+            }
+        }
+        
+        if (victim == editor->buffer_count || !buffer_evict(editor->buffers[victim])) {
+            error_clear();
+            break;
+        }
+        total -= usage[victim];
+    }
+}
+
+/**
+ * @brief 將指定緩衝區設為作用中
+ *
+ * 已釋放的緩衝區先重新載入，並更新使用時序後套用記憶體上限。
+ *
+ * @param editor 編輯器實例
+ * @param index 緩衝區索引
+ * @return 成功回傳 true，重新載入失敗時回傳 false（目前緩衝區不變）
+ */
+static bool activate_buffer(editor_t *editor, size_t index) {
+    buffer_t *buf = editor->buffers[index];
+    if (buf->evicted && !reload_buffer(editor, buf)) {
+        return false;
+    }
+    
+    editor->current_buffer = index;
+    buf->last_used = ++editor->use_clock;
+    enforce_memory_limit(editor);
+    return true;
+}
+
+void editor_set_memory_limit(editor_t *editor, size_t bytes) {
+    if (editor == NULL) {
+        return;
+    }
+    
+    editor->memory_limit = bytes ? bytes : EDITOR_DEFAULT_MEMORY_LIMIT;
+    if (editor->buffer_count > 0) {
+        enforce_memory_limit(editor);
+    }
+}
+
+size_t editor_memory_usage(editor_t *editor) {
+    if (editor == NULL) {
+        return 0;
+    }
+    
+    size_t total = 0;
+    for (size_t i = 0; i < editor->buffer_count; i++) {
+        if (editor->buffers[i] != NULL && !editor->buffers[i]->evicted) {
+            total += buffer_memory_usage(editor->buffers[i]);
+        }
+    }
+    return total;
+}
+
 /* ============================================================================
  * 緩衝區管理實作
  * ============================================================================ */
@@ -110,9 +258,8 @@ bool editor_open_file(editor_t *editor, const char *filename) {
         if (editor->buffers[i] != NULL && 
             editor->buffers[i]->filename != NULL &&
             strcmp(editor->buffers[i]->filename, filename) == 0) {
-            /* 已開啟，直接切換到該緩衝區 */
-            editor->current_buffer = i;
-            return true;
+            /* 已開啟，直接切換到該緩衝區（必要時重新載入） */
+            return activate_buffer(editor, i);
         }
     }
     
@@ -136,7 +283,64 @@ bool editor_open_file(editor_t *editor, const char *filename) {
     
     /* 加入編輯器並切換到新緩衝區 */
     editor->buffers[editor->buffer_count++] = buf;
-    editor->current_buffer = editor->buffer_count - 1;
+    activate_buffer(editor, editor->buffer_count - 1);
+    editor->cursor_row = 0;
+    editor->cursor_col = 0;
+    editor->first_line = 0;
+    
+    return true;
+}
+
+bool editor_open_vfs(editor_t *editor, struct vfs *vfs, const char *path) {
+    /* 參數驗證 */
+    if (editor == NULL || vfs == NULL || path == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    /* 檢查是否已開啟同一個 VFS 檔案 */
+    for (size_t i = 0; i < editor->buffer_count; i++) {
+        if (editor->buffers[i] != NULL &&
+            editor->buffers[i]->memory_backed &&
+            editor->buffers[i]->filename != NULL &&
+            strcmp(editor->buffers[i]->filename, path) == 0) {
+            return activate_buffer(editor, i);
+        }
+    }
+    
+    /* 檢查緩衝區數量上限 */
+    if (editor->buffer_count >= MAX_BUFFERS) {
+        error_set(ERR_INVALID_INPUT, "緩衝區數量已達上限");
+        return false;
+    }
+    
+    buffer_t *buf = buffer_create(path);
+    if (buf == NULL) {
+        return false;
+    }
+    buf->memory_backed = true;
+    
+    /* 直接從 VFS 內容切分行（不存在的檔案視為新檔案）；
+     * 呼叫者不持有鎖，內容複製進緩衝區後即釋放，編輯期間背景儲存可照常進行 */
+    vfs_read_lock(vfs);
+    vfs_node_t *node = vfs_find_node(vfs, path);
+    bool ok = true;
+    if (node != NULL && node->type != VFS_FILE) {
+        error_set(ERR_INVALID_INPUT, "不是檔案: %s", path);
+        ok = false;
+    } else if (node != NULL) {
+        ok = load_vfs_content(buf, node);
+    }
+    vfs_unlock(vfs);
+    if (!ok) {
+        buffer_destroy(buf);
+        return false;
+    }
+    
+    /* 加入編輯器並切換到新緩衝區 */
+    editor->vfs = vfs;
+    editor->buffers[editor->buffer_count++] = buf;
+    activate_buffer(editor, editor->buffer_count - 1);
     editor->cursor_row = 0;
     editor->cursor_col = 0;
     editor->first_line = 0;
@@ -160,6 +364,11 @@ bool editor_close_buffer(editor_t *editor) {
         /* 有未儲存的修改 */
     }
     
+    /* 背景儲存完成後才能銷毀來源緩衝區 */
+    if (editor->pending_save_buffer == editor->buffers[idx]) {
+        editor_wait_save(editor);
+    }
+    
     /* 銷毀緩衝區 */
     buffer_destroy(editor->buffers[idx]);
     
@@ -170,10 +379,13 @@ bool editor_close_buffer(editor_t *editor) {
     
     editor->buffer_count--;
     
-    /* 調整目前緩衝區索引 */
+    /* 調整目前緩衝區索引（新的作用中緩衝區可能需要重新載入） */
     if (editor->current_buffer >= editor->buffer_count && editor->buffer_count > 0) {
         editor->current_buffer = editor->buffer_count - 1;
     }
+    if (editor->buffer_count > 0) {
+        activate_buffer(editor, editor->current_buffer);
+    }
     
     /* 若無緩衝區則結束編輯器 */
     if (editor->buffer_count == 0) {
@@ -189,8 +401,10 @@ bool editor_switch_buffer(editor_t *editor, size_t index) {
         return false;
     }
     
-    /* 切換並重設游標位置 */
-    editor->current_buffer = index;
+    /* 切換（必要時重新載入）並重設游標位置 */
+    if (!activate_buffer(editor, index)) {
+        return false;
+    }
     editor->cursor_row = 0;
     editor->cursor_col = 0;
     editor->first_line = 0;
@@ -202,6 +416,27 @@ bool editor_switch_buffer(editor_t *editor, size_t index) {
  * 輸入處理實作
  * ============================================================================ */
 
+/**
+ * @brief 設定狀態列附加訊息（顯示到下次按鍵為止）
+ *
+ * 過長的訊息（如 error_t 的完整錯誤訊息）在 UTF-8 字元邊界截斷，
+ * 不會在狀態列留下半個字元。
+ *
+ * @param editor 編輯器實例
+ * @param note 訊息內容
+ */
+static void set_status_note(editor_t *editor, const char *note) {
+    size_t len = strlen(note);
+    if (len >= sizeof(editor->status_note)) {
+        len = sizeof(editor->status_note) - 1;
+        while (len > 0 && ((unsigned char)note[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(editor->status_note, note, len);
+    editor->status_note[len] = '\0';
+}
+
 /**
  * @brief 處理 Normal 模式的按鍵
  * @param editor 編輯器實例
@@ -209,32 +444,61 @@ bool editor_switch_buffer(editor_t *editor, size_t index) {
  * @param key 按鍵輸入
  */
 static void handle_normal_mode(editor_t *editor, buffer_t *buf, key_input_t *key) {
+    if (key->ctrl && key->key == 'r') {
+        /* Ctrl+R: 重做 */
+        if (!vim_redo(editor, editor->vim_ctx)) {
+            screen_show_status("已是最新的變更", true);
+        }
+        return;
+    }
+    
     switch (key->key) {
         case 'i':
         case 'a':
             /* 進入插入模式 */
             editor_set_mode(editor, MODE_INSERT);
             break;
-            
+        
         case 'v':
             /* 進入可視模式 */
             editor_set_mode(editor, MODE_VISUAL);
             break;
-            
+        
         case ':':
             /* 進入命令模式 */
             editor_set_mode(editor, MODE_COMMAND);
             safe_free(editor->command_buffer);
             editor->command_buffer = safe_strdup("");
             break;
-            
+        
+        case '/':
+            /* 進入搜尋（命令模式，輸入時即時搜尋） */
+            editor_set_mode(editor, MODE_COMMAND);
+            safe_free(editor->command_buffer);
+            editor->command_buffer = safe_strdup("/");
+            break;
+        
+        case 'n':
+            /* 依原方向搜尋下一個匹配 */
+            if (!vim_search_next(editor, editor->vim_ctx)) {
+                screen_show_status("找不到匹配", true);
+            }
+            break;
+        
+        case 'N':
+            /* 依反方向搜尋上一個匹配 */
+            if (!vim_search_prev(editor, editor->vim_ctx)) {
+                screen_show_status("找不到匹配", true);
+            }
+            break;
+        
         case 'h':
             /* 游標左移 */
             if (editor->cursor_col > 0) {
                 editor->cursor_col--;
             }
             break;
-            
+        
         case 'l':
             /* 游標右移 */
             {
@@ -244,7 +508,7 @@ static void handle_normal_mode(editor_t *editor, buffer_t *buf, key_input_t *key
                 }
             }
             break;
-            
+        
         case 'j':
             /* 游標下移 */
             if (editor->cursor_row < buf->line_count - 1) {
@@ -256,7 +520,7 @@ static void handle_normal_mode(editor_t *editor, buffer_t *buf, key_input_t *key
                 }
             }
             break;
-            
+        
         case 'k':
             /* 游標上移 */
             if (editor->cursor_row > 0) {
@@ -268,19 +532,44 @@ static void handle_normal_mode(editor_t *editor, buffer_t *buf, key_input_t *key
                 }
             }
             break;
-            
+        
         case 'x':
             /* 刪除游標處的字元 */
+            {
+                line_t *line = buffer_get_line(buf, editor->cursor_row);
+                if (line != NULL && editor->cursor_col < line->length) {
+                    vim_record_undo(editor->vim_ctx, UNDO_DELETE_CHAR, editor->cursor_row, editor->cursor_col,
+                                    line->text + editor->cursor_col, 1);
+                }
+            }
             buffer_delete_char(buf, editor->cursor_row, editor->cursor_col);
             break;
-            
+        
         case 'd':
             /* dd: 刪除目前行（簡化實作，需要雙擊偵測） */
+            {
+                /* 只剩一行時緩衝區會清空該行內容而非移除 */
+                line_t *line = buffer_get_line(buf, editor->cursor_row);
+                if (line != NULL && buf->line_count > 1) {
+                    vim_record_undo(editor->vim_ctx, UNDO_DELETE_LINE, editor->cursor_row, 0,
+                                    line->text, line->length);
+                } else if (line != NULL && line->length > 0) {
+                    vim_record_undo(editor->vim_ctx, UNDO_DELETE_CHAR, editor->cursor_row, 0,
+                                    line->text, line->length);
+                }
+            }
             buffer_delete_line(buf, editor->cursor_row);
             if (editor->cursor_row >= buf->line_count) {
                 editor->cursor_row = buf->line_count - 1;
             }
             break;
+        
+        case 'u':
+            /* 撤銷最近一組變更（Ctrl+U 不觸發） */
+            if (!key->ctrl && !vim_undo(editor, editor->vim_ctx)) {
+                screen_show_status("已是最舊的變更", true);
+            }
+            break;
     }
 }
 
@@ -298,6 +587,11 @@ static void handle_insert_mode(editor_t *editor, buffer_t *buf, key_input_t *key
         /* Backspace: 刪除前一個字元 */
         if (editor->cursor_col > 0) {
             editor->cursor_col--;
+            line_t *line = buffer_get_line(buf, editor->cursor_row);
+            if (line != NULL && editor->cursor_col < line->length) {
+                vim_record_undo(editor->vim_ctx, UNDO_DELETE_CHAR, editor->cursor_row, editor->cursor_col,
+                                line->text + editor->cursor_col, 1);
+            }
             buffer_delete_char(buf, editor->cursor_row, editor->cursor_col);
         } else if (editor->cursor_row > 0) {
             /* 游標在行首，合併到上一行 */
@@ -311,16 +605,41 @@ static void handle_insert_mode(editor_t *editor, buffer_t *buf, key_input_t *key
         }
     } else if (key->key == '\n' || key->key == '\r') {
         /* Enter: 插入新行 */
+        vim_record_undo(editor->vim_ctx, UNDO_INSERT_LINE, editor->cursor_row + 1, 0, "", 0);
         buffer_insert_line(buf, editor->cursor_row + 1, "");
         editor->cursor_row++;
         editor->cursor_col = 0;
     } else if (key->key >= 32 && key->key < 127) {
         /* 可列印字元: 插入到游標位置 */
-        buffer_insert_char(buf, editor->cursor_row, editor->cursor_col, key->key);
+        char c = key->key;
+        vim_record_undo(editor->vim_ctx, UNDO_INSERT_CHAR, editor->cursor_row, editor->cursor_col, &c, 1);
+        buffer_insert_char(buf, editor->cursor_row, editor->cursor_col, c);
         editor->cursor_col++;
     }
 }
 
+/**
+ * @brief 將括號貼上的內容整段插入
+ * 
+ * 取出已到達的所有貼上內容，以區塊插入一次寫入緩衝區，
+ * 不逐字經過按鍵處理（貼上的文字不會被解讀為指令）。
+ * 
+ * @param editor 編輯器實例
+ * @param first 第一個貼上的位元組
+ */
+static void insert_paste(editor_t *editor, const key_input_t *first) {
+    char chunk[INPUT_RING_SIZE];
+    chunk[0] = first->key;
+    size_t len = 1 + input_read_paste(chunk + 1, sizeof(chunk) - 1);
+    
+    while (len > 0) {
+        if (!editor_insert_text(editor, chunk, len)) {
+            return;
+        }
+        len = input_read_paste(chunk, sizeof(chunk));
+    }
+}
+
 /**
  * @brief 處理 Command 模式的按鍵
  * @param editor 編輯器實例
@@ -334,7 +653,8 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
             if (cmd != NULL) {
                 switch (cmd->type) {
                     case CMD_QUIT:
-                        /* :q - 退出（檢查未儲存的修改） */
+                        /* :q - 退出（檢查未儲存的修改，背景儲存失敗也算未儲存） */
+                        editor_wait_save(editor);
                         if (editor->buffer_count > 0) {
                             buffer_t *buf = editor->buffers[editor->current_buffer];
                             if (buf != NULL && buffer_is_modified(buf)) {
@@ -354,7 +674,7 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                             editor_set_mode(editor, MODE_NORMAL);
                         }
                         break;
-                        
+                    
                     case CMD_QUIT_FORCE:
                         /* :q! - 強制退出 */
                         safe_free(editor->command_buffer);
@@ -362,20 +682,23 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                         editor_set_mode(editor, MODE_NORMAL);
                         editor->running = false;
                         break;
-                        
+                    
                     case CMD_WRITE:
-                        /* :w - 儲存 */
+                        /* :w - 儲存（另存新檔為同步，否則在背景寫入） */
                         if (cmd->arg1 != NULL) {
-                            editor_save_as(editor, cmd->arg1);
-                        } else {
-                            editor_save(editor);
+                            if (editor_save_as(editor, cmd->arg1)) {
+                                set_status_note(editor, "檔案已儲存");
+                            } else {
+                                set_status_note(editor, error_get().message);
+                            }
+                        } else if (!editor_save_async(editor)) {
+                            set_status_note(editor, error_get().message);
                         }
-                        screen_show_status("檔案已儲存", false);
                         safe_free(editor->command_buffer);
                         editor->command_buffer = NULL;
                         editor_set_mode(editor, MODE_NORMAL);
                         break;
-                        
+                    
                     case CMD_WRITE_QUIT:
                         /* :wq - 儲存並退出 */
                         editor_save(editor);
@@ -384,7 +707,7 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                         editor_set_mode(editor, MODE_NORMAL);
                         editor->running = false;
                         break;
-                        
+                    
                     case CMD_EDIT:
                         /* :e <filename> - 開啟檔案 */
                         if (cmd->arg1 != NULL) {
@@ -397,7 +720,7 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                         editor->command_buffer = NULL;
                         editor_set_mode(editor, MODE_NORMAL);
                         break;
-                        
+                    
                     case CMD_BUFFER:
                         /* :b <n> - 切換緩衝區 */
                         if (cmd->arg1 != NULL) {
@@ -410,7 +733,7 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                         editor->command_buffer = NULL;
                         editor_set_mode(editor, MODE_NORMAL);
                         break;
-                        
+                    
                     case CMD_SUBSTITUTE:
                         /* :s/old/new/ - 搜尋替換 */
                         if (cmd->arg1 != NULL && cmd->arg2 != NULL) {
@@ -420,17 +743,26 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                         editor->command_buffer = NULL;
                         editor_set_mode(editor, MODE_NORMAL);
                         break;
-                        
+                    
                     case CMD_SEARCH:
-                        /* /pattern - 搜尋 */
-                        if (cmd->arg1 != NULL) {
-                            screen_show_status("搜尋功能待實作", false);
+                        /* /pattern - 搜尋（增量搜尋已將游標移到匹配位置） */
+                        if (editor->vim_ctx != NULL && editor->vim_ctx->isearch_active) {
+                            bool found = editor->vim_ctx->isearch_found;
+                            vim_search_incremental_end(editor, editor->vim_ctx, found);
+                            if (!found) {
+                                screen_show_status("找不到匹配", true);
+                            }
+                        } else if (cmd->arg1 != NULL && !vim_search_forward(editor, cmd->arg1)) {
+                            screen_show_status("找不到匹配", true);
+                        }
+                        if (editor->vim_ctx != NULL) {
+                            editor->vim_ctx->search_direction = 1;
                         }
                         safe_free(editor->command_buffer);
                         editor->command_buffer = NULL;
                         editor_set_mode(editor, MODE_NORMAL);
                         break;
-                        
+                    
                     case CMD_SET:
                         /* :set <option> - 設定選項 */
                         screen_show_status("設定功能待實作", false);
@@ -438,7 +770,7 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
                         editor->command_buffer = NULL;
                         editor_set_mode(editor, MODE_NORMAL);
                         break;
-                        
+                    
                     case CMD_UNKNOWN:
                         screen_show_status("未知命令", true);
                         break;
@@ -456,7 +788,8 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
             editor->command_buffer = NULL;
         }
     } else if (key->key == '\x1b') {
-        /* Escape: 取消命令 */
+        /* Escape: 取消命令（增量搜尋時游標回到起點） */
+        vim_search_incremental_end(editor, editor->vim_ctx, false);
         editor_set_mode(editor, MODE_NORMAL);
         safe_free(editor->command_buffer);
         editor->command_buffer = NULL;
@@ -481,6 +814,68 @@ static void handle_command_mode(editor_t *editor, key_input_t *key) {
             editor->command_buffer[len + 1] = '\0';
         }
     }
+    
+    /* 搜尋命令：每次輸入都從上次的匹配位置繼續搜尋；刪掉斜線則取消搜尋 */
+    if (editor->mode == MODE_COMMAND && editor->vim_ctx != NULL) {
+        if (editor->command_buffer != NULL && editor->command_buffer[0] == '/') {
+            vim_search_incremental(editor, editor->vim_ctx, editor->command_buffer + 1);
+        } else {
+            vim_search_incremental_end(editor, editor->vim_ctx, false);
+        }
+    }
+}
+
+bool editor_insert_text(editor_t *editor, const char *text, size_t len) {
+    if (editor == NULL || text == NULL || editor->buffer_count == 0) {
+        return false;
+    }
+    
+    buffer_t *buf = editor->buffers[editor->current_buffer];
+    size_t row = editor->cursor_row;
+    line_t *line = buffer_get_line(buf, row);
+    if (line == NULL) {
+        return false;
+    }
+    size_t col = (editor->cursor_col > line->length) ? line->length : editor->cursor_col;
+    
+    if (!buffer_insert_block(buf, row, col, text, len)) {
+        return false;
+    }
+    
+    /* Insert 模式中併入目前的插入群組，其他模式自成一次撤銷 */
+    bool own_group = (editor->mode != MODE_INSERT);
+    if (own_group) {
+        vim_undo_begin_group(editor->vim_ctx);
+    }
+    
+    /* 單行文字記為插入字元（可與輸入的字元合併），多行文字整段記為一筆區塊記錄 */
+    const char *last_newline = NULL;
+    for (size_t i = len; i > 0; i--) {
+        if (text[i - 1] == '\n') {
+            last_newline = text + i - 1;
+            break;
+        }
+    }
+    if (last_newline == NULL) {
+        if (len > 0) {
+            vim_record_undo(editor->vim_ctx, UNDO_INSERT_CHAR, row, col, text, len);
+        }
+        col += len;
+    } else {
+        vim_record_undo(editor->vim_ctx, UNDO_INSERT_BLOCK, row, col, text, len);
+        for (size_t i = 0; i < len; i++) {
+            row += (text[i] == '\n');
+        }
+        col = len - (size_t)(last_newline + 1 - text);
+    }
+    
+    if (own_group) {
+        vim_undo_end_group(editor->vim_ctx);
+    }
+    
+    editor->cursor_row = row;
+    editor->cursor_col = col;
+    return true;
 }
 
 void editor_handle_input(editor_t *editor, key_input_t *key) {
@@ -499,18 +894,18 @@ void editor_handle_input(editor_t *editor, key_input_t *key) {
         case MODE_NORMAL:
             handle_normal_mode(editor, buf, key);
             break;
-            
+        
         case MODE_INSERT:
             handle_insert_mode(editor, buf, key);
             break;
-            
+        
         case MODE_VISUAL:
             /* 可視模式（簡化實作） */
             if (key->key == '\x1b') {
                 editor_set_mode(editor, MODE_NORMAL);
             }
             break;
-            
+        
         case MODE_COMMAND:
             handle_command_mode(editor, key);
             break;
@@ -568,9 +963,32 @@ void editor_run(editor_t *editor) {
     screen_hide_cursor();
     
     bool needs_refresh = true;
+    int save_percent = 0;
     
     /* 主迴圈 */
     while (editor->running) {
+        /* 背景儲存：進度變化時重繪，完成後顯示結果 */
+        if (editor->pending_save != NULL) {
+            size_t written = 0;
+            size_t total = 0;
+            bool done = async_save_poll(editor->pending_save, &written, &total);
+            int percent = (total > 0) ? (int)(written * 100 / total) : 100;
+            
+            if (done) {
+                if (editor_wait_save(editor)) {
+                    set_status_note(editor, "檔案已儲存");
+                } else {
+                    set_status_note(editor, error_get().message);
+                }
+                needs_refresh = true;
+            } else if (percent != save_percent) {
+                save_percent = percent;
+                needs_refresh = true;
+            }
+        } else {
+            save_percent = 0;
+        }
+        
         /* 只在需要時重繪畫面（減少閃爍） */
         if (needs_refresh && editor->buffer_count > 0) {
             buffer_t *buf = editor->buffers[editor->current_buffer];
@@ -597,6 +1015,15 @@ void editor_run(editor_t *editor) {
                 strncat(status, " [+]", sizeof(status) - strlen(status) - 1);
             }
             
+            /* 背景儲存進度或最近一次的訊息 */
+            if (editor->pending_save != NULL) {
+                size_t len = strlen(status);
+                snprintf(status + len, sizeof(status) - len, " | 儲存中 %d%%", save_percent);
+            } else if (editor->status_note[0] != '\0') {
+                size_t len = strlen(status);
+                snprintf(status + len, sizeof(status) - len, " | %s", editor->status_note);
+            }
+            
             screen_show_status(status, false);
             
             /* 顯示命令列 */
@@ -606,24 +1033,46 @@ void editor_run(editor_t *editor) {
                 screen_show_command("");
             }
             
+            /* 整個畫面以單一 write 送出 */
+            screen_flush();
+            
             needs_refresh = false;
         }
         
-        /* 讀取按鍵輸入 */
+        /* 讀取並處理所有已到達的按鍵後才重繪一次（大量貼上時只重繪一次） */
+        size_t old_row = editor->cursor_row;
+        size_t old_col = editor->cursor_col;
+        editor_mode_t old_mode = editor->mode;
+        bool handled = false;
+        
         key_input_t key;
-        if (input_read_key(&key)) {
-            /* 記錄處理前的狀態以偵測變化 */
-            size_t old_row = editor->cursor_row;
-            size_t old_col = editor->cursor_col;
-            editor_mode_t old_mode = editor->mode;
+        while (editor->running && input_read_key(&key)) {
+            handled = true;
+            
+            if (editor->status_note[0] != '\0') {
+                editor->status_note[0] = '\0';
+                needs_refresh = true;
+            }
+            
+            if (key.paste && editor->mode != MODE_COMMAND) {
+                insert_paste(editor, &key);
+                needs_refresh = true;
+            } else {
+                editor_handle_input(editor, &key);
+            }
             
-            editor_handle_input(editor, &key);
+            if (editor->mode == MODE_COMMAND || editor->mode != old_mode) {
+                needs_refresh = true;
+            }
             
+            if (!input_pending()) {
+                break;
+            }
+        }
+        
+        if (handled) {
             /* 若有任何變化則標記需要重繪 */
-            if (old_row != editor->cursor_row || 
-                old_col != editor->cursor_col || 
-                old_mode != editor->mode ||
-                editor->mode == MODE_COMMAND) {
+            if (old_row != editor->cursor_row || old_col != editor->cursor_col) {
                 needs_refresh = true;
             }
         } else {
@@ -632,6 +1081,9 @@ void editor_run(editor_t *editor) {
         }
     }
     
+    /* 離開前等待背景儲存寫完 */
+    editor_wait_save(editor);
+    
     /* 清理終端機狀態 */
     screen_cleanup();
     input_cleanup();
@@ -641,16 +1093,79 @@ void editor_run(editor_t *editor) {
  * 檔案儲存實作
  * ============================================================================ */
 
+/**
+ * @brief 確認緩衝區內容仍常駐（已釋放的緩衝區不可寫回，否則會覆蓋原檔）
+ * @param buf 來源緩衝區
+ * @return 常駐回傳 true，否則回傳 false 並設定錯誤訊息
+ */
+static bool check_resident(const buffer_t *buf) {
+    if (buf->evicted) {
+        error_set(ERR_INVALID_INPUT, "緩衝區尚未重新載入: %s", buf->filename);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 將緩衝區內容寫入 VFS 檔案（不存在時建立）
+ * @param editor 編輯器實例
+ * @param buf 來源緩衝區
+ * @param path VFS 絕對路徑
+ * @return 成功回傳 true，失敗回傳 false
+ */
+static bool save_to_vfs(editor_t *editor, buffer_t *buf, const char *path) {
+    if (editor->vfs == NULL) {
+        error_set(ERR_INVALID_INPUT, "未指定 VFS");
+        return false;
+    }
+    
+    size_t size = 0;
+    char *data = buffer_serialize_to_memory(buf, &size);
+    if (data == NULL) {
+        return false;
+    }
+    
+    /* 寫入鎖只涵蓋查詢與寫回，序列化在鎖外完成 */
+    bool ok;
+    vfs_write_lock(editor->vfs);
+    vfs_node_t *node = vfs_find_node(editor->vfs, path);
+    if (node == NULL) {
+        ok = vfs_create_file(editor->vfs, path, data, size) != NULL;
+    } else if (node->type == VFS_FILE) {
+        ok = vfs_write_file(node, data, size);
+    } else {
+        error_set(ERR_INVALID_INPUT, "不是檔案: %s", path);
+        ok = false;
+    }
+    vfs_unlock(editor->vfs);
+    
+    /* 安全清除序列化後的明文 */
+    secure_zero(data, size);
+    safe_free(data);
+    
+    if (ok) {
+        buf->modified = false;
+    }
+    return ok;
+}
+
 bool editor_save(editor_t *editor) {
     if (editor == NULL || editor->buffer_count == 0) {
         return false;
     }
     
+    /* 避免與進行中的背景儲存交錯寫入 */
+    editor_wait_save(editor);
+    
     buffer_t *buf = editor->buffers[editor->current_buffer];
-    if (buf == NULL) {
+    if (buf == NULL || !check_resident(buf)) {
         return false;
     }
     
+    if (buf->memory_backed) {
+        return save_to_vfs(editor, buf, buf->filename);
+    }
+    
     return buffer_save_to_file(buf, NULL);
 }
 
@@ -659,20 +1174,115 @@ bool editor_save_as(editor_t *editor, const char *filename) {
         return false;
     }
     
+    editor_wait_save(editor);
+    
     buffer_t *buf = editor->buffers[editor->current_buffer];
-    if (buf == NULL) {
+    if (buf == NULL || !check_resident(buf)) {
         return false;
     }
     
+    if (buf->memory_backed) {
+        /* 相對路徑以目前檔案所在的 VFS 目錄為準 */
+        char *path = NULL;
+        if (filename[0] == '/') {
+            path = safe_strdup(filename);
+        } else {
+            char *dir = path_get_dirname(buf->filename);
+            if (dir != NULL) {
+                path = (char *)safe_malloc(strlen(dir) + strlen(filename) + 2);
+                if (path != NULL) {
+                    sprintf(path, "%s%s%s", dir,
+                            (strcmp(dir, "/") == 0) ? "" : "/", filename);
+                }
+                safe_free(dir);
+            }
+        }
+        if (path == NULL) {
+            return false;
+        }
+        
+        bool ok = save_to_vfs(editor, buf, path);
+        if (ok) {
+            safe_free(buf->filename);
+            buf->filename = path;
+        } else {
+            safe_free(path);
+        }
+        return ok;
+    }
+    
     return buffer_save_to_file(buf, filename);
 }
 
+bool editor_save_async(editor_t *editor) {
+    if (editor == NULL || editor->buffer_count == 0) {
+        return false;
+    }
+    
+    buffer_t *buf = editor->buffers[editor->current_buffer];
+    if (buf == NULL || !check_resident(buf)) {
+        return false;
+    }
+    
+    /* VFS 緩衝區寫回記憶體中的 VFS，不需背景執行緒 */
+    if (buf->memory_backed) {
+        return editor_save(editor);
+    }
+    if (buf->filename == NULL) {
+        error_set(ERR_INVALID_INPUT, "檔案名稱為 NULL");
+        return false;
+    }
+    
+    /* 一次只進行一個背景儲存 */
+    if (!editor_wait_save(editor)) {
+        set_status_note(editor, error_get().message);
+    }
+    
+    /* 在 UI 執行緒取得快照，之後的編輯不影響寫入的內容 */
+    size_t size = 0;
+    char *data = buffer_serialize_to_memory(buf, &size);
+    if (data == NULL) {
+        return false;
+    }
+    
+    editor->pending_save = async_save_start(buf->filename, data, size);
+    if (editor->pending_save == NULL) {
+        return false;
+    }
+    editor->pending_save_buffer = buf;
+    
+    /* 先視為已儲存；寫入期間的編輯會重新設定修改標記，失敗時再還原 */
+    buf->modified = false;
+    return true;
+}
+
+bool editor_wait_save(editor_t *editor) {
+    if (editor == NULL || editor->pending_save == NULL) {
+        return true;
+    }
+    
+    bool ok = async_save_finish(editor->pending_save);
+    if (!ok && editor->pending_save_buffer != NULL) {
+        editor->pending_save_buffer->modified = true;
+    }
+    
+    editor->pending_save = NULL;
+    editor->pending_save_buffer = NULL;
+    return ok;
+}
+
 /* ============================================================================
  * 模式管理實作
  * ============================================================================ */
 
 void editor_set_mode(editor_t *editor, editor_mode_t mode) {
     if (editor != NULL) {
+        /* 一次插入模式中的所有輸入視為一個撤銷群組 */
+        if (editor->mode != MODE_INSERT && mode == MODE_INSERT) {
+            vim_undo_begin_group(editor->vim_ctx);
+        } else if (editor->mode == MODE_INSERT && mode != MODE_INSERT) {
+            vim_undo_end_group(editor->vim_ctx);
+        }
         editor->mode = mode;
     }
 }
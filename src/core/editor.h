@@ -37,6 +37,18 @@ typedef enum {
     MODE_COMMAND      /**< 命令模式：執行 Ex 命令 */
 } editor_mode_t;
 
+/* ============================================================================
+ * 常數定義
+ * ============================================================================ */
+
+/**
+ * @brief 所有緩衝區內容的預設記憶體上限（位元組）
+ *
+ * 超過時釋放最久未使用、且沒有未儲存修改的非作用中緩衝區，
+ * 切換回該緩衝區時再從檔案或 VFS 重新載入。
+ */
+#define EDITOR_DEFAULT_MEMORY_LIMIT (256u * 1024u * 1024u)
+
 /* ============================================================================
  * 前向宣告
  * ============================================================================ */
@@ -61,6 +73,16 @@ typedef struct cursor cursor_t;
 struct vim_context;
 typedef struct vim_context vim_context_t;
 
+/**
+ * @brief 虛擬檔案系統（定義於 filesystem/vfs.h）
+ */
+struct vfs;
+
+/**
+ * @brief 背景儲存（定義於 async_save.h）
+ */
+struct async_save;
+
 /* ============================================================================
  * 資料結構定義
  * ============================================================================ */
@@ -83,6 +105,12 @@ typedef struct editor {
     vim_context_t *vim_ctx;    /**< Vim 操作上下文 */
     size_t repeat_count;       /**< 重複次數（如 3dd 中的 3） */
     char last_operation;       /**< 最後執行的操作（用於 . 命令） */
+    struct vfs *vfs;           /**< VFS 模式下儲存的目標檔案系統（可為 NULL） */
+    struct async_save *pending_save; /**< 進行中的背景儲存（NULL 表示沒有） */
+    buffer_t *pending_save_buffer;   /**< 背景儲存的來源緩衝區 */
+    char status_note[128];     /**< 狀態列附加訊息（如儲存結果），下次按鍵時清除 */
+    size_t memory_limit;       /**< 緩衝區內容的記憶體上限（位元組） */
+    size_t use_clock;          /**< 緩衝區使用時序計數器（LRU） */
 } editor_t;
 
 /* ============================================================================
@@ -124,6 +152,21 @@ void editor_destroy(editor_t *editor);
  */
 bool editor_open_file(editor_t *editor, const char *filename);
 
+/**
+ * @brief 直接開啟 VFS 檔案節點到新緩衝區
+ * 
+ * 內容直接從 VFS 載入記憶體，儲存時寫回 VFS 節點，
+ * 全程不經過主機檔案系統（明文不會落地）。
+ * 若節點不存在，則建立新的空緩衝區，儲存時才建立檔案。
+ * 呼叫者不可持有 VFS 的鎖：載入時取得讀取鎖、寫回時取得寫入鎖，編輯期間不持有。
+ * 
+ * @param editor 編輯器實例
+ * @param vfs 檔案所在的虛擬檔案系統
+ * @param path 檔案的 VFS 絕對路徑
+ * @return 成功回傳 true，失敗回傳 false
+ */
+bool editor_open_vfs(editor_t *editor, struct vfs *vfs, const char *path);
+
 /**
  * @brief 關閉目前的緩衝區
  * 
@@ -138,12 +181,34 @@ bool editor_close_buffer(editor_t *editor);
 /**
  * @brief 切換到指定的緩衝區
  * 
+ * 已被釋放的緩衝區會先重新載入，之後若超過記憶體上限，
+ * 會釋放其他最久未使用的緩衝區。
+ * 
  * @param editor 編輯器實例
  * @param index 目標緩衝區的索引（從 0 開始）
  * @return 成功回傳 true，索引無效時回傳 false
  */
 bool editor_switch_buffer(editor_t *editor, size_t index);
 
+/**
+ * @brief 設定緩衝區內容的記憶體上限
+ * 
+ * 立即套用：超過上限時釋放非作用中、沒有未儲存修改的緩衝區（最久未使用者優先）。
+ * 作用中與有未儲存修改的緩衝區不會被釋放，因此實際用量可能仍高於上限。
+ * 
+ * @param editor 編輯器實例
+ * @param bytes 上限（位元組），0 表示使用 EDITOR_DEFAULT_MEMORY_LIMIT
+ */
+void editor_set_memory_limit(editor_t *editor, size_t bytes);
+
+/**
+ * @brief 取得所有常駐緩衝區內容佔用的記憶體
+ * 
+ * @param editor 編輯器實例
+ * @return 位元組數（已釋放的緩衝區不計）
+ */
+size_t editor_memory_usage(editor_t *editor);
+
 /* ============================================================================
  * 輸入處理與主迴圈
  * ============================================================================ */
@@ -158,6 +223,20 @@ bool editor_switch_buffer(editor_t *editor, size_t index);
  */
 void editor_handle_input(editor_t *editor, key_input_t *key);
 
+/**
+ * @brief 在游標位置插入一段文字
+ * 
+ * 文字可包含換行，以單一次區塊插入寫入緩衝區，游標移到插入內容之後。
+ * Insert 模式中併入目前的插入群組，其他模式自成一次撤銷。
+ * 用於括號貼上的快速路徑。
+ * 
+ * @param editor 編輯器實例
+ * @param text 要插入的文字（不需以 null 結尾）
+ * @param len 文字長度
+ * @return 成功回傳 true，失敗回傳 false
+ */
+bool editor_insert_text(editor_t *editor, const char *text, size_t len);
+
 /**
  * @brief 執行編輯器主迴圈
  * 
@@ -175,6 +254,8 @@ void editor_run(editor_t *editor);
 /**
  * @brief 儲存目前緩衝區到原檔案
  * 
+ * VFS 緩衝區會寫回對應的 VFS 節點。
+ * 
  * @param editor 編輯器實例
  * @return 成功回傳 true，失敗回傳 false
  */
@@ -183,12 +264,36 @@ bool editor_save(editor_t *editor);
 /**
  * @brief 另存目前緩衝區到指定檔案
  * 
+ * VFS 緩衝區另存到 VFS 中的指定路徑（相對路徑以目前檔案所在目錄為準）。
+ * 
  * @param editor 編輯器實例
  * @param filename 目標檔案路徑
  * @return 成功回傳 true，失敗回傳 false
  */
 bool editor_save_as(editor_t *editor, const char *filename);
 
+/**
+ * @brief 在背景儲存目前緩衝區
+ * 
+ * 在呼叫端將緩衝區序列化為快照後交給寫入執行緒，寫入期間可繼續編輯；
+ * 寫入失敗時緩衝區會重新標記為已修改。
+ * 主機檔案先寫入暫存檔再原子性地取代原檔。VFS 緩衝區的內容只存在記憶體，
+ * 直接同步寫回。
+ * 
+ * @param editor 編輯器實例
+ * @return 成功啟動（或同步儲存成功）回傳 true，失敗回傳 false
+ * @note 若已有進行中的背景儲存，會先等待它完成
+ */
+bool editor_save_async(editor_t *editor);
+
+/**
+ * @brief 等待進行中的背景儲存完成
+ * 
+ * @param editor 編輯器實例
+ * @return 沒有進行中的儲存或儲存成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool editor_wait_save(editor_t *editor);
+
 /* ============================================================================
  * 模式管理
  * ============================================================================ */
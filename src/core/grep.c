@@ -0,0 +1,529 @@
+/**
+ * @file grep.c
+ * @brief VFS 內容搜尋模組實作
+ *
+ * 檔案搜尋以批次進行（與 vfs_import 相同的兩階段）：
+ * 1. 平行階段：工作執行緒各自掃描一個檔案，把輸出寫入該項目的記憶體緩衝區
+ * 2. 輸出階段：呼叫端執行緒依走訪順序寫出各項目的輸出與錯誤訊息
+ * 沒有可用的工作執行緒或批次只有一個檔案時，在呼叫端依序掃描、直接寫入輸出串流，
+ * 大型檔案的結果不需先暫存。
+ *
+ * 連續儲存的內容直接在原處掃描；尚未載入或分段儲存的內容以 vfs_pread() 分段讀入
+ * 暫存緩衝區，每段只處理到最後一個換行，未完整的行移到下一段開頭，
+ * 因此每一行都完整地出現在同一段中。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "grep.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include "../utils/threadpool.h"
+#include <string.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/**
+ * @brief 輸出目的地：直接寫入串流，或暫存在記憶體緩衝區
+ */
+typedef struct {
+    FILE *file;                    /**< 輸出串流（NULL 表示寫入緩衝區） */
+    char *data;                    /**< 緩衝區內容 */
+    size_t len;                    /**< 緩衝區已使用的長度 */
+    size_t capacity;               /**< 緩衝區容量 */
+    bool failed;                   /**< 緩衝區擴充失敗（之後的輸出被捨棄） */
+} grep_sink_t;
+
+/**
+ * @brief 一段文字（或一個檔案）的掃描狀態
+ */
+typedef struct {
+    const search_pattern_t *pattern; /**< 編譯後的模式 */
+    const grep_options_t *options; /**< 搜尋選項 */
+    const char *label;             /**< 檔名 */
+    grep_sink_t *sink;             /**< 輸出目的地 */
+    size_t line_no;                /**< 下一段文字開頭的行號 */
+    size_t matches;                /**< 符合的行數 */
+    bool done;                     /**< 已可決定結果（-l 找到第一個匹配），不需繼續讀取 */
+} grep_scan_t;
+
+/**
+ * @brief 批次中的一個檔案
+ */
+typedef struct {
+    vfs_node_t *node;              /**< 檔案節點 */
+    char *label;                   /**< 顯示名稱 */
+    grep_sink_t sink;              /**< 平行階段的輸出 */
+    size_t matches;                /**< 符合的行數 */
+    error_t error;                 /**< 讀取失敗時的錯誤（code 為 ERR_OK 表示成功） */
+} grep_item_t;
+
+/**
+ * @brief 進行中的檔案搜尋
+ */
+struct grep_search {
+    const search_pattern_t *pattern; /**< 編譯後的模式 */
+    grep_options_t options;        /**< 搜尋選項 */
+    FILE *out;                     /**< 輸出串流 */
+    threadpool_t *pool;            /**< 平行掃描使用的執行緒池（可為 NULL） */
+    bool pool_checked;             /**< 是否已嘗試建立執行緒池 */
+    bool ok;                       /**< 目前為止所有檔案都成功讀取 */
+    size_t matches;                /**< 已輸出檔案的符合行數總和 */
+    size_t count;                  /**< 批次中的檔案數 */
+    size_t bytes;                  /**< 批次中的內容總大小 */
+    grep_item_t items[GREP_BATCH_FILES]; /**< 批次中的檔案（依走訪順序） */
+};
+
+/* ============================================================================
+ * 輸出
+ * ============================================================================ */
+
+/**
+ * @brief 寫出一段資料
+ */
+static void sink_write(grep_sink_t *sink, const char *data, size_t len) {
+    if (sink->file != NULL) {
+        fwrite(data, 1, len, sink->file);
+        return;
+    }
+    if (sink->failed) {
+        return;
+    }
+    
+    if (len > sink->capacity - sink->len) {
+        size_t capacity = (sink->capacity > 0) ? sink->capacity : 4096;
+        while (len > capacity - sink->len) {
+            capacity *= 2;
+        }
+        char *data_new = (char *)safe_realloc(sink->data, capacity);
+        if (data_new == NULL) {
+            sink->failed = true;
+            return;
+        }
+        sink->data = data_new;
+        sink->capacity = capacity;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+}
+
+/**
+ * @brief 寫出檔名或數字欄位，後接 suffix
+ */
+static void sink_field(grep_sink_t *sink, const char *label, size_t number, char suffix) {
+    char buf[32];
+    if (label != NULL) {
+        sink_write(sink, label, strlen(label));
+        sink_write(sink, &suffix, 1);
+    } else {
+        int n = snprintf(buf, sizeof(buf), "%zu%c", number, suffix);
+        sink_write(sink, buf, (size_t)n);
+    }
+}
+
+/**
+ * @brief 清除並釋放緩衝區（內容為解密後的檔案文字）
+ */
+static void sink_release(grep_sink_t *sink) {
+    if (sink->data != NULL) {
+        secure_zero(sink->data, sink->capacity);
+        safe_free(sink->data);
+    }
+    memset(sink, 0, sizeof(*sink));
+}
+
+/* ============================================================================
+ * 掃描
+ * ============================================================================ */
+
+/**
+ * @brief 計算 text[from, to) 中的換行字元數
+ */
+static size_t count_newlines(const char *text, size_t from, size_t to) {
+    size_t count = 0;
+    while (from < to) {
+        const char *nl = (const char *)memchr(text + from, '\n', to - from);
+        if (nl == NULL) {
+            break;
+        }
+        count++;
+        from = (size_t)(nl - text) + 1;
+    }
+    return count;
+}
+
+/**
+ * @brief 掃描只含完整行的一段文字（或檔案的最後一段），輸出符合的行
+ *
+ * 模式不含換行字元，因此直接在整段文字中搜尋下一個匹配，
+ * 再向前後找出所在行；不符合的行不需逐行比對。
+ */
+static void scan_lines(grep_scan_t *scan, const char *text, size_t len) {
+    const grep_options_t *options = scan->options;
+    bool print_lines = !options->count_only && !options->files_only;
+    size_t counted = 0;  // 已計算行號的位置
+    size_t pos = 0;
+    
+    while (pos < len && !scan->done) {
+        const char *found = search_find(scan->pattern, text + pos, len - pos);
+        if (found == NULL) {
+            break;
+        }
+        
+        // 找出匹配所在行的範圍
+        size_t at = (size_t)(found - text);
+        size_t start = at;
+        while (start > pos && text[start - 1] != '\n') {
+            start--;
+        }
+        const char *newline = (const char *)memchr(text + at, '\n', len - at);
+        size_t end = (newline != NULL) ? (size_t)(newline - text) : len;
+        scan->matches++;
+        scan->done = options->files_only;
+        
+        if (print_lines) {
+            // 只計算上一個匹配行到本行之間的換行字元
+            if (options->line_numbers) {
+                scan->line_no += count_newlines(text, counted, start);
+                counted = start;
+            }
+            if (options->show_label && scan->label != NULL) {
+                sink_field(scan->sink, scan->label, 0, ':');
+            }
+            if (options->line_numbers) {
+                sink_field(scan->sink, NULL, scan->line_no, ':');
+            }
+            sink_write(scan->sink, text + start, end - start);
+            sink_write(scan->sink, "\n", 1);
+        }
+        pos = end + 1;
+    }
+    
+    // 下一段文字從本段之後的行開始
+    if (print_lines && options->line_numbers) {
+        scan->line_no += count_newlines(text, counted, len);
+    }
+}
+
+/**
+ * @brief 輸出 -c／-l 的結果
+ */
+static void scan_finish(grep_scan_t *scan) {
+    const grep_options_t *options = scan->options;
+    if (options->files_only) {
+        if (scan->matches > 0) {
+            sink_field(scan->sink, scan->label != NULL ? scan->label : "(標準輸入)", 0, '\n');
+        }
+    } else if (options->count_only) {
+        if (options->show_label && scan->label != NULL) {
+            sink_field(scan->sink, scan->label, 0, ':');
+        }
+        sink_field(scan->sink, NULL, scan->matches, '\n');
+    }
+}
+
+/**
+ * @brief 以 vfs_pread() 分段讀取並掃描檔案（只讀取掃描到的範圍）
+ *
+ * @return 成功回傳 true，讀取失敗回傳 false 並設定錯誤訊息
+ */
+static bool scan_streamed(grep_scan_t *scan, vfs_node_t *node) {
+    size_t capacity = GREP_CHUNK_SIZE;
+    char *buf = (char *)safe_malloc_uninit(capacity);
+    if (buf == NULL) {
+        return false;
+    }
+    
+    bool ok = true;
+    size_t have = 0;     // 緩衝區開頭尚未掃描的不完整行
+    size_t offset = 0;
+    while (offset < node->size && !scan->done) {
+        // 一行超過緩衝區時加倍，讓整行可以放進同一段
+        if (have == capacity) {
+            char *grown = (char *)safe_malloc_uninit(capacity * 2);
+            if (grown == NULL) {
+                ok = false;
+                break;
+            }
+            memcpy(grown, buf, have);
+            secure_zero(buf, capacity);
+            safe_free(buf);
+            buf = grown;
+            capacity *= 2;
+        }
+        
+        size_t n = 0;
+        if (!vfs_pread(node, offset, buf + have, capacity - have, &n)) {
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        offset += n;
+        have += n;
+        
+        // 只掃描到最後一個換行；到達檔案結尾時掃描全部
+        size_t complete = have;
+        if (offset < node->size) {
+            while (complete > 0 && buf[complete - 1] != '\n') {
+                complete--;
+            }
+        }
+        scan_lines(scan, buf, complete);
+        memmove(buf, buf + complete, have - complete);
+        have -= complete;
+    }
+    
+    // 讀取提前結束時，剩餘的不完整行仍需掃描
+    if (ok && have > 0 && !scan->done) {
+        scan_lines(scan, buf, have);
+    }
+    
+    secure_zero(buf, capacity);
+    safe_free(buf);
+    return ok;
+}
+
+/**
+ * @brief 掃描批次中的一個檔案（工作執行緒或呼叫端執行緒）
+ */
+static void scan_item(const grep_search_t *search, grep_item_t *item) {
+    grep_scan_t scan = { search->pattern, &search->options, item->label, &item->sink, 1, 0, false };
+    vfs_node_t *node = item->node;
+    
+    // 連續儲存的內容直接在原處掃描，其他情況分段讀取
+    bool ok = true;
+    vfs_content_view_t view;
+    vfs_content_view(node, &view);
+    if (node->size == 0) {
+        // 空檔案沒有任何行
+    } else if (!view.lazy && view.extents == NULL && view.data != NULL) {
+        scan_lines(&scan, (const char *)view.data, node->size);
+    } else {
+        ok = scan_streamed(&scan, node);
+    }
+    
+    if (ok && item->sink.failed) {
+        error_set(ERR_MEMORY, "搜尋結果的記憶體不足");
+        ok = false;
+    }
+    if (!ok) {
+        item->error = error_get();
+        error_clear();
+        return;
+    }
+    scan_finish(&scan);
+    item->matches = scan.matches;
+}
+
+/**
+ * @brief 平行階段：掃描一個檔案，輸出寫入該項目的緩衝區
+ */
+static void scan_task(void *arg, size_t index) {
+    grep_search_t *search = (grep_search_t *)arg;
+    scan_item(search, &search->items[index]);
+}
+
+/* ============================================================================
+ * 批次
+ * ============================================================================ */
+
+/**
+ * @brief 掃描目前的批次並依序輸出
+ */
+static void batch_flush(grep_search_t *search) {
+    if (search->count == 0) {
+        return;
+    }
+    
+    // 第一次需要平行掃描時才建立執行緒池；只有一個 CPU 時不建立
+    if (search->count > 1 && !search->pool_checked) {
+        search->pool_checked = true;
+        if (threadpool_default_threads() > 1) {
+            search->pool = threadpool_create(0);
+            if (search->pool == NULL) {
+                error_clear();  // 改為依序掃描
+            }
+        }
+    }
+    
+    bool parallel = (search->count > 1 && threadpool_size(search->pool) > 1);
+    if (parallel) {
+        threadpool_parallel_for(search->pool, search->count, scan_task, search);
+    }
+    
+    for (size_t i = 0; i < search->count; i++) {
+        grep_item_t *item = &search->items[i];
+        if (parallel) {
+            fwrite(item->sink.data, 1, item->sink.len, search->out);
+        } else {
+            item->sink.file = search->out;
+            scan_item(search, item);
+        }
+        
+        if (item->error.code != ERR_OK) {
+            fflush(search->out);
+            printf("錯誤: 讀取檔案失敗: %s: %s\n", item->label, item->error.message);
+            search->ok = false;
+        }
+        search->matches += item->matches;
+        
+        sink_release(&item->sink);
+        safe_free(item->label);
+        memset(item, 0, sizeof(*item));
+    }
+    search->count = 0;
+    search->bytes = 0;
+}
+
+/**
+ * @brief 將檔案排入批次（取得 label 的所有權）
+ */
+static void batch_add(grep_search_t *search, vfs_node_t *node, char *label) {
+    bool full = (search->count == GREP_BATCH_FILES) ||
+                (search->count > 0 && search->bytes + node->size > GREP_BATCH_BYTES);
+    if (full) {
+        batch_flush(search);
+    }
+    
+    grep_item_t *item = &search->items[search->count++];
+    item->node = node;
+    item->label = label;
+    search->bytes += node->size;
+}
+
+/**
+ * @brief 連接顯示名稱與子節點名稱
+ * @return 新配置的字串，失敗回傳 NULL
+ */
+static char *join_label(const char *label, const char *name) {
+    size_t label_len = strlen(label);
+    size_t name_len = strlen(name);
+    bool need_slash = (label_len > 0 && label[label_len - 1] != '/');
+    
+    char *joined = (char *)safe_malloc(label_len + need_slash + name_len + 1);
+    if (joined == NULL) {
+        return NULL;
+    }
+    
+    memcpy(joined, label, label_len);
+    if (need_slash) {
+        joined[label_len] = '/';
+    }
+    memcpy(joined + label_len + need_slash, name, name_len + 1);
+    return joined;
+}
+
+/**
+ * @brief 依名稱順序走訪目錄，把檔案排入批次
+ */
+static bool walk_dir(grep_search_t *search, vfs_node_t *dir, const char *label) {
+    vfs_dir_iter_t iter;
+    if (!vfs_dir_iter_begin(&iter, dir, true)) {
+        return false;
+    }
+    
+    vfs_node_t *child;
+    while ((child = vfs_dir_iter_next(&iter)) != NULL) {
+        char *child_label = join_label(label, child->name);
+        if (child_label == NULL) {
+            return false;
+        }
+        
+        if (child->type == VFS_FILE) {
+            batch_add(search, child, child_label);
+        } else {
+            bool ok = walk_dir(search, child, child_label);
+            safe_free(child_label);
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* ============================================================================
+ * 公開函式
+ * ============================================================================ */
+
+/**
+ * @brief 搜尋一段文字並輸出符合的行
+ */
+size_t grep_text(const search_pattern_t *pattern, const grep_options_t *options,
+                 const char *label, const char *text, size_t len, FILE *out) {
+    grep_sink_t sink = { out, NULL, 0, 0, false };
+    grep_scan_t scan = { pattern, options, label, &sink, 1, 0, false };
+    scan_lines(&scan, text, len);
+    scan_finish(&scan);
+    return scan.matches;
+}
+
+/**
+ * @brief 開始一次檔案搜尋
+ */
+grep_search_t *grep_search_begin(const search_pattern_t *pattern, const grep_options_t *options,
+                                 FILE *out) {
+    if (pattern == NULL || options == NULL || out == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的搜尋參數");
+        return NULL;
+    }
+    
+    grep_search_t *search = (grep_search_t *)safe_malloc(sizeof(grep_search_t));
+    if (search == NULL) {
+        return NULL;
+    }
+    search->pattern = pattern;
+    search->options = *options;
+    search->out = out;
+    search->ok = true;
+    return search;
+}
+
+/**
+ * @brief 加入要搜尋的檔案或目錄
+ */
+bool grep_search_add(grep_search_t *search, vfs_node_t *node, const char *label) {
+    if (search == NULL || node == NULL || label == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的搜尋參數");
+        return false;
+    }
+    
+    if (node->type == VFS_DIR) {
+        if (!search->options.recursive) {
+            error_set(ERR_INVALID_INPUT, "%s 是目錄（使用 -r 遞迴搜尋）", label);
+            return false;
+        }
+        return walk_dir(search, node, label);
+    }
+    
+    char *copy = safe_strdup(label);
+    if (copy == NULL) {
+        return false;
+    }
+    batch_add(search, node, copy);
+    return true;
+}
+
+/**
+ * @brief 掃描剩餘的批次、輸出結果並釋放搜尋實例
+ */
+bool grep_search_finish(grep_search_t *search, size_t *matches) {
+    if (search == NULL) {
+        return false;
+    }
+    
+    batch_flush(search);
+    if (matches != NULL) {
+        *matches = search->matches;
+    }
+    
+    bool ok = search->ok;
+    threadpool_destroy(search->pool);
+    safe_free(search);
+    return ok;
+}
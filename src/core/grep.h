@@ -0,0 +1,112 @@
+/**
+ * @file grep.h
+ * @brief VFS 內容搜尋模組標頭檔
+ *
+ * 本模組在 VFS 檔案內容中搜尋包含模式的行（shell 的 grep 命令），包含：
+ * - 單段文字搜尋：管線輸入等已在記憶體中的文字
+ * - 檔案與目錄樹搜尋：依名稱順序走訪子樹，檔案內容交給執行緒池平行掃描
+ *
+ * @note 設計考量：
+ *   - 使用 search.h 的搜尋核心，直接在整段文字中找下一個匹配再向前後找出所在行，
+ *     不符合的行不需逐行比對
+ *   - 走訪在呼叫端執行緒進行，檔案排入批次；每批平行掃描後依走訪順序輸出，
+ *     結果與依序搜尋相同，同時保留在記憶體中的輸出有上限
+ *   - 尚未載入的檔案以 vfs_pread() 分段讀取，只解密掃描到的範圍，
+ *     也不會把內容留在記憶體中；-l 找到第一個匹配即停止讀取該檔案
+ *   - 工作執行緒只讀取檔案內容，不修改 VFS，呼叫端需持有讀取鎖
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef GREP_H
+#define GREP_H
+
+#include "search.h"
+#include "../filesystem/vfs.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/** @brief 每批平行掃描的最多檔案數 */
+#define GREP_BATCH_FILES 256
+
+/** @brief 每批平行掃描的內容大小上限（位元組；單一較大的檔案自成一批） */
+#define GREP_BATCH_BYTES (32u * 1024u * 1024u)
+
+/** @brief 分段讀取尚未載入或分段儲存的檔案時，每次讀取的大小 */
+#define GREP_CHUNK_SIZE (64u * 1024u)
+
+/**
+ * @brief 搜尋選項
+ */
+typedef struct {
+    bool line_numbers;             /**< 在每行前加上行號（-n） */
+    bool count_only;               /**< 只輸出符合的行數（-c） */
+    bool files_only;               /**< 只輸出有匹配的檔名（-l） */
+    bool recursive;                /**< 遞迴搜尋目錄（-r） */
+    bool show_label;               /**< 在每行前加上檔名 */
+} grep_options_t;
+
+/**
+ * @brief 進行中的檔案搜尋（不透明型別）
+ */
+typedef struct grep_search grep_search_t;
+
+/* ============================================================================
+ * 搜尋函式
+ * ============================================================================ */
+
+/**
+ * @brief 搜尋一段文字並輸出符合的行
+ *
+ * @param pattern 編譯後的模式
+ * @param options 搜尋選項
+ * @param label 檔名（options->show_label 或 files_only 時使用，可為 NULL）
+ * @param text 要搜尋的文字
+ * @param len 文字長度
+ * @param out 輸出串流
+ * @return 符合的行數
+ */
+size_t grep_text(const search_pattern_t *pattern, const grep_options_t *options,
+                 const char *label, const char *text, size_t len, FILE *out);
+
+/**
+ * @brief 開始一次檔案搜尋
+ *
+ * @param pattern 編譯後的模式（在 grep_search_finish() 前需保持有效）
+ * @param options 搜尋選項（會被複製）
+ * @param out 輸出串流
+ * @return 搜尋實例，失敗回傳 NULL 並設定錯誤訊息
+ */
+grep_search_t *grep_search_begin(const search_pattern_t *pattern, const grep_options_t *options,
+                                 FILE *out);
+
+/**
+ * @brief 加入要搜尋的檔案或目錄
+ *
+ * 檔案排入批次，批次滿時先平行掃描並輸出；目錄在 recursive 時依名稱順序走訪，
+ * 子節點的檔名為 label 加上相對路徑。讀取失敗的檔案在其輸出位置印出錯誤訊息後略過。
+ *
+ * @param search 搜尋實例
+ * @param node 檔案或目錄節點
+ * @param label 節點的顯示名稱（通常為命令列上的路徑）
+ * @return 成功回傳 true；目錄但未指定 recursive 或記憶體不足時回傳 false 並設定錯誤訊息
+ *         （檔案讀取失敗不影響回傳值，由 grep_search_finish() 回報）
+ */
+bool grep_search_add(grep_search_t *search, vfs_node_t *node, const char *label);
+
+/**
+ * @brief 掃描剩餘的批次、輸出結果並釋放搜尋實例
+ *
+ * @param search 搜尋實例（可為 NULL）
+ * @param matches 輸出參數，所有檔案符合的行數總和（可為 NULL）
+ * @return 所有檔案都成功讀取回傳 true
+ */
+bool grep_search_finish(grep_search_t *search, size_t *matches);
+
+#endif // GREP_H
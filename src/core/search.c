@@ -0,0 +1,284 @@
+/**
+ * @file search.c
+ * @brief 文字搜尋引擎模組實作
+ *
+ * 實作 Boyer-Moore-Horspool 正向與反向搜尋，以及沿行鏈結串列的跨行搜尋。
+ */
+
+#include "search.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include <string.h>
+
+/* ============================================================================
+ * 私有輔助函式
+ * ============================================================================ */
+
+/**
+ * @brief 估計位元組在一般文字中的出現頻率（越大越常見）
+ *
+ * 只用來挑選預先篩選的位元組，不需要精確。
+ */
+static int byte_frequency(unsigned char c) {
+    if (c == ' ' || (c != '\0' && strchr("etaoinsrhl", c) != NULL)) {
+        return 6;
+    }
+    if (c >= 'a' && c <= 'z') {
+        return 5;
+    }
+    if (c >= 0x80) {
+        return 4;  /* UTF-8 多位元組字元（中文）的組成位元組 */
+    }
+    if (c >= '0' && c <= '9') {
+        return 3;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return 2;
+    }
+    return 1;
+}
+
+/**
+ * @brief 以位移表（Boyer-Moore-Horspool）從 pos 開始搜尋
+ */
+static const char *find_bmh(const search_pattern_t *pattern, const char *text, size_t len, size_t pos) {
+    const char *pat = pattern->text;
+    size_t m = pattern->length;
+    unsigned char tail = (unsigned char)pat[m - 1];
+    
+    while (pos <= len - m) {
+        unsigned char c = (unsigned char)text[pos + m - 1];
+        if (c == tail && memcmp(text + pos, pat, m - 1) == 0) {
+            return text + pos;
+        }
+        pos += pattern->skip[c];
+    }
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * 模式管理實作
+ * ============================================================================ */
+
+search_pattern_t *search_compile(const char *pattern) {
+    /* 參數驗證 */
+    if (pattern == NULL || pattern[0] == '\0') {
+        error_set(ERR_INVALID_INPUT, "搜尋模式為空");
+        return NULL;
+    }
+    
+    search_pattern_t *compiled = (search_pattern_t *)safe_malloc(sizeof(search_pattern_t));
+    if (compiled == NULL) {
+        return NULL;
+    }
+    
+    compiled->text = safe_strdup(pattern);
+    if (compiled->text == NULL) {
+        safe_free(compiled);
+        return NULL;
+    }
+    
+    size_t m = strlen(pattern);
+    compiled->length = m;
+    
+    /* 挑選最稀有的位元組作為 memchr 預先篩選的目標 */
+    compiled->rare_index = 0;
+    for (size_t i = 1; i < m; i++) {
+        if (byte_frequency((unsigned char)pattern[i]) <
+            byte_frequency((unsigned char)pattern[compiled->rare_index])) {
+            compiled->rare_index = i;
+        }
+    }
+    
+    /* 正向：視窗最後一個位元組 c 對齊到模式中 c 最右側（不含最後一個）的出現位置 */
+    for (size_t c = 0; c < 256; c++) {
+        compiled->skip[c] = m;
+        compiled->rskip[c] = m;
+    }
+    for (size_t i = 0; i + 1 < m; i++) {
+        compiled->skip[(unsigned char)pattern[i]] = m - 1 - i;
+    }
+    
+    /* 反向：視窗第一個位元組 c 對齊到模式中 c 最左側（不含第一個）的出現位置 */
+    for (size_t i = m - 1; i > 0; i--) {
+        compiled->rskip[(unsigned char)pattern[i]] = i;
+    }
+    
+    return compiled;
+}
+
+void search_free(search_pattern_t *pattern) {
+    if (pattern == NULL) {
+        return;
+    }
+    
+    safe_free(pattern->text);
+    safe_free(pattern);
+}
+
+/* ============================================================================
+ * 單行搜尋實作
+ * ============================================================================ */
+
+const char *search_find(const search_pattern_t *pattern, const char *text, size_t len) {
+    if (pattern == NULL || text == NULL || len < pattern->length) {
+        return NULL;
+    }
+    
+    const char *pat = pattern->text;
+    size_t m = pattern->length;
+    size_t rare = pattern->rare_index;
+    unsigned char rare_byte = (unsigned char)pat[rare];
+    
+    /* 以 memchr 跳到稀有位元組的候選位置再比對整個模式 */
+    size_t pos = 0;
+    size_t misses = 0;
+    while (pos <= len - m) {
+        const char *hit = (const char *)memchr(text + pos + rare, rare_byte, len - m - pos + 1);
+        if (hit == NULL) {
+            return NULL;
+        }
+        
+        pos = (size_t)(hit - text) - rare;
+        if (memcmp(text + pos, pat, m) == 0) {
+            return text + pos;
+        }
+        pos++;
+        
+        /* 候選位置太密集時 memchr 反而較慢，改用位移表處理剩餘部分 */
+        misses++;
+        if (m >= SEARCH_BMH_MIN_LENGTH && misses >= 4 && misses * SEARCH_PREFILTER_MIN_GAP > pos) {
+            return (pos <= len - m) ? find_bmh(pattern, text, len, pos) : NULL;
+        }
+    }
+    
+    return NULL;
+}
+
+const char *search_find_last(const search_pattern_t *pattern, const char *text, size_t len) {
+    if (pattern == NULL || text == NULL || len < pattern->length) {
+        return NULL;
+    }
+    
+    const char *pat = pattern->text;
+    size_t m = pattern->length;
+    unsigned char head = (unsigned char)pat[0];
+    
+    /* 反向 Boyer-Moore-Horspool：視窗由右往左，依視窗第一個位元組決定位移量 */
+    size_t pos = len - m;
+    for (;;) {
+        unsigned char c = (unsigned char)text[pos];
+        if (c == head && memcmp(text + pos + 1, pat + 1, m - 1) == 0) {
+            return text + pos;
+        }
+        
+        size_t shift = pattern->rskip[c];
+        if (pos < shift) {
+            return NULL;
+        }
+        pos -= shift;
+    }
+}
+
+/* ============================================================================
+ * 緩衝區搜尋實作
+ * ============================================================================ */
+
+bool search_buffer_forward(buffer_t *buf, const search_pattern_t *pattern,
+                           size_t row, size_t col, bool wrap,
+                           size_t *out_row, size_t *out_col) {
+    if (buf == NULL || pattern == NULL || out_row == NULL || out_col == NULL ||
+        row >= buf->line_count) {
+        return false;
+    }
+    
+    /* 起始行只搜尋 col 之後的部分，之後沿鏈結串列逐行前進 */
+    line_t *line = buffer_get_line(buf, row);
+    size_t start = col;
+    for (size_t r = row; line != NULL; r++, line = line->next) {
+        if (start < line->length) {
+            const char *found = search_find(pattern, line->text + start, line->length - start);
+            if (found != NULL) {
+                *out_row = r;
+                *out_col = (size_t)(found - line->text);
+                return true;
+            }
+        }
+        start = 0;
+    }
+    
+    if (!wrap) {
+        return false;
+    }
+    
+    /* 循環：從檔案開頭搜尋到起始行（起始行中 col 之後已確認沒有匹配） */
+    line = buf->head;
+    for (size_t r = 0; r <= row && line != NULL; r++, line = line->next) {
+        const char *found = search_find(pattern, line->text, line->length);
+        if (found != NULL) {
+            *out_row = r;
+            *out_col = (size_t)(found - line->text);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool search_buffer_backward(buffer_t *buf, const search_pattern_t *pattern,
+                            size_t row, size_t col, bool wrap,
+                            size_t *out_row, size_t *out_col) {
+    if (buf == NULL || pattern == NULL || out_row == NULL || out_col == NULL ||
+        row >= buf->line_count) {
+        return false;
+    }
+    
+    /* 起始行只接受起點在 col 之前的匹配（匹配本身可延伸到 col 之後） */
+    line_t *line = buffer_get_line(buf, row);
+    size_t m = pattern->length;
+    if (line != NULL && col > 0) {
+        size_t limit = col - 1 + m;
+        if (limit > line->length) {
+            limit = line->length;
+        }
+        const char *found = search_find_last(pattern, line->text, limit);
+        if (found != NULL) {
+            *out_row = row;
+            *out_col = (size_t)(found - line->text);
+            return true;
+        }
+    }
+    
+    /* 沿鏈結串列逐行後退 */
+    size_t r = row;
+    for (line = (line != NULL) ? line->prev : NULL; line != NULL; line = line->prev) {
+        r--;
+        const char *found = search_find_last(pattern, line->text, line->length);
+        if (found != NULL) {
+            *out_row = r;
+            *out_col = (size_t)(found - line->text);
+            return true;
+        }
+    }
+    
+    if (!wrap) {
+        return false;
+    }
+    
+    /* 循環：從檔案尾端搜尋到起始行（起始行中 col 之前已確認沒有匹配） */
+    line = buf->tail;
+    for (r = buf->line_count - 1; r >= row && line != NULL; r--, line = line->prev) {
+        const char *found = search_find_last(pattern, line->text, line->length);
+        if (found != NULL) {
+            *out_row = r;
+            *out_col = (size_t)(found - line->text);
+            return true;
+        }
+        if (r == 0) {
+            break;
+        }
+    }
+    
+    return false;
+}
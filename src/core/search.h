@@ -0,0 +1,143 @@
+/**
+ * @file search.h
+ * @brief 文字搜尋引擎模組標頭檔
+ *
+ * 本模組提供編輯器使用的子字串搜尋，包含：
+ * - 模式編譯：預先計算 Boyer-Moore-Horspool 的正向與反向位移表
+ * - 單行搜尋：第一個匹配與最後一個匹配
+ * - 緩衝區搜尋：從指定位置跨行向前/向後搜尋，可循環
+ *
+ * @note 設計考量：
+ *   - 編譯後的模式可在 n/N 之間重複使用，不需重新計算位移表
+ *   - 先以 memchr 掃描模式中最稀有的位元組（標準函式庫以 SIMD 實作），
+ *     候選位置過於密集時才改用位移表
+ *   - 反向搜尋使用反向位移表，一次掃描即可找到最後一個匹配
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "buffer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ============================================================================
+ * 常數定義
+ * ============================================================================ */
+
+/**
+ * @brief 使用位移表的最短模式長度
+ *
+ * 較短的模式位移量有限，直接以 memchr 尋找首字元再比對較快。
+ */
+#define SEARCH_BMH_MIN_LENGTH 4
+
+/**
+ * @brief memchr 預先篩選的平均命中間距下限（位元組）
+ *
+ * 稀有位元組的候選位置比此更密集時（至少錯失 4 次後判斷），改用位移表繼續搜尋該段文字。
+ */
+#define SEARCH_PREFILTER_MIN_GAP 32
+
+/* ============================================================================
+ * 資料結構定義
+ * ============================================================================ */
+
+/**
+ * @brief 編譯後的搜尋模式
+ */
+typedef struct search_pattern {
+    char *text;                 /**< 模式文字（以 null 結尾） */
+    size_t length;              /**< 模式長度 */
+    size_t rare_index;          /**< 預先篩選使用的位元組在模式中的位置 */
+    size_t skip[256];           /**< 正向位移表（依視窗最後一個位元組） */
+    size_t rskip[256];          /**< 反向位移表（依視窗第一個位元組） */
+} search_pattern_t;
+
+/* ============================================================================
+ * 模式管理
+ * ============================================================================ */
+
+/**
+ * @brief 編譯搜尋模式
+ *
+ * @param pattern 要搜尋的文字（不可為空字串）
+ * @return 編譯後的模式，失敗時回傳 NULL 並設定錯誤訊息
+ * @note 呼叫者需負責使用 search_free() 釋放
+ */
+search_pattern_t *search_compile(const char *pattern);
+
+/**
+ * @brief 釋放編譯後的搜尋模式
+ *
+ * @param pattern 要釋放的模式（可為 NULL）
+ */
+void search_free(search_pattern_t *pattern);
+
+/* ============================================================================
+ * 單行搜尋
+ * ============================================================================ */
+
+/**
+ * @brief 在文字中尋找第一個匹配
+ *
+ * @param pattern 編譯後的模式
+ * @param text 搜尋的文字（不需以 null 結尾）
+ * @param len 文字長度
+ * @return 匹配的起始位置，找不到時回傳 NULL
+ */
+const char *search_find(const search_pattern_t *pattern, const char *text, size_t len);
+
+/**
+ * @brief 在文字中尋找最後一個匹配
+ *
+ * @param pattern 編譯後的模式
+ * @param text 搜尋的文字（不需以 null 結尾）
+ * @param len 文字長度
+ * @return 匹配的起始位置，找不到時回傳 NULL
+ */
+const char *search_find_last(const search_pattern_t *pattern, const char *text, size_t len);
+
+/* ============================================================================
+ * 緩衝區搜尋
+ * ============================================================================ */
+
+/**
+ * @brief 從指定位置向檔案尾端搜尋
+ *
+ * 找出起點位於 (row, col) 或之後的第一個匹配（包含該位置）；
+ * wrap 為 true 時到達尾端後從檔案開頭繼續，直到回到起始行。
+ *
+ * @param buf 目標緩衝區
+ * @param pattern 編譯後的模式
+ * @param row 起始行號
+ * @param col 起始欄位（可超過行長度）
+ * @param wrap 是否循環搜尋
+ * @param out_row 輸出參數，匹配所在行號
+ * @param out_col 輸出參數，匹配所在欄位
+ * @return 找到回傳 true，否則回傳 false
+ */
+bool search_buffer_forward(buffer_t *buf, const search_pattern_t *pattern,
+                           size_t row, size_t col, bool wrap,
+                           size_t *out_row, size_t *out_col);
+
+/**
+ * @brief 從指定位置向檔案頭端搜尋
+ *
+ * 找出起點位於 (row, col) 之前的最後一個匹配（不包含該位置）；
+ * wrap 為 true 時到達開頭後從檔案尾端繼續，直到回到起始行。
+ *
+ * @param buf 目標緩衝區
+ * @param pattern 編譯後的模式
+ * @param row 起始行號
+ * @param col 起始欄位（可超過行長度）
+ * @param wrap 是否循環搜尋
+ * @param out_row 輸出參數，匹配所在行號
+ * @param out_col 輸出參數，匹配所在欄位
+ * @return 找到回傳 true，否則回傳 false
+ */
+bool search_buffer_backward(buffer_t *buf, const search_pattern_t *pattern,
+                            size_t row, size_t col, bool wrap,
+                            size_t *out_row, size_t *out_col);
+
+#endif // SEARCH_H
@@ -6,12 +6,16 @@
  * 具體的命令實作委託給 shell_commands 模組。
  */
 
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 open_memstream） */
+
 #include "shell.h"
 #include "shell_commands.h"
 #include "shell_completion.h"
 #include "../filesystem/vfs.h"
 #include "../filesystem/vfs_persist.h"
+#include "../filesystem/vfs_journal.h"
 #include "../filesystem/fileops.h"
+#include "../security/kdf.h"
 #include "../utils/memory.h"
 #include "../utils/error.h"
 #include "../ui/splash.h"
@@ -19,6 +23,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 #if defined(__unix__) || defined(__APPLE__)
 #include <termios.h>
 #include <unistd.h>
@@ -34,12 +39,30 @@
 /** @brief 命令參數最大數量 */
 #define MAX_ARGS 64
 
+/** @brief 管線中最多的命令數量 */
+#define MAX_PIPELINE_STAGES 16
+
+/** @brief 命令分派雜湊表槽數（2 的冪次，需大於命令數量） */
+#define CMD_HASH_SLOTS 64
+
+/** @brief 尋找無碰撞雜湊種子時最多嘗試的次數 */
+#define CMD_HASH_MAX_SEEDS 100000u
+
 /** @brief VFS 持久化檔案名稱 */
 #define VFS_DATA_FILE ".yunfs_data"
 
 /** @brief VFS 加密金鑰 */
 #define ENCRYPTION_KEY "yunhongisbest"
 
+/** @brief 自動儲存間隔的環境變數（秒，0 停用自動儲存） */
+#define AUTOSAVE_INTERVAL_ENV "YUNFS_AUTOSAVE_INTERVAL"
+
+/** @brief 自動儲存變更量門檻的環境變數（位元組） */
+#define AUTOSAVE_BYTES_ENV "YUNFS_AUTOSAVE_BYTES"
+
+/** @brief 密鑰衍生成本的環境變數（scrypt N 的以 2 為底對數） */
+#define KDF_COST_ENV "YUNFS_KDF_COST"
+
 /* ============================================================================
  * 命令表定義
  * ============================================================================ */
@@ -49,12 +72,22 @@
  */
 typedef bool (*cmd_handler_t)(shell_t *shell, int argc, char **argv);
 
+/**
+ * @brief 命令執行期間持有的 VFS 鎖
+ */
+typedef enum {
+    CMD_LOCK_READ,          /**< 唯讀命令，執行期間持有讀取鎖 */
+    CMD_LOCK_WRITE,         /**< 修改 VFS，執行期間持有寫入鎖 */
+    CMD_LOCK_SELF           /**< 由命令自行在存取 VFS 時取得鎖（如 vim 編輯期間不持有鎖） */
+} cmd_lock_t;
+
 /**
  * @brief 命令表項目結構
  */
 typedef struct {
     const char *name;       /**< 命令名稱 */
     cmd_handler_t handler;  /**< 命令處理函數 */
+    cmd_lock_t lock;        /**< 分派時取得的 VFS 鎖 */
 } cmd_entry_t;
 
 /**
@@ -63,22 +96,61 @@ typedef struct {
  * 使用表驅動方式管理命令，便於擴展和維護。
  */
 static const cmd_entry_t cmd_table[] = {
-    { "ls",      cmd_ls      },
-    { "cd",      cmd_cd      },
-    { "pwd",     cmd_pwd     },
-    { "mkdir",   cmd_mkdir   },
-    { "touch",   cmd_touch   },
-    { "cat",     cmd_cat     },
-    { "echo",    cmd_echo    },
-    { "rm",      cmd_rm      },
-    { "mv",      cmd_mv      },
-    { "cp",      cmd_cp      },
-    { "vim",     cmd_vim     },
-    { "clear",   cmd_clear   },
-    { "help",    cmd_help    },
-    { "history", cmd_history },
-    { "exit",    cmd_exit    },
-    { NULL,      NULL        }  // 結束標記
+    { "ls",      cmd_ls,      CMD_LOCK_READ  },
+    { "cd",      cmd_cd,      CMD_LOCK_READ  },
+    { "pwd",     cmd_pwd,     CMD_LOCK_READ  },
+    { "du",      cmd_du,      CMD_LOCK_READ  },
+    { "df",      cmd_df,      CMD_LOCK_READ  },
+    { "meminfo", cmd_meminfo, CMD_LOCK_READ  },
+    { "stats",   cmd_stats,   CMD_LOCK_READ  },
+    { "mkdir",   cmd_mkdir,   CMD_LOCK_WRITE },
+    { "touch",   cmd_touch,   CMD_LOCK_WRITE },
+    { "cat",     cmd_cat,     CMD_LOCK_READ  },
+    { "echo",    cmd_echo,    CMD_LOCK_WRITE },
+    { "grep",    cmd_grep,    CMD_LOCK_READ  },
+    { "rm",      cmd_rm,      CMD_LOCK_WRITE },
+    { "mv",      cmd_mv,      CMD_LOCK_WRITE },
+    { "cp",      cmd_cp,      CMD_LOCK_WRITE },
+    { "import",  cmd_import,  CMD_LOCK_WRITE },
+    { "export",  cmd_export,  CMD_LOCK_READ  },
+    { "vim",     cmd_vim,     CMD_LOCK_SELF  },
+    { "clear",   cmd_clear,   CMD_LOCK_READ  },
+    { "help",    cmd_help,    CMD_LOCK_READ  },
+    { "history", cmd_history, CMD_LOCK_READ  },
+    { "exit",    cmd_exit,    CMD_LOCK_READ  },
+    { NULL,      NULL,        CMD_LOCK_READ  }  // 結束標記
+};
+
+/**
+ * @brief 命令分派的完美雜湊表
+ * 
+ * 首次分派時以命令表尋找一個讓所有命令名稱落在不同槽位的種子，
+ * 之後查詢只需計算一次雜湊並比對一次字串。
+ */
+static struct {
+    uint8_t slots[CMD_HASH_SLOTS];  /**< 命令表索引 + 1（0 表示空槽） */
+    uint32_t seed;                  /**< 雜湊種子 */
+    int state;                      /**< 0 尚未建立，1 可用，-1 找不到種子（改為依序比對） */
+} cmd_dispatch;
+
+/* ============================================================================
+ * 命令列解析緩衝區
+ * ============================================================================ */
+
+/**
+ * @brief 重複使用的命令列解析緩衝區
+ * 
+ * 命令列複製到 text 後就地以 '\0' 切分，argv 指向其中，
+ * 各管線階段的參數在 argv 中以 NULL 分隔。text 只在命令列變長時擴充，
+ * 之後的命令不需配置記憶體。
+ */
+struct shell_line_arena {
+    char *text;                                  /**< 切分後的命令列 */
+    size_t capacity;                             /**< text 容量 */
+    char *argv[MAX_ARGS + MAX_PIPELINE_STAGES];  /**< 所有階段的參數指標 */
+    int stage_start[MAX_PIPELINE_STAGES];        /**< 各階段第一個參數在 argv 中的位置 */
+    int stage_argc[MAX_PIPELINE_STAGES];         /**< 各階段的參數數量 */
+    int stages;                                  /**< 階段數量（0 表示空命令） */
 };
 
 /* ============================================================================
@@ -95,7 +167,7 @@ static bool read_password(char *password, size_t size) {
     if (password == NULL || size == 0) {
         return false;
     }
-    
+
 #if defined(__unix__) || defined(__APPLE__)
     // Unix/Linux/macOS 系統：關閉 echo 來隱藏輸入
     struct termios old_term, new_term;
@@ -179,11 +251,16 @@ static bool verify_password(const char *input_password) {
  * Shell 生命週期管理
  * ============================================================================ */
 
+static void shell_init_state(shell_t *shell);
+static void shell_start_autosave(shell_t *shell);
+static void shell_apply_kdf_cost(void);
+
 shell_t *shell_create(void) {
     shell_t *shell = (shell_t *)safe_malloc(sizeof(shell_t));
     if (shell == NULL) {
         return NULL;
     }
+    shell_apply_kdf_cost();
     
     // 檢查是否存在 .yunfs_data 檔案
     bool data_file_exists = fileops_exists(VFS_DATA_FILE);
@@ -241,38 +318,184 @@ shell_t *shell_create(void) {
         return NULL;
     }
     
-    // 初始化 Shell 狀態
+    // 開啟持久化日誌，之後的變更即時記錄；失敗時改為結束時完整儲存
+    shell->journal = vfs_journal_open(shell->vfs, VFS_DATA_FILE, ENCRYPTION_KEY);
+    if (shell->journal == NULL) {
+        error_clear();
+    }
+    
+    shell_init_state(shell);
+    shell_start_autosave(shell);
+    return shell;
+}
+
+shell_t *shell_create_batch(const char *password) {
+    shell_t *shell = (shell_t *)safe_malloc(sizeof(shell_t));
+    if (shell == NULL) {
+        return NULL;
+    }
+    shell_apply_kdf_cost();
+    
+    if (fileops_exists(VFS_DATA_FILE)) {
+        // 現有資料一律載入，密碼由呼叫者提供（不互動詢問）
+        if (!verify_password(password)) {
+            error_set(ERR_PERMISSION, "密碼錯誤或未提供密碼，拒絕存取");
+            safe_free(shell);
+            return NULL;
+        }
+        
+        shell->vfs = vfs_load_encrypted(VFS_DATA_FILE, password);
+        if (shell->vfs == NULL) {
+            safe_free(shell);
+            return NULL;
+        }
+        
+        // 重播上次互動模式留下的日誌後立即卸離，批次中的變更不逐筆寫入日誌
+        vfs_journal_t *journal = vfs_journal_open(shell->vfs, VFS_DATA_FILE, ENCRYPTION_KEY);
+        if (journal == NULL || !vfs_journal_close(journal)) {
+            error_clear();
+        }
+    } else {
+        shell->vfs = vfs_init();
+        if (shell->vfs == NULL) {
+            safe_free(shell);
+            return NULL;
+        }
+    }
+    
+    // 無日誌：由背景自動儲存與 shell_destroy 寫出完整快照
+    shell->journal = NULL;
+    shell_init_state(shell);
+    shell->batch = true;
+    shell_start_autosave(shell);
+    return shell;
+}
+
+/**
+ * @brief 初始化 Shell 的執行狀態（VFS 與日誌以外的欄位）
+ */
+static void shell_init_state(shell_t *shell) {
     shell->current_dir = shell->vfs->root;
     shell->prompt = safe_strdup("yun-fs$ ");
     shell->running = true;
     shell->history_count = 0;
+    shell->out = stdout;
+    shell->pipe_input = NULL;
+    shell->pipe_input_len = 0;
+    shell->line_arena = NULL;
+    shell->autosave = NULL;
+    
+    shell->batch = false;
+    shell->vfs_locked = false;
     
     // 初始化歷史記錄陣列
     for (int i = 0; i < HISTORY_MAX; i++) {
         shell->history[i] = NULL;
     }
+}
+
+/**
+ * @brief 讀取數值設定的環境變數
+ * @return 環境變數的數值，未設定或格式錯誤時回傳 fallback
+ */
+static unsigned long env_setting(const char *name, unsigned long fallback) {
+    const char *value = getenv(name);
+    if (value == NULL || *value == '\0') {
+        return fallback;
+    }
     
-    return shell;
+    char *end = NULL;
+    unsigned long parsed = strtoul(value, &end, 10);
+    return (*end == '\0') ? parsed : fallback;
 }
 
-void shell_destroy(shell_t *shell) {
-    if (shell == NULL) {
+/**
+ * @brief 依環境變數設定儲存時的密鑰衍生成本（無效的值維持預設）
+ */
+static void shell_apply_kdf_cost(void) {
+    kdf_params_t params = vfs_persist_kdf();
+    unsigned long log_n = env_setting(KDF_COST_ENV, params.log_n);
+    if (log_n > UINT8_MAX) {
+        return;
+    }
+    
+    params.log_n = (uint8_t)log_n;
+    if (!vfs_persist_set_kdf(&params)) {
+        error_clear();
+    }
+}
+
+/**
+ * @brief 啟動背景自動儲存（失敗時維持結束時儲存）
+ */
+static void shell_start_autosave(shell_t *shell) {
+    unsigned long interval = env_setting(AUTOSAVE_INTERVAL_ENV, VFS_AUTOSAVE_INTERVAL);
+    if (interval == 0 || interval > UINT32_MAX) {
         return;
     }
     
-    // 保存 VFS 到持久化檔案
+    size_t dirty_bytes = (size_t)env_setting(AUTOSAVE_BYTES_ENV, VFS_AUTOSAVE_DIRTY_BYTES);
+    shell->autosave = vfs_autosave_start(shell->vfs, shell->journal, VFS_DATA_FILE, ENCRYPTION_KEY,
+                                         (unsigned)interval, dirty_bytes);
+    if (shell->autosave == NULL) {
+        error_clear();
+    }
+}
+
+bool shell_destroy(shell_t *shell) {
+    if (shell == NULL) {
+        return true;
+    }
+    
+    bool ok = true;
+    
+    // 保存 VFS 到持久化檔案：有日誌時只需同步日誌，
+    // 否則只在有未儲存的變更（或尚未建立映像檔）時完整儲存
     if (shell->vfs != NULL) {
-        vfs_save_encrypted(shell->vfs, VFS_DATA_FILE, ENCRYPTION_KEY);
+        // 中斷信號可能在命令執行中途送達，先釋放命令持有的鎖
+        if (shell->vfs_locked) {
+            shell->vfs_locked = false;
+            vfs_unlock(shell->vfs);
+        }
+        if (!vfs_autosave_stop(shell->autosave)) {
+            error_clear();
+        }
+        shell->autosave = NULL;
+        
+        bool saved;
+        if (shell->journal != NULL) {
+            saved = vfs_journal_close(shell->journal);
+        } else {
+            saved = shell->vfs->dirty_ops == 0 && shell->vfs->image_id != 0;
+        }
+        if (!saved && !vfs_save_encrypted(shell->vfs, VFS_DATA_FILE, ENCRYPTION_KEY)) {
+            // 例如延遲載入的區塊在儲存時驗證失敗；先前的映像檔與日誌保持不變
+            error_t err = error_get();
+            fprintf(stderr, "錯誤: 無法儲存 VFS%s%s\n",
+                    err.code != ERR_OK ? ": " : "", err.code != ERR_OK ? err.message : "");
+            ok = false;
+        }
+        shell->journal = NULL;
         vfs_destroy(shell->vfs);
     }
     
+    // 工作階段結束，清除快取的衍生密鑰與主執行緒的暫存區段
+    kdf_cache_clear();
+    scratch_arena_release();
+    
     // 釋放歷史記錄
     for (int i = 0; i < shell->history_count; i++) {
         safe_free(shell->history[i]);
     }
     
+    if (shell->line_arena != NULL) {
+        safe_free(shell->line_arena->text);
+        safe_free(shell->line_arena);
+    }
+    
     safe_free(shell->prompt);
     safe_free(shell);
+    return ok;
 }
 
 /* ============================================================================
@@ -334,47 +557,237 @@ void shell_free_args(char **args, int argc) {
 }
 
 /**
- * @brief 在命令表中查找命令處理函數
+ * @brief 計算命令名稱的雜湊值（FNV-1a 加上最終混合，讓低位元也均勻分布）
+ */
+static uint32_t command_hash(const char *name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (; *name != '\0'; name++) {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/**
+ * @brief 為命令表建立完美雜湊表
+ */
+static void build_dispatch_table(void) {
+    for (uint32_t seed = 0; seed < CMD_HASH_MAX_SEEDS; seed++) {
+        memset(cmd_dispatch.slots, 0, sizeof(cmd_dispatch.slots));
+        
+        bool collision = false;
+        for (int i = 0; cmd_table[i].name != NULL && !collision; i++) {
+            uint32_t slot = command_hash(cmd_table[i].name, seed) & (CMD_HASH_SLOTS - 1);
+            if (cmd_dispatch.slots[slot] != 0 || i + 1 > UINT8_MAX) {
+                collision = true;
+            } else {
+                cmd_dispatch.slots[slot] = (uint8_t)(i + 1);
+            }
+        }
+        
+        if (!collision) {
+            cmd_dispatch.seed = seed;
+            cmd_dispatch.state = 1;
+            return;
+        }
+    }
+    
+    cmd_dispatch.state = -1;
+}
+
+/**
+ * @brief 在命令表中查找命令
  * @param name 命令名稱
- * @return 對應的處理函數，找不到返回 NULL
+ * @return 對應的命令表項目，找不到返回 NULL
  */
-static cmd_handler_t find_command_handler(const char *name) {
+static const cmd_entry_t *find_command(const char *name) {
+    if (cmd_dispatch.state == 0) {
+        build_dispatch_table();
+    }
+    
+    if (cmd_dispatch.state > 0) {
+        uint32_t slot = command_hash(name, cmd_dispatch.seed) & (CMD_HASH_SLOTS - 1);
+        int index = cmd_dispatch.slots[slot];
+        if (index != 0 && strcmp(cmd_table[index - 1].name, name) == 0) {
+            return &cmd_table[index - 1];
+        }
+        return NULL;
+    }
+    
     for (int i = 0; cmd_table[i].name != NULL; i++) {
         if (strcmp(cmd_table[i].name, name) == 0) {
-            return cmd_table[i].handler;
+            return &cmd_table[i];
         }
     }
     return NULL;
 }
 
+/**
+ * @brief 將命令列切分為各管線階段的參數
+ * 
+ * 參數以空白分隔，| 分隔管線階段（前後不需空白）。
+ * 
+ * @param shell Shell 實例（使用其命令列解析緩衝區）
+ * @param line 命令列
+ * @return 成功返回 true，語法錯誤或記憶體不足返回 false 並設定錯誤訊息
+ */
+static bool parse_pipeline(shell_t *shell, const char *line) {
+    if (shell->line_arena == NULL) {
+        shell->line_arena = (struct shell_line_arena *)safe_malloc(sizeof(struct shell_line_arena));
+        if (shell->line_arena == NULL) {
+            return false;
+        }
+    }
+    struct shell_line_arena *arena = shell->line_arena;
+    
+    // 每個參數後加上 '\0'，| 緊鄰參數時最多需要兩倍長度
+    size_t need = strlen(line) * 2 + 1;
+    if (need > arena->capacity) {
+        char *text = (char *)safe_realloc(arena->text, need);
+        if (text == NULL) {
+            return false;
+        }
+        arena->text = text;
+        arena->capacity = need;
+    }
+    
+    char *out = arena->text;
+    int count = 0;   // argv 中已使用的位置（含階段分隔的 NULL）
+    int args = 0;    // 參數總數
+    int stage = 0;
+    arena->stage_start[0] = 0;
+    arena->stage_argc[0] = 0;
+    
+    const char *p = line;
+    for (;;) {
+        while (*p && isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        
+        if (*p == '|') {
+            if (arena->stage_argc[stage] == 0) {
+                error_set(ERR_INVALID_INPUT, "語法錯誤: 管線中有空的命令");
+                return false;
+            }
+            if (stage + 1 >= MAX_PIPELINE_STAGES) {
+                error_set(ERR_INVALID_INPUT, "管線中的命令過多（最多 %d 個）", MAX_PIPELINE_STAGES);
+                return false;
+            }
+            arena->argv[count++] = NULL;
+            stage++;
+            arena->stage_start[stage] = count;
+            arena->stage_argc[stage] = 0;
+            p++;
+            continue;
+        }
+        
+        if (args >= MAX_ARGS - 1) {
+            error_set(ERR_INVALID_INPUT, "參數過多（最多 %d 個）", MAX_ARGS - 1);
+            return false;
+        }
+        
+        arena->argv[count++] = out;
+        while (*p && !isspace((unsigned char)*p) && *p != '|') {
+            *out++ = *p++;
+        }
+        *out++ = '\0';
+        arena->stage_argc[stage]++;
+        args++;
+    }
+    
+    if (stage > 0 && arena->stage_argc[stage] == 0) {
+        error_set(ERR_INVALID_INPUT, "語法錯誤: 管線中有空的命令");
+        return false;
+    }
+    
+    arena->argv[count] = NULL;  // NULL 結尾
+    arena->stages = (args > 0) ? stage + 1 : 0;
+    return true;
+}
+
 bool shell_execute_command(shell_t *shell, const char *command) {
     if (shell == NULL || command == NULL) {
         return false;
     }
     
     // 跳過前導空白
-    while (*command && isspace(*command)) command++;
+    while (*command && isspace((unsigned char)*command)) command++;
     if (!*command) return true;  // 空命令視為成功
     
-    // 解析命令
-    int argc = 0;
-    char **argv = shell_parse_command(command, &argc);
-    if (argv == NULL || argc == 0) {
+    // 解析命令（重複使用 shell 的解析緩衝區）
+    if (!parse_pipeline(shell, command)) {
+        error_t err = error_get();
+        printf("錯誤: %s\n", (err.code != ERR_OK) ? err.message : "無法解析命令");
+        error_clear();
         return false;
     }
     
-    // 查找並執行命令
-    bool result = false;
-    cmd_handler_t handler = find_command_handler(argv[0]);
+    struct shell_line_arena *arena = shell->line_arena;
+    if (arena->stages == 0) {
+        return true;
+    }
     
-    if (handler != NULL) {
-        result = handler(shell, argc, argv);
-    } else {
-        printf("錯誤: 未知命令 '%s'。輸入 'help' 查看可用命令\n", argv[0]);
-        result = false;
+    // 先確認所有命令都存在，避免管線執行到一半才發現錯誤
+    const cmd_entry_t *commands[MAX_PIPELINE_STAGES];
+    for (int i = 0; i < arena->stages; i++) {
+        const char *name = arena->argv[arena->stage_start[i]];
+        commands[i] = find_command(name);
+        if (commands[i] == NULL) {
+            printf("錯誤: 未知命令 '%s'。輸入 'help' 查看可用命令\n", name);
+            return false;
+        }
+    }
+    
+    // 依序執行：前一個命令的輸出緩衝區作為下一個命令的輸入
+    bool result = false;
+    char *input = NULL;
+    size_t input_len = 0;
+    for (int i = 0; i < arena->stages; i++) {
+        char *output = NULL;
+        size_t output_len = 0;
+        FILE *stream = stdout;
+        if (i + 1 < arena->stages) {
+            stream = open_memstream(&output, &output_len);
+            if (stream == NULL) {
+                printf("錯誤: 無法建立管線緩衝區\n");
+                result = false;
+                break;
+            }
+        }
+        
+        shell->out = stream;
+        shell->pipe_input = input;
+        shell->pipe_input_len = input_len;
+        
+        // 併行模式下唯讀命令可與其他讀取者（如背景儲存）同時執行
+        if (commands[i]->lock == CMD_LOCK_SELF) {
+            result = commands[i]->handler(shell, arena->stage_argc[i], arena->argv + arena->stage_start[i]);
+        } else {
+            if (commands[i]->lock == CMD_LOCK_WRITE) {
+                vfs_write_lock(shell->vfs);
+            } else {
+                vfs_read_lock(shell->vfs);
+            }
+            shell->vfs_locked = true;
+            result = commands[i]->handler(shell, arena->stage_argc[i], arena->argv + arena->stage_start[i]);
+            shell->vfs_locked = false;
+            vfs_unlock(shell->vfs);
+        }
+        
+        if (stream != stdout) {
+            fclose(stream);
+        }
+        free(input);  // open_memstream 的緩衝區由標準函式庫配置
+        input = output;
+        input_len = output_len;
     }
+    free(input);
     
-    shell_free_args(argv, argc);
+    shell->out = stdout;
+    shell->pipe_input = NULL;
+    shell->pipe_input_len = 0;
     return result;
 }
 
@@ -426,10 +839,9 @@ void shell_run(shell_t *shell) {
     // 主命令迴圈
     while (shell->running) {
         // 顯示提示符：綠色的當前路徑 + 提示符
-        char *current_path = vfs_get_path(shell->current_dir);
+        const char *current_path = vfs_peek_path(shell->current_dir, NULL);
         if (current_path != NULL) {
             printf("\033[32m%s\033[0m ", current_path);
-            safe_free(current_path);
         }
         printf("%s", shell->prompt);
         fflush(stdout);
@@ -446,3 +858,44 @@ void shell_run(shell_t *shell) {
         shell_execute_command(shell, line);
     }
 }
+
+/* ============================================================================
+ * 批次模式
+ * ============================================================================ */
+
+int shell_run_batch(shell_t *shell, FILE *input) {
+    if (shell == NULL || input == NULL) {
+        return -1;
+    }
+    
+    char line[MAX_LINE_LEN];
+    int failures = 0;
+    int line_no = 0;
+    
+    while (shell->running && fgets(line, sizeof(line), input) != NULL) {
+        line_no++;
+        
+        // 移除行尾換行（含 CRLF）
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        
+        // 跳過空行與 # 開頭的註解
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        
+        if (!shell_execute_command(shell, p)) {
+            fprintf(stderr, "批次第 %d 行失敗: %s\n", line_no, p);
+            failures++;
+        }
+    }
+    
+    fflush(shell->out);
+    return failures;
+}
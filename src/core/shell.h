@@ -10,11 +10,20 @@
 #define SHELL_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
 #include "../filesystem/vfs.h"
+#include "../filesystem/vfs_journal.h"
+#include "../filesystem/vfs_autosave.h"
 
 /** @brief 最大歷史記錄數量 */
 #define HISTORY_MAX 100
 
+/**
+ * @brief 命令列解析緩衝區（不透明型別，於 shell.c 定義）
+ */
+struct shell_line_arena;
+
 /**
  * @brief Shell 實例結構
  * 
@@ -22,11 +31,19 @@
  */
 typedef struct {
     vfs_t *vfs;                     /**< 虛擬文件系統實例 */
+    vfs_journal_t *journal;         /**< 持久化日誌（NULL 表示結束時完整儲存） */
+    vfs_autosave_t *autosave;       /**< 背景自動儲存（NULL 表示未啟用） */
     vfs_node_t *current_dir;        /**< 當前工作目錄節點 */
     char *prompt;                   /**< 命令提示符字串 */
     bool running;                   /**< Shell 運行狀態旗標 */
     char *history[HISTORY_MAX];     /**< 命令歷史記錄陣列 */
     int history_count;              /**< 當前歷史記錄數量 */
+    FILE *out;                      /**< 命令的輸出串流（管線中為記憶體緩衝區，否則為 stdout） */
+    const char *pipe_input;         /**< 管線上一個命令的輸出（不在管線中時為 NULL） */
+    size_t pipe_input_len;          /**< 上一個命令輸出的長度 */
+    struct shell_line_arena *line_arena; /**< 重複使用的命令列解析緩衝區（首次執行命令時配置） */
+    bool batch;                     /**< 批次模式（無終端機互動，不可執行 vim 等全螢幕命令） */
+    bool vfs_locked;                /**< 目前的命令是否持有 VFS 鎖（中斷信號時由 shell_destroy 釋放） */
 } shell_t;
 
 /* ============================================================================
@@ -43,14 +60,27 @@ typedef struct {
  */
 shell_t *shell_create(void);
 
+/**
+ * @brief 創建批次模式的 Shell 實例
+ * 
+ * 不顯示任何詢問：存在持久化檔案時以 password 驗證並載入（含重播日誌），
+ * 否則創建新的 VFS。批次模式不開啟日誌，所有變更在 shell_destroy 時一次儲存。
+ * 
+ * @param password 持久化檔案的密碼（無現有資料時可為 NULL）
+ * @return 新創建的 Shell 實例，失敗返回 NULL 並設定錯誤訊息
+ */
+shell_t *shell_create_batch(const char *password);
+
 /**
  * @brief 銷毀 Shell 實例並釋放資源
  * 
- * 將 VFS 保存到持久化檔案，釋放所有分配的記憶體。
+ * 將日誌寫入持久儲存（必要時壓縮為新快照），無日誌時完整保存 VFS，
+ * 並釋放所有分配的記憶體。儲存失敗時將錯誤印到 stderr，記憶體仍會釋放。
  * 
  * @param shell 要銷毀的 Shell 實例
+ * @return true 已儲存（或無需儲存），false 儲存失敗
  */
-void shell_destroy(shell_t *shell);
+bool shell_destroy(shell_t *shell);
 
 /**
  * @brief 運行 Shell 主迴圈
@@ -62,18 +92,33 @@ void shell_destroy(shell_t *shell);
  */
 void shell_run(shell_t *shell);
 
+/**
+ * @brief 以批次模式依序執行腳本中的命令
+ * 
+ * 每行一個命令（可含管線），空行與 # 開頭的行略過；不顯示提示符與啟動畫面，
+ * 也不設定終端機。失敗的命令會在 stderr 報告行號並繼續執行下一行，
+ * 遇到 exit 時停止。
+ * 
+ * @param shell 以 shell_create_batch 創建的 Shell 實例
+ * @param input 腳本輸入串流（例如已開啟的檔案或 stdin）
+ * @return 執行失敗的命令數量，參數無效時返回 -1
+ */
+int shell_run_batch(shell_t *shell, FILE *input);
+
 /* ============================================================================
  * 命令處理
  * ============================================================================ */
 
 /**
- * @brief 執行單一命令
+ * @brief 執行單一命令或以 | 串接的管線
  * 
- * 解析並執行給定的命令字串。
+ * 解析並執行給定的命令字串。管線中每個命令的輸出寫入記憶體緩衝區，
+ * 作為下一個命令的輸入（shell->pipe_input）；最後一個命令輸出到 stdout。
+ * 命令列在重複使用的緩衝區中就地切分，不為每個參數配置記憶體。
  * 
  * @param shell Shell 實例
  * @param command 要執行的命令字串
- * @return 命令執行成功返回 true，失敗返回 false
+ * @return 命令（管線中為最後一個命令）執行成功返回 true，失敗返回 false
  */
 bool shell_execute_command(shell_t *shell, const char *command);
 
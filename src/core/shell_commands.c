@@ -8,14 +8,21 @@
 #include "shell_commands.h"
 #include "shell.h"
 #include "editor.h"
+#include "search.h"
+#include "grep.h"
 #include "../filesystem/vfs.h"
 #include "../filesystem/path.h"
+#include "../filesystem/vfs_import.h"
 #include "../utils/memory.h"
 #include "../utils/error.h"
+#include "../utils/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/** cat 串流尚未載入的檔案時，堆疊上緩衝區的大小 */
+#define CAT_STREAM_CHUNK_SIZE (16u * 1024u)
+
 /* ============================================================================
  * 私有輔助函數
  * ============================================================================ */
@@ -33,15 +40,8 @@ static bool copy_node_recursive(vfs_t *vfs, vfs_node_t *src, const char *dst_pat
     }
     
     if (src->type == VFS_FILE) {
-        // 複製檔案：讀取源檔案內容並創建新檔案
-        size_t size = 0;
-        void *data = vfs_read_file(src, &size);
-        if (data != NULL) {
-            vfs_node_t *new_file = vfs_create_file(vfs, dst_path, data, size);
-            safe_free(data);
-            return new_file != NULL;
-        }
-        return false;
+        // 複製檔案：與源檔案共用內容區塊，不複製資料
+        return vfs_copy_file(vfs, src, dst_path) != NULL;
     } else {
         // 複製目錄：先創建目錄，再遞迴複製所有子節點
         vfs_node_t *new_dir = vfs_create_dir(vfs, dst_path);
@@ -49,28 +49,53 @@ static bool copy_node_recursive(vfs_t *vfs, vfs_node_t *src, const char *dst_pat
             return false;
         }
         
+        // 子節點的目標路徑放在暫存區段，每處理完一個子節點即回收
+        arena_t *scratch = scratch_arena();
+        size_t dst_len = strlen(dst_path);
+        bool slash = dst_path[dst_len - 1] != '/';
+        bool ok = true;
         vfs_node_t *child = src->children;
-        while (child != NULL) {
-            // 構建子節點的目標路徑
-            char *child_dst_path = (char *)safe_malloc(strlen(dst_path) + strlen(child->name) + 2);
+        while (child != NULL && ok) {
+            arena_mark_t mark = arena_mark(scratch);
+            size_t name_len = strlen(child->name);
+            char *child_dst_path = (char *)arena_alloc(scratch, dst_len + slash + name_len + 1);
             if (child_dst_path != NULL) {
-                strcpy(child_dst_path, dst_path);
-                if (dst_path[strlen(dst_path) - 1] != '/') {
-                    strcat(child_dst_path, "/");
+                memcpy(child_dst_path, dst_path, dst_len);
+                if (slash) {
+                    child_dst_path[dst_len] = '/';
                 }
-                strcat(child_dst_path, child->name);
-                
-                if (!copy_node_recursive(vfs, child, child_dst_path)) {
-                    safe_free(child_dst_path);
-                    return false;
-                }
-                safe_free(child_dst_path);
+                memcpy(child_dst_path + dst_len + slash, child->name, name_len + 1);
+                ok = copy_node_recursive(vfs, child, child_dst_path);
             }
+            arena_rewind(scratch, mark);
             child = child->next;
         }
         
-        return true;
+        return ok;
+    }
+}
+
+/**
+ * @brief 將位元組數格式化為易讀的大小（如 12.3K）
+ * @param bytes 位元組數
+ * @param out 輸出緩衝區
+ * @param size 緩衝區大小
+ */
+static void format_size(size_t bytes, char *out, size_t size) {
+    static const char units[] = "KMGT";
+    
+    if (bytes < 1024) {
+        snprintf(out, size, "%zuB", bytes);
+        return;
+    }
+    
+    double value = (double)bytes / 1024.0;
+    size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < sizeof(units) - 1) {
+        value /= 1024.0;
+        unit++;
     }
+    snprintf(out, size, "%.1f%c", value, units[unit]);
 }
 
 /* ============================================================================
@@ -101,30 +126,28 @@ char *shell_get_full_path(shell_t *shell, const char *path) {
         return safe_strdup(path);
     }
     
-    // 相對路徑：與當前目錄路徑連接
-    char *current_path = vfs_get_path(shell->current_dir);
+    // 相對路徑：與當前目錄路徑連接（借用快取的路徑，只配置結果）
+    size_t current_len = 0;
+    const char *current_path = vfs_peek_path(shell->current_dir, &current_len);
     if (current_path == NULL) {
         return NULL;
     }
     
-    size_t current_len = strlen(current_path);
     size_t path_len = strlen(path);
     char *full_path = (char *)safe_malloc(current_len + path_len + 2);
     if (full_path == NULL) {
-        safe_free(current_path);
         return NULL;
     }
     
-    strncpy(full_path, current_path, current_len);
+    memcpy(full_path, current_path, current_len);
     // 確保路徑分隔符
     if (current_path[current_len - 1] != '/') {
         full_path[current_len] = '/';
         current_len++;
     }
-    strncpy(full_path + current_len, path, path_len);
+    memcpy(full_path + current_len, path, path_len);
     full_path[current_len + path_len] = '\0';
     
-    safe_free(current_path);
     return full_path;
 }
 
@@ -133,7 +156,29 @@ char *shell_get_full_path(shell_t *shell, const char *path) {
  * ============================================================================ */
 
 bool cmd_ls(shell_t *shell, int argc, char **argv) {
-    const char *path = (argc > 1) ? argv[1] : ".";
+    const char *path = ".";
+    bool sorted = true;
+    size_t limit = 0;  // 0 表示不限制
+    
+    // 解析選項：-U 依建立順序列出，-n <數量> 只列出前幾項
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-U") == 0) {
+            sorted = false;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("用法: ls [-U] [-n <數量>] [目錄]\n");
+                return false;
+            }
+            limit = (size_t)strtoul(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0') {
+                printf("錯誤: 無效的數量: %s\n", argv[i]);
+                return false;
+            }
+        } else {
+            path = argv[i];
+        }
+    }
     
     // 取得目標目錄節點
     vfs_node_t *dir;
@@ -155,25 +200,33 @@ bool cmd_ls(shell_t *shell, int argc, char **argv) {
         }
     }
     
-    // 列出目錄內容
-    size_t count = 0;
-    vfs_node_t **children = vfs_list_dir(dir, &count);
-    
-    if (children == NULL || count == 0) {
-        printf("(空目錄)\n");
-        return true;
+    // 以游標逐一走訪，不配置子節點陣列，達到上限即停止；輸出到管線時不加顏色
+    bool color = (shell->out == stdout && !shell->batch);
+    vfs_dir_iter_t iter;
+    if (!vfs_dir_iter_begin(&iter, dir, sorted)) {
+        printf("錯誤: %s\n", error_get().message);
+        return false;
     }
     
-    // 輸出每個子節點，目錄以藍色顯示
-    for (size_t i = 0; i < count; i++) {
-        if (children[i]->type == VFS_DIR) {
-            printf("\033[34m%s\033[0m/\n", children[i]->name);
+    size_t shown = 0;
+    vfs_node_t *child;
+    while ((limit == 0 || shown < limit) && (child = vfs_dir_iter_next(&iter)) != NULL) {
+        // 目錄以藍色顯示
+        if (child->type == VFS_DIR && color) {
+            fprintf(shell->out, "\033[34m%s\033[0m/\n", child->name);
+        } else if (child->type == VFS_DIR) {
+            fprintf(shell->out, "%s/\n", child->name);
         } else {
-            printf("%s\n", children[i]->name);
+            fprintf(shell->out, "%s\n", child->name);
         }
+        shown++;
     }
     
-    safe_free(children);
+    if (shown == 0) {
+        fprintf(shell->out, "(空目錄)\n");
+    } else if (shown < dir->size) {
+        fprintf(shell->out, "... (共 %zu 項，僅列出前 %zu 項)\n", dir->size, shown);
+    }
     return true;
 }
 
@@ -202,14 +255,142 @@ bool cmd_pwd(shell_t *shell, int argc, char **argv) {
     (void)argc;
     (void)argv;
     
-    char *path = vfs_get_path(shell->current_dir);
+    const char *path = vfs_peek_path(shell->current_dir, NULL);
     if (path != NULL) {
-        printf("%s\n", path);
-        safe_free(path);
+        fprintf(shell->out, "%s\n", path);
+    }
+    return true;
+}
+
+bool cmd_du(shell_t *shell, int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : ".";
+    
+    // 取得目標節點
+    vfs_node_t *node;
+    if (strcmp(path, ".") == 0) {
+        node = shell->current_dir;
+    } else {
+        char *full_path = shell_get_full_path(shell, path);
+        if (full_path == NULL) {
+            printf("錯誤: 無法解析路徑\n");
+            return false;
+        }
+        
+        node = vfs_find_node(shell->vfs, full_path);
+        safe_free(full_path);
+        
+        if (node == NULL) {
+            printf("錯誤: 路徑不存在\n");
+            return false;
+        }
+    }
+    
+    // 子樹統計隨每次變更增量維護，這裡直接讀取
+    size_t bytes = vfs_subtree_size(node);
+    char human[32];
+    format_size(bytes, human, sizeof(human));
+    
+    const char *display = vfs_peek_path(node, NULL);
+    fprintf(shell->out, "%s\t%zu 位元組\t%zu 個節點\t%s\n", human, bytes, vfs_subtree_nodes(node),
+           (display != NULL) ? display : path);
+    return true;
+}
+
+bool cmd_df(shell_t *shell, int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    
+    char human[32];
+    format_size(shell->vfs->total_size, human, sizeof(human));
+    
+    fprintf(shell->out, "節點數\t已使用\t位元組\n");
+    fprintf(shell->out, "%zu\t%s\t%zu\n", shell->vfs->total_nodes, human, shell->vfs->total_size);
+    return true;
+}
+
+/**
+ * @brief 輸出一列記憶體統計
+ */
+static void print_mem_stats(shell_t *shell, const char *name, const mem_stats_t *stats, bool raw) {
+    char current[32];
+    char peak[32];
+    if (raw) {
+        snprintf(current, sizeof(current), "%zu", stats->current);
+        snprintf(peak, sizeof(peak), "%zu", stats->peak);
+    } else {
+        format_size(stats->current, current, sizeof(current));
+        format_size(stats->peak, peak, sizeof(peak));
+    }
+    fprintf(shell->out, "%-10s\t%s\t%s\t%zu\t%zu\n", name, current, peak, stats->allocs, stats->frees);
+}
+
+/**
+ * @brief 將奈秒格式化為易讀的時間（如 812ns、12.3us、4.5ms、1.20s）
+ */
+static void format_duration(uint64_t ns, char *out, size_t size) {
+    if (ns < 1000) {
+        snprintf(out, size, "%lluns", (unsigned long long)ns);
+    } else if (ns < 1000000) {
+        snprintf(out, size, "%.1fus", (double)ns / 1e3);
+    } else if (ns < 1000000000) {
+        snprintf(out, size, "%.1fms", (double)ns / 1e6);
+    } else {
+        snprintf(out, size, "%.2fs", (double)ns / 1e9);
+    }
+}
+
+bool cmd_stats(shell_t *shell, int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+        trace_reset();
+        return true;
+    }
+    if (argc > 1) {
+        printf("用法: stats [-r]\n");
+        return false;
+    }
+    
+    fprintf(shell->out, "%-15s\t次數\t總計\t平均\tp50\tp90\tp99\t最大\n", "探針");
+    for (int probe = 0; probe < TRACE_PROBE_COUNT; probe++) {
+        trace_summary_t summary = trace_summary((trace_probe_t)probe);
+        if (summary.count == 0) {
+            continue;
+        }
+        
+        uint64_t values[6] = {
+            summary.total, summary.total / summary.count, summary.p50, summary.p90, summary.p99,
+            summary.max
+        };
+        char text[6][16];
+        for (int i = 0; i < 6; i++) {
+            format_duration(values[i], text[i], sizeof(text[i]));
+        }
+        fprintf(shell->out, "%-15s\t%llu\t%s\t%s\t%s\t%s\t%s\t%s\n",
+                trace_probe_name((trace_probe_t)probe), (unsigned long long)summary.count,
+                text[0], text[1], text[2], text[3], text[4], text[5]);
+    }
+    if (trace_capturing()) {
+        fprintf(shell->out, "(正在記錄 Chrome trace，結束時寫出)\n");
     }
     return true;
 }
 
+bool cmd_meminfo(shell_t *shell, int argc, char **argv) {
+    bool raw = (argc > 1 && strcmp(argv[1], "-b") == 0);
+    if (argc > 1 && !raw) {
+        printf("用法: meminfo [-b]\n");
+        return false;
+    }
+    
+    fprintf(shell->out, "%-10s\t目前\t最大\t配置\t釋放\n", "分類");
+    for (int tag = 0; tag < MEM_TAG_COUNT; tag++) {
+        mem_stats_t stats = mem_stats((mem_tag_t)tag);
+        print_mem_stats(shell, mem_tag_name((mem_tag_t)tag), &stats, raw);
+    }
+    mem_stats_t total = mem_stats_total();
+    print_mem_stats(shell, "total", &total, raw);
+    return true;
+}
+
 /* ============================================================================
  * 檔案/目錄操作命令實作
  * ============================================================================ */
@@ -273,6 +454,12 @@ bool cmd_touch(shell_t *shell, int argc, char **argv) {
 }
 
 bool cmd_cat(shell_t *shell, int argc, char **argv) {
+    // 管線中未指定檔案時輸出上一階段的內容
+    if (argc < 2 && shell->pipe_input != NULL) {
+        fwrite(shell->pipe_input, 1, shell->pipe_input_len, shell->out);
+        return true;
+    }
+    
     if (argc < 2) {
         printf("用法: cat <檔案名稱>\n");
         return false;
@@ -292,29 +479,151 @@ bool cmd_cat(shell_t *shell, int argc, char **argv) {
         return false;
     }
     
-    // 讀取並輸出檔案內容
-    size_t size = 0;
-    void *data = vfs_read_file(file, &size);
-    if (data != NULL && size > 0) {
-        fwrite(data, 1, size, stdout);
-        printf("\n");
-        safe_free(data);
+    // 借用檔案內容直接輸出，不配置也不複製
+    if (file->size == 0) {
+        return true;
+    }
+    
+    size_t offset = 0;
+    vfs_content_view_t content;
+    vfs_content_view(file, &content);
+    if (content.lazy) {
+        // 尚未載入的檔案：經由堆疊上的緩衝區分段串流，不載入整個檔案
+        char chunk[CAT_STREAM_CHUNK_SIZE];
+        size_t n = 0;
+        while (offset < file->size && vfs_pread(file, offset, chunk, sizeof(chunk), &n) && n > 0) {
+            fwrite(chunk, 1, n, shell->out);
+            offset += n;
+        }
+    } else {
+        // 逐段借用（分段儲存時每次一段，連續儲存時一次輸出全部）
+        while (offset < file->size) {
+            size_t n = 0;
+            const void *view = vfs_peek_range(file, offset, &n);
+            if (view == NULL) {
+                break;
+            }
+            fwrite(view, 1, n, shell->out);
+            offset += n;
+        }
+    }
+    fprintf(shell->out, "\n");
+    
+    if (offset < file->size) {
+        printf("錯誤: 讀取檔案失敗: %s\n", error_get().message);
+        return false;
     }
     
     return true;
 }
 
+bool cmd_grep(shell_t *shell, int argc, char **argv) {
+    grep_options_t options = { 0 };
+    int arg = 1;
+    
+    // 解析選項：-r 遞迴搜尋目錄，-n 顯示行號，-c 只顯示符合的行數，-l 只顯示檔名（可合併，如 -rn）
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg++) {
+        for (const char *flag = argv[arg] + 1; *flag != '\0'; flag++) {
+            if (*flag == 'r') {
+                options.recursive = true;
+            } else if (*flag == 'n') {
+                options.line_numbers = true;
+            } else if (*flag == 'c') {
+                options.count_only = true;
+            } else if (*flag == 'l') {
+                options.files_only = true;
+            } else {
+                printf("錯誤: 未知選項: %s\n", argv[arg]);
+                return false;
+            }
+        }
+    }
+    
+    if (arg >= argc) {
+        printf("用法: grep [-r] [-n] [-c] [-l] <模式> [路徑...]\n");
+        return false;
+    }
+    
+    search_pattern_t *pattern = search_compile(argv[arg++]);
+    if (pattern == NULL) {
+        printf("錯誤: %s\n", error_get().message);
+        error_clear();
+        return false;
+    }
+    
+    // 未指定檔案時搜尋管線上一階段的輸出
+    if (arg >= argc) {
+        bool ok = (shell->pipe_input != NULL);
+        if (ok) {
+            grep_text(pattern, &options, NULL, shell->pipe_input, shell->pipe_input_len, shell->out);
+        } else {
+            printf("錯誤: 沒有輸入（請指定檔案或使用管線）\n");
+        }
+        search_free(pattern);
+        return ok;
+    }
+    
+    // 先解析所有路徑，不存在的路徑在任何搜尋結果之前回報
+    int count = argc - arg;
+    vfs_node_t **nodes = (vfs_node_t **)safe_malloc((size_t)count * sizeof(vfs_node_t *));
+    if (nodes == NULL) {
+        search_free(pattern);
+        printf("錯誤: 記憶體不足\n");
+        return false;
+    }
+    
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        char *full_path = shell_get_full_path(shell, argv[arg + i]);
+        nodes[i] = (full_path != NULL) ? vfs_find_node(shell->vfs, full_path) : NULL;
+        safe_free(full_path);
+        
+        if (nodes[i] == NULL) {
+            printf("錯誤: 檔案不存在: %s\n", argv[arg + i]);
+            ok = false;
+        }
+    }
+    
+    // 搜尋多個檔案或目錄樹時在每行前加上檔名
+    options.show_label = (count > 1) ||
+                         (options.recursive && nodes[0] != NULL && nodes[0]->type == VFS_DIR);
+    
+    grep_search_t *search = grep_search_begin(pattern, &options, shell->out);
+    if (search == NULL) {
+        printf("錯誤: %s\n", error_get().message);
+        error_clear();
+        ok = false;
+    }
+    for (int i = 0; search != NULL && i < count; i++) {
+        if (nodes[i] != NULL && !grep_search_add(search, nodes[i], argv[arg + i])) {
+            fflush(shell->out);
+            printf("錯誤: %s\n", error_get().message);
+            error_clear();
+            ok = false;
+        }
+    }
+    if (search != NULL && !grep_search_finish(search, NULL)) {
+        ok = false;
+    }
+    
+    safe_free(nodes);
+    search_free(pattern);
+    return ok;
+}
+
 bool cmd_echo(shell_t *shell, int argc, char **argv) {
     if (argc < 2) {
-        printf("\n");
+        fprintf(shell->out, "\n");
         return true;
     }
     
-    // 檢查是否有重定向符號 ">"
+    // 檢查是否有重定向符號 ">"（覆寫）或 ">>"（附加）
     int redirect_idx = -1;
+    bool append = false;
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], ">") == 0 && i + 1 < argc) {
+        if ((strcmp(argv[i], ">") == 0 || strcmp(argv[i], ">>") == 0) && i + 1 < argc) {
             redirect_idx = i;
+            append = (argv[i][1] == '>');
             break;
         }
     }
@@ -322,15 +631,15 @@ bool cmd_echo(shell_t *shell, int argc, char **argv) {
     // 輸出文本到終端
     int text_end = (redirect_idx > 0) ? redirect_idx : argc;
     for (int i = 1; i < text_end; i++) {
-        printf("%s", argv[i]);
+        fprintf(shell->out, "%s", argv[i]);
         if (i < text_end - 1) {
-            printf(" ");
+            fprintf(shell->out, " ");
         }
     }
     
     if (redirect_idx < 0) {
         // 無重定向，直接換行
-        printf("\n");
+        fprintf(shell->out, "\n");
     } else {
         // 有重定向，寫入檔案
         const char *filename = argv[redirect_idx + 1];
@@ -352,10 +661,12 @@ bool cmd_echo(shell_t *shell, int argc, char **argv) {
                     }
                 }
                 
-                // 寫入或創建檔案
+                // 寫入或創建檔案（附加時只寫入新增的部分）
                 vfs_node_t *file = vfs_find_node(shell->vfs, full_path);
                 if (file == NULL) {
                     file = vfs_create_file(shell->vfs, full_path, content, strlen(content));
+                } else if (append) {
+                    vfs_append(file, content, strlen(content));
                 } else {
                     vfs_write_file(file, content, strlen(content));
                 }
@@ -551,6 +862,77 @@ bool cmd_cp(shell_t *shell, int argc, char **argv) {
     return true;
 }
 
+bool cmd_import(shell_t *shell, int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        printf("用法: import <主機目錄> [VFS目錄]\n");
+        return false;
+    }
+    
+    // 未指定 VFS 目錄時匯入到當前目錄
+    char *dst_path = shell_get_full_path(shell, argc == 3 ? argv[2] : ".");
+    if (dst_path == NULL) {
+        printf("錯誤: 無法解析目標路徑\n");
+        return false;
+    }
+    
+    vfs_import_stats_t stats;
+    bool result = vfs_import_tree(shell->vfs, argv[1], dst_path, &stats);
+    safe_free(dst_path);
+    
+    fprintf(shell->out, "已匯入 %zu 個檔案、%zu 個目錄，共 %zu 位元組",
+            stats.files, stats.dirs, stats.bytes);
+    if (stats.skipped > 0) {
+        fprintf(shell->out, "（略過 %zu 項）", stats.skipped);
+    }
+    fprintf(shell->out, "\n");
+    
+    if (!result) {
+        error_t err = error_get();
+        if (err.code != ERR_OK) {
+            printf("錯誤: %s\n", err.message);
+            error_clear();
+        } else {
+            printf("錯誤: 無法匯入\n");
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+bool cmd_export(shell_t *shell, int argc, char **argv) {
+    if (argc != 3) {
+        printf("用法: export <VFS路徑> <主機路徑>\n");
+        return false;
+    }
+    
+    char *src_path = shell_get_full_path(shell, argv[1]);
+    if (src_path == NULL) {
+        printf("錯誤: 無法解析來源路徑\n");
+        return false;
+    }
+    
+    vfs_import_stats_t stats;
+    bool result = vfs_export_tree(shell->vfs, src_path, argv[2], &stats);
+    safe_free(src_path);
+    
+    fprintf(shell->out, "已匯出 %zu 個檔案、%zu 個目錄，共 %zu 位元組\n",
+            stats.files, stats.dirs, stats.bytes);
+    
+    if (!result) {
+        error_t err = error_get();
+        if (err.code != ERR_OK) {
+            printf("錯誤: %s\n", err.message);
+            error_clear();
+        } else {
+            printf("錯誤: 無法匯出\n");
+        }
+        return false;
+    }
+    
+    return true;
+}
+
 /* ============================================================================
  * 編輯器命令實作
  * ============================================================================ */
@@ -561,106 +943,39 @@ bool cmd_vim(shell_t *shell, int argc, char **argv) {
         return false;
     }
     
+    if (shell->batch) {
+        printf("錯誤: 批次模式不支援 vim\n");
+        return false;
+    }
+    
+    // vim 自行管理鎖：解析路徑與載入、寫回時才持有，編輯期間背景儲存可照常進行
+    vfs_read_lock(shell->vfs);
     char *full_path = shell_get_full_path(shell, argv[1]);
+    vfs_unlock(shell->vfs);
     if (full_path == NULL) {
         printf("錯誤: 無法解析路徑\n");
         return false;
     }
     
-    // 創建臨時檔案名稱（將路徑中的 / 替換為 _）
-    char *tmp_filename = (char *)safe_malloc(strlen(full_path) + 10);
-    if (tmp_filename == NULL) {
-        safe_free(full_path);
-        return false;
-    }
-    strcpy(tmp_filename, ".tmp_");
-    for (size_t i = 0; i < strlen(full_path); i++) {
-        if (full_path[i] == '/') {
-            tmp_filename[strlen(tmp_filename)] = '_';
-        } else {
-            tmp_filename[strlen(tmp_filename)] = full_path[i];
-        }
-    }
-    tmp_filename[strlen(tmp_filename)] = '\0';
-    
-    // 從 VFS 讀取檔案內容到臨時檔案
-    vfs_node_t *file = vfs_find_node(shell->vfs, full_path);
-    if (file != NULL && file->type == VFS_FILE) {
-        size_t size = 0;
-        void *data = vfs_read_file(file, &size);
-        FILE *tmp_file = fopen(tmp_filename, "w");
-        if (tmp_file != NULL) {
-            if (data != NULL && size > 0) {
-                fwrite(data, 1, size, tmp_file);
-            }
-            fclose(tmp_file);
-            if (data != NULL) {
-                safe_free(data);
-            }
-        } else if (data != NULL) {
-            safe_free(data);
-        }
-    } else {
-        // 檔案不存在，創建空的臨時檔案
-        FILE *tmp_file = fopen(tmp_filename, "w");
-        if (tmp_file != NULL) {
-            fclose(tmp_file);
-        }
-    }
-    
-    // 創建並運行編輯器
+    // 創建編輯器，直接在記憶體中編輯 VFS 節點（不經過主機檔案系統）
     editor_t *editor = editor_create();
     if (editor == NULL) {
         printf("錯誤: 無法創建編輯器\n");
-        safe_free(tmp_filename);
         safe_free(full_path);
         return false;
     }
     
-    if (editor_open_file(editor, tmp_filename)) {
+    bool ok = editor_open_vfs(editor, shell->vfs, full_path);
+    if (ok) {
         editor_run(editor);
-        
-        // 編輯完成後，將臨時檔案內容保存回 VFS
-        FILE *saved_file = fopen(tmp_filename, "r");
-        if (saved_file != NULL) {
-            fseek(saved_file, 0, SEEK_END);
-            long size = ftell(saved_file);
-            fseek(saved_file, 0, SEEK_SET);
-            
-            if (size > 0) {
-                void *data = safe_malloc(size);
-                if (data != NULL) {
-                    fread(data, 1, size, saved_file);
-                    
-                    if (file == NULL) {
-                        vfs_create_file(shell->vfs, full_path, data, size);
-                    } else {
-                        vfs_write_file(file, data, size);
-                    }
-                    
-                    safe_free(data);
-                }
-            } else {
-                // 空檔案處理
-                if (file == NULL) {
-                    vfs_create_file(shell->vfs, full_path, NULL, 0);
-                } else {
-                    vfs_write_file(file, NULL, 0);
-                }
-            }
-            
-            fclose(saved_file);
-        }
-        
-        // 清理臨時檔案
-        remove(tmp_filename);
+    } else {
+        printf("錯誤: 無法開啟檔案 %s\n", argv[1]);
     }
     
     editor_destroy(editor);
-    safe_free(tmp_filename);
     safe_free(full_path);
     
-    return true;
+    return ok;
 }
 
 /* ============================================================================
@@ -678,27 +993,35 @@ bool cmd_clear(shell_t *shell, int argc, char **argv) {
 }
 
 bool cmd_help(shell_t *shell, int argc, char **argv) {
-    (void)shell;
     (void)argc;
     (void)argv;
     
-    printf("可用命令:\n");
-    printf("  ls [目錄]     - 列出目錄內容\n");
-    printf("  cd [目錄]     - 切換目錄\n");
-    printf("  pwd           - 顯示當前目錄\n");
-    printf("  mkdir <目錄>  - 創建目錄\n");
-    printf("  touch <檔案>  - 創建檔案\n");
-    printf("  cat <檔案>    - 顯示檔案內容\n");
-    printf("  echo [文本]   - 輸出文本（支持 > 重定向）\n");
-    printf("  rm <檔案>     - 刪除檔案\n");
-    printf("  rm -r <目錄>  - 遞迴刪除目錄\n");
-    printf("  mv <源> <目標> - 移動/重命名\n");
-    printf("  cp <源> <目標> - 複製檔案或目錄\n");
-    printf("  vim <檔案>    - 使用編輯器打開檔案\n");
-    printf("  clear         - 清屏\n");
-    printf("  history       - 顯示歷史記錄\n");
-    printf("  help          - 顯示幫助\n");
-    printf("  exit          - 退出\n");
+    fprintf(shell->out, "可用命令:\n");
+    fprintf(shell->out, "  ls [目錄]     - 列出目錄內容（依名稱排序）\n");
+    fprintf(shell->out, "  ls -U / -n N  - 依建立順序列出 / 只列出前 N 項\n");
+    fprintf(shell->out, "  cd [目錄]     - 切換目錄\n");
+    fprintf(shell->out, "  pwd           - 顯示當前目錄\n");
+    fprintf(shell->out, "  du [路徑]     - 顯示檔案或目錄的總大小\n");
+    fprintf(shell->out, "  df            - 顯示檔案系統的使用量\n");
+    fprintf(shell->out, "  meminfo [-b]  - 顯示各子系統的記憶體用量（-b 以位元組顯示）\n");
+    fprintf(shell->out, "  stats [-r]    - 顯示主要操作的耗時分佈（-r 清除統計）\n");
+    fprintf(shell->out, "  mkdir <目錄>  - 創建目錄\n");
+    fprintf(shell->out, "  touch <檔案>  - 創建檔案\n");
+    fprintf(shell->out, "  cat <檔案>    - 顯示檔案內容\n");
+    fprintf(shell->out, "  echo [文本]   - 輸出文本（支持 > 與 >> 重定向）\n");
+    fprintf(shell->out, "  grep [-r] <模式> [路徑...] - 搜尋包含模式的行（-r 遞迴，-n 行號，-c 計數，-l 檔名）\n");
+    fprintf(shell->out, "  rm <檔案>     - 刪除檔案\n");
+    fprintf(shell->out, "  rm -r <目錄>  - 遞迴刪除目錄\n");
+    fprintf(shell->out, "  mv <源> <目標> - 移動/重命名\n");
+    fprintf(shell->out, "  cp <源> <目標> - 複製檔案或目錄\n");
+    fprintf(shell->out, "  import <主機目錄> [VFS目錄] - 匯入主機上的目錄樹\n");
+    fprintf(shell->out, "  export <VFS路徑> <主機路徑> - 將檔案或目錄樹匯出到主機\n");
+    fprintf(shell->out, "  vim <檔案>    - 使用編輯器打開檔案\n");
+    fprintf(shell->out, "  clear         - 清屏\n");
+    fprintf(shell->out, "  history       - 顯示歷史記錄\n");
+    fprintf(shell->out, "  help          - 顯示幫助\n");
+    fprintf(shell->out, "  exit          - 退出\n");
+    fprintf(shell->out, "\n以 | 串接命令，前一個命令的輸出作為下一個命令的輸入（如 cat f | grep x）\n");
     return true;
 }
 
@@ -707,13 +1030,13 @@ bool cmd_history(shell_t *shell, int argc, char **argv) {
     (void)argv;
     
     if (shell->history_count == 0) {
-        printf("(無歷史記錄)\n");
+        fprintf(shell->out, "(無歷史記錄)\n");
         return true;
     }
     
     // 輸出所有歷史記錄，格式：編號 + 命令
     for (int i = 0; i < shell->history_count; i++) {
-        printf("%4d  %s\n", i + 1, shell->history[i]);
+        fprintf(shell->out, "%4d  %s\n", i + 1, shell->history[i]);
     }
     return true;
 }
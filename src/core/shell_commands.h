@@ -4,6 +4,7 @@
  * 
  * 定義所有 shell 內建命令的處理函數介面。
  * 每個命令遵循統一的函數簽名：bool cmd_xxx(shell_t *shell, int argc, char **argv)
+ * 一般輸出寫入 shell->out（管線中為記憶體緩衝區），錯誤與用法訊息直接輸出到終端。
  */
 
 #ifndef SHELL_COMMANDS_H
@@ -20,7 +21,8 @@
  * @brief 列出目錄內容
  * @param shell Shell 實例
  * @param argc 參數數量
- * @param argv 參數陣列，argv[1] 為可選的目錄路徑
+ * @param argv 參數陣列：可選的 -U（依建立順序）、-n <數量>（只列出前幾項）與目錄路徑
+ * @note 預設依名稱排序，使用目錄的排序索引逐項輸出，不配置整個子節點陣列
  * @return 成功返回 true，失敗返回 false
  */
 bool cmd_ls(shell_t *shell, int argc, char **argv);
@@ -43,6 +45,43 @@ bool cmd_cd(shell_t *shell, int argc, char **argv);
  */
 bool cmd_pwd(shell_t *shell, int argc, char **argv);
 
+/**
+ * @brief 顯示檔案或目錄子樹的總大小與節點數
+ * @param shell Shell 實例
+ * @param argc 參數數量
+ * @param argv 參數陣列，argv[1] 為可選的目標路徑（預設為當前目錄）
+ * @note 讀取增量維護的子樹統計，不走訪子樹
+ * @return 成功返回 true，失敗返回 false
+ */
+bool cmd_du(shell_t *shell, int argc, char **argv);
+
+/**
+ * @brief 顯示整個檔案系統的節點數與已使用大小
+ * @param shell Shell 實例
+ * @param argc 參數數量（未使用）
+ * @param argv 參數陣列（未使用）
+ * @return 總是返回 true
+ */
+bool cmd_df(shell_t *shell, int argc, char **argv);
+
+/**
+ * @brief 顯示各子系統目前與最大的記憶體用量及配置次數
+ * @param shell Shell 實例
+ * @param argc 參數數量
+ * @param argv 參數陣列（-b 以位元組顯示）
+ * @return 成功返回 true，參數錯誤返回 false
+ */
+bool cmd_meminfo(shell_t *shell, int argc, char **argv);
+
+/**
+ * @brief 顯示各追蹤探針的次數、總耗時與百分位數
+ * @param shell Shell 實例
+ * @param argc 參數數量
+ * @param argv 參數陣列（-r 清除統計）
+ * @return 成功返回 true，參數錯誤返回 false
+ */
+bool cmd_stats(shell_t *shell, int argc, char **argv);
+
 /* ============================================================================
  * 檔案/目錄操作命令
  * ============================================================================ */
@@ -70,6 +109,7 @@ bool cmd_touch(shell_t *shell, int argc, char **argv);
  * @param shell Shell 實例
  * @param argc 參數數量
  * @param argv 參數陣列，argv[1] 為檔案名稱
+ * @note 管線中未指定檔案時輸出上一階段的內容
  * @return 成功返回 true，失敗返回 false
  */
 bool cmd_cat(shell_t *shell, int argc, char **argv);
@@ -78,11 +118,21 @@ bool cmd_cat(shell_t *shell, int argc, char **argv);
  * @brief 輸出文字到終端或重定向到檔案
  * @param shell Shell 實例
  * @param argc 參數數量
- * @param argv 參數陣列，支援 > 重定向語法
+ * @param argv 參數陣列，支援 > 覆寫與 >> 附加重定向語法
  * @return 成功返回 true，失敗返回 false
  */
 bool cmd_echo(shell_t *shell, int argc, char **argv);
 
+/**
+ * @brief 搜尋包含指定模式的行
+ * @param shell Shell 實例
+ * @param argc 參數數量
+ * @param argv 參數陣列：可選的 -n（行號）、-c（只計數），接著為模式與檔案路徑
+ * @note 未指定檔案時搜尋管線上一階段的輸出
+ * @return 成功返回 true，失敗返回 false
+ */
+bool cmd_grep(shell_t *shell, int argc, char **argv);
+
 /**
  * @brief 刪除檔案或目錄
  * @param shell Shell 實例
@@ -111,6 +161,24 @@ bool cmd_mv(shell_t *shell, int argc, char **argv);
  */
 bool cmd_cp(shell_t *shell, int argc, char **argv);
 
+/**
+ * @brief 將主機上的目錄樹匯入 VFS
+ * @param shell Shell 實例
+ * @param argc 參數數量
+ * @param argv 參數陣列，argv[1] 為主機目錄，argv[2] 為 VFS 目標目錄（可省略，預設為當前目錄）
+ * @return 成功返回 true，失敗返回 false
+ */
+bool cmd_import(shell_t *shell, int argc, char **argv);
+
+/**
+ * @brief 將 VFS 中的檔案或目錄樹匯出到主機
+ * @param shell Shell 實例
+ * @param argc 參數數量
+ * @param argv 參數陣列，argv[1] 為 VFS 來源路徑，argv[2] 為主機目標路徑
+ * @return 成功返回 true，失敗返回 false
+ */
+bool cmd_export(shell_t *shell, int argc, char **argv);
+
 /* ============================================================================
  * 編輯器命令
  * ============================================================================ */
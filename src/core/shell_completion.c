@@ -15,6 +15,50 @@
 #include <termios.h>
 #include <unistd.h>
 
+/** 列出補全候選項時最多顯示的項目數 */
+#define COMPLETION_LIST_MAX 200
+
+/* ============================================================================
+ * 私有輔助函數
+ * ============================================================================ */
+
+/**
+ * @brief 解析補全目標所在的目錄
+ * 
+ * 例如 "dir/sub/fi" 解析為目錄 "dir/sub/"，名稱前綴為 "fi"。
+ * 
+ * @param shell Shell 實例
+ * @param word 正在輸入的詞
+ * @param name_prefix 輸出參數，指向 word 中最後一個 '/' 之後的名稱前綴
+ * @return 目錄節點，不存在時返回 NULL
+ */
+static vfs_node_t *completion_dir(shell_t *shell, const char *word, const char **name_prefix) {
+    const char *last_slash = strrchr(word, '/');
+    if (last_slash == NULL) {
+        *name_prefix = word;
+        return shell->current_dir;
+    }
+    
+    *name_prefix = last_slash + 1;
+    char *dir_path = safe_strndup(word, (size_t)(last_slash - word) + 1);
+    if (dir_path == NULL) {
+        return NULL;
+    }
+    
+    char *full_dir = shell_get_full_path(shell, dir_path);
+    safe_free(dir_path);
+    if (full_dir == NULL) {
+        return NULL;
+    }
+    
+    vfs_node_t *dir = vfs_find_node(shell->vfs, full_dir);
+    safe_free(full_dir);
+    if (dir == NULL || dir->type != VFS_DIR) {
+        return NULL;
+    }
+    return dir;
+}
+
 /* ============================================================================
  * 補全功能實作
  * ============================================================================ */
@@ -22,87 +66,46 @@
 char **shell_get_completions(shell_t *shell, const char *prefix, size_t *count) {
     *count = 0;
     
-    // 分離目錄路徑和檔名前綴
-    // 例如: "dir/sub/fi" -> dir_path="dir/sub/", name_prefix="fi"
-    const char *last_slash = strrchr(prefix, '/');
-    char *dir_path = NULL;
-    const char *name_prefix = prefix;
+    const char *name_prefix = NULL;
+    vfs_node_t *search_dir = completion_dir(shell, prefix, &name_prefix);
+    if (search_dir == NULL) {
+        return NULL;
+    }
     
-    if (last_slash != NULL) {
-        size_t dir_len = last_slash - prefix + 1;
-        dir_path = (char *)safe_malloc(dir_len + 1);
-        if (dir_path == NULL) return NULL;
-        strncpy(dir_path, prefix, dir_len);
-        dir_path[dir_len] = '\0';
-        name_prefix = last_slash + 1;
+    // 以排序索引定位符合前綴的範圍，只走訪符合的項目
+    vfs_dir_iter_t iter;
+    if (!vfs_dir_iter_begin_prefix(&iter, search_dir, name_prefix, strlen(name_prefix))) {
+        return NULL;
     }
     
-    // 確定要搜尋的目錄
-    vfs_node_t *search_dir;
-    if (dir_path != NULL) {
-        char *full_dir = shell_get_full_path(shell, dir_path);
-        if (full_dir == NULL) {
-            safe_free(dir_path);
-            return NULL;
-        }
-        search_dir = vfs_find_node(shell->vfs, full_dir);
-        safe_free(full_dir);
-        if (search_dir == NULL || search_dir->type != VFS_DIR) {
-            safe_free(dir_path);
-            return NULL;
-        }
-    } else {
-        search_dir = shell->current_dir;
+    size_t matches = vfs_dir_iter_remaining(&iter);
+    if (matches == 0) {
+        return NULL;
     }
     
-    // 動態陣列收集符合前綴的項目
-    size_t prefix_len = strlen(name_prefix);
-    size_t capacity = 16;
-    char **completions = (char **)safe_malloc(sizeof(char *) * capacity);
+    char **completions = (char **)safe_malloc(sizeof(char *) * matches);
     if (completions == NULL) {
-        safe_free(dir_path);
         return NULL;
     }
     
-    // 遍歷目錄中的所有子節點
-    vfs_node_t *child = search_dir->children;
-    while (child != NULL) {
-        // 檢查是否符合前綴
-        if (prefix_len == 0 || strncmp(child->name, name_prefix, prefix_len) == 0) {
-            // 擴展陣列容量
-            if (*count >= capacity) {
-                capacity *= 2;
-                char **new_completions = (char **)realloc(completions, sizeof(char *) * capacity);
-                if (new_completions == NULL) {
-                    shell_free_completions(completions, *count);
-                    safe_free(dir_path);
-                    return NULL;
-                }
-                completions = new_completions;
-            }
-            
-            // 構建完整的補全字串（包含目錄路徑）
-            size_t name_len = strlen(child->name);
-            size_t total_len = (dir_path ? strlen(dir_path) : 0) + name_len + 2;
-            completions[*count] = (char *)safe_malloc(total_len);
-            if (completions[*count] != NULL) {
-                if (dir_path) {
-                    strcpy(completions[*count], dir_path);
-                    strcat(completions[*count], child->name);
-                } else {
-                    strcpy(completions[*count], child->name);
-                }
-                // 目錄加上 "/" 後綴以便識別
-                if (child->type == VFS_DIR) {
-                    strcat(completions[*count], "/");
-                }
-                (*count)++;
-            }
+    // 構建完整的補全字串（包含目錄路徑），目錄加上 "/" 後綴以便識別
+    size_t dir_len = (size_t)(name_prefix - prefix);
+    vfs_node_t *child;
+    while ((child = vfs_dir_iter_next(&iter)) != NULL) {
+        size_t name_len = strlen(child->name);
+        char *completion = (char *)safe_malloc(dir_len + name_len + 2);
+        if (completion == NULL) {
+            continue;
         }
-        child = child->next;
+        memcpy(completion, prefix, dir_len);
+        memcpy(completion + dir_len, child->name, name_len);
+        if (child->type == VFS_DIR) {
+            completion[dir_len + name_len++] = '/';
+        }
+        completion[dir_len + name_len] = '\0';
+        completions[(*count)++] = completion;
     }
     
-    safe_free(dir_path);
     return completions;
 }
 
@@ -135,8 +138,40 @@ char *shell_find_common_prefix(char **completions, size_t count) {
  * 輸入處理實作
  * ============================================================================ */
 
+/**
+ * @brief 在游標位置插入文字並更新顯示
+ * @param buffer 輸入緩衝區
+ * @param pos 當前緩衝區長度指標
+ * @param cursor 當前游標位置指標
+ * @param size 緩衝區最大大小
+ * @param text 要插入的文字
+ * @param len 文字長度
+ */
+static void insert_at_cursor(char *buffer, size_t *pos, size_t *cursor, size_t size,
+                             const char *text, size_t len) {
+    if (len == 0 || *pos + len >= size - 1) {
+        return;
+    }
+    
+    // 移動游標後的內容，插入補全部分
+    memmove(buffer + *cursor + len, buffer + *cursor, *pos - *cursor + 1);
+    memcpy(buffer + *cursor, text, len);
+    *pos += len;
+    
+    // 更新顯示
+    printf("%s", buffer + *cursor);
+    *cursor += len;
+    if (*pos > *cursor) {
+        printf("\033[%zuD", *pos - *cursor);
+    }
+}
+
 /**
  * @brief 處理 Tab 鍵自動完成
+ * 
+ * 直接在目錄的排序索引上定位符合前綴的範圍：唯一匹配與共同前綴
+ * 不需配置或比較任何候選字串，只有列出候選項時才走訪範圍。
+ * 
  * @param shell Shell 實例
  * @param buffer 輸入緩衝區
  * @param pos 當前緩衝區長度指標
@@ -159,71 +194,55 @@ static void handle_tab_completion(shell_t *shell, char *buffer,
     strncpy(word, buffer + word_start, word_len);
     word[word_len] = '\0';
     
-    // 獲取補全選項
-    size_t comp_count = 0;
-    char **completions = shell_get_completions(shell, word, &comp_count);
+    // 定位符合前綴的項目
+    const char *name_prefix = NULL;
+    vfs_node_t *dir = completion_dir(shell, word, &name_prefix);
+    if (dir == NULL) return;
+    
+    size_t prefix_len = strlen(name_prefix);
+    vfs_dir_iter_t iter;
+    if (!vfs_dir_iter_begin_prefix(&iter, dir, name_prefix, prefix_len)) return;
+    
+    size_t matches = vfs_dir_iter_remaining(&iter);
+    size_t common_len = vfs_dir_iter_common_prefix(&iter);
     
-    if (comp_count == 1) {
-        // 唯一匹配：直接補全
-        size_t comp_len = strlen(completions[0]);
-        size_t add_len = comp_len - word_len;
+    if (matches == 1) {
+        // 唯一匹配：直接補全，目錄加上 "/"
+        vfs_node_t *child = vfs_dir_iter_next(&iter);
+        insert_at_cursor(buffer, pos, cursor, size, child->name + prefix_len, common_len - prefix_len);
+        if (child->type == VFS_DIR) {
+            insert_at_cursor(buffer, pos, cursor, size, "/", 1);
+        }
+    } else if (matches > 1 && common_len > prefix_len) {
+        // 多個匹配且有共同前綴可以補全（共同前綴取自範圍內第一個名稱）
+        vfs_node_t *first = vfs_dir_iter_next(&iter);
+        insert_at_cursor(buffer, pos, cursor, size, first->name + prefix_len, common_len - prefix_len);
+    } else if (matches > 1) {
+        // 無法進一步補全，顯示所有選項（過多時只顯示前面部分）
+        printf("\n");
+        size_t shown = 0;
+        vfs_node_t *child;
+        while (shown < COMPLETION_LIST_MAX && (child = vfs_dir_iter_next(&iter)) != NULL) {
+            printf("%.*s%s%s  ", (int)(name_prefix - word), word, child->name,
+                   (child->type == VFS_DIR) ? "/" : "");
+            shown++;
+        }
+        if (shown < matches) {
+            printf("... (共 %zu 項)", matches);
+        }
+        printf("\n");
         
-        if (add_len > 0 && *pos + add_len < size - 1) {
-            // 移動游標後的內容，插入補全部分
-            memmove(buffer + *cursor + add_len, buffer + *cursor, *pos - *cursor + 1);
-            memcpy(buffer + *cursor, completions[0] + word_len, add_len);
-            *pos += add_len;
-            
-            // 更新顯示
-            printf("%s", buffer + *cursor);
-            *cursor += add_len;
-            if (*pos > *cursor) {
-                printf("\033[%zuD", *pos - *cursor);
-            }
+        // 重新顯示提示符和當前輸入
+        const char *current_path = vfs_peek_path(shell->current_dir, NULL);
+        if (current_path != NULL) {
+            printf("\033[32m%s\033[0m ", current_path);
         }
-    } else if (comp_count > 1) {
-        // 多個匹配：嘗試補全共同前綴
-        char *common = shell_find_common_prefix(completions, comp_count);
-        if (common != NULL) {
-            size_t common_len = strlen(common);
-            if (common_len > word_len) {
-                // 有共同前綴可以補全
-                size_t add_len = common_len - word_len;
-                if (*pos + add_len < size - 1) {
-                    memmove(buffer + *cursor + add_len, buffer + *cursor, *pos - *cursor + 1);
-                    memcpy(buffer + *cursor, common + word_len, add_len);
-                    *pos += add_len;
-                    
-                    printf("%s", buffer + *cursor);
-                    *cursor += add_len;
-                    if (*pos > *cursor) {
-                        printf("\033[%zuD", *pos - *cursor);
-                    }
-                }
-            } else {
-                // 無法進一步補全，顯示所有選項
-                printf("\n");
-                for (size_t i = 0; i < comp_count; i++) {
-                    printf("%s  ", completions[i]);
-                }
-                printf("\n");
-                
-                // 重新顯示提示符和當前輸入
-                char *current_path = vfs_get_path(shell->current_dir);
-                if (current_path != NULL) {
-                    printf("\033[32m%s\033[0m ", current_path);
-                    safe_free(current_path);
-                }
-                printf("%s%s", shell->prompt, buffer);
-                if (*pos > *cursor) {
-                    printf("\033[%zuD", *pos - *cursor);
-                }
-            }
-            safe_free(common);
+        printf("%s%s", shell->prompt, buffer);
+        if (*pos > *cursor) {
+            printf("\033[%zuD", *pos - *cursor);
         }
     }
     
-    shell_free_completions(completions, comp_count);
     fflush(stdout);
 }
 
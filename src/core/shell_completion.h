@@ -40,8 +40,9 @@ bool shell_read_line_with_completion(shell_t *shell, char *buffer, size_t size);
  * @param shell Shell 實例
  * @param prefix 要匹配的前綴字串
  * @param count 輸出參數，返回匹配項目的數量
- * @return 匹配的字串陣列，呼叫者需使用 free_completions 釋放
+ * @return 匹配的字串陣列（依名稱排序），呼叫者需使用 free_completions 釋放
  * @note 目錄名稱會自動加上 "/" 後綴
+ * @note 以目錄的排序索引二分搜尋前綴範圍，只走訪符合的項目
  */
 char **shell_get_completions(shell_t *shell, const char *prefix, size_t *count);
 
@@ -10,6 +10,7 @@
 #include "buffer_ops.h"
 #include "../utils/memory.h"
 #include "../utils/error.h"
+#include "../utils/trace.h"
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
@@ -18,8 +19,8 @@
  * 私有常數定義
  * ============================================================================ */
 
-/** @brief 最大撤銷記錄數量 */
-#define MAX_UNDO_RECORDS 1000
+/** @brief 撤銷記錄陣列的初始容量 */
+#define INITIAL_UNDO_CAPACITY 64
 
 /* ============================================================================
  * 上下文管理實作
@@ -35,7 +36,7 @@ void vim_init_context(vim_context_t *ctx) {
     
     /* 設定初始值 */
     ctx->op_type = VIM_OP_NONE;
-    ctx->undo_max = MAX_UNDO_RECORDS;
+    ctx->undo_budget = VIM_UNDO_DEFAULT_BUDGET;
     ctx->search_direction = 1;  /* 預設向前搜尋 */
     
     /* 初始化所有暫存器 */
@@ -56,13 +57,8 @@ void vim_cleanup_context(vim_context_t *ctx) {
     }
     
     /* 釋放所有撤銷記錄 */
-    undo_record_t *record = ctx->undo_head;
-    while (record != NULL) {
-        undo_record_t *next = record->next;
-        safe_free(record->text);
-        safe_free(record);
-        record = next;
-    }
+    tagged_free(MEM_TAG_UNDO, ctx->undo_records, ctx->undo_capacity * sizeof(undo_record_t));
+    tagged_free(MEM_TAG_UNDO, ctx->undo_text, ctx->undo_text_cap);
     
     /* 釋放所有暫存器內容 */
     for (int i = 0; i < 26; i++) {
@@ -72,64 +68,404 @@ void vim_cleanup_context(vim_context_t *ctx) {
     
     /* 釋放搜尋模式 */
     safe_free(ctx->search_pattern);
+    search_free(ctx->search_compiled);
 }
 
 /* ============================================================================
  * 撤銷/重做實作
  * ============================================================================ */
 
+/**
+ * @brief 撤銷記錄目前佔用的位元組數
+ */
+static size_t undo_bytes(const vim_context_t *ctx) {
+    return ctx->undo_count * sizeof(undo_record_t) + ctx->undo_text_len;
+}
+
+/**
+ * @brief 確保文字區還能容納 extra 個位元組
+ */
+static bool undo_reserve_text(vim_context_t *ctx, size_t extra) {
+    if (ctx->undo_text_len + extra <= ctx->undo_text_cap) {
+        return true;
+    }
+    
+    size_t cap = ctx->undo_text_cap ? ctx->undo_text_cap : 256;
+    while (cap < ctx->undo_text_len + extra) {
+        cap *= 2;
+    }
+    char *grown = (char *)tagged_realloc(MEM_TAG_UNDO, ctx->undo_text, ctx->undo_text_cap, cap);
+    if (grown == NULL) {
+        return false;
+    }
+    ctx->undo_text = grown;
+    ctx->undo_text_cap = cap;
+    return true;
+}
+
+/**
+ * @brief 將文字附加到文字區尾端（reversed 為 true 時以反向附加）
+ */
+static void undo_append_text(vim_context_t *ctx, const char *text, size_t len, bool reversed) {
+    char *dst = ctx->undo_text + ctx->undo_text_len;
+    if (reversed) {
+        for (size_t i = 0; i < len; i++) {
+            dst[i] = text[len - 1 - i];
+        }
+    } else if (len > 0) {
+        memcpy(dst, text, len);
+    }
+    ctx->undo_text_len += len;
+}
+
+/**
+ * @brief 捨棄最舊的群組直到符合記憶體預算
+ *
+ * 一次降到預算的 3/4，讓搬移文字區的成本分攤到之後的記錄上。
+ * 只捨棄已套用的記錄，且至少保留最新的一個群組。
+ */
+static void undo_enforce_budget(vim_context_t *ctx) {
+    if (undo_bytes(ctx) <= ctx->undo_budget) {
+        return;
+    }
+    
+    /* 只剩最新的群組時沒有可捨棄的記錄（避免大型群組每次記錄都重新掃描） */
+    if (ctx->undo_pos == ctx->undo_count && ctx->undo_count > 0 &&
+        ctx->undo_records[0].group == ctx->undo_records[ctx->undo_count - 1].group) {
+        return;
+    }
+    
+    size_t target = ctx->undo_budget / 4 * 3;
+    size_t drop = 0;
+    size_t bytes = undo_bytes(ctx);
+    while (drop < ctx->undo_pos && bytes > target) {
+        /* 整個群組一起捨棄 */
+        size_t group = ctx->undo_records[drop].group;
+        size_t end = drop;
+        while (end < ctx->undo_pos && ctx->undo_records[end].group == group) {
+            end++;
+        }
+        if (end == ctx->undo_pos && ctx->undo_pos == ctx->undo_count) {
+            break;  /* 保留最新的群組 */
+        }
+        for (size_t i = drop; i < end; i++) {
+            bytes -= sizeof(undo_record_t) + ctx->undo_records[i].text_len;
+        }
+        drop = end;
+    }
+    
+    if (drop == 0) {
+        return;
+    }
+    
+    /* 記錄文字依序存放，因此剩餘文字從第一筆保留記錄的位移開始 */
+    size_t base = (drop < ctx->undo_count) ? ctx->undo_records[drop].text_offset : ctx->undo_text_len;
+    memmove(ctx->undo_text, ctx->undo_text + base, ctx->undo_text_len - base);
+    ctx->undo_text_len -= base;
+    
+    memmove(ctx->undo_records, ctx->undo_records + drop, (ctx->undo_count - drop) * sizeof(undo_record_t));
+    ctx->undo_count -= drop;
+    ctx->undo_pos -= drop;
+    for (size_t i = 0; i < ctx->undo_count; i++) {
+        ctx->undo_records[i].text_offset -= base;
+    }
+}
+
+/**
+ * @brief 嘗試將操作合併到最新記錄
+ *
+ * @return 已合併回傳 true
+ */
+static bool undo_try_coalesce(vim_context_t *ctx, undo_type_t type, size_t row, size_t col,
+                              const char *text, size_t len) {
+    if (ctx->undo_pos == 0 || !ctx->undo_group_open) {
+        return false;
+    }
+    
+    undo_record_t *last = &ctx->undo_records[ctx->undo_pos - 1];
+    if (last->group != ctx->undo_group || last->type != type) {
+        return false;
+    }
+    
+    switch (type) {
+        case UNDO_INSERT_CHAR:
+            /* 連續輸入：新字元緊接在上次輸入之後 */
+            if (row != last->row || col != last->col + last->text_len) {
+                return false;
+            }
+            if (!undo_reserve_text(ctx, len)) {
+                return false;
+            }
+            undo_append_text(ctx, text, len, false);
+            last->text_len += len;
+            return true;
+        
+        case UNDO_DELETE_CHAR:
+            if (row != last->row) {
+                return false;
+            }
+            if (col == last->col && !last->reversed) {
+                /* 連續 x：後面的字元移到同一欄位 */
+                if (!undo_reserve_text(ctx, len)) {
+                    return false;
+                }
+                undo_append_text(ctx, text, len, false);
+            } else if (col + len == last->col && (last->reversed || last->text_len == 1)) {
+                /* 連續 Backspace：刪除的字元往左延伸，以反向附加 */
+                if (!undo_reserve_text(ctx, len)) {
+                    return false;
+                }
+                undo_append_text(ctx, text, len, true);
+                last->reversed = true;
+                last->col = col;
+            } else {
+                return false;
+            }
+            last->text_len += len;
+            return true;
+        
+        case UNDO_INSERT_LINE:
+        case UNDO_DELETE_LINE:
+            /* 連續插入的行接在上一段之後；連續刪除的行都在同一行號 */
+            if (row != last->row + (type == UNDO_INSERT_LINE ? last->line_count : 0)) {
+                return false;
+            }
+            if (!undo_reserve_text(ctx, len + 1)) {
+                return false;
+            }
+            undo_append_text(ctx, "\n", 1, false);
+            undo_append_text(ctx, text, len, false);
+            last->text_len += len + 1;
+            last->line_count++;
+            return true;
+        
+        default:
+            return false;
+    }
+}
+
 void vim_record_undo(vim_context_t *ctx, undo_type_t type, size_t row, size_t col, const char *text, size_t len) {
     if (ctx == NULL) {
         return;
     }
+    if (text == NULL) {
+        len = 0;
+    }
+    
+    /* 新的操作使所有可重做的記錄失效 */
+    if (ctx->undo_pos < ctx->undo_count) {
+        ctx->undo_count = ctx->undo_pos;
+        ctx->undo_text_len = (ctx->undo_pos > 0)
+            ? ctx->undo_records[ctx->undo_pos - 1].text_offset + ctx->undo_records[ctx->undo_pos - 1].text_len
+            : 0;
+    }
+    
+    if (!undo_try_coalesce(ctx, type, row, col, text, len)) {
+        /* 配置新的撤銷記錄 */
+        if (ctx->undo_count == ctx->undo_capacity) {
+            size_t cap = ctx->undo_capacity ? ctx->undo_capacity * 2 : INITIAL_UNDO_CAPACITY;
+            undo_record_t *grown = (undo_record_t *)tagged_realloc(MEM_TAG_UNDO, ctx->undo_records,
+                                                                   ctx->undo_capacity * sizeof(undo_record_t),
+                                                                   cap * sizeof(undo_record_t));
+            if (grown == NULL) {
+                return;
+            }
+            ctx->undo_records = grown;
+            ctx->undo_capacity = cap;
+        }
+        if (!undo_reserve_text(ctx, len)) {
+            return;
+        }
+        
+        /* 群組外的操作各自成為一個群組 */
+        if (!ctx->undo_group_open) {
+            ctx->undo_group++;
+        }
+        
+        undo_record_t *record = &ctx->undo_records[ctx->undo_count++];
+        record->type = type;
+        record->row = row;
+        record->col = col;
+        record->text_offset = ctx->undo_text_len;
+        record->text_len = len;
+        record->line_count = 1;
+        record->group = ctx->undo_group;
+        record->reversed = false;
+        undo_append_text(ctx, text, len, false);
+        ctx->undo_pos = ctx->undo_count;
+    }
+    
+    /* 若超過預算，移除最舊的群組 */
+    undo_enforce_budget(ctx);
+}
+
+void vim_undo_begin_group(vim_context_t *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    ctx->undo_group++;
+    ctx->undo_group_open = true;
+}
+
+void vim_undo_end_group(vim_context_t *ctx) {
+    if (ctx != NULL) {
+        ctx->undo_group_open = false;
+    }
+}
+
+void vim_set_undo_budget(vim_context_t *ctx, size_t bytes) {
+    if (ctx == NULL) {
+        return;
+    }
+    ctx->undo_budget = bytes ? bytes : VIM_UNDO_DEFAULT_BUDGET;
+    undo_enforce_budget(ctx);
+}
+
+/**
+ * @brief 取得記錄文字的正向、以 '\0' 結尾的副本
+ */
+static char *undo_record_text(const vim_context_t *ctx, const undo_record_t *record) {
+    char *text = (char *)safe_malloc(record->text_len + 1);
+    if (text == NULL) {
+        return NULL;
+    }
     
-    /* 配置新的撤銷記錄 */
-    undo_record_t *record = (undo_record_t *)safe_malloc(sizeof(undo_record_t));
-    if (record == NULL) {
+    const char *src = ctx->undo_text + record->text_offset;
+    for (size_t i = 0; i < record->text_len; i++) {
+        text[i] = record->reversed ? src[record->text_len - 1 - i] : src[i];
+    }
+    text[record->text_len] = '\0';
+    return text;
+}
+
+/**
+ * @brief 套用記錄的反向操作（撤銷）或原操作（重做）
+ *
+ * @param editor 編輯器實例（用於移動游標）
+ * @param buf 目標緩衝區
+ * @param ctx Vim 上下文
+ * @param record 要套用的記錄
+ * @param undo true 為撤銷，false 為重做
+ */
+static void apply_undo_record(editor_t *editor, buffer_t *buf, const vim_context_t *ctx,
+                              const undo_record_t *record, bool undo) {
+    char *text = undo_record_text(ctx, record);
+    if (text == NULL) {
         return;
     }
     
-    /* 填入記錄資訊 */
-    record->type = type;
-    record->row = row;
-    record->col = col;
-    record->text = NULL;
-    record->text_len = 0;
+    size_t row = record->row;
+    size_t col = record->col;
+    bool removes;  /* 這次套用是移除還是加回內容 */
     
-    /* 複製相關文字 */
-    if (text != NULL && len > 0) {
-        record->text = safe_strndup(text, len);
-        if (record->text != NULL) {
-            record->text_len = len;
+    switch (record->type) {
+        case UNDO_INSERT_CHAR:
+        case UNDO_DELETE_CHAR:
+            removes = (record->type == UNDO_INSERT_CHAR) == undo;
+            if (removes) {
+                buffer_replace_text(buf, row, col, col + record->text_len, "");
+            } else {
+                buffer_insert_text(buf, row, col, text);
+                if (!undo) {
+                    col += record->text_len;
+                }
+            }
+            break;
+        
+        case UNDO_INSERT_LINE:
+        case UNDO_DELETE_LINE:
+            removes = (record->type == UNDO_INSERT_LINE) == undo;
+            /* 多行記錄以單一次拼接整段移除或加回 */
+            if (removes) {
+                buffer_splice_lines(buf, row, record->line_count, NULL, 0);
+            } else {
+                buffer_splice_lines(buf, row, 0, text, record->text_len);
+            }
+            col = 0;
+            break;
+        
+        case UNDO_SPLIT_LINE:
+        case UNDO_JOIN_LINE:
+            /* 分割與合併互為反向操作 */
+            if ((record->type == UNDO_SPLIT_LINE) == undo) {
+                buffer_join_lines(buf, row);
+            } else {
+                buffer_split_line(buf, row, col);
+            }
+            break;
+        
+        case UNDO_INSERT_BLOCK: {
+            /* 插入的範圍結束於最後一段文字之後 */
+            size_t end_row = row;
+            size_t end_col = col;
+            for (size_t i = 0; i < record->text_len; i++) {
+                if (text[i] == '\n') {
+                    end_row++;
+                    end_col = 0;
+                } else {
+                    end_col++;
+                }
+            }
+            if (undo) {
+                buffer_delete_range(buf, row, col, end_row, end_col);
+            } else {
+                buffer_insert_block(buf, row, col, text, record->text_len);
+                row = end_row;
+                col = end_col;
+            }
+            break;
         }
     }
     
-    /* 插入到串列頭（最新的記錄在前） */
-    record->prev = NULL;
-    record->next = ctx->undo_head;
+    safe_free(text);
+    
+    /* 游標移到變更位置 */
+    if (row >= buf->line_count) {
+        row = buf->line_count - 1;
+    }
+    line_t *line = buffer_get_line(buf, row);
+    editor->cursor_row = row;
+    editor->cursor_col = (line != NULL && col > line->length) ? line->length : col;
+}
+
+bool vim_undo(editor_t *editor, vim_context_t *ctx) {
+    TRACE_SCOPE(TRACE_VIM_UNDO);
+    if (editor == NULL || ctx == NULL || editor->buffer_count == 0 || ctx->undo_pos == 0) {
+        return false;
+    }
     
-    if (ctx->undo_head != NULL) {
-        ctx->undo_head->prev = record;
+    buffer_t *buf = editor->buffers[editor->current_buffer];
+    if (buf == NULL) {
+        return false;
     }
-    ctx->undo_head = record;
     
-    if (ctx->undo_tail == NULL) {
-        ctx->undo_tail = record;
+    /* 由新到舊撤銷最新群組的所有記錄 */
+    size_t group = ctx->undo_records[ctx->undo_pos - 1].group;
+    while (ctx->undo_pos > 0 && ctx->undo_records[ctx->undo_pos - 1].group == group) {
+        ctx->undo_pos--;
+        apply_undo_record(editor, buf, ctx, &ctx->undo_records[ctx->undo_pos], true);
+    }
+    return true;
+}
+
+bool vim_redo(editor_t *editor, vim_context_t *ctx) {
+    TRACE_SCOPE(TRACE_VIM_UNDO);
+    if (editor == NULL || ctx == NULL || editor->buffer_count == 0 || ctx->undo_pos >= ctx->undo_count) {
+        return false;
     }
     
-    ctx->undo_count++;
+    buffer_t *buf = editor->buffers[editor->current_buffer];
+    if (buf == NULL) {
+        return false;
+    }
     
-    /* 若超過上限，移除最舊的記錄 */
-    while (ctx->undo_count > ctx->undo_max && ctx->undo_tail != NULL) {
-        undo_record_t *old = ctx->undo_tail;
-        ctx->undo_tail = old->prev;
-        if (ctx->undo_tail != NULL) {
-            ctx->undo_tail->next = NULL;
-        }
-        safe_free(old->text);
-        safe_free(old);
-        ctx->undo_count--;
+    /* 由舊到新重做下一個群組的所有記錄 */
+    size_t group = ctx->undo_records[ctx->undo_pos].group;
+    while (ctx->undo_pos < ctx->undo_count && ctx->undo_records[ctx->undo_pos].group == group) {
+        apply_undo_record(editor, buf, ctx, &ctx->undo_records[ctx->undo_pos], false);
+        ctx->undo_pos++;
     }
+    return true;
 }
 
 /* ============================================================================
@@ -326,56 +662,44 @@ bool vim_find_line_end(buffer_t *buf, size_t row, size_t *new_col) {
  * 搜尋操作實作
  * ============================================================================ */
 
-bool vim_search_forward(editor_t *editor, const char *pattern) {
-    /* 參數驗證 */
-    if (editor == NULL || pattern == NULL || editor->buffer_count == 0) {
-        return false;
-    }
-    
-    buffer_t *buf = editor->buffers[editor->current_buffer];
-    if (buf == NULL) {
-        return false;
+/**
+ * @brief 取得模式的編譯結果，與上次相同時直接重複使用
+ * 
+ * 同時記錄為 n/N 使用的搜尋模式。
+ * 
+ * @param ctx Vim 上下文
+ * @param pattern 搜尋模式
+ * @return 編譯後的模式（由 ctx 擁有），失敗時回傳 NULL
+ */
+static const search_pattern_t *get_compiled_pattern(vim_context_t *ctx, const char *pattern) {
+    if (ctx->search_compiled != NULL && strcmp(ctx->search_compiled->text, pattern) == 0) {
+        return ctx->search_compiled;
     }
     
-    size_t start_row = editor->cursor_row;
-    size_t start_col = editor->cursor_col + 1;  /* 從目前位置的下一個字元開始 */
-    
-    /* 從目前位置向後搜尋 */
-    for (size_t row = start_row; row < buf->line_count; row++) {
-        line_t *line = buffer_get_line(buf, row);
-        if (line == NULL) {
-            continue;
-        }
-        
-        size_t start = (row == start_row) ? start_col : 0;
-        const char *found = strstr(line->text + start, pattern);
-        if (found != NULL) {
-            editor->cursor_row = row;
-            editor->cursor_col = found - line->text;
-            return true;
-        }
+    search_pattern_t *compiled = search_compile(pattern);
+    if (compiled == NULL) {
+        return NULL;
     }
     
-    /* 從檔案開頭繼續搜尋（循環搜尋） */
-    for (size_t row = 0; row <= start_row; row++) {
-        line_t *line = buffer_get_line(buf, row);
-        if (line == NULL) {
-            continue;
-        }
-        
-        size_t end = (row == start_row) ? start_col : line->length;
-        const char *found = strstr(line->text, pattern);
-        if (found != NULL && (size_t)(found - line->text) < end) {
-            editor->cursor_row = row;
-            editor->cursor_col = found - line->text;
-            return true;
-        }
+    /* pattern 可能就是 ctx->search_pattern，先複製再釋放 */
+    char *text = safe_strdup(pattern);
+    if (text == NULL) {
+        search_free(compiled);
+        return NULL;
     }
+    safe_free(ctx->search_pattern);
+    ctx->search_pattern = text;
     
-    return false;
+    search_free(ctx->search_compiled);
+    ctx->search_compiled = compiled;
+    return compiled;
 }
 
-bool vim_search_backward(editor_t *editor, const char *pattern) {
+/**
+ * @brief 以編輯器的上下文編譯模式並執行搜尋
+ */
+static bool search_from_cursor(editor_t *editor, const char *pattern, bool forward) {
+    TRACE_SCOPE(TRACE_VIM_SEARCH);
     /* 參數驗證 */
     if (editor == NULL || pattern == NULL || editor->buffer_count == 0) {
         return false;
@@ -386,59 +710,40 @@ bool vim_search_backward(editor_t *editor, const char *pattern) {
         return false;
     }
     
-    size_t start_row = editor->cursor_row;
-    size_t start_col = editor->cursor_col;
-    
-    /* 從目前位置向前搜尋 */
-    for (size_t row = start_row; row < buf->line_count; row--) {
-        line_t *line = buffer_get_line(buf, row);
-        if (line == NULL) {
-            if (row == 0) break;
-            continue;
-        }
-        
-        size_t end = (row == start_row) ? start_col : line->length;
-        const char *last_found = NULL;
-        const char *found = line->text;
-        
-        /* 找到該範圍內的最後一個匹配 */
-        while ((found = strstr(found, pattern)) != NULL && (size_t)(found - line->text) < end) {
-            last_found = found;
-            found++;
-        }
-        
-        if (last_found != NULL) {
-            editor->cursor_row = row;
-            editor->cursor_col = last_found - line->text;
-            return true;
-        }
-        
-        if (row == 0) break;
+    /* 沒有上下文時使用暫時的編譯結果 */
+    search_pattern_t *temp = NULL;
+    const search_pattern_t *compiled;
+    if (editor->vim_ctx != NULL) {
+        compiled = get_compiled_pattern(editor->vim_ctx, pattern);
+    } else {
+        compiled = temp = search_compile(pattern);
     }
-    
-    /* 從檔案尾端繼續搜尋（循環搜尋） */
-    for (size_t row = buf->line_count - 1; row > start_row; row--) {
-        line_t *line = buffer_get_line(buf, row);
-        if (line == NULL) {
-            continue;
-        }
-        
-        const char *last_found = NULL;
-        const char *found = line->text;
-        
-        while ((found = strstr(found, pattern)) != NULL) {
-            last_found = found;
-            found++;
-        }
-        
-        if (last_found != NULL) {
-            editor->cursor_row = row;
-            editor->cursor_col = last_found - line->text;
-            return true;
-        }
+    if (compiled == NULL) {
+        return false;
     }
     
-    return false;
+    /* 向前從游標的下一個字元開始，向後從游標之前開始，兩者皆循環搜尋 */
+    size_t row = 0;
+    size_t col = 0;
+    bool found = forward
+        ? search_buffer_forward(buf, compiled, editor->cursor_row, editor->cursor_col + 1, true, &row, &col)
+        : search_buffer_backward(buf, compiled, editor->cursor_row, editor->cursor_col, true, &row, &col);
+    
+    search_free(temp);
+    
+    if (found) {
+        editor->cursor_row = row;
+        editor->cursor_col = col;
+    }
+    return found;
+}
+
+bool vim_search_forward(editor_t *editor, const char *pattern) {
+    return search_from_cursor(editor, pattern, true);
+}
+
+bool vim_search_backward(editor_t *editor, const char *pattern) {
+    return search_from_cursor(editor, pattern, false);
 }
 
 bool vim_search_next(editor_t *editor, vim_context_t *ctx) {
@@ -466,3 +771,84 @@ bool vim_search_prev(editor_t *editor, vim_context_t *ctx) {
         return vim_search_forward(editor, ctx->search_pattern);
     }
 }
+
+bool vim_search_incremental(editor_t *editor, vim_context_t *ctx, const char *pattern) {
+    TRACE_SCOPE(TRACE_VIM_SEARCH);
+    if (editor == NULL || ctx == NULL || pattern == NULL || editor->buffer_count == 0) {
+        return false;
+    }
+    
+    buffer_t *buf = editor->buffers[editor->current_buffer];
+    if (buf == NULL) {
+        return false;
+    }
+    
+    /* 第一次呼叫：記錄起點 */
+    if (!ctx->isearch_active) {
+        ctx->isearch_active = true;
+        ctx->isearch_found = false;
+        ctx->isearch_anchor.row = editor->cursor_row;
+        ctx->isearch_anchor.col = editor->cursor_col;
+    }
+    
+    /* 模式被清空：回到起點 */
+    if (pattern[0] == '\0') {
+        ctx->isearch_found = false;
+        editor->cursor_row = ctx->isearch_anchor.row;
+        editor->cursor_col = ctx->isearch_anchor.col;
+        return false;
+    }
+    
+    /*
+     * 新模式延伸舊模式時，新模式的第一個匹配不會早於舊模式的匹配，
+     * 因此可以從目前的匹配位置（包含該位置）繼續，不必從起點重新掃描。
+     */
+    bool resume = ctx->isearch_found && ctx->search_compiled != NULL &&
+                  strncmp(pattern, ctx->search_compiled->text, ctx->search_compiled->length) == 0;
+    
+    const search_pattern_t *compiled = get_compiled_pattern(ctx, pattern);
+    if (compiled == NULL) {
+        return false;
+    }
+    
+    size_t row = 0;
+    size_t col = 0;
+    bool found;
+    if (resume) {
+        found = search_buffer_forward(buf, compiled, ctx->isearch_match.row, ctx->isearch_match.col, false, &row, &col);
+        if (!found) {
+            /* 匹配已越過檔案尾端，從開頭循環到起點 */
+            found = search_buffer_forward(buf, compiled, 0, 0, false, &row, &col) &&
+                    (row < ctx->isearch_anchor.row ||
+                     (row == ctx->isearch_anchor.row && col <= ctx->isearch_anchor.col));
+        }
+    } else {
+        found = search_buffer_forward(buf, compiled, ctx->isearch_anchor.row, ctx->isearch_anchor.col + 1, true, &row, &col);
+    }
+    
+    ctx->isearch_found = found;
+    if (found) {
+        ctx->isearch_match.row = row;
+        ctx->isearch_match.col = col;
+        editor->cursor_row = row;
+        editor->cursor_col = col;
+    } else {
+        editor->cursor_row = ctx->isearch_anchor.row;
+        editor->cursor_col = ctx->isearch_anchor.col;
+    }
+    return found;
+}
+
+void vim_search_incremental_end(editor_t *editor, vim_context_t *ctx, bool accept) {
+    if (editor == NULL || ctx == NULL || !ctx->isearch_active) {
+        return;
+    }
+    
+    if (!accept) {
+        editor->cursor_row = ctx->isearch_anchor.row;
+        editor->cursor_col = ctx->isearch_anchor.col;
+    }
+    
+    ctx->isearch_active = false;
+    ctx->isearch_found = false;
+}
@@ -19,6 +19,7 @@
 #define VIM_OPS_H
 
 #include "buffer.h"
+#include "search.h"
 #include "../ui/input.h"
 #include "../ui/screen.h"
 #include <stdbool.h>
@@ -65,25 +66,32 @@ typedef enum {
     UNDO_DELETE_LINE,   /**< 刪除行 */
     UNDO_JOIN_LINE,     /**< 合併行 */
     UNDO_SPLIT_LINE,    /**< 分割行 */
+    UNDO_INSERT_BLOCK,  /**< 插入多行文字（貼上；撤銷時刪除整段範圍） */
 } undo_type_t;
 
 /* ============================================================================
  * 資料結構定義
  * ============================================================================ */
 
+/** @brief 撤銷記錄的預設記憶體預算（位元組） */
+#define VIM_UNDO_DEFAULT_BUDGET (4u * 1024u * 1024u)
+
 /**
  * @brief 撤銷記錄結構
  * 
- * 儲存單一操作的撤銷資訊，使用雙向鏈結串列連接。
+ * 儲存一段連續操作的撤銷資訊。相鄰的同類操作會合併為一筆記錄
+ * （如連續輸入的字元、連續刪除或貼上的多行），文字存放在
+ * 上下文的連續文字區中，記錄本身以陣列儲存。
  */
 typedef struct undo_record {
     undo_type_t type;           /**< 操作類型 */
     size_t row;                 /**< 操作發生的行號 */
     size_t col;                 /**< 操作發生的欄位 */
-    char *text;                 /**< 相關的文字內容 */
-    size_t text_len;            /**< 文字長度 */
-    struct undo_record *prev;   /**< 前一筆記錄 */
-    struct undo_record *next;   /**< 後一筆記錄 */
+    size_t text_offset;         /**< 文字在 undo_text 中的位移 */
+    size_t text_len;            /**< 文字長度（行操作時多行以 '\n' 分隔） */
+    size_t line_count;          /**< 行操作涉及的行數 */
+    size_t group;               /**< 群組編號（同一群組的記錄一次撤銷） */
+    bool reversed;              /**< 文字以反向儲存（連續 Backspace 刪除的字元） */
 } undo_record_t;
 
 /**
@@ -107,10 +115,16 @@ typedef struct vim_context {
     size_t count;                   /**< 重複次數（如 3dd） */
     bool pending;                   /**< 是否有待處理的操作符 */
     char last_key;                  /**< 最後按下的按鍵 */
-    undo_record_t *undo_head;       /**< 撤銷記錄串列頭（最新） */
-    undo_record_t *undo_tail;       /**< 撤銷記錄串列尾（最舊） */
-    size_t undo_count;              /**< 目前撤銷記錄數量 */
-    size_t undo_max;                /**< 最大撤銷記錄數量 */
+    undo_record_t *undo_records;    /**< 撤銷記錄陣列（由舊到新） */
+    size_t undo_count;              /**< 記錄數量（含可重做的記錄） */
+    size_t undo_capacity;           /**< 記錄陣列容量 */
+    size_t undo_pos;                /**< 已套用的記錄數，其後為可重做的記錄 */
+    char *undo_text;                /**< 所有記錄文字的連續儲存區 */
+    size_t undo_text_len;           /**< 文字區已使用長度 */
+    size_t undo_text_cap;           /**< 文字區容量 */
+    size_t undo_budget;             /**< 撤銷記錄的記憶體預算（位元組） */
+    size_t undo_group;              /**< 目前的群組編號 */
+    bool undo_group_open;           /**< 是否正在群組中（如一次插入模式） */
     vim_register_t registers[26];   /**< a-z 具名暫存器 */
     vim_register_t default_register;/**< 預設暫存器（"） */
     visual_mode_t visual_mode;      /**< Visual 模式類型 */
@@ -118,6 +132,11 @@ typedef struct vim_context {
     cursor_t visual_end;            /**< Visual 模式選取終點 */
     char *search_pattern;           /**< 目前的搜尋模式 */
     size_t search_direction;        /**< 搜尋方向（1=向前，-1=向後） */
+    search_pattern_t *search_compiled; /**< search_pattern 編譯後的結果（n/N 重複使用） */
+    bool isearch_active;            /**< 是否正在進行增量搜尋 */
+    bool isearch_found;             /**< 增量搜尋目前是否有匹配 */
+    cursor_t isearch_anchor;        /**< 增量搜尋開始時的游標位置 */
+    cursor_t isearch_match;         /**< 增量搜尋目前的匹配位置 */
 } vim_context_t;
 
 /* ============================================================================
@@ -216,6 +235,8 @@ bool vim_visual_mode(editor_t *editor, key_input_t *key, vim_context_t *ctx);
 /**
  * @brief 執行撤銷操作
  * 
+ * 一次撤銷最新的整個群組（如一次插入模式中的所有輸入）。
+ * 
  * @param editor 編輯器實例
  * @param ctx Vim 上下文
  * @return 成功撤銷回傳 true，無可撤銷時回傳 false
@@ -225,6 +246,8 @@ bool vim_undo(editor_t *editor, vim_context_t *ctx);
 /**
  * @brief 執行重做操作
  * 
+ * 一次重做下一個完整群組。
+ * 
  * @param editor 編輯器實例
  * @param ctx Vim 上下文
  * @return 成功重做回傳 true，無可重做時回傳 false
@@ -234,6 +257,9 @@ bool vim_redo(editor_t *editor, vim_context_t *ctx);
 /**
  * @brief 記錄撤銷資訊
  * 
+ * 記錄已完成的操作；與同群組最新記錄相鄰的同類操作會直接合併。
+ * 新記錄會捨棄所有可重做的記錄，超出記憶體預算時捨棄最舊的群組。
+ * 
  * @param ctx Vim 上下文
  * @param type 操作類型
  * @param row 行號
@@ -243,6 +269,30 @@ bool vim_redo(editor_t *editor, vim_context_t *ctx);
  */
 void vim_record_undo(vim_context_t *ctx, undo_type_t type, size_t row, size_t col, const char *text, size_t len);
 
+/**
+ * @brief 開始撤銷群組
+ * 
+ * 之後記錄的操作都屬於同一群組，直到 vim_undo_end_group()。
+ * 
+ * @param ctx Vim 上下文
+ */
+void vim_undo_begin_group(vim_context_t *ctx);
+
+/**
+ * @brief 結束撤銷群組
+ * 
+ * @param ctx Vim 上下文
+ */
+void vim_undo_end_group(vim_context_t *ctx);
+
+/**
+ * @brief 設定撤銷記錄的記憶體預算
+ * 
+ * @param ctx Vim 上下文
+ * @param bytes 預算（位元組），0 表示使用 VIM_UNDO_DEFAULT_BUDGET
+ */
+void vim_set_undo_budget(vim_context_t *ctx, size_t bytes);
+
 /* ============================================================================
  * 暫存器操作
  * ============================================================================ */
@@ -317,6 +367,28 @@ bool vim_search_next(editor_t *editor, vim_context_t *ctx);
  */
 bool vim_search_prev(editor_t *editor, vim_context_t *ctx);
 
+/**
+ * @brief 增量搜尋（邊輸入邊搜尋）
+ * 
+ * 第一次呼叫時記錄游標位置作為起點。之後若新模式是上一個模式的延伸，
+ * 從目前的匹配位置繼續搜尋，否則從起點重新搜尋；找不到時游標回到起點。
+ * 
+ * @param editor 編輯器實例
+ * @param ctx Vim 上下文
+ * @param pattern 目前輸入的搜尋模式（可為空字串）
+ * @return 找到回傳 true 並移動游標，否則回傳 false
+ */
+bool vim_search_incremental(editor_t *editor, vim_context_t *ctx, const char *pattern);
+
+/**
+ * @brief 結束增量搜尋
+ * 
+ * @param editor 編輯器實例
+ * @param ctx Vim 上下文
+ * @param accept true 保留目前匹配位置，false 將游標還原到起點
+ */
+void vim_search_incremental_end(editor_t *editor, vim_context_t *ctx, bool accept);
+
 /* ============================================================================
  * 文字物件操作
  * ============================================================================ */
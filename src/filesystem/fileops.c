@@ -8,6 +8,8 @@
  * @date 2025
  */
 
+#define _DEFAULT_SOURCE  /* 啟用 syscall（_GNU_SOURCE 的 error_t 會與 error.h 衝突） */
+
 #include "fileops.h"
 #include "../security/sanitize.h"
 #include "../security/validation.h"
@@ -20,10 +22,17 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
 
 /** 檔案大小上限：100MB */
 #define MAX_FILE_SIZE (1024 * 1024 * 100)
 
+/** 串流讀寫與複製時每次系統呼叫的最大位元組數 */
+#define STREAM_CHUNK_SIZE (8u * 1024u * 1024u)
+
 /* ========================================================================
  * 檔案開啟與讀寫函式實作
  * ======================================================================== */
@@ -125,6 +134,33 @@ bool fileops_read(const char *path, void **data, size_t *size) {
     return true;
 }
 
+/**
+ * @brief 將檔案內容讀入呼叫者提供的緩衝區
+ */
+bool fileops_read_exact(const char *path, void *dst, size_t size) {
+    if (path == NULL || (dst == NULL && size > 0)) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    FILE *file = fileops_open(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    
+    /* 不使用 stdio 緩衝區，直接讀入目的記憶體 */
+    setvbuf(file, NULL, _IONBF, 0);
+    size_t read_size = fread(dst, 1, size, file);
+    fclose(file);
+    
+    if (read_size != size) {
+        error_set(ERR_IO_ERROR, "讀取檔案失敗: %s", path);
+        return false;
+    }
+    
+    return true;
+}
+
 /**
  * @brief 安全地寫入檔案內容
  */
@@ -158,6 +194,136 @@ bool fileops_write(const char *path, const void *data, size_t size) {
     return true;
 }
 
+/* ========================================================================
+ * 檔案描述符串流函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 從檔案描述符讀取恰好 size 位元組
+ */
+int fileops_read_fd(int fd, void *dst, size_t size) {
+    char *p = (char *)dst;
+    size_t done = 0;
+    
+    while (done < size) {
+        size_t chunk = size - done;
+        if (chunk > STREAM_CHUNK_SIZE) {
+            chunk = STREAM_CHUNK_SIZE;
+        }
+        
+        ssize_t n = read(fd, p + done, chunk);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (n == 0) {
+            return EIO;  /* 檔案比預期短（讀取期間被截斷） */
+        }
+        done += (size_t)n;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 將 size 位元組完整寫入檔案描述符
+ */
+int fileops_write_fd(int fd, const void *src, size_t size) {
+    const char *p = (const char *)src;
+    size_t done = 0;
+    
+    while (done < size) {
+        size_t chunk = size - done;
+        if (chunk > STREAM_CHUNK_SIZE) {
+            chunk = STREAM_CHUNK_SIZE;
+        }
+        
+        ssize_t n = write(fd, p + done, chunk);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        done += (size_t)n;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 在兩個檔案描述符之間串流複製內容
+ *
+ * 依序嘗試 copy_file_range（同檔案系統可在核心內完成，甚至共用區塊）、
+ * sendfile，最後退回以固定大小緩衝區 read/write。
+ */
+int fileops_copy_fd(int in_fd, int out_fd, size_t size) {
+    size_t done = 0;
+
+#if defined(__linux__)
+    /* 核心內複製：不經過使用者空間；不支援時（如跨檔案系統）改用下一種方式 */
+    while (done < size) {
+        size_t chunk = size - done;
+        if (chunk > STREAM_CHUNK_SIZE) {
+            chunk = STREAM_CHUNK_SIZE;
+        }
+#if defined(SYS_copy_file_range)
+        ssize_t n = (ssize_t)syscall(SYS_copy_file_range, in_fd, NULL, out_fd, NULL, chunk, 0u);
+#else
+        ssize_t n = 0;  /* 不支援：直接改用 sendfile */
+#endif
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    
+    while (done < size) {
+        size_t chunk = size - done;
+        if (chunk > STREAM_CHUNK_SIZE) {
+            chunk = STREAM_CHUNK_SIZE;
+        }
+        ssize_t n = sendfile(out_fd, in_fd, NULL, chunk);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+#endif
+    
+    if (done == size) {
+        return 0;
+    }
+    
+    /* 一般 read/write 複製剩餘部分（使用 malloc：失敗時不設定錯誤訊息） */
+    size_t buffer_size = size - done < STREAM_CHUNK_SIZE ? size - done : STREAM_CHUNK_SIZE;
+    char *buffer = (char *)malloc(buffer_size);
+    if (buffer == NULL) {
+        return ENOMEM;
+    }
+    
+    int err = 0;
+    while (err == 0 && done < size) {
+        size_t chunk = size - done < buffer_size ? size - done : buffer_size;
+        err = fileops_read_fd(in_fd, buffer, chunk);
+        if (err == 0) {
+            err = fileops_write_fd(out_fd, buffer, chunk);
+        }
+        done += chunk;
+    }
+    
+    free(buffer);
+    return err;
+}
+
 /* ========================================================================
  * 檔案管理函式實作
  * ======================================================================== */
@@ -176,21 +342,42 @@ bool fileops_copy(const char *src, const char *dst) {
         return false;
     }
     
-    /* 讀取來源檔案 */
-    void *data = NULL;
-    size_t size = 0;
-    
-    if (!fileops_read(src, &data, &size)) {
+    char *normalized_src = normalize_path(src);
+    char *normalized_dst = normalize_path(dst);
+    if (normalized_src == NULL || normalized_dst == NULL) {
+        safe_free(normalized_src);
+        safe_free(normalized_dst);
         return false;
     }
     
-    /* 寫入目標檔案 */
-    bool result = fileops_write(dst, data, size);
-    
-    /* 安全清除並釋放緩衝區 */
-    secure_zero(data, size);
-    safe_free(data);
-    
+    /* 以檔案描述符串流複製，內容不整份讀入記憶體，也不受 MAX_FILE_SIZE 限制 */
+    bool result = false;
+    struct stat st;
+    int in_fd = open(normalized_src, O_RDONLY);
+    if (in_fd < 0 || fstat(in_fd, &st) != 0) {
+        error_set(ERR_FILE_NOT_FOUND, "無法打開檔案 %s: %s", normalized_src, strerror(errno));
+    } else {
+        int out_fd = open(normalized_dst, O_WRONLY | O_CREAT | O_TRUNC, st.st_mode & 0777);
+        if (out_fd < 0) {
+            error_set(ERR_IO_ERROR, "無法打開檔案 %s: %s", normalized_dst, strerror(errno));
+        } else {
+            int err = fileops_copy_fd(in_fd, out_fd, (size_t)st.st_size);
+            if (close(out_fd) != 0 && err == 0) {
+                err = errno;
+            }
+            if (err != 0) {
+                error_set(ERR_IO_ERROR, "複製檔案失敗 %s: %s", normalized_dst, strerror(err));
+            } else {
+                result = true;
+            }
+        }
+    }
+    
+    if (in_fd >= 0) {
+        close(in_fd);
+    }
+    safe_free(normalized_src);
+    safe_free(normalized_dst);
     return result;
 }
 
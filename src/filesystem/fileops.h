@@ -51,6 +51,19 @@ FILE *fileops_open(const char *path, const char *mode);
  */
 bool fileops_read(const char *path, void **data, size_t *size);
 
+/**
+ * @brief 將檔案內容讀入呼叫者提供的緩衝區
+ *
+ * 讀取檔案開頭的 size 個位元組，不經過 stdio 緩衝區，
+ * 適合已知檔案大小、要直接讀入目的記憶體的情況。
+ *
+ * @param path 檔案路徑
+ * @param dst  目的緩衝區（至少 size 位元組）
+ * @param size 要讀取的位元組數
+ * @return true 成功，false 失敗（包含檔案比 size 短）
+ */
+bool fileops_read_exact(const char *path, void *dst, size_t size);
+
 /**
  * @brief 安全地寫入檔案內容
  *
@@ -63,6 +76,46 @@ bool fileops_read(const char *path, void **data, size_t *size);
  */
 bool fileops_write(const char *path, const void *data, size_t size);
 
+/* ========================================================================
+ * 檔案描述符串流函式
+ *
+ * 以大區塊直接在檔案描述符與記憶體之間傳輸，不經過 stdio 緩衝區。
+ * 這些函式不設定錯誤訊息，而是回傳 errno 值，可在工作執行緒中平行呼叫。
+ * ======================================================================== */
+
+/**
+ * @brief 從檔案描述符讀取恰好 size 位元組
+ *
+ * @param fd   已開啟的檔案描述符
+ * @param dst  目的緩衝區（至少 size 位元組）
+ * @param size 要讀取的位元組數
+ * @return 成功回傳 0，失敗回傳 errno 值（檔案提前結束時為 EIO）
+ */
+int fileops_read_fd(int fd, void *dst, size_t size);
+
+/**
+ * @brief 將 size 位元組完整寫入檔案描述符
+ *
+ * @param fd   已開啟的檔案描述符
+ * @param src  來源緩衝區
+ * @param size 要寫入的位元組數
+ * @return 成功回傳 0，失敗回傳 errno 值
+ */
+int fileops_write_fd(int fd, const void *src, size_t size);
+
+/**
+ * @brief 在兩個檔案描述符之間串流複製 size 位元組
+ *
+ * 主機支援時使用 copy_file_range 或 sendfile 在核心內複製，
+ * 否則以固定大小的緩衝區分段讀寫。
+ *
+ * @param in_fd  來源檔案描述符（從目前位置開始讀取）
+ * @param out_fd 目標檔案描述符（從目前位置開始寫入）
+ * @param size   要複製的位元組數
+ * @return 成功回傳 0，失敗回傳 errno 值
+ */
+int fileops_copy_fd(int in_fd, int out_fd, size_t size);
+
 /* ========================================================================
  * 檔案管理函式
  * ======================================================================== */
@@ -70,7 +123,8 @@ bool fileops_write(const char *path, const void *data, size_t size);
 /**
  * @brief 安全地複製檔案
  *
- * 將來源檔案複製到目標路徑。
+ * 將來源檔案複製到目標路徑。以串流方式複製（主機支援時使用
+ * copy_file_range/sendfile），內容不整份讀入記憶體，也不受檔案大小上限限制。
  *
  * @param src 來源檔案路徑
  * @param dst 目標檔案路徑
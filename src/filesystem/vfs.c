@@ -8,28 +8,196 @@
  * @date 2025
  */
 
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 pthread_rwlock_t） */
+
 #include "vfs.h"
 #include "path.h"
 #include "../security/sanitize.h"
 #include "../security/validation.h"
 #include "../utils/memory.h"
 #include "../utils/error.h"
+#include "../utils/trace.h"
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* ========================================================================
+ * 子節點雜湊索引
+ * ======================================================================== */
+
+/** @brief 索引最小槽數（需為 2 的冪次） */
+#define CHILD_INDEX_MIN_SLOTS 64
+
+/**
+ * @brief 雜湊索引槽位
+ *
+ * 保存名稱雜湊值以便在比對字串前快速排除不相符的槽位，
+ * node 為 NULL 代表空槽。
+ */
+typedef struct {
+    uint32_t hash;                 /**< 名稱雜湊值 */
+    vfs_node_t *node;              /**< 對應的子節點 */
+} child_slot_t;
+
+/**
+ * @brief 目錄子節點雜湊索引（開放定址、線性探測）
+ */
+struct vfs_child_index {
+    child_slot_t *slots;           /**< 槽位陣列 */
+    size_t capacity;               /**< 槽位數量（2 的冪次） */
+    size_t count;                  /**< 已使用槽位數量 */
+};
+
+/* ========================================================================
+ * 子節點名稱排序索引
+ * ======================================================================== */
+
+/** @brief 排序索引的最小容量 */
+#define SORTED_INDEX_MIN_CAPACITY 16
+
+/**
+ * @brief 目錄子節點排序索引（依名稱位元組序排列的指標陣列）
+ *
+ * 首次依名稱順序走訪目錄時建立，之後隨子節點的加入與移除以
+ * 二分搜尋定位並就地插入/刪除，不需重新排序。
+ */
+struct vfs_sorted_index {
+    vfs_node_t **nodes;            /**< 依名稱排序的子節點 */
+    size_t count;                  /**< 子節點數量 */
+    size_t capacity;               /**< 陣列容量 */
+};
+
+/* ========================================================================
+ * 併行存取
+ * ======================================================================== */
+
+/**
+ * @brief 併行模式使用的鎖
+ */
+struct vfs_sync {
+    pthread_rwlock_t lock;         /**< 讀寫鎖（讀取者共享，寫入者獨佔） */
+    pthread_mutex_t turnstile;     /**< 取得讀寫鎖前先通過，等待中的寫入者擋住新的讀取者 */
+    pthread_mutex_t cache_lock;    /**< 保護讀取者也會更新的狀態（延遲載入、合併分段、排序索引、路徑快取）；
+                                        子節點雜湊索引只在獨佔存取時建立（add_child 與載入），不需此鎖 */
+};
+
+/* ========================================================================
+ * 節點配置池
+ * ======================================================================== */
+
+/** @brief 每個 slab 容納的節點數量 */
+#define NODE_SLAB_COUNT 256
+
+/**
+ * @brief 節點 slab
+ *
+ * 一次配置一整塊連續節點，提升走訪樹狀結構時的區域性。
+ */
+typedef struct node_slab {
+    struct node_slab *next;                /**< 下一個 slab */
+    size_t used;                           /**< 已切出的節點數量 */
+    vfs_node_t nodes[NODE_SLAB_COUNT];     /**< 節點儲存區 */
+} node_slab_t;
+
+/**
+ * @brief VFS 節點配置池
+ *
+ * 釋放的節點以 next 欄位串成自由串列重複使用；
+ * vfs_destroy 時線性掃描所有 slab 一次釋放，不需遞迴走訪。
+ */
+struct vfs_node_pool {
+    node_slab_t *slabs;                    /**< slab 串列（最新者在前） */
+    vfs_node_t *free_list;                 /**< 可重複使用的節點 */
+};
+
+/* ========================================================================
+ * 檔案內容區塊
+ * ======================================================================== */
+
+/**
+ * @brief 內容區塊標頭
+ *
+ * 內容緊接在標頭之後，節點的 data 指向 bytes。
+ * 參考計數與 VFS 其餘部分相同，不具執行緒安全性。
+ */
+typedef struct {
+    size_t refcount;               /**< 參考計數 */
+    size_t size;                   /**< 內容大小（位元組） */
+    unsigned char bytes[];         /**< 內容 */
+} vfs_blob_t;
+
+/** @brief 由內容指標取得區塊標頭 */
+#define BLOB_OF(data) ((vfs_blob_t *)((unsigned char *)(data) - offsetof(vfs_blob_t, bytes)))
+
+/* ========================================================================
+ * 路徑快取
+ * ======================================================================== */
+
+/**
+ * @brief 路徑快取項目
+ */
+typedef struct {
+    vfs_node_t *node;              /**< 快取的節點（NULL 表示空項目） */
+    char *path;                    /**< 完整路徑（項目清空後保留緩衝區重複使用） */
+    size_t len;                    /**< 路徑長度 */
+    size_t capacity;               /**< 緩衝區大小 */
+    uint64_t last_used;            /**< 最近一次使用的時間戳（遞增計數） */
+} path_cache_entry_t;
+
+/**
+ * @brief VFS 完整路徑快取
+ *
+ * 快取的節點帶有 VFS_NODE_PATH_CACHED 旗標，重新命名或移動節點時
+ * 檢查各項目的祖先鏈，只清除位於該子樹中的項目；
+ * 成本與快取大小成正比，與子樹大小無關。
+ */
+struct vfs_path_cache {
+    path_cache_entry_t entries[VFS_PATH_CACHE_SLOTS]; /**< 快取項目 */
+    uint64_t clock;                /**< 使用時間戳計數器 */
+};
 
 /* ========================================================================
  * 內部輔助函式宣告
  * ======================================================================== */
 
-static vfs_node_t *create_node(const char *name, vfs_node_type_t type);
-static void destroy_node(vfs_node_t *node);
-static vfs_node_t *find_child(vfs_node_t *parent, const char *name);
+static vfs_node_t *create_node(vfs_t *vfs, const char *name, size_t len, vfs_node_type_t type);
+static vfs_node_t *insert_file(vfs_t *vfs, const char *path, void *blob, size_t size);
+static void extents_free(vfs_extent_list_t *list);
+static vfs_extent_list_t *extents_share(const vfs_extent_list_t *src);
+static void path_cache_forget(vfs_node_t *node);
+static void path_cache_invalidate(vfs_t *vfs, const vfs_node_t *subtree);
+static char *path_alloc(vfs_node_t *node, arena_t *arena);
+static void destroy_node(vfs_t *vfs, vfs_node_t *node);
+static void release_node_resources(vfs_node_t *node);
+static bool set_node_name(vfs_node_t *node, const char *name, size_t len);
+static bool materialize_node(vfs_node_t *node);
+static bool content_acquire(vfs_node_t *node, bool load, bool flatten, vfs_content_view_t *view);
+static void retired_release(vfs_t *vfs);
+static void vfs_notify(vfs_t *vfs, vfs_op_t op, const char *path, const char *path2,
+                       const void *data, size_t size, time_t mtime);
+static void mark_dirty(vfs_t *vfs, size_t bytes);
+static vfs_node_t *find_child(vfs_node_t *parent, const char *name, size_t len);
 static bool add_child(vfs_node_t *parent, vfs_node_t *child);
 static bool remove_child(vfs_node_t *parent, vfs_node_t *child);
+static void stats_adjust(vfs_node_t *dir, size_t nodes, size_t bytes, bool grow);
+static void file_set_size(vfs_node_t *file, size_t size);
 static vfs_node_t *resolve_path(vfs_t *vfs, const char *path, bool create_dirs);
-static char **split_path(const char *path, size_t *count);
+static inline bool name_equals(const char *node_name, const char *name, size_t len);
+static uint32_t hash_name(const char *name, size_t len);
+static bool child_index_build(vfs_node_t *dir);
+static void child_index_destroy(vfs_node_t *dir);
+static bool child_index_insert(vfs_node_t *dir, vfs_node_t *child);
+static void child_index_remove(vfs_node_t *dir, vfs_node_t *child);
+static vfs_node_t *child_index_lookup(vfs_node_t *dir, const char *name, size_t len);
+static bool sorted_index_build(vfs_node_t *dir);
+static void sorted_index_destroy(vfs_node_t *dir);
+static void sorted_index_insert(vfs_node_t *dir, vfs_node_t *child);
+static void sorted_index_remove(vfs_node_t *dir, vfs_node_t *child);
+static size_t sorted_index_lower_bound(const vfs_sorted_index_t *index, const char *name, size_t len);
 
 /* ========================================================================
  * VFS 生命週期函式實作
@@ -44,124 +212,1225 @@ vfs_t *vfs_init(void) {
         return NULL;
     }
     
+    vfs->pool = (struct vfs_node_pool *)safe_malloc(sizeof(struct vfs_node_pool));
+    if (vfs->pool == NULL) {
+        safe_free(vfs);
+        return NULL;
+    }
+    vfs->pool->slabs = NULL;
+    vfs->pool->free_list = NULL;
+    
+    vfs->sync = (struct vfs_sync *)safe_malloc(sizeof(struct vfs_sync));
+    if (vfs->sync == NULL) {
+        safe_free(vfs->pool);
+        safe_free(vfs);
+        return NULL;
+    }
+    vfs->backing = NULL;
+    vfs->observer = NULL;
+    vfs->image_id = 0;
+    vfs->concurrent = false;
+    vfs->retired = NULL;
+    
     /* 建立根目錄節點 */
-    vfs->root = create_node("/", VFS_DIR);
+    vfs->root = create_node(vfs, "/", 1, VFS_DIR);
     if (vfs->root == NULL) {
+        safe_free(vfs->sync);
+        safe_free(vfs->pool);
         safe_free(vfs);
         return NULL;
     }
     
+    pthread_rwlock_init(&vfs->sync->lock, NULL);
+    pthread_mutex_init(&vfs->sync->turnstile, NULL);
+    pthread_mutex_init(&vfs->sync->cache_lock, NULL);
+    
     vfs->root->parent = NULL;
     vfs->total_nodes = 1;
     vfs->total_size = 0;
     
-    return vfs;
+    return vfs;
+}
+
+/**
+ * @brief 銷毀虛擬檔案系統
+ *
+ * 線性掃描節點池釋放各節點擁有的資源，再整批釋放 slab。
+ */
+void vfs_destroy(vfs_t *vfs) {
+    if (vfs == NULL) {
+        return;
+    }
+    
+    node_slab_t *slab = vfs->pool->slabs;
+    while (slab != NULL) {
+        node_slab_t *next = slab->next;
+        for (size_t i = 0; i < slab->used; i++) {
+            if (slab->nodes[i].flags & VFS_NODE_IN_USE) {
+                release_node_resources(&slab->nodes[i]);
+            }
+        }
+        tagged_free(MEM_TAG_VFS_NODE, slab, sizeof(node_slab_t));
+        slab = next;
+    }
+    
+    if (vfs->backing != NULL) {
+        vfs->backing->release(vfs->backing);
+    }
+    
+    if (vfs->path_cache != NULL) {
+        for (size_t i = 0; i < VFS_PATH_CACHE_SLOTS; i++) {
+            tagged_free(MEM_TAG_VFS_INDEX, vfs->path_cache->entries[i].path,
+                        vfs->path_cache->entries[i].capacity);
+        }
+        tagged_free(MEM_TAG_VFS_INDEX, vfs->path_cache, sizeof(struct vfs_path_cache));
+    }
+    
+    retired_release(vfs);
+    pthread_mutex_destroy(&vfs->sync->cache_lock);
+    pthread_mutex_destroy(&vfs->sync->turnstile);
+    pthread_rwlock_destroy(&vfs->sync->lock);
+    safe_free(vfs->sync);
+    
+    safe_free(vfs->pool);
+    safe_free(vfs);
+}
+
+/**
+ * @brief 將 VFS 標記為已持久化
+ */
+void vfs_mark_clean(vfs_t *vfs) {
+    if (vfs != NULL) {
+        vfs->dirty_ops = 0;
+        vfs->dirty_bytes = 0;
+    }
+}
+
+/**
+ * @brief 複製節點到快照（遞迴處理子節點）
+ *
+ * 子節點依原順序串接，序列化結果與原 VFS 相同。
+ *
+ * @param snapshot 快照
+ * @param dst      快照中的對應節點（名稱與類型已設定）
+ * @param src      原節點
+ * @return true 成功，false 記憶體不足（已配置的節點由 vfs_destroy 一併釋放）
+ */
+static bool snapshot_node(vfs_t *snapshot, vfs_node_t *dst, const vfs_node_t *src) {
+    dst->size = src->size;
+    dst->tree_nodes = src->tree_nodes;
+    dst->tree_size = src->tree_size;
+    dst->mtime = src->mtime;
+    dst->ctime = src->ctime;
+    
+    if (src->type == VFS_FILE) {
+        dst->flags |= src->flags & VFS_NODE_LAZY;
+        dst->backing_offset = src->backing_offset;
+        dst->data = vfs_blob_retain(src->data);
+        if (src->extents != NULL) {
+            dst->extents = extents_share(src->extents);
+            if (dst->extents == NULL) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    vfs_node_t **tail = &dst->children;
+    for (const vfs_node_t *child = src->children; child != NULL; child = child->next) {
+        vfs_node_t *node = create_node(snapshot, child->name, strlen(child->name), child->type);
+        if (node == NULL) {
+            return false;
+        }
+        node->parent = dst;
+        *tail = node;
+        tail = &node->next;
+        if (!snapshot_node(snapshot, node, child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 建立 VFS 的快照
+ */
+vfs_t *vfs_snapshot(vfs_t *vfs) {
+    if (vfs == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    vfs_t *snapshot = vfs_init();
+    if (snapshot == NULL) {
+        return NULL;
+    }
+    
+    snapshot->backing = vfs->backing;
+    snapshot->image_id = vfs->image_id;
+    snapshot->total_nodes = vfs->total_nodes;
+    snapshot->total_size = vfs->total_size;
+    if (!snapshot_node(snapshot, snapshot->root, vfs->root)) {
+        vfs_snapshot_release(snapshot);
+        error_set(ERR_MEMORY, "建立快照時記憶體不足");
+        return NULL;
+    }
+    return snapshot;
+}
+
+/**
+ * @brief 釋放快照
+ */
+void vfs_snapshot_release(vfs_t *snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+    
+    /* 後備儲存屬於原 VFS */
+    snapshot->backing = NULL;
+    vfs_destroy(snapshot);
+}
+
+/* ========================================================================
+ * 併行存取函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 釋放讀取者合併後留下的分段串列
+ *
+ * 僅在沒有讀取者可能仍借用這些段落時呼叫（持有寫入鎖或沒有其他執行緒）。
+ */
+static void retired_release(vfs_t *vfs) {
+    while (vfs->retired != NULL) {
+        vfs_extent_list_t *list = vfs->retired;
+        vfs->retired = list->next_retired;
+        extents_free(list);
+    }
+}
+
+/**
+ * @brief 取得保護讀取者更新狀態的互斥鎖（非併行模式不做任何事）
+ */
+static inline void cache_lock(vfs_t *vfs) {
+    if (vfs->concurrent) {
+        pthread_mutex_lock(&vfs->sync->cache_lock);
+    }
+}
+
+/**
+ * @brief 釋放 cache_lock() 取得的互斥鎖
+ */
+static inline void cache_unlock(vfs_t *vfs) {
+    if (vfs->concurrent) {
+        pthread_mutex_unlock(&vfs->sync->cache_lock);
+    }
+}
+
+/**
+ * @brief 啟用或停用併行模式
+ */
+void vfs_set_concurrent(vfs_t *vfs, bool enabled) {
+    if (vfs == NULL) {
+        return;
+    }
+    vfs->concurrent = enabled;
+    retired_release(vfs);
+}
+
+/**
+ * @brief 取得讀取鎖
+ */
+void vfs_read_lock(vfs_t *vfs) {
+    if (vfs != NULL && vfs->concurrent) {
+        pthread_mutex_lock(&vfs->sync->turnstile);
+        pthread_rwlock_rdlock(&vfs->sync->lock);
+        pthread_mutex_unlock(&vfs->sync->turnstile);
+    }
+}
+
+/**
+ * @brief 取得寫入鎖
+ */
+void vfs_write_lock(vfs_t *vfs) {
+    if (vfs != NULL && vfs->concurrent) {
+        /* 預設的讀寫鎖偏好讀取者，持續有讀取者時寫入者會一直等待；
+         * 寫入者等待期間持有 turnstile，新的讀取者需排在其後 */
+        pthread_mutex_lock(&vfs->sync->turnstile);
+        pthread_rwlock_wrlock(&vfs->sync->lock);
+        pthread_mutex_unlock(&vfs->sync->turnstile);
+        
+        /* 已沒有讀取者借用被合併掉的段落 */
+        retired_release(vfs);
+    }
+}
+
+/**
+ * @brief 釋放讀取鎖或寫入鎖
+ */
+void vfs_unlock(vfs_t *vfs) {
+    if (vfs != NULL && vfs->concurrent) {
+        pthread_rwlock_unlock(&vfs->sync->lock);
+    }
+}
+
+/* ========================================================================
+ * 節點配置函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 配置新節點
+ */
+vfs_node_t *vfs_node_alloc(vfs_t *vfs, const char *name, size_t len, vfs_node_type_t type) {
+    if (vfs == NULL || name == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    return create_node(vfs, name, len, type);
+}
+
+/**
+ * @brief 釋放節點及其子節點
+ */
+void vfs_node_free(vfs_t *vfs, vfs_node_t *node) {
+    if (vfs == NULL) {
+        return;
+    }
+    
+    destroy_node(vfs, node);
+}
+
+/**
+ * @brief 為載入後的大型目錄建立子節點雜湊索引
+ */
+void vfs_node_index_children(vfs_node_t *dir) {
+    if (dir == NULL || dir->type != VFS_DIR || dir->child_index != NULL ||
+        dir->size <= VFS_CHILD_INDEX_THRESHOLD) {
+        return;
+    }
+    
+    /* 索引僅為加速用途，記憶體不足時維持鏈結串列，之後加入子節點時再建立 */
+    child_index_build(dir);
+}
+
+/* ========================================================================
+ * 檔案內容區塊函式實作
+ * ======================================================================== */
+
+void *vfs_blob_create(const void *data, size_t size) {
+    if (size == 0) {
+        error_set(ERR_INVALID_INPUT, "內容區塊大小為 0");
+        return NULL;
+    }
+    
+    if (size > SIZE_MAX - sizeof(vfs_blob_t)) {
+        error_set(ERR_MEMORY, "內容區塊過大: %zu", size);
+        return NULL;
+    }
+    
+    vfs_blob_t *blob = (vfs_blob_t *)tagged_malloc(MEM_TAG_FILE_DATA, sizeof(vfs_blob_t) + size);
+    if (blob == NULL) {
+        return NULL;
+    }
+    
+    blob->refcount = 1;
+    blob->size = size;
+    if (data != NULL) {
+        memcpy(blob->bytes, data, size);
+    }
+    return blob->bytes;
+}
+
+void *vfs_blob_retain(void *data) {
+    if (data != NULL) {
+        BLOB_OF(data)->refcount++;
+    }
+    return data;
+}
+
+void vfs_blob_release(void *data) {
+    if (data == NULL) {
+        return;
+    }
+    
+    vfs_blob_t *blob = BLOB_OF(data);
+    if (--blob->refcount == 0) {
+        secure_zero(blob->bytes, blob->size);
+        tagged_free(MEM_TAG_FILE_DATA, blob, sizeof(vfs_blob_t) + blob->size);
+    }
+}
+
+size_t vfs_blob_refcount(const void *data) {
+    return (data != NULL) ? BLOB_OF(data)->refcount : 0;
+}
+
+/* ========================================================================
+ * 分段儲存
+ * ======================================================================== */
+
+/**
+ * @brief 第 index 段的內容長度
+ */
+static size_t extent_length(const vfs_node_t *node, size_t index) {
+    size_t start = index * VFS_EXTENT_SIZE;
+    size_t rest = node->size - start;
+    return (rest < VFS_EXTENT_SIZE) ? rest : VFS_EXTENT_SIZE;
+}
+
+/**
+ * @brief 釋放分段串列及所有段落的參考
+ */
+static void extents_free(vfs_extent_list_t *list) {
+    if (list == NULL) {
+        return;
+    }
+    
+    for (size_t i = 0; i < list->count; i++) {
+        vfs_blob_release(list->chunks[i]);
+    }
+    tagged_free(MEM_TAG_FILE_DATA, list->chunks, list->capacity * sizeof(void *));
+    tagged_free(MEM_TAG_FILE_DATA, list, sizeof(vfs_extent_list_t));
+}
+
+/**
+ * @brief 確保 chunks 陣列至少能容納 count 段
+ */
+static bool extents_reserve(vfs_extent_list_t *list, size_t count) {
+    if (count <= list->capacity) {
+        return true;
+    }
+    
+    size_t capacity = list->capacity ? list->capacity : 4;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    
+    void **chunks = (void **)tagged_realloc(MEM_TAG_FILE_DATA, list->chunks,
+                                            list->capacity * sizeof(void *),
+                                            capacity * sizeof(void *));
+    if (chunks == NULL) {
+        return false;
+    }
+    list->chunks = chunks;
+    list->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief 建立與 src 共用所有段落的分段串列
+ */
+static vfs_extent_list_t *extents_share(const vfs_extent_list_t *src) {
+    vfs_extent_list_t *list = (vfs_extent_list_t *)tagged_malloc(MEM_TAG_FILE_DATA,
+                                                                 sizeof(vfs_extent_list_t));
+    if (list == NULL) {
+        return NULL;
+    }
+    
+    if (!extents_reserve(list, src->count)) {
+        tagged_free(MEM_TAG_FILE_DATA, list, sizeof(vfs_extent_list_t));
+        return NULL;
+    }
+    for (size_t i = 0; i < src->count; i++) {
+        list->chunks[i] = vfs_blob_retain(src->chunks[i]);
+    }
+    list->count = src->count;
+    return list;
+}
+
+/**
+ * @brief 將檔案轉為分段儲存
+ *
+ * 連續內容切成段落複製一次；延遲載入的內容直接從後備儲存逐段讀入。
+ */
+static bool extents_convert(vfs_node_t *node) {
+    if (node->extents != NULL) {
+        return true;
+    }
+    
+    vfs_extent_list_t *list = (vfs_extent_list_t *)tagged_malloc(MEM_TAG_FILE_DATA,
+                                                                 sizeof(vfs_extent_list_t));
+    if (list == NULL) {
+        return false;
+    }
+    
+    size_t count = (node->size + VFS_EXTENT_SIZE - 1) / VFS_EXTENT_SIZE;
+    if (!extents_reserve(list, count)) {
+        tagged_free(MEM_TAG_FILE_DATA, list, sizeof(vfs_extent_list_t));
+        return false;
+    }
+    
+    bool lazy = (node->flags & VFS_NODE_LAZY) != 0;
+    vfs_backing_t *backing = node->owner->backing;
+    if (lazy && backing == NULL) {
+        error_set(ERR_IO_ERROR, "找不到檔案內容的後備儲存: %s", node->name);
+        extents_free(list);
+        return false;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        size_t start = i * VFS_EXTENT_SIZE;
+        size_t len = extent_length(node, i);
+        void *chunk = vfs_blob_create(lazy ? NULL : (const char *)node->data + start, len);
+        if (chunk == NULL ||
+            (lazy && !backing->read(backing, node->backing_offset + start, chunk, len))) {
+            vfs_blob_release(chunk);
+            extents_free(list);
+            return false;
+        }
+        list->chunks[list->count++] = chunk;
+    }
+    
+    vfs_blob_release(node->data);
+    node->data = NULL;
+    node->extents = list;
+    node->flags &= ~VFS_NODE_LAZY;
+    node->generation++;
+    return true;
+}
+
+/**
+ * @brief 取得可寫入的第 index 段，容量至少為 need 位元組
+ *
+ * 與其他檔案共用或容量不足的段落會複製到新區塊（容量倍增，最多 VFS_EXTENT_SIZE）。
+ * index 可等於目前段數，此時附加新的一段。
+ */
+static void *extent_for_write(vfs_extent_list_t *list, size_t index, size_t used, size_t need) {
+    void *chunk = (index < list->count) ? list->chunks[index] : NULL;
+    size_t capacity = (chunk != NULL) ? BLOB_OF(chunk)->size : 0;
+    
+    if (chunk != NULL && capacity >= need && vfs_blob_refcount(chunk) == 1) {
+        return chunk;
+    }
+    
+    if (chunk == NULL && !extents_reserve(list, index + 1)) {
+        return NULL;
+    }
+    
+    size_t new_capacity = (capacity > 0) ? capacity : 64;
+    while (new_capacity < need) {
+        new_capacity *= 2;
+    }
+    if (new_capacity > VFS_EXTENT_SIZE) {
+        new_capacity = VFS_EXTENT_SIZE;
+    }
+    
+    /* 新區塊配置時已清零，空隙自然補零 */
+    void *copy = vfs_blob_create(NULL, new_capacity);
+    if (copy == NULL) {
+        return NULL;
+    }
+    if (chunk != NULL) {
+        memcpy(copy, chunk, used);
+        vfs_blob_release(chunk);
+    } else {
+        list->count++;
+    }
+    list->chunks[index] = copy;
+    return copy;
+}
+
+/**
+ * @brief 將檔案內容複製到連續的記憶體
+ */
+static void extents_copy_out(const vfs_node_t *node, const vfs_extent_list_t *list,
+                             void *dst, size_t offset, size_t len) {
+    unsigned char *out = (unsigned char *)dst;
+    while (len > 0) {
+        size_t index = offset / VFS_EXTENT_SIZE;
+        size_t within = offset % VFS_EXTENT_SIZE;
+        size_t n = extent_length(node, index) - within;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(out, (const unsigned char *)list->chunks[index] + within, n);
+        out += n;
+        offset += n;
+        len -= n;
+    }
+}
+
+/* ========================================================================
+ * 內部輔助函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 從節點池取得一個未初始化的節點
+ */
+static vfs_node_t *pool_take(struct vfs_node_pool *pool) {
+    if (pool->free_list != NULL) {
+        vfs_node_t *node = pool->free_list;
+        pool->free_list = node->next;
+        return node;
+    }
+    
+    if (pool->slabs == NULL || pool->slabs->used == NODE_SLAB_COUNT) {
+        node_slab_t *slab = (node_slab_t *)tagged_malloc(MEM_TAG_VFS_NODE, sizeof(node_slab_t));
+        if (slab == NULL) {
+            return NULL;
+        }
+        slab->next = pool->slabs;
+        slab->used = 0;
+        pool->slabs = slab;
+    }
+    
+    return &pool->slabs->nodes[pool->slabs->used++];
+}
+
+/**
+ * @brief 釋放另外配置的長名稱
+ */
+static void name_free(vfs_node_t *node) {
+    tagged_free(MEM_TAG_VFS_NODE, node->name, strlen(node->name) + 1);
+}
+
+/**
+ * @brief 設定節點名稱
+ *
+ * 短名稱直接存放於節點內嵌緩衝區，較長的名稱才另外配置。
+ * 名稱不需以 '\0' 結尾。
+ *
+ * @param node 節點
+ * @param name 名稱起始位置
+ * @param len  名稱長度
+ * @return true 成功，false 記憶體不足（原名稱保持不變）
+ */
+static bool set_node_name(vfs_node_t *node, const char *name, size_t len) {
+    char *storage;
+    
+    if (len < VFS_INLINE_NAME_LEN) {
+        storage = node->name_inline;
+        memmove(storage, name, len);
+        storage[len] = '\0';
+    } else {
+        size_t n = strnlen(name, len);
+        storage = (char *)tagged_malloc_uninit(MEM_TAG_VFS_NODE, n + 1);
+        if (storage == NULL) {
+            return false;
+        }
+        memcpy(storage, name, n);
+        storage[n] = '\0';
+    }
+    
+    if (node->name != NULL && node->name != node->name_inline && node->name != storage) {
+        name_free(node);
+    }
+    node->name = storage;
+    return true;
+}
+
+/**
+ * @brief 建立新節點
+ *
+ * 名稱以（指標, 長度）傳入，不需以 '\0' 結尾，
+ * 供路徑解析直接以路徑字串中的組件建立節點。
+ *
+ * @param vfs  VFS 實例（節點配置池的擁有者）
+ * @param name 節點名稱起始位置
+ * @param len  名稱長度
+ * @param type 節點類型
+ * @return 新節點指標，失敗回傳 NULL
+ */
+static vfs_node_t *create_node(vfs_t *vfs, const char *name, size_t len, vfs_node_type_t type) {
+    if (name == NULL) {
+        error_set(ERR_INVALID_INPUT, "節點名稱為 NULL");
+        return NULL;
+    }
+    
+    vfs_node_t *node = pool_take(vfs->pool);
+    if (node == NULL) {
+        return NULL;
+    }
+    
+    node->name = NULL;
+    if (!set_node_name(node, name, len)) {
+        node->flags = 0;
+        node->next = vfs->pool->free_list;
+        vfs->pool->free_list = node;
+        return NULL;
+    }
+    
+    node->type = type;
+    node->flags = VFS_NODE_IN_USE;
+    node->data = NULL;
+    node->extents = NULL;
+    node->size = 0;
+    node->tree_nodes = 1;
+    node->tree_size = 0;
+    node->mtime = time(NULL);
+    node->ctime = node->mtime;
+    node->parent = NULL;
+    node->children = NULL;
+    node->next = NULL;
+    node->child_index = NULL;
+    node->sorted_index = NULL;
+    node->owner = vfs;
+    node->backing_offset = 0;
+    
+    return node;
+}
+
+/**
+ * @brief 累計自上次持久化以來的變更（背景自動儲存據此決定何時儲存）
+ */
+static void mark_dirty(vfs_t *vfs, size_t bytes) {
+    vfs->dirty_ops++;
+    vfs->dirty_bytes += bytes;
+}
+
+/**
+ * @brief 將已完成的變更操作通知觀察者（如日誌模組）
+ */
+static void vfs_notify(vfs_t *vfs, vfs_op_t op, const char *path, const char *path2,
+                       const void *data, size_t size, time_t mtime) {
+    if (vfs->observer != NULL) {
+        vfs->observer->record(vfs->observer, op, path, path2, data, size, mtime);
+    }
+}
+
+/**
+ * @brief 載入延遲載入檔案的內容
+ *
+ * 併行模式下呼叫者需持有寫入鎖或 cache_lock。
+ *
+ * @param node 檔案節點
+ * @return true 內容已在記憶體中，false 讀取失敗
+ */
+static bool materialize_node(vfs_node_t *node) {
+    if (!(node->flags & VFS_NODE_LAZY)) {
+        return true;
+    }
+    
+    vfs_backing_t *backing = node->owner->backing;
+    if (backing == NULL) {
+        error_set(ERR_IO_ERROR, "找不到檔案內容的後備儲存: %s", node->name);
+        return false;
+    }
+    
+    void *data = vfs_blob_create(NULL, node->size);
+    if (data == NULL) {
+        return false;
+    }
+    
+    if (!backing->read(backing, node->backing_offset, data, node->size)) {
+        vfs_blob_release(data);
+        return false;
+    }
+    
+    node->data = data;
+    node->flags &= ~VFS_NODE_LAZY;
+    return true;
+}
+
+/**
+ * @brief 取得檔案內容的快照，必要時先載入或合併
+ *
+ * 讀取者之間的狀態更新在 cache_lock 下進行；併行模式下合併掉的分段
+ * 移到待釋放串列，其他讀取者先前取得的快照仍然有效。
+ *
+ * @param node    檔案節點
+ * @param load    是否載入延遲載入的內容
+ * @param flatten 是否將分段儲存合併為連續儲存
+ * @param view    輸出參數，內容快照
+ * @return true 成功，false 載入或合併失敗
+ */
+static bool content_acquire(vfs_node_t *node, bool load, bool flatten, vfs_content_view_t *view) {
+    vfs_t *vfs = node->owner;
+    bool ok = true;
+    
+    cache_lock(vfs);
+    if (load) {
+        ok = materialize_node(node);
+    }
+    
+    if (ok && flatten && node->extents != NULL) {
+        void *blob = vfs_blob_create(NULL, node->size);
+        if (blob == NULL) {
+            ok = false;
+        } else {
+            extents_copy_out(node, node->extents, blob, 0, node->size);
+            if (vfs->concurrent) {
+                node->extents->next_retired = vfs->retired;
+                vfs->retired = node->extents;
+            } else {
+                extents_free(node->extents);
+            }
+            node->extents = NULL;
+            node->data = blob;
+            node->generation++;
+        }
+    }
+    
+    view->data = node->data;
+    view->extents = node->extents;
+    view->lazy = (node->flags & VFS_NODE_LAZY) != 0;
+    cache_unlock(vfs);
+    
+    return ok;
+}
+
+/**
+ * @brief 釋放節點擁有的資源（檔案內容、長名稱、索引），不處理節點本身
+ */
+static void release_node_resources(vfs_node_t *node) {
+    /* 釋放檔案內容的參考（最後一個參考會安全清除內容） */
+    if (node->type == VFS_FILE) {
+        vfs_blob_release(node->data);
+        extents_free(node->extents);
+    }
+    node->data = NULL;
+    node->extents = NULL;
+    node->generation++;  /* 節點回到配置池後重複使用時，舊的檢視仍可判斷為過期 */
+    
+    if (node->flags & VFS_NODE_PATH_CACHED) {
+        path_cache_forget(node);
+    }
+    
+    child_index_destroy(node);
+    sorted_index_destroy(node);
+    
+    if (node->name != node->name_inline) {
+        name_free(node);
+    }
+    node->name = NULL;
+}
+
+/**
+ * @brief 遞迴銷毀節點及其子節點，並將節點歸還配置池
+ *
+ * @param vfs  VFS 實例
+ * @param node 要銷毀的節點
+ */
+static void destroy_node(vfs_t *vfs, vfs_node_t *node) {
+    if (node == NULL) {
+        return;
+    }
+    
+    /* 遞迴銷毀所有子節點 */
+    vfs_node_t *child = node->children;
+    while (child != NULL) {
+        vfs_node_t *next = child->next;
+        destroy_node(vfs, child);
+        child = next;
+    }
+    
+    release_node_resources(node);
+    secure_zero(node->name_inline, sizeof(node->name_inline));
+    node->flags = 0;
+    node->next = vfs->pool->free_list;
+    vfs->pool->free_list = node;
+}
+
+/**
+ * @brief 計算名稱雜湊值（FNV-1a）
+ *
+ * @param name 名稱字串
+ * @param len  名稱長度
+ * @return 32 位元雜湊值
+ */
+static uint32_t hash_name(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 將節點放入槽位陣列（不檢查重複、不擴容）
+ */
+static void child_index_place(child_slot_t *slots, size_t capacity,
+                              uint32_t hash, vfs_node_t *node) {
+    size_t mask = capacity - 1;
+    size_t pos = hash & mask;
+    while (slots[pos].node != NULL) {
+        pos = (pos + 1) & mask;
+    }
+    slots[pos].hash = hash;
+    slots[pos].node = node;
+}
+
+/**
+ * @brief 調整索引槽位數量並重新雜湊
+ *
+ * @param index    索引
+ * @param capacity 新槽位數量（2 的冪次）
+ * @return true 成功，false 記憶體不足
+ */
+static bool child_index_resize(vfs_child_index_t *index, size_t capacity) {
+    child_slot_t *slots = (child_slot_t *)tagged_calloc(MEM_TAG_VFS_INDEX, capacity,
+                                                        sizeof(child_slot_t));
+    if (slots == NULL) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->slots[i].node != NULL) {
+            child_index_place(slots, capacity, index->slots[i].hash, index->slots[i].node);
+        }
+    }
+    
+    tagged_free(MEM_TAG_VFS_INDEX, index->slots, index->capacity * sizeof(child_slot_t));
+    index->slots = slots;
+    index->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief 釋放雜湊索引的槽位與結構
+ */
+static void child_index_free(vfs_child_index_t *index) {
+    tagged_free(MEM_TAG_VFS_INDEX, index->slots, index->capacity * sizeof(child_slot_t));
+    tagged_free(MEM_TAG_VFS_INDEX, index, sizeof(vfs_child_index_t));
+}
+
+/**
+ * @brief 為目錄建立子節點雜湊索引
+ *
+ * 索引僅為加速用途，建立失敗時目錄仍以鏈結串列正常運作。
+ *
+ * @param dir 目錄節點
+ * @return true 成功，false 記憶體不足
+ */
+static bool child_index_build(vfs_node_t *dir) {
+    size_t capacity = CHILD_INDEX_MIN_SLOTS;
+    while (capacity < dir->size * 2) {
+        capacity <<= 1;
+    }
+    
+    vfs_child_index_t *index = (vfs_child_index_t *)tagged_malloc(MEM_TAG_VFS_INDEX,
+                                                                  sizeof(vfs_child_index_t));
+    if (index == NULL) {
+        return false;
+    }
+    
+    index->slots = (child_slot_t *)tagged_calloc(MEM_TAG_VFS_INDEX, capacity, sizeof(child_slot_t));
+    if (index->slots == NULL) {
+        tagged_free(MEM_TAG_VFS_INDEX, index, sizeof(vfs_child_index_t));
+        return false;
+    }
+    index->capacity = capacity;
+    index->count = 0;
+    
+    for (vfs_node_t *child = dir->children; child != NULL; child = child->next) {
+        /* 保持裝載率不超過 1/2（目錄大小欄位可能與實際子節點數不一致） */
+        if ((index->count + 1) * 2 > index->capacity &&
+            !child_index_resize(index, index->capacity * 2)) {
+            child_index_free(index);
+            return false;
+        }
+        child_index_place(index->slots, index->capacity,
+                          hash_name(child->name, strlen(child->name)), child);
+        index->count++;
+    }
+    
+    dir->child_index = index;
+    return true;
+}
+
+/**
+ * @brief 釋放目錄的子節點雜湊索引
+ */
+static void child_index_destroy(vfs_node_t *dir) {
+    if (dir->child_index == NULL) {
+        return;
+    }
+    child_index_free(dir->child_index);
+    dir->child_index = NULL;
+}
+
+/**
+ * @brief 將子節點加入索引
+ *
+ * 擴容失敗時捨棄整個索引，退回鏈結串列查詢。
+ *
+ * @return true 索引仍有效，false 索引已捨棄
+ */
+static bool child_index_insert(vfs_node_t *dir, vfs_node_t *child) {
+    vfs_child_index_t *index = dir->child_index;
+    
+    if ((index->count + 1) * 2 > index->capacity &&
+        !child_index_resize(index, index->capacity * 2)) {
+        child_index_destroy(dir);
+        return false;
+    }
+    
+    child_index_place(index->slots, index->capacity,
+                      hash_name(child->name, strlen(child->name)), child);
+    index->count++;
+    return true;
+}
+
+/**
+ * @brief 從索引移除子節點
+ *
+ * 使用向後位移刪除（backward shift），避免留下墓碑槽位。
+ */
+static void child_index_remove(vfs_node_t *dir, vfs_node_t *child) {
+    vfs_child_index_t *index = dir->child_index;
+    size_t mask = index->capacity - 1;
+    size_t pos = hash_name(child->name, strlen(child->name)) & mask;
+    
+    while (index->slots[pos].node != child) {
+        if (index->slots[pos].node == NULL) {
+            return;  /* 不在索引中 */
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    /* 將後續屬於同一探測鏈的槽位往前補位 */
+    size_t hole = pos;
+    size_t next = (hole + 1) & mask;
+    while (index->slots[next].node != NULL) {
+        size_t home = index->slots[next].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->slots[hole].node = NULL;
+    index->count--;
+}
+
+/**
+ * @brief 以索引查詢子節點
+ */
+static vfs_node_t *child_index_lookup(vfs_node_t *dir, const char *name, size_t len) {
+    vfs_child_index_t *index = dir->child_index;
+    size_t mask = index->capacity - 1;
+    uint32_t hash = hash_name(name, len);
+    size_t pos = hash & mask;
+    
+    while (index->slots[pos].node != NULL) {
+        vfs_node_t *node = index->slots[pos].node;
+        if (index->slots[pos].hash == hash &&
+            name_equals(node->name, name, len)) {
+            return node;
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 比較節點名稱與（指標, 長度）名稱檢視的位元組序
+ *
+ * @return 小於、等於、大於 0 分別表示節點名稱排在前、相同、排在後
+ */
+static int name_compare(const char *node_name, const char *name, size_t len) {
+    int cmp = strncmp(node_name, name, len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (node_name[len] == '\0') ? 0 : 1;
+}
+
+/**
+ * @brief qsort 比較函式：依名稱排序節點指標
+ */
+static int sorted_index_compare(const void *a, const void *b) {
+    const vfs_node_t *x = *(vfs_node_t *const *)a;
+    const vfs_node_t *y = *(vfs_node_t *const *)b;
+    return strcmp(x->name, y->name);
+}
+
+/**
+ * @brief 為目錄建立子節點排序索引
+ *
+ * @param dir 目錄節點
+ * @return true 成功，false 記憶體不足
+ */
+static bool sorted_index_build(vfs_node_t *dir) {
+    size_t count = 0;
+    for (vfs_node_t *child = dir->children; child != NULL; child = child->next) {
+        count++;
+    }
+    
+    size_t capacity = SORTED_INDEX_MIN_CAPACITY;
+    while (capacity < count) {
+        capacity <<= 1;
+    }
+    
+    vfs_sorted_index_t *index = (vfs_sorted_index_t *)tagged_malloc(MEM_TAG_VFS_INDEX,
+                                                                    sizeof(vfs_sorted_index_t));
+    if (index == NULL) {
+        return false;
+    }
+    
+    index->nodes = (vfs_node_t **)tagged_malloc_uninit(MEM_TAG_VFS_INDEX,
+                                                       capacity * sizeof(vfs_node_t *));
+    if (index->nodes == NULL) {
+        tagged_free(MEM_TAG_VFS_INDEX, index, sizeof(vfs_sorted_index_t));
+        return false;
+    }
+    index->capacity = capacity;
+    index->count = 0;
+    
+    for (vfs_node_t *child = dir->children; child != NULL; child = child->next) {
+        index->nodes[index->count++] = child;
+    }
+    qsort(index->nodes, index->count, sizeof(vfs_node_t *), sorted_index_compare);
+    
+    dir->sorted_index = index;
+    return true;
+}
+
+/**
+ * @brief 釋放目錄的子節點排序索引
+ */
+static void sorted_index_destroy(vfs_node_t *dir) {
+    if (dir->sorted_index == NULL) {
+        return;
+    }
+    tagged_free(MEM_TAG_VFS_INDEX, dir->sorted_index->nodes,
+                dir->sorted_index->capacity * sizeof(vfs_node_t *));
+    tagged_free(MEM_TAG_VFS_INDEX, dir->sorted_index, sizeof(vfs_sorted_index_t));
+    dir->sorted_index = NULL;
+}
+
+/**
+ * @brief 找出第一個名稱不小於指定名稱的位置
+ */
+static size_t sorted_index_lower_bound(const vfs_sorted_index_t *index, const char *name, size_t len) {
+    size_t lo = 0;
+    size_t hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (name_compare(index->nodes[mid]->name, name, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief 將子節點插入排序索引
+ *
+ * 擴容失敗時捨棄整個索引，下次依名稱走訪時重新建立。
+ */
+static void sorted_index_insert(vfs_node_t *dir, vfs_node_t *child) {
+    vfs_sorted_index_t *index = dir->sorted_index;
+    
+    if (index->count == index->capacity) {
+        vfs_node_t **nodes = (vfs_node_t **)tagged_realloc(MEM_TAG_VFS_INDEX, index->nodes,
+                                                           index->capacity * sizeof(vfs_node_t *),
+                                                           index->capacity * 2 * sizeof(vfs_node_t *));
+        if (nodes == NULL) {
+            sorted_index_destroy(dir);
+            return;
+        }
+        index->nodes = nodes;
+        index->capacity *= 2;
+    }
+    
+    size_t pos = sorted_index_lower_bound(index, child->name, strlen(child->name));
+    memmove(index->nodes + pos + 1, index->nodes + pos, (index->count - pos) * sizeof(vfs_node_t *));
+    index->nodes[pos] = child;
+    index->count++;
 }
 
 /**
- * @brief 銷毀虛擬檔案系統
+ * @brief 從排序索引移除子節點（需在修改名稱前呼叫）
  */
-void vfs_destroy(vfs_t *vfs) {
-    if (vfs == NULL) {
-        return;
-    }
+static void sorted_index_remove(vfs_node_t *dir, vfs_node_t *child) {
+    vfs_sorted_index_t *index = dir->sorted_index;
     
-    if (vfs->root != NULL) {
-        destroy_node(vfs->root);
+    size_t pos = sorted_index_lower_bound(index, child->name, strlen(child->name));
+    if (pos >= index->count || index->nodes[pos] != child) {
+        return;  /* 不在索引中 */
     }
-    
-    safe_free(vfs);
+    memmove(index->nodes + pos, index->nodes + pos + 1, (index->count - pos - 1) * sizeof(vfs_node_t *));
+    index->count--;
 }
 
-/* ========================================================================
- * 內部輔助函式實作
- * ======================================================================== */
+/**
+ * @brief 比對節點名稱與（指標, 長度）名稱檢視
+ */
+static inline bool name_equals(const char *node_name, const char *name, size_t len) {
+    return strncmp(node_name, name, len) == 0 && node_name[len] == '\0';
+}
 
 /**
- * @brief 建立新節點
+ * @brief 在父節點中尋找指定名稱的子節點
  *
- * @param name 節點名稱
- * @param type 節點類型
- * @return 新節點指標，失敗回傳 NULL
+ * @param parent 父節點
+ * @param name   要尋找的名稱（不需以 '\0' 結尾）
+ * @param len    名稱長度
+ * @return 找到的子節點，未找到回傳 NULL
  */
-static vfs_node_t *create_node(const char *name, vfs_node_type_t type) {
-    if (name == NULL) {
-        error_set(ERR_INVALID_INPUT, "節點名稱為 NULL");
+static vfs_node_t *find_child(vfs_node_t *parent, const char *name, size_t len) {
+    if (parent == NULL || name == NULL || parent->type != VFS_DIR) {
         return NULL;
     }
     
-    vfs_node_t *node = (vfs_node_t *)safe_malloc(sizeof(vfs_node_t));
-    if (node == NULL) {
-        return NULL;
+    /* 大型目錄使用雜湊索引（在 add_child 或載入時建立，讀取者不修改） */
+    if (parent->child_index != NULL) {
+        return child_index_lookup(parent, name, len);
     }
     
-    node->name = safe_strdup(name);
-    if (node->name == NULL) {
-        safe_free(node);
-        return NULL;
+    vfs_node_t *child = parent->children;
+    while (child != NULL) {
+        if (name_equals(child->name, name, len)) {
+            return child;
+        }
+        child = child->next;
     }
     
-    node->type = type;
-    node->data = NULL;
-    node->size = 0;
-    node->mtime = time(NULL);
-    node->ctime = node->mtime;
-    node->parent = NULL;
-    node->children = NULL;
-    node->next = NULL;
-    
-    return node;
+    return NULL;
 }
 
 /**
- * @brief 遞迴銷毀節點及其子節點
+ * @brief 將子樹統計的變化沿祖先鏈向上套用
  *
- * @param node 要銷毀的節點
+ * 從 dir（含）逐層更新到最上層的祖先；到達 VFS 根目錄時同步
+ * total_nodes/total_size。尚未掛上樹的子樹只更新到其頂端，
+ * 之後整棵加入時再一次計入。
+ *
+ * @param dir   子樹統計改變的目錄
+ * @param nodes 節點數的變化量
+ * @param bytes 檔案位元組數的變化量
+ * @param grow  true 為增加，false 為減少
  */
-static void destroy_node(vfs_node_t *node) {
-    if (node == NULL) {
+static void stats_adjust(vfs_node_t *dir, size_t nodes, size_t bytes, bool grow) {
+    if (nodes == 0 && bytes == 0) {
         return;
     }
     
-    /* 遞迴銷毀所有子節點 */
-    vfs_node_t *child = node->children;
-    while (child != NULL) {
-        vfs_node_t *next = child->next;
-        destroy_node(child);
-        child = next;
+    vfs_node_t *top = dir;
+    for (vfs_node_t *curr = dir; curr != NULL; curr = curr->parent) {
+        if (grow) {
+            curr->tree_nodes += nodes;
+            curr->tree_size += bytes;
+        } else {
+            curr->tree_nodes -= nodes;
+            curr->tree_size -= bytes;
+        }
+        top = curr;
     }
     
-    /* 安全清除並釋放檔案資料 */
-    if (node->type == VFS_FILE && node->data != NULL) {
-        secure_zero(node->data, node->size);
-        safe_free(node->data);
+    vfs_t *vfs = top->owner;
+    if (vfs != NULL && top == vfs->root) {
+        vfs->total_nodes = top->tree_nodes;
+        vfs->total_size = top->tree_size;
     }
-    
-    safe_free(node->name);
-    safe_free(node);
 }
 
 /**
- * @brief 在父節點中尋找指定名稱的子節點
- *
- * @param parent 父節點
- * @param name   要尋找的名稱
- * @return 找到的子節點，未找到回傳 NULL
+ * @brief 變更檔案大小並更新祖先目錄的統計
  */
-static vfs_node_t *find_child(vfs_node_t *parent, const char *name) {
-    if (parent == NULL || name == NULL || parent->type != VFS_DIR) {
-        return NULL;
-    }
-    
-    vfs_node_t *child = parent->children;
-    while (child != NULL) {
-        if (strcmp(child->name, name) == 0) {
-            return child;
+static void file_set_size(vfs_node_t *file, size_t size) {
+    if (file->parent != NULL) {
+        if (size >= file->size) {
+            stats_adjust(file->parent, 0, size - file->size, true);
+        } else {
+            stats_adjust(file->parent, 0, file->size - size, false);
         }
-        child = child->next;
     }
-    
-    return NULL;
+    file->size = size;
 }
 
 /**
@@ -177,7 +1446,7 @@ static bool add_child(vfs_node_t *parent, vfs_node_t *child) {
     }
     
     /* 檢查是否已存在同名節點 */
-    if (find_child(parent, child->name) != NULL) {
+    if (find_child(parent, child->name, strlen(child->name)) != NULL) {
         error_set(ERR_INVALID_INPUT, "節點已存在: %s", child->name);
         return false;
     }
@@ -190,6 +1459,17 @@ static bool add_child(vfs_node_t *parent, vfs_node_t *child) {
     if (parent->type == VFS_DIR) {
         parent->size++;
     }
+    stats_adjust(parent, vfs_subtree_nodes(child), vfs_subtree_size(child), true);
+    
+    /* 同步雜湊索引，目錄成長超過門檻時建立 */
+    if (parent->child_index != NULL) {
+        child_index_insert(parent, child);
+    } else if (parent->size > VFS_CHILD_INDEX_THRESHOLD) {
+        child_index_build(parent);
+    }
+    if (parent->sorted_index != NULL) {
+        sorted_index_insert(parent, child);
+    }
     
     parent->mtime = time(NULL);
     
@@ -226,120 +1506,92 @@ static bool remove_child(vfs_node_t *parent, vfs_node_t *child) {
     child->next = NULL;
     child->parent = NULL;
     
-    if (parent->type == VFS_DIR) {
-        parent->size--;
-    }
-    
-    parent->mtime = time(NULL);
-    
-    return true;
-}
-
-/**
- * @brief 分割路徑為組件陣列
- *
- * @param path  路徑字串
- * @param count 輸出參數，組件數量
- * @return 組件字串陣列（需由呼叫者釋放），失敗回傳 NULL
- */
-static char **split_path(const char *path, size_t *count) {
-    if (path == NULL || count == NULL) {
-        return NULL;
+    if (parent->sorted_index != NULL) {
+        sorted_index_remove(parent, child);
     }
     
-    /* 規範化路徑 */
-    char *normalized = normalize_path(path);
-    if (normalized == NULL) {
-        return NULL;
+    if (parent->type == VFS_DIR) {
+        parent->size--;
     }
+    stats_adjust(parent, vfs_subtree_nodes(child), vfs_subtree_size(child), false);
     
-    /* 計算路徑組件數量 */
-    size_t components = 0;
-    for (size_t i = 0; normalized[i] != '\0'; i++) {
-        if (normalized[i] == '/' && i > 0 && normalized[i-1] != '/') {
-            components++;
+    /* 同步雜湊索引，目錄縮小到門檻一半以下時改回鏈結串列 */
+    if (parent->child_index != NULL) {
+        if (parent->size < VFS_CHILD_INDEX_THRESHOLD / 2) {
+            child_index_destroy(parent);
+        } else {
+            child_index_remove(parent, child);
         }
     }
-    if (normalized[strlen(normalized)-1] != '/') {
-        components++;
-    }
-    
-    char **result = (char **)safe_malloc(sizeof(char *) * (components + 1));
-    if (result == NULL) {
-        safe_free(normalized);
-        return NULL;
-    }
     
-    /* 使用 strtok 分割路徑 */
-    size_t idx = 0;
-    char *token = strtok(normalized, "/");
-    while (token != NULL && idx < components) {
-        result[idx++] = safe_strdup(token);
-        token = strtok(NULL, "/");
-    }
-    result[idx] = NULL;
-    *count = idx;
+    parent->mtime = time(NULL);
     
-    safe_free(normalized);
-    return result;
+    return true;
 }
 
 /**
  * @brief 解析路徑並回傳對應節點
  *
+ * 直接在原始路徑字串上以（指標, 長度）逐一走訪組件，不配置任何暫存記憶體。
+ * 連續斜線與結尾斜線會被忽略，相對路徑一律從根目錄開始解析。
+ *
  * @param vfs         VFS 實例
  * @param path        路徑字串
  * @param create_dirs 若為 true，自動建立不存在的中間目錄
  * @return 解析到的節點，失敗回傳 NULL
+ *
+ * @note 路徑遍歷檢查由呼叫端的公開函式負責
  */
 static vfs_node_t *resolve_path(vfs_t *vfs, const char *path, bool create_dirs) {
+    TRACE_SCOPE(TRACE_VFS_RESOLVE);
     if (vfs == NULL || path == NULL || vfs->root == NULL) {
         return NULL;
     }
     
-    /* 規範化路徑 */
-    char *normalized = normalize_path(path);
-    if (normalized == NULL) {
-        return NULL;
-    }
-    
-    /* 分割路徑為組件 */
-    size_t count = 0;
-    char **components = split_path(normalized, &count);
-    safe_free(normalized);
-    
-    if (components == NULL) {
+    if (!validate_path_length(path, 0)) {
         return NULL;
     }
     
     /* 從根節點開始遍歷 */
     vfs_node_t *current = vfs->root;
+    const char *p = path;
     
-    for (size_t i = 0; i < count; i++) {
-        if (components[i] == NULL || strlen(components[i]) == 0) {
-            continue;
+    for (;;) {
+        while (*p == '/') {
+            p++;
         }
+        if (*p == '\0') {
+            break;
+        }
+        
+        /* 取出目前組件 */
+        const char *component = p;
+        while (*p != '\0' && *p != '/') {
+            p++;
+        }
+        size_t len = (size_t)(p - component);
         
-        vfs_node_t *child = find_child(current, components[i]);
+        vfs_node_t *child = find_child(current, component, len);
         
         if (child == NULL) {
-            if (create_dirs && i < count - 1) {
-                /* 自動建立中間目錄 */
-                child = create_node(components[i], VFS_DIR);
-                if (child == NULL) {
-                    for (size_t j = 0; j < count; j++) {
-                        safe_free(components[j]);
-                    }
-                    safe_free(components);
-                    return NULL;
-                }
-                add_child(current, child);
-            } else {
+            /* 判斷是否為最後一個組件 */
+            const char *rest = p;
+            while (*rest == '/') {
+                rest++;
+            }
+            
+            if (!create_dirs || *rest == '\0') {
                 /* 路徑不存在 */
-                for (size_t j = 0; j < count; j++) {
-                    safe_free(components[j]);
-                }
-                safe_free(components);
+                return NULL;
+            }
+            
+            /* 自動建立中間目錄 */
+            child = create_node(vfs, component, len, VFS_DIR);
+            if (child == NULL) {
+                return NULL;
+            }
+            if (!add_child(current, child)) {
+                destroy_node(vfs, child);
                 return NULL;
             }
         }
@@ -347,12 +1599,6 @@ static vfs_node_t *resolve_path(vfs_t *vfs, const char *path, bool create_dirs)
         current = child;
     }
     
-    /* 釋放組件陣列 */
-    for (size_t i = 0; i < count; i++) {
-        safe_free(components[i]);
-    }
-    safe_free(components);
-    
     return current;
 }
 
@@ -361,19 +1607,15 @@ static vfs_node_t *resolve_path(vfs_t *vfs, const char *path, bool create_dirs)
  * ======================================================================== */
 
 /**
- * @brief 建立檔案
+ * @brief 在指定路徑建立檔案節點並加入父目錄
+ *
+ * @param vfs  VFS 實例
+ * @param path 檔案完整路徑（已通過路徑遍歷檢查）
+ * @param blob 檔案內容區塊（取得一個參考，失敗時釋放；可為 NULL）
+ * @param size 內容大小
+ * @return 新建立的檔案節點，失敗回傳 NULL
  */
-vfs_node_t *vfs_create_file(vfs_t *vfs, const char *path, const void *data, size_t size) {
-    if (vfs == NULL || path == NULL) {
-        error_set(ERR_INVALID_INPUT, "參數為 NULL");
-        return NULL;
-    }
-    
-    /* 安全性檢查：路徑遍歷攻擊 */
-    if (is_path_traversal(path)) {
-        return NULL;
-    }
-    
+static vfs_node_t *insert_file(vfs_t *vfs, const char *path, void *blob, size_t size) {
     /* 取得目錄與檔案名稱 */
     char *dir_path = path_get_dirname(path);
     char *filename = path_get_basename(path);
@@ -381,6 +1623,7 @@ vfs_node_t *vfs_create_file(vfs_t *vfs, const char *path, const void *data, size
     if (dir_path == NULL || filename == NULL) {
         safe_free(dir_path);
         safe_free(filename);
+        vfs_blob_release(blob);
         return NULL;
     }
     
@@ -390,45 +1633,177 @@ vfs_node_t *vfs_create_file(vfs_t *vfs, const char *path, const void *data, size
     
     if (parent == NULL || parent->type != VFS_DIR) {
         safe_free(filename);
+        vfs_blob_release(blob);
         error_set(ERR_FILE_NOT_FOUND, "父目錄不存在: %s", path);
         return NULL;
     }
     
     /* 檢查檔案是否已存在 */
-    vfs_node_t *existing = find_child(parent, filename);
+    vfs_node_t *existing = find_child(parent, filename, strlen(filename));
     if (existing != NULL) {
         safe_free(filename);
+        vfs_blob_release(blob);
         error_set(ERR_INVALID_INPUT, "檔案已存在: %s", path);
         return NULL;
     }
     
     /* 建立檔案節點 */
-    vfs_node_t *file = create_node(filename, VFS_FILE);
+    vfs_node_t *file = create_node(vfs, filename, strlen(filename), VFS_FILE);
     safe_free(filename);
     
     if (file == NULL) {
+        vfs_blob_release(blob);
+        return NULL;
+    }
+    
+    file->data = blob;
+    file->size = (blob != NULL) ? size : 0;
+    
+    /* 加入父目錄 */
+    if (!add_child(parent, file)) {
+        destroy_node(vfs, file);
+        return NULL;
+    }
+    
+    return file;
+}
+
+/**
+ * @brief 建立檔案
+ */
+vfs_node_t *vfs_create_file(vfs_t *vfs, const char *path, const void *data, size_t size) {
+    TRACE_SCOPE(TRACE_VFS_CREATE);
+    if (vfs == NULL || path == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    /* 安全性檢查：路徑遍歷攻擊 */
+    if (is_path_traversal(path)) {
         return NULL;
     }
     
     /* 複製檔案內容 */
+    void *blob = NULL;
     if (size > 0 && data != NULL) {
-        file->data = safe_malloc(size);
-        if (file->data == NULL) {
-            destroy_node(file);
+        blob = vfs_blob_create(data, size);
+        if (blob == NULL) {
             return NULL;
         }
-        memcpy(file->data, data, size);
-        file->size = size;
     }
     
-    /* 加入父目錄 */
-    if (!add_child(parent, file)) {
-        destroy_node(file);
+    vfs_node_t *file = insert_file(vfs, path, blob, size);
+    if (file == NULL) {
+        return NULL;
+    }
+    
+    mark_dirty(vfs, file->size);
+    vfs_notify(vfs, VFS_OP_CREATE_FILE, path, NULL, data, file->size, file->mtime);
+    
+    return file;
+}
+
+/**
+ * @brief 以內容區塊建立檔案
+ */
+vfs_node_t *vfs_create_file_blob(vfs_t *vfs, const char *path, void *blob, size_t size) {
+    TRACE_SCOPE(TRACE_VFS_CREATE);
+    if (vfs == NULL || path == NULL || (blob == NULL && size > 0)) {
+        vfs_blob_release(blob);
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    /* 安全性檢查：路徑遍歷攻擊 */
+    if (is_path_traversal(path)) {
+        vfs_blob_release(blob);
+        return NULL;
+    }
+    
+    vfs_node_t *file = insert_file(vfs, path, blob, size);
+    if (file == NULL) {
+        return NULL;
+    }
+    
+    mark_dirty(vfs, file->size);
+    vfs_notify(vfs, VFS_OP_CREATE_FILE, path, NULL, file->data, file->size, file->mtime);
+    
+    return file;
+}
+
+/**
+ * @brief 取得檔案內容儲存方式的快照
+ */
+void vfs_content_view(vfs_node_t *node, vfs_content_view_t *view) {
+    TRACE_SCOPE(TRACE_VFS_READ);
+    if (view == NULL) {
+        return;
+    }
+    if (node == NULL || node->type != VFS_FILE) {
+        view->data = NULL;
+        view->extents = NULL;
+        view->lazy = false;
+        return;
+    }
+    content_acquire(node, false, false, view);
+}
+
+/**
+ * @brief 複製檔案
+ */
+vfs_node_t *vfs_copy_file(vfs_t *vfs, vfs_node_t *src, const char *dst_path) {
+    if (vfs == NULL || src == NULL || dst_path == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    if (src->type != VFS_FILE) {
+        error_set(ERR_INVALID_INPUT, "來源不是檔案: %s", src->name);
+        return NULL;
+    }
+    
+    /* 安全性檢查：路徑遍歷攻擊 */
+    if (is_path_traversal(dst_path)) {
+        return NULL;
+    }
+    
+    /* 分段儲存的來源：共用所有段落 */
+    if (src->extents != NULL) {
+        vfs_extent_list_t *extents = extents_share(src->extents);
+        if (extents == NULL) {
+            return NULL;
+        }
+        
+        vfs_node_t *file = insert_file(vfs, dst_path, NULL, 0);
+        if (file == NULL) {
+            extents_free(extents);
+            return NULL;
+        }
+        file->extents = extents;
+        file_set_size(file, src->size);
+        mark_dirty(vfs, file->size);
+        
+        /* 日誌需要連續的內容 */
+        if (vfs->observer != NULL) {
+            void *data = vfs_read_file(file, NULL);
+            vfs_notify(vfs, VFS_OP_CREATE_FILE, dst_path, NULL, data, file->size, file->mtime);
+            safe_free(data);
+        }
+        return file;
+    }
+    
+    /* 延遲載入的來源先讀入一次，之後兩個節點共用同一個區塊 */
+    if (!materialize_node(src)) {
         return NULL;
     }
     
-    vfs->total_nodes++;
-    vfs->total_size += size;
+    vfs_node_t *file = insert_file(vfs, dst_path, vfs_blob_retain(src->data), src->size);
+    if (file == NULL) {
+        return NULL;
+    }
+    
+    mark_dirty(vfs, file->size);
+    vfs_notify(vfs, VFS_OP_CREATE_FILE, dst_path, NULL, file->data, file->size, file->mtime);
     
     return file;
 }
@@ -437,6 +1812,7 @@ vfs_node_t *vfs_create_file(vfs_t *vfs, const char *path, const void *data, size
  * @brief 建立目錄
  */
 vfs_node_t *vfs_create_dir(vfs_t *vfs, const char *path) {
+    TRACE_SCOPE(TRACE_VFS_CREATE);
     if (vfs == NULL || path == NULL) {
         error_set(ERR_INVALID_INPUT, "參數為 NULL");
         return NULL;
@@ -475,7 +1851,7 @@ vfs_node_t *vfs_create_dir(vfs_t *vfs, const char *path) {
     }
     
     /* 建立目錄節點 */
-    vfs_node_t *dir = create_node(dirname, VFS_DIR);
+    vfs_node_t *dir = create_node(vfs, dirname, strlen(dirname), VFS_DIR);
     safe_free(dirname);
     
     if (dir == NULL) {
@@ -484,11 +1860,12 @@ vfs_node_t *vfs_create_dir(vfs_t *vfs, const char *path) {
     
     /* 加入父目錄 */
     if (!add_child(parent, dir)) {
-        destroy_node(dir);
+        destroy_node(vfs, dir);
         return NULL;
     }
     
-    vfs->total_nodes++;
+    mark_dirty(vfs, 0);
+    vfs_notify(vfs, VFS_OP_CREATE_DIR, path, NULL, NULL, 0, dir->mtime);
     
     return dir;
 }
@@ -513,6 +1890,7 @@ vfs_node_t *vfs_find_node(vfs_t *vfs, const char *path) {
  * @brief 刪除節點
  */
 bool vfs_delete_node(vfs_t *vfs, const char *path) {
+    TRACE_SCOPE(TRACE_VFS_DELETE);
     if (vfs == NULL || path == NULL) {
         return false;
     }
@@ -539,17 +1917,14 @@ bool vfs_delete_node(vfs_t *vfs, const char *path) {
         return false;
     }
     
-    /* 從父節點移除 */
+    /* 從父節點移除（同時扣除整個子樹的統計） */
     remove_child(node->parent, node);
     
-    /* 更新統計資訊 */
-    if (node->type == VFS_FILE) {
-        vfs->total_size -= node->size;
-    }
-    vfs->total_nodes--;
-    
     /* 銷毀節點（含子節點） */
-    destroy_node(node);
+    destroy_node(vfs, node);
+    
+    mark_dirty(vfs, 0);
+    vfs_notify(vfs, VFS_OP_DELETE, path, NULL, NULL, 0, 0);
     
     return true;
 }
@@ -580,21 +1955,89 @@ bool vfs_rename_node(vfs_t *vfs, const char *old_path, const char *new_path) {
     
     /* 檢查新名稱是否已存在 */
     if (node->parent != NULL) {
-        if (find_child(node->parent, new_name) != NULL) {
+        if (find_child(node->parent, new_name, strlen(new_name)) != NULL) {
             safe_free(new_name);
             error_set(ERR_INVALID_INPUT, "目標名稱已存在");
             return false;
         }
     }
     
-    /* 更新名稱 */
-    safe_free(node->name);
-    node->name = new_name;
+    /* 更新名稱（雜湊與排序索引以名稱為鍵，需先移除再以新名稱加入） */
+    vfs_node_t *parent = node->parent;
+    if (parent != NULL && parent->child_index != NULL) {
+        child_index_remove(parent, node);
+    }
+    if (parent != NULL && parent->sorted_index != NULL) {
+        sorted_index_remove(parent, node);
+    }
+    if (!set_node_name(node, new_name, strlen(new_name))) {
+        if (parent != NULL && parent->child_index != NULL) {
+            child_index_insert(parent, node);
+        }
+        if (parent != NULL && parent->sorted_index != NULL) {
+            sorted_index_insert(parent, node);
+        }
+        safe_free(new_name);
+        return false;
+    }
+    safe_free(new_name);
+    if (parent != NULL && parent->child_index != NULL) {
+        child_index_insert(parent, node);
+    }
+    if (parent != NULL && parent->sorted_index != NULL) {
+        sorted_index_insert(parent, node);
+    }
     node->mtime = time(NULL);
     
+    /* 子樹中所有節點的路徑都已改變 */
+    path_cache_invalidate(vfs, node);
+    
+    mark_dirty(vfs, 0);
+    vfs_notify(vfs, VFS_OP_RENAME, old_path, new_path, NULL, 0, node->mtime);
+    
     return true;
 }
 
+/**
+ * @brief 檢查 node 是否為 ancestor 本身或其子孫
+ */
+static bool node_within(const vfs_node_t *node, const vfs_node_t *ancestor) {
+    for (; node != NULL; node = node->parent) {
+        if (node == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 找出路徑上最深一個已存在的節點（不建立目錄）
+ *
+ * @param vfs  VFS 實例
+ * @param path 目錄路徑
+ * @return 已存在的節點，記憶體不足時回傳 NULL
+ */
+static vfs_node_t *deepest_existing(vfs_t *vfs, const char *path) {
+    char *dir = safe_strdup(path);
+    while (dir != NULL) {
+        vfs_node_t *node = resolve_path(vfs, dir, false);
+        if (node != NULL) {
+            safe_free(dir);
+            error_clear();
+            return node;
+        }
+        
+        char *up = path_get_dirname(dir);
+        bool top = (up == NULL || strcmp(up, dir) == 0);
+        safe_free(dir);
+        dir = top ? NULL : up;
+        if (top) {
+            safe_free(up);
+        }
+    }
+    return NULL;
+}
+
 /**
  * @brief 移動節點
  */
@@ -623,6 +2066,16 @@ bool vfs_move_node(vfs_t *vfs, const char *src_path, const char *dst_path) {
         return false;
     }
     
+    /* 不可移到自身或自己的子孫底下，否則父節點鏈會形成迴圈；
+     * 目標目錄需要建立時，以最近一個已存在的祖先判斷，避免先在子樹中建立目錄 */
+    vfs_node_t *anchor = deepest_existing(vfs, dst_dir_path);
+    if (anchor != NULL && node_within(anchor, src_node)) {
+        safe_free(dst_dir_path);
+        safe_free(dst_name);
+        error_set(ERR_INVALID_INPUT, "無法將目錄移到自身的子目錄中: %s", src_path);
+        return false;
+    }
+    
     vfs_node_t *dst_parent = resolve_path(vfs, dst_dir_path, true);
     safe_free(dst_dir_path);
     
@@ -632,30 +2085,63 @@ bool vfs_move_node(vfs_t *vfs, const char *src_path, const char *dst_path) {
         return false;
     }
     
-    /* 檢查目標名稱是否已存在 */
-    if (find_child(dst_parent, dst_name) != NULL) {
+    if (node_within(dst_parent, src_node)) {
+        safe_free(dst_name);
+        error_set(ERR_INVALID_INPUT, "無法將目錄移到自身的子目錄中: %s", src_path);
+        return false;
+    }
+    
+    /* 移到原位置視為錯誤；其他同名衝突由 add_child 偵測並放回原處 */
+    if (find_child(dst_parent, dst_name, strlen(dst_name)) == src_node) {
         safe_free(dst_name);
         error_set(ERR_INVALID_INPUT, "目標名稱已存在");
         return false;
     }
     
+    /* 保留原名稱，加入新位置失敗時放回原處 */
+    char *old_name = safe_strdup(src_node->name);
+    if (old_name == NULL) {
+        safe_free(dst_name);
+        return false;
+    }
+    
+    /* 子樹中所有節點的路徑都將改變 */
+    path_cache_invalidate(vfs, src_node);
+    
     /* 從原位置移除 */
-    if (src_node->parent != NULL) {
-        remove_child(src_node->parent, src_node);
+    vfs_node_t *src_parent = src_node->parent;
+    if (src_parent != NULL) {
+        remove_child(src_parent, src_node);
     }
     
     /* 更新名稱 */
-    safe_free(src_node->name);
-    src_node->name = dst_name;
+    if (!set_node_name(src_node, dst_name, strlen(dst_name))) {
+        safe_free(dst_name);
+        safe_free(old_name);
+        if (src_parent != NULL) {
+            add_child(src_parent, src_node);
+        }
+        return false;
+    }
+    safe_free(dst_name);
     
     /* 加入新位置 */
     if (!add_child(dst_parent, src_node)) {
-        safe_free(dst_name);
+        error_t err = error_get();
+        if (set_node_name(src_node, old_name, strlen(old_name)) && src_parent != NULL) {
+            add_child(src_parent, src_node);
+        }
+        error_set(err.code, "%s", err.message);
+        safe_free(old_name);
         return false;
     }
+    safe_free(old_name);
     
     src_node->mtime = time(NULL);
     
+    mark_dirty(vfs, 0);
+    vfs_notify(vfs, VFS_OP_MOVE, src_path, dst_path, NULL, 0, src_node->mtime);
+    
     return true;
 }
 
@@ -667,6 +2153,7 @@ bool vfs_move_node(vfs_t *vfs, const char *src_path, const char *dst_path) {
  * @brief 讀取檔案內容
  */
 void *vfs_read_file(vfs_node_t *node, size_t *size) {
+    TRACE_SCOPE(TRACE_VFS_READ);
     if (node == NULL || node->type != VFS_FILE) {
         error_set(ERR_INVALID_INPUT, "無效的檔案節點");
         return NULL;
@@ -676,17 +2163,26 @@ void *vfs_read_file(vfs_node_t *node, size_t *size) {
         *size = node->size;
     }
     
-    if (node->data == NULL || node->size == 0) {
+    vfs_content_view_t view;
+    if (node->size == 0 || !content_acquire(node, true, false, &view)) {
         return NULL;
     }
     
-    /* 回傳內容副本 */
-    void *data = safe_malloc(node->size);
+    if (view.data == NULL && view.extents == NULL) {
+        return NULL;
+    }
+    
+    /* 回傳內容副本（整段覆寫，不需清零） */
+    void *data = safe_malloc_uninit(node->size);
     if (data == NULL) {
         return NULL;
     }
     
-    memcpy(data, node->data, node->size);
+    if (view.extents != NULL) {
+        extents_copy_out(node, view.extents, data, 0, node->size);
+    } else {
+        memcpy(data, view.data, node->size);
+    }
     return data;
 }
 
@@ -694,35 +2190,234 @@ void *vfs_read_file(vfs_node_t *node, size_t *size) {
  * @brief 寫入檔案內容
  */
 bool vfs_write_file(vfs_node_t *node, const void *data, size_t size) {
+    TRACE_SCOPE(TRACE_VFS_WRITE);
     if (node == NULL || node->type != VFS_FILE) {
         error_set(ERR_INVALID_INPUT, "無效的檔案節點");
         return false;
     }
     
-    /* 安全清除並釋放舊資料 */
-    if (node->data != NULL) {
-        secure_zero(node->data, node->size);
-        safe_free(node->data);
+    /* 配置新內容區塊（寫入時複製：與其他檔案共用的舊區塊保持不變） */
+    void *blob = NULL;
+    if (size > 0 && data != NULL) {
+        blob = vfs_blob_create(data, size);
+        if (blob == NULL) {
+            return false;
+        }
+    }
+    
+    /* 釋放舊內容的參考（尚未載入的內容直接捨棄） */
+    vfs_blob_release(node->data);
+    extents_free(node->extents);
+    node->data = blob;
+    node->extents = NULL;
+    node->flags &= ~VFS_NODE_LAZY;
+    node->generation++;
+    
+    file_set_size(node, size);
+    node->mtime = time(NULL);
+    mark_dirty(node->owner, size);
+    
+    /* 通知觀察者（僅在有觀察者時才需要建構路徑；路徑放在暫存區段） */
+    if (node->owner->observer != NULL) {
+        arena_t *scratch = scratch_arena();
+        arena_mark_t mark = arena_mark(scratch);
+        char *path = path_alloc(node, scratch);
+        if (path != NULL) {
+            vfs_notify(node->owner, VFS_OP_WRITE, path, NULL, data, size, node->mtime);
+        }
+        arena_rewind(scratch, mark);
     }
     
-    /* 配置並複製新資料 */
-    if (size > 0 && data != NULL) {
-        node->data = safe_malloc(size);
-        if (node->data == NULL) {
-            node->size = 0;
+    return true;
+}
+
+/**
+ * @brief 借用檔案內容的唯讀檢視
+ */
+const void *vfs_peek_file(vfs_node_t *node, size_t *size) {
+    TRACE_SCOPE(TRACE_VFS_READ);
+    if (node == NULL || node->type != VFS_FILE) {
+        error_set(ERR_INVALID_INPUT, "無效的檔案節點");
+        return NULL;
+    }
+    
+    if (size != NULL) {
+        *size = node->size;
+    }
+    
+    /* 分段儲存先合併為單一區塊 */
+    vfs_content_view_t view;
+    if (node->size == 0 || !content_acquire(node, true, true, &view)) {
+        return NULL;
+    }
+    
+    return view.data;
+}
+
+/**
+ * @brief 借用檔案中一段連續內容的唯讀檢視
+ */
+const void *vfs_peek_range(vfs_node_t *node, size_t offset, size_t *len) {
+    if (node == NULL || node->type != VFS_FILE || len == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的檔案節點");
+        return NULL;
+    }
+    
+    *len = 0;
+    vfs_content_view_t view;
+    if (offset >= node->size || !content_acquire(node, true, false, &view)) {
+        return NULL;
+    }
+    
+    if (view.extents != NULL) {
+        size_t index = offset / VFS_EXTENT_SIZE;
+        size_t within = offset % VFS_EXTENT_SIZE;
+        *len = extent_length(node, index) - within;
+        return (const unsigned char *)view.extents->chunks[index] + within;
+    }
+    
+    *len = node->size - offset;
+    return (const unsigned char *)view.data + offset;
+}
+
+/**
+ * @brief 讀取檔案內容的一段範圍
+ */
+bool vfs_pread(vfs_node_t *node, size_t offset, void *dst, size_t len, size_t *out_len) {
+    TRACE_SCOPE(TRACE_VFS_READ);
+    if (node == NULL || node->type != VFS_FILE || (dst == NULL && len > 0) || out_len == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的檔案節點");
+        return false;
+    }
+    
+    *out_len = 0;
+    if (offset >= node->size) {
+        return true;
+    }
+    if (len > node->size - offset) {
+        len = node->size - offset;
+    }
+    
+    vfs_content_view_t view;
+    content_acquire(node, false, false, &view);
+    
+    if (view.lazy) {
+        /* 直接讀取後備儲存中的範圍，不載入整個檔案 */
+        vfs_backing_t *backing = node->owner->backing;
+        if (backing == NULL) {
+            error_set(ERR_IO_ERROR, "找不到檔案內容的後備儲存: %s", node->name);
             return false;
         }
-        memcpy(node->data, data, size);
+        if (!backing->read(backing, node->backing_offset + offset, dst, len)) {
+            return false;
+        }
+    } else if (view.extents != NULL) {
+        extents_copy_out(node, view.extents, dst, offset, len);
     } else {
-        node->data = NULL;
+        memcpy(dst, (const char *)view.data + offset, len);
+    }
+    
+    *out_len = len;
+    return true;
+}
+
+/**
+ * @brief 寫入檔案內容的一段範圍
+ */
+bool vfs_pwrite(vfs_node_t *node, size_t offset, const void *data, size_t len) {
+    TRACE_SCOPE(TRACE_VFS_WRITE);
+    if (node == NULL || node->type != VFS_FILE || (data == NULL && len > 0)) {
+        error_set(ERR_INVALID_INPUT, "無效的檔案節點");
+        return false;
+    }
+    
+    if (len == 0) {
+        return true;
+    }
+    if (offset > SIZE_MAX - len) {
+        error_set(ERR_INVALID_INPUT, "寫入範圍超出上限");
+        return false;
+    }
+    
+    if (!extents_convert(node)) {
+        return false;
+    }
+    node->generation++;
+    
+    /* 空隙所在的段落先延伸到新的結尾（新區塊已清零） */
+    size_t end = offset + len;
+    size_t old_size = node->size;
+    size_t last = (old_size > 0) ? (old_size - 1) / VFS_EXTENT_SIZE : 0;
+    size_t first_write = offset / VFS_EXTENT_SIZE;
+    for (size_t index = last; old_size < offset && index < first_write; index++) {
+        size_t used = (index * VFS_EXTENT_SIZE < old_size) ? old_size - index * VFS_EXTENT_SIZE : 0;
+        if (used < VFS_EXTENT_SIZE &&
+            extent_for_write(node->extents, index, used, VFS_EXTENT_SIZE) == NULL) {
+            return false;
+        }
+    }
+    
+    /* 逐段寫入，只複製或配置受影響的段落 */
+    const unsigned char *in = (const unsigned char *)data;
+    size_t pos = offset;
+    while (pos < end) {
+        size_t index = pos / VFS_EXTENT_SIZE;
+        size_t start = index * VFS_EXTENT_SIZE;
+        size_t within = pos - start;
+        size_t n = VFS_EXTENT_SIZE - within;
+        if (n > end - pos) {
+            n = end - pos;
+        }
+        size_t used = (start < old_size) ? old_size - start : 0;
+        if (used > VFS_EXTENT_SIZE) {
+            used = VFS_EXTENT_SIZE;
+        }
+        size_t need = (within + n > used) ? within + n : used;
+        
+        unsigned char *chunk = (unsigned char *)extent_for_write(node->extents, index, used, need);
+        if (chunk == NULL) {
+            return false;
+        }
+        memcpy(chunk + within, in, n);
+        in += n;
+        pos += n;
+        if (pos > node->size) {
+            file_set_size(node, pos);
+        }
     }
     
-    node->size = size;
     node->mtime = time(NULL);
+    mark_dirty(node->owner, len);
+    
+    /* 通知觀察者：內容前加上寫入位置（路徑與記錄放在暫存區段） */
+    if (node->owner->observer != NULL) {
+        arena_t *scratch = scratch_arena();
+        arena_mark_t mark = arena_mark(scratch);
+        char *path = path_alloc(node, scratch);
+        unsigned char *record = (unsigned char *)arena_alloc(scratch, sizeof(uint64_t) + len);
+        if (path != NULL && record != NULL) {
+            uint64_t where = (uint64_t)offset;
+            memcpy(record, &where, sizeof(where));
+            memcpy(record + sizeof(where), data, len);
+            vfs_notify(node->owner, VFS_OP_PWRITE, path, NULL, record, sizeof(where) + len, node->mtime);
+        }
+        arena_rewind(scratch, mark);
+    }
     
     return true;
 }
 
+/**
+ * @brief 附加內容到檔案結尾
+ */
+bool vfs_append(vfs_node_t *node, const void *data, size_t len) {
+    if (node == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的檔案節點");
+        return false;
+    }
+    return vfs_pwrite(node, node->size, data, len);
+}
+
 /* ========================================================================
  * 目錄操作函式實作
  * ======================================================================== */
@@ -768,61 +2463,353 @@ vfs_node_t **vfs_list_dir(vfs_node_t *dir, size_t *count) {
 }
 
 /**
- * @brief 取得節點的完整路徑
+ * @brief 開始走訪目錄
  */
-char *vfs_get_path(vfs_node_t *node) {
-    if (node == NULL) {
+bool vfs_dir_iter_begin(vfs_dir_iter_t *iter, vfs_node_t *dir, bool sorted) {
+    if (iter == NULL || dir == NULL || dir->type != VFS_DIR) {
+        error_set(ERR_INVALID_INPUT, "無效的目錄節點");
+        return false;
+    }
+    
+    iter->dir = dir;
+    iter->next = dir->children;
+    iter->index = 0;
+    iter->end = 0;
+    iter->sorted = sorted;
+    
+    if (sorted) {
+        /* 排序索引在首次依名稱走訪時建立，可能由多個讀取者同時觸發 */
+        cache_lock(dir->owner);
+        bool ok = (dir->sorted_index != NULL || sorted_index_build(dir));
+        cache_unlock(dir->owner);
+        if (!ok) {
+            error_set(ERR_MEMORY, "無法建立目錄排序索引");
+            return false;
+        }
+        iter->end = dir->sorted_index->count;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 開始走訪目錄中名稱以指定前綴開頭的子節點
+ */
+bool vfs_dir_iter_begin_prefix(vfs_dir_iter_t *iter, vfs_node_t *dir, const char *prefix, size_t len) {
+    if (prefix == NULL && len > 0) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    if (!vfs_dir_iter_begin(iter, dir, true)) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+    
+    /* 符合前綴的名稱在排序索引中相鄰：起點為下界，終點為第一個大於前綴範圍的位置 */
+    const vfs_sorted_index_t *index = dir->sorted_index;
+    size_t lo = sorted_index_lower_bound(index, prefix, len);
+    size_t hi = index->count;
+    iter->index = lo;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strncmp(index->nodes[mid]->name, prefix, len) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    iter->end = lo;
+    
+    return true;
+}
+
+/**
+ * @brief 取得依名稱走訪時尚未取得的子節點數量
+ */
+size_t vfs_dir_iter_remaining(const vfs_dir_iter_t *iter) {
+    if (iter == NULL || !iter->sorted || iter->dir == NULL || iter->dir->sorted_index == NULL) {
+        return 0;
+    }
+    return (iter->end > iter->index) ? iter->end - iter->index : 0;
+}
+
+/**
+ * @brief 取得剩餘子節點名稱的最長共同前綴長度
+ */
+size_t vfs_dir_iter_common_prefix(const vfs_dir_iter_t *iter) {
+    if (vfs_dir_iter_remaining(iter) == 0) {
+        return 0;
+    }
+    
+    const vfs_sorted_index_t *index = iter->dir->sorted_index;
+    const char *first = index->nodes[iter->index]->name;
+    const char *last = index->nodes[iter->end - 1]->name;
+    size_t len = 0;
+    while (first[len] != '\0' && first[len] == last[len]) {
+        len++;
+    }
+    return len;
+}
+
+/**
+ * @brief 取得走訪中的下一個子節點
+ */
+vfs_node_t *vfs_dir_iter_next(vfs_dir_iter_t *iter) {
+    if (iter == NULL || iter->dir == NULL) {
         return NULL;
     }
     
-    /* 配置初始緩衝區 */
-    size_t capacity = 256;
-    char *path = (char *)safe_malloc(capacity);
-    if (path == NULL) {
+    if (!iter->sorted) {
+        vfs_node_t *node = iter->next;
+        if (node != NULL) {
+            iter->next = node->next;
+        }
+        return node;
+    }
+    
+    /* 索引在走訪期間因記憶體不足被捨棄時提前結束 */
+    const vfs_sorted_index_t *index = iter->dir->sorted_index;
+    if (index == NULL || iter->index >= iter->end || iter->index >= index->count) {
         return NULL;
     }
+    return index->nodes[iter->index++];
+}
+
+/**
+ * @brief 取得子樹的節點數
+ */
+size_t vfs_subtree_nodes(const vfs_node_t *node) {
+    if (node == NULL) {
+        return 0;
+    }
+    return (node->type == VFS_DIR) ? node->tree_nodes : 1;
+}
+
+/**
+ * @brief 取得子樹內檔案的總大小
+ */
+size_t vfs_subtree_size(const vfs_node_t *node) {
+    if (node == NULL) {
+        return 0;
+    }
+    return (node->type == VFS_DIR) ? node->tree_size : node->size;
+}
+
+/* ========================================================================
+ * 路徑快取實作
+ * ======================================================================== */
+
+/**
+ * @brief 找出節點的快取項目
+ */
+static path_cache_entry_t *path_cache_find(struct vfs_path_cache *cache, const vfs_node_t *node) {
+    if (cache == NULL || !(node->flags & VFS_NODE_PATH_CACHED)) {
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < VFS_PATH_CACHE_SLOTS; i++) {
+        if (cache->entries[i].node == node) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 清空快取項目（保留緩衝區）
+ */
+static void path_cache_drop(path_cache_entry_t *entry) {
+    entry->node->flags &= ~VFS_NODE_PATH_CACHED;
+    entry->node = NULL;
+    entry->len = 0;
+}
+
+/**
+ * @brief 節點釋放時移除其快取項目
+ */
+static void path_cache_forget(vfs_node_t *node) {
+    path_cache_entry_t *entry = path_cache_find(node->owner->path_cache, node);
+    if (entry != NULL) {
+        path_cache_drop(entry);
+    }
+    node->flags &= ~VFS_NODE_PATH_CACHED;
+}
+
+/**
+ * @brief 清除位於 subtree 子樹中（含 subtree 本身）的快取項目
+ */
+static void path_cache_invalidate(vfs_t *vfs, const vfs_node_t *subtree) {
+    struct vfs_path_cache *cache = vfs->path_cache;
+    if (cache == NULL) {
+        return;
+    }
     
-    path[0] = '\0';
+    for (size_t i = 0; i < VFS_PATH_CACHE_SLOTS; i++) {
+        path_cache_entry_t *entry = &cache->entries[i];
+        for (const vfs_node_t *curr = entry->node; curr != NULL; curr = curr->parent) {
+            if (curr == subtree) {
+                path_cache_drop(entry);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 計算節點的路徑長度
+ *
+ * 向上走訪到根節點或最近一個已快取路徑的祖先為止。
+ *
+ * @param node   節點指標
+ * @param prefix 輸出參數，可直接複製的祖先路徑（沒有時為 NULL）
+ * @param prefix_len 輸出參數，祖先路徑長度
+ * @return 完整路徑長度（不含結尾 '\0'）
+ */
+static size_t path_measure(const vfs_node_t *node, const path_cache_entry_t **prefix, size_t *prefix_len) {
+    struct vfs_path_cache *cache = node->owner->path_cache;
+    size_t len = 0;
+    
+    *prefix = NULL;
+    *prefix_len = 0;
+    for (const vfs_node_t *curr = node; curr->parent != NULL; curr = curr->parent) {
+        const path_cache_entry_t *entry = path_cache_find(cache, curr);
+        if (entry != NULL) {
+            *prefix = entry;
+            *prefix_len = entry->len;
+            break;
+        }
+        len += strlen(curr->name) + 1;
+    }
     
-    /* 收集從節點到根的路徑組件 */
-    vfs_node_t *components[64];
-    size_t depth = 0;
-    vfs_node_t *curr = node;
+    /* 根目錄本身為 "/" */
+    return (*prefix_len + len > 0) ? *prefix_len + len : 1;
+}
+
+/**
+ * @brief 將節點路徑寫入 out（大小至少為 len + 1）
+ */
+static void path_fill(const vfs_node_t *node, const path_cache_entry_t *prefix, size_t prefix_len,
+                      char *out, size_t len) {
+    if (prefix != NULL) {
+        memcpy(out, prefix->path, prefix_len);
+    }
     
-    while (curr != NULL && depth < 64) {
-        components[depth++] = curr;
-        curr = curr->parent;
+    /* 由結尾往前寫入各層名稱 */
+    size_t pos = len;
+    for (const vfs_node_t *curr = node; pos > prefix_len && curr->parent != NULL; curr = curr->parent) {
+        size_t name_len = strlen(curr->name);
+        pos -= name_len;
+        memcpy(out + pos, curr->name, name_len);
+        out[--pos] = '/';
     }
     
-    /* 反向建構路徑字串 */
-    for (size_t i = depth; i > 0; i--) {
-        size_t idx = i - 1;
-        size_t len = strlen(path);
-        size_t name_len = strlen(components[idx]->name);
-        
-        /* 必要時擴展緩衝區 */
-        if (len + name_len + 2 > capacity) {
-            capacity = (len + name_len + 2) * 2;
-            char *new_path = (char *)safe_realloc(path, capacity);
-            if (new_path == NULL) {
-                safe_free(path);
-                return NULL;
+    if (len == 1 && prefix_len == 0) {
+        out[0] = '/';
+    }
+    out[len] = '\0';
+}
+
+/**
+ * @brief 配置並寫入節點的完整路徑
+ *
+ * @param node  節點指標
+ * @param arena 配置來源；NULL 時以 safe_malloc_uninit 配置（呼叫者以 safe_free 釋放）
+ * @return 路徑字串，失敗回傳 NULL
+ */
+static char *path_alloc(vfs_node_t *node, arena_t *arena) {
+    cache_lock(node->owner);
+    const path_cache_entry_t *prefix;
+    size_t prefix_len;
+    size_t len = path_measure(node, &prefix, &prefix_len);
+    
+    char *path = (char *)((arena != NULL) ? arena_alloc(arena, len + 1) : safe_malloc_uninit(len + 1));
+    if (path != NULL) {
+        path_fill(node, prefix, prefix_len, path, len);
+    }
+    cache_unlock(node->owner);
+    return path;
+}
+
+/**
+ * @brief 取得節點的完整路徑
+ */
+char *vfs_get_path(vfs_node_t *node) {
+    if (node == NULL) {
+        return NULL;
+    }
+    return path_alloc(node, NULL);
+}
+
+/**
+ * @brief 查詢或建立節點的路徑快取項目（呼叫者需持有 cache_lock）
+ */
+static const char *path_cache_lookup(vfs_node_t *node, size_t *len) {
+    vfs_t *vfs = node->owner;
+    if (vfs->path_cache == NULL) {
+        vfs->path_cache = (struct vfs_path_cache *)tagged_malloc(MEM_TAG_VFS_INDEX,
+                                                                 sizeof(struct vfs_path_cache));
+        if (vfs->path_cache == NULL) {
+            return NULL;
+        }
+    }
+    struct vfs_path_cache *cache = vfs->path_cache;
+    
+    path_cache_entry_t *entry = path_cache_find(cache, node);
+    if (entry == NULL) {
+        /* 選擇空項目或最久未使用的項目 */
+        entry = &cache->entries[0];
+        for (size_t i = 0; i < VFS_PATH_CACHE_SLOTS && entry->node != NULL; i++) {
+            path_cache_entry_t *candidate = &cache->entries[i];
+            if (candidate->node == NULL || candidate->last_used < entry->last_used) {
+                entry = candidate;
             }
-            path = new_path;
         }
-        
-        if (idx == depth - 1 || (idx < depth - 1 && components[idx]->name[0] != '/')) {
-            strncat(path, components[idx]->name, name_len);
+        if (entry->node != NULL) {
+            path_cache_drop(entry);
         }
         
-        if (idx > 0 && components[idx]->name[0] != '/') {
-            strncat(path, "/", 1);
+        const path_cache_entry_t *prefix;
+        size_t prefix_len;
+        size_t path_len = path_measure(node, &prefix, &prefix_len);
+        
+        if (path_len + 1 > entry->capacity) {
+            size_t capacity = (path_len + 1 > 64) ? path_len + 1 : 64;
+            char *buffer = (char *)tagged_realloc(MEM_TAG_VFS_INDEX, entry->path, entry->capacity,
+                                                  capacity);
+            if (buffer == NULL) {
+                return NULL;
+            }
+            entry->path = buffer;
+            entry->capacity = capacity;
         }
+        
+        path_fill(node, prefix, prefix_len, entry->path, path_len);
+        entry->node = node;
+        entry->len = path_len;
+        node->flags |= VFS_NODE_PATH_CACHED;
     }
     
-    if (strlen(path) == 0) {
-        strncpy(path, "/", 2);
+    entry->last_used = ++cache->clock;
+    if (len != NULL) {
+        *len = entry->len;
+    }
+    return entry->path;
+}
+
+/**
+ * @brief 借用節點的完整路徑
+ */
+const char *vfs_peek_path(vfs_node_t *node, size_t *len) {
+    if (node == NULL) {
+        error_set(ERR_INVALID_INPUT, "節點為 NULL");
+        return NULL;
     }
     
+    cache_lock(node->owner);
+    const char *path = path_cache_lookup(node, len);
+    cache_unlock(node->owner);
     return path;
 }
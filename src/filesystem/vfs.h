@@ -17,6 +17,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 /* ========================================================================
@@ -31,35 +32,198 @@ typedef enum {
     VFS_DIR     /**< 目錄節點 */
 } vfs_node_type_t;
 
+/**
+ * @brief 目錄子節點雜湊索引（不透明型別）
+ *
+ * 子節點數量超過 VFS_CHILD_INDEX_THRESHOLD 的目錄會建立此索引，
+ * 以開放定址法將名稱查詢降為平均 O(1)；小型目錄維持單純的鏈結串列。
+ */
+typedef struct vfs_child_index vfs_child_index_t;
+
+/**
+ * @brief 目錄子節點排序索引（不透明型別）
+ *
+ * 首次依名稱順序走訪目錄時建立，之後隨子節點加入與移除增量維護。
+ */
+typedef struct vfs_sorted_index vfs_sorted_index_t;
+
+/**
+ * @brief 啟用子節點雜湊索引的目錄大小門檻
+ */
+#define VFS_CHILD_INDEX_THRESHOLD 32
+
+/**
+ * @brief 節點內嵌名稱緩衝區大小（含結尾 '\0'），較長的名稱另外配置
+ */
+#define VFS_INLINE_NAME_LEN 24
+
+/**
+ * @brief 節點旗標
+ */
+#define VFS_NODE_IN_USE 0x01u      /**< 節點正在使用中（非配置池中的空閒節點） */
+#define VFS_NODE_LAZY   0x02u      /**< 檔案內容尚未載入，需從映像檔讀取 */
+#define VFS_NODE_PATH_CACHED 0x04u /**< 節點的完整路徑在路徑快取中 */
+
+/**
+ * @brief 路徑快取的項目數
+ *
+ * 快取 vfs_peek_path() 最近查詢的節點路徑（如 shell 的目前目錄），
+ * 以最久未使用者替換。
+ */
+#define VFS_PATH_CACHE_SLOTS 16
+
+/**
+ * @brief VFS 完整路徑快取（不透明型別）
+ */
+struct vfs_path_cache;
+
+/**
+ * @brief 分段儲存時每段的容量上限（位元組）
+ */
+#define VFS_EXTENT_SIZE (64u * 1024u)
+
+/**
+ * @brief 分段儲存的檔案內容
+ *
+ * 以 vfs_pwrite/vfs_append 修改過的檔案改用分段儲存，
+ * 每段是一個內容區塊，部分更新與附加只需複製受影響的段落。
+ * 除最後一段外每段皆為 VFS_EXTENT_SIZE 位元組，位置 off 位於第
+ * off / VFS_EXTENT_SIZE 段；最後一段的區塊容量可以較小，成長時再擴大。
+ * 段落可與複製出的檔案共用，修改前才各自複製（寫入時複製）。
+ */
+typedef struct vfs_extent_list {
+    void **chunks;                 /**< 各段的內容區塊 */
+    size_t count;                  /**< 段數 */
+    size_t capacity;               /**< chunks 陣列容量 */
+    struct vfs_extent_list *next_retired; /**< 待釋放串列中的下一項（僅併行模式使用） */
+} vfs_extent_list_t;
+
+struct vfs;
+
+/**
+ * @brief VFS 內容後備儲存
+ *
+ * 延遲載入時，檔案內容保留在映像檔中，由持久化模組提供此介面
+ * 在首次存取時讀取（並解密）指定範圍。
+ */
+typedef struct vfs_backing {
+    /**
+     * @brief 讀取內容範圍
+     * @return true 成功，false 失敗（需設定錯誤訊息）
+     */
+    bool (*read)(struct vfs_backing *backing, uint64_t offset, void *dst, size_t len);
+    
+    /** @brief 釋放後備儲存（VFS 銷毀時呼叫） */
+    void (*release)(struct vfs_backing *backing);
+} vfs_backing_t;
+
 /**
  * @brief VFS 節點結構
  *
  * 表示虛擬檔案系統中的單一節點（檔案或目錄）。
- * 使用鏈結串列管理子節點與兄弟節點。
+ * 使用鏈結串列管理子節點與兄弟節點，大型目錄另附雜湊索引加速查詢。
  */
 typedef struct vfs_node {
-    char *name;                    /**< 節點名稱 */
+    char *name;                    /**< 節點名稱（短名稱指向 name_inline） */
     vfs_node_type_t type;          /**< 節點類型（檔案/目錄） */
-    void *data;                    /**< 檔案內容（目錄為 NULL） */
+    unsigned int flags;            /**< 節點旗標（VFS_NODE_*） */
+    void *data;                    /**< 連續儲存的檔案內容（指向共用的內容區塊，唯讀；目錄為 NULL） */
+    vfs_extent_list_t *extents;    /**< 分段儲存的檔案內容（連續儲存時為 NULL） */
+    uint64_t generation;           /**< 內容世代：內容或儲存方式改變時遞增，借用的檢視以此判斷是否過期 */
     size_t size;                   /**< 大小（檔案：位元組數，目錄：子節點數） */
+    size_t tree_nodes;             /**< 目錄子樹的節點數（含自身；檔案不使用） */
+    size_t tree_size;              /**< 目錄子樹內檔案的總位元組數（檔案不使用） */
     time_t mtime;                  /**< 最後修改時間 */
     time_t ctime;                  /**< 建立時間 */
     struct vfs_node *parent;       /**< 父節點指標 */
     struct vfs_node *children;     /**< 第一個子節點（鏈結串列頭） */
     struct vfs_node *next;         /**< 下一個兄弟節點 */
+    vfs_child_index_t *child_index; /**< 子節點雜湊索引（僅大型目錄，否則為 NULL） */
+    vfs_sorted_index_t *sorted_index; /**< 子節點排序索引（尚未依名稱走訪過則為 NULL） */
+    struct vfs *owner;             /**< 所屬的 VFS */
+    uint64_t backing_offset;       /**< 延遲載入時內容在後備儲存中的位置 */
+    char name_inline[VFS_INLINE_NAME_LEN]; /**< 短名稱內嵌儲存區 */
 } vfs_node_t;
 
+/**
+ * @brief VFS 變更操作類型（供日誌等觀察者使用）
+ */
+typedef enum {
+    VFS_OP_CREATE_FILE,            /**< 建立檔案（path, data, size） */
+    VFS_OP_CREATE_DIR,             /**< 建立目錄（path） */
+    VFS_OP_WRITE,                  /**< 覆寫檔案內容（path, data, size） */
+    VFS_OP_DELETE,                 /**< 刪除節點（path） */
+    VFS_OP_RENAME,                 /**< 重新命名（path → path2） */
+    VFS_OP_MOVE,                   /**< 移動節點（path → path2） */
+    VFS_OP_PWRITE                  /**< 部分寫入（path, data, size）：data 開頭為 8 位元組的
+                                        寫入位置（uint64_t 主機序），其後為寫入的內容 */
+} vfs_op_t;
+
+/**
+ * @brief VFS 變更觀察者
+ *
+ * 每個變更操作成功完成後呼叫 record，持久化日誌藉此記錄操作。
+ */
+typedef struct vfs_observer {
+    /**
+     * @brief 記錄一個已完成的變更操作
+     *
+     * @param observer 觀察者
+     * @param op       操作類型
+     * @param path     目標路徑
+     * @param path2    第二個路徑（重新命名/移動的目標，其餘為 NULL）
+     * @param data     檔案內容（建立/覆寫檔案，其餘為 NULL）
+     * @param size     內容大小
+     * @param mtime    操作後節點的修改時間
+     */
+    void (*record)(struct vfs_observer *observer, vfs_op_t op, const char *path,
+                   const char *path2, const void *data, size_t size, time_t mtime);
+} vfs_observer_t;
+
+/**
+ * @brief VFS 節點配置池（不透明型別）
+ */
+struct vfs_node_pool;
+
+/**
+ * @brief 併行模式使用的鎖（不透明型別）
+ */
+struct vfs_sync;
+
 /**
  * @brief VFS 檔案系統結構
  *
  * 管理整個虛擬檔案系統的根節點與統計資訊。
+ * 所有節點皆由 VFS 擁有的 slab 配置池配置。
  */
-typedef struct {
+typedef struct vfs {
     vfs_node_t *root;              /**< 根目錄節點 */
-    size_t total_nodes;            /**< 總節點數量 */
-    size_t total_size;             /**< 總檔案大小（位元組） */
+    struct vfs_node_pool *pool;    /**< 節點配置池 */
+    vfs_backing_t *backing;        /**< 延遲載入的內容後備儲存（可為 NULL） */
+    vfs_observer_t *observer;      /**< 變更觀察者（可為 NULL） */
+    struct vfs_path_cache *path_cache; /**< 完整路徑快取（首次使用時配置） */
+    uint64_t image_id;             /**< 最近一次載入或儲存的映像檔識別碼（0 表示尚未持久化） */
+    size_t total_nodes;            /**< 總節點數量（與根目錄的子樹統計同步） */
+    size_t total_size;             /**< 總檔案大小（位元組，與根目錄的子樹統計同步） */
+    bool concurrent;               /**< 是否啟用併行模式（見 vfs_set_concurrent()） */
+    struct vfs_sync *sync;         /**< 讀寫鎖與保護讀取者更新狀態的互斥鎖 */
+    vfs_extent_list_t *retired;    /**< 讀取者合併後待釋放的分段串列（下次取得寫入鎖時釋放） */
+    uint64_t dirty_ops;            /**< 自上次持久化以來的變更操作數 */
+    uint64_t dirty_bytes;          /**< 自上次持久化以來寫入的內容位元組數 */
 } vfs_t;
 
+/**
+ * @brief 檔案內容儲存方式的快照（供持久化等 VFS 內部模組使用）
+ *
+ * 三者之一有效：lazy 為 true 時內容仍在後備儲存中（位於 node->backing_offset），
+ * 否則為連續儲存的 data 或分段儲存的 extents（空檔案兩者皆為 NULL）。
+ */
+typedef struct {
+    const void *data;              /**< 連續儲存的內容 */
+    const vfs_extent_list_t *extents; /**< 分段儲存的內容 */
+    bool lazy;                     /**< 內容尚未載入 */
+} vfs_content_view_t;
+
 /* ========================================================================
  * VFS 生命週期函式
  * ======================================================================== */
@@ -82,6 +246,190 @@ vfs_t *vfs_init(void);
  */
 void vfs_destroy(vfs_t *vfs);
 
+/**
+ * @brief 將 VFS 標記為已持久化
+ *
+ * 清除變更累計（dirty_ops、dirty_bytes）；由持久化與日誌模組
+ * 在所有變更確實寫入儲存後呼叫。
+ *
+ * @param vfs VFS 實例（可為 NULL）
+ */
+void vfs_mark_clean(vfs_t *vfs);
+
+/**
+ * @brief 建立 VFS 的快照（寫入時複製）
+ *
+ * 複製目錄樹結構，檔案內容與原 VFS 共用內容區塊（只保留參考，不複製內容）；
+ * 延遲載入的檔案借用原 VFS 的後備儲存。原 VFS 之後的修改不影響快照，
+ * 因此可在不持有鎖的情況下序列化快照（如 vfs_save_encrypted()），
+ * 修改命令不需等待儲存完成。
+ *
+ * @param vfs VFS 實例
+ * @return 快照（非併行模式的 VFS），失敗回傳 NULL
+ * @note 內容區塊的參考計數不是原子操作：併行模式下建立與釋放快照都需持有原 VFS 的寫入鎖；
+ *       快照需在原 VFS 銷毀前以 vfs_snapshot_release() 釋放
+ */
+vfs_t *vfs_snapshot(vfs_t *vfs);
+
+/**
+ * @brief 釋放 vfs_snapshot() 建立的快照
+ *
+ * 釋放快照的節點與內容區塊參考，不釋放借用的後備儲存。
+ *
+ * @param snapshot 快照（可為 NULL）
+ */
+void vfs_snapshot_release(vfs_t *snapshot);
+
+/* ========================================================================
+ * 併行存取
+ *
+ * 預設（非併行模式）下 VFS 只能由單一執行緒使用，以下鎖定函式皆不做任何事。
+ * 啟用併行模式後，多個執行緒可同時持有讀取鎖（ls、cat、搜尋等唯讀操作），
+ * 修改 VFS 的操作需持有寫入鎖，與所有讀取者互斥。
+ *
+ * 讀取者也會更新的內部狀態（延遲載入內容、合併分段、建立排序索引、路徑快取）
+ * 另由 VFS 內部的互斥鎖保護；讀取者合併掉的分段延到下次取得寫入鎖時才釋放，
+ * 其他讀取者借用的檢視在釋放讀取鎖前保持有效。
+ * ======================================================================== */
+
+/**
+ * @brief 啟用或停用併行模式
+ *
+ * @param vfs     VFS 實例
+ * @param enabled true 啟用
+ * @note 需在沒有其他執行緒使用此 VFS 時呼叫（例如建立背景執行緒之前）
+ */
+void vfs_set_concurrent(vfs_t *vfs, bool enabled);
+
+/**
+ * @brief 取得讀取鎖（可與其他讀取者同時持有）
+ *
+ * 持有讀取鎖時只能呼叫不修改 VFS 的函式（查詢、讀取、借用檢視、走訪目錄）。
+ * vfs_peek_path() 回傳的緩衝區會被其他執行緒的查詢覆寫，其他執行緒應改用 vfs_get_path()。
+ *
+ * @param vfs VFS 實例（可為 NULL）
+ */
+void vfs_read_lock(vfs_t *vfs);
+
+/**
+ * @brief 取得寫入鎖（與所有讀取者及其他寫入者互斥）
+ *
+ * @param vfs VFS 實例（可為 NULL）
+ */
+void vfs_write_lock(vfs_t *vfs);
+
+/**
+ * @brief 釋放 vfs_read_lock() 或 vfs_write_lock() 取得的鎖
+ *
+ * @param vfs VFS 實例（可為 NULL）
+ */
+void vfs_unlock(vfs_t *vfs);
+
+/* ========================================================================
+ * 節點配置函式（供持久化等 VFS 內部模組使用）
+ * ======================================================================== */
+
+/**
+ * @brief 配置新節點
+ *
+ * 從 VFS 的節點配置池取得節點並初始化，節點尚未加入任何目錄。
+ *
+ * @param vfs  VFS 實例
+ * @param name 節點名稱（不需以 '\0' 結尾）
+ * @param len  名稱長度
+ * @param type 節點類型
+ * @return 新節點指標，失敗回傳 NULL
+ */
+vfs_node_t *vfs_node_alloc(vfs_t *vfs, const char *name, size_t len, vfs_node_type_t type);
+
+/**
+ * @brief 釋放節點及其子節點
+ *
+ * 安全清除檔案內容並將節點歸還配置池。呼叫前節點需已從父目錄移除。
+ *
+ * @param vfs  VFS 實例
+ * @param node 要釋放的節點（可為 NULL）
+ */
+void vfs_node_free(vfs_t *vfs, vfs_node_t *node);
+
+/**
+ * @brief 為直接連結子節點的目錄建立雜湊索引
+ *
+ * 載入映像檔時子節點直接串入 children，不經過加入子節點的路徑；
+ * 連結完成後呼叫此函式，讓查詢不必在讀取鎖下建立索引。
+ * 呼叫者需獨佔存取該目錄，目錄未超過門檻時不做任何事。
+ *
+ * @param dir 目錄節點
+ */
+void vfs_node_index_children(vfs_node_t *dir);
+
+/* ========================================================================
+ * 檔案內容區塊（供持久化等 VFS 內部模組使用）
+ * ======================================================================== */
+
+/**
+ * @brief 配置內容區塊
+ *
+ * 檔案內容存放在不可變、具參考計數的區塊中，節點的 data 指向區塊內容。
+ * 複製檔案只增加參考計數；覆寫檔案時配置新區塊（寫入時複製），
+ * 舊區塊在最後一個參考釋放時才安全清除並釋放。
+ *
+ * @param data 初始內容（可為 NULL，此時內容為零）
+ * @param size 內容大小（位元組，需大於 0）
+ * @return 區塊內容指標（參考計數為 1），失敗回傳 NULL
+ */
+void *vfs_blob_create(const void *data, size_t size);
+
+/**
+ * @brief 增加內容區塊的參考計數
+ *
+ * @param data 區塊內容指標（可為 NULL）
+ * @return data
+ */
+void *vfs_blob_retain(void *data);
+
+/**
+ * @brief 釋放一個內容區塊參考
+ *
+ * 最後一個參考釋放時安全清除並釋放區塊。
+ *
+ * @param data 區塊內容指標（可為 NULL）
+ */
+void vfs_blob_release(void *data);
+
+/**
+ * @brief 取得內容區塊的參考計數
+ *
+ * @param data 區塊內容指標
+ * @return 參考計數，data 為 NULL 時回傳 0
+ */
+size_t vfs_blob_refcount(const void *data);
+
+/**
+ * @brief 以內容區塊建立檔案
+ *
+ * 與 vfs_create_file() 相同，但直接採用已填入內容的區塊而不複製，
+ * 適合先把內容讀入區塊再建立節點的匯入流程。
+ *
+ * @param vfs  VFS 實例
+ * @param path 檔案路徑
+ * @param blob 內容區塊（取得此參考的所有權，失敗時也會釋放；size 為 0 時可為 NULL）
+ * @param size 內容大小（位元組）
+ * @return 新檔案節點，失敗回傳 NULL
+ */
+vfs_node_t *vfs_create_file_blob(vfs_t *vfs, const char *path, void *blob, size_t size);
+
+/**
+ * @brief 取得檔案內容儲存方式的快照（不載入延遲內容）
+ *
+ * 持有讀取鎖時，快照中的指標在釋放讀取鎖前有效，
+ * 即使其他讀取者同時載入或合併了同一檔案的內容。
+ *
+ * @param node 檔案節點
+ * @param view 輸出參數，內容快照
+ */
+void vfs_content_view(vfs_node_t *node, vfs_content_view_t *view);
+
 /* ========================================================================
  * 節點操作函式
  * ======================================================================== */
@@ -101,6 +449,21 @@ void vfs_destroy(vfs_t *vfs);
  */
 vfs_node_t *vfs_create_file(vfs_t *vfs, const char *path, const void *data, size_t size);
 
+/**
+ * @brief 複製檔案
+ *
+ * 在指定路徑建立與來源內容相同的新檔案。兩者共用同一個內容區塊，
+ * 不複製資料；之後任一方被覆寫時才各自擁有內容。
+ *
+ * @param vfs      VFS 實例
+ * @param src      來源檔案節點
+ * @param dst_path 目標檔案完整路徑
+ * @return 新建立的檔案節點，失敗回傳 NULL
+ *
+ * @note 若中間目錄不存在會自動建立
+ */
+vfs_node_t *vfs_copy_file(vfs_t *vfs, vfs_node_t *src, const char *dst_path);
+
 /**
  * @brief 建立目錄
  *
@@ -167,7 +530,7 @@ bool vfs_move_node(vfs_t *vfs, const char *src_path, const char *dst_path);
 /**
  * @brief 讀取檔案內容
  *
- * 取得檔案節點的內容副本。
+ * 取得檔案節點的內容副本。延遲載入的檔案會在此時從映像檔讀入。
  *
  * @param node 檔案節點指標
  * @param size 輸出參數，內容大小（可為 NULL）
@@ -178,7 +541,7 @@ void *vfs_read_file(vfs_node_t *node, size_t *size);
 /**
  * @brief 寫入檔案內容
  *
- * 覆寫檔案節點的內容。
+ * 以連續儲存覆寫檔案節點的全部內容。舊內容若與其他檔案共用則保持不變。
  *
  * @param node 檔案節點指標
  * @param data 新內容
@@ -187,6 +550,77 @@ void *vfs_read_file(vfs_node_t *node, size_t *size);
  */
 bool vfs_write_file(vfs_node_t *node, const void *data, size_t size);
 
+/**
+ * @brief 借用檔案內容的唯讀檢視
+ *
+ * 回傳指向檔案內容的指標，不配置也不複製。延遲載入的內容會在此時讀入，
+ * 分段儲存的檔案會先合併為連續儲存（之後的部分寫入再改回分段）。
+ * 檢視在節點下一次變更內容、改變儲存方式或刪除前有效；
+ * 呼叫者可記下 node->generation，值改變即表示檢視已過期。
+ *
+ * @param node 檔案節點指標
+ * @param size 輸出參數，內容大小（可為 NULL）
+ * @return 唯讀內容指標；空檔案或失敗時回傳 NULL（以 size 區分）
+ */
+const void *vfs_peek_file(vfs_node_t *node, size_t *size);
+
+/**
+ * @brief 借用檔案中一段連續內容的唯讀檢視
+ *
+ * 回傳從 offset 開始、在儲存中連續的最長一段（分段儲存時最多到該段結尾），
+ * 不合併段落也不複製。逐段呼叫即可走訪整個檔案。
+ * 延遲載入的內容會在此時讀入；有效期限同 vfs_peek_file()。
+ *
+ * @param node   檔案節點指標
+ * @param offset 起始位置
+ * @param len    輸出參數，檢視的長度（offset 超過檔案結尾時為 0）
+ * @return 唯讀內容指標，offset 超過結尾或失敗時回傳 NULL
+ */
+const void *vfs_peek_range(vfs_node_t *node, size_t offset, size_t *len);
+
+/**
+ * @brief 讀取檔案內容的一段範圍
+ *
+ * 將 [offset, offset + len) 中位於檔案範圍內的部分複製到 dst，不複製整個檔案。
+ * 延遲載入的檔案直接從映像檔讀取該範圍，不會載入整個內容，
+ * 因此可用來分段串流大型檔案。
+ *
+ * @param node     檔案節點指標
+ * @param offset   起始位置
+ * @param dst      輸出緩衝區（至少 len 位元組）
+ * @param len      最多讀取的位元組數
+ * @param out_len  輸出參數，實際讀取的位元組數（offset 超過檔案結尾時為 0）
+ * @return true 成功，false 失敗
+ */
+bool vfs_pread(vfs_node_t *node, size_t offset, void *dst, size_t len, size_t *out_len);
+
+/**
+ * @brief 寫入檔案內容的一段範圍
+ *
+ * 覆寫 [offset, offset + len) 的內容，超過檔案結尾時延長檔案，
+ * 原結尾與 offset 之間的空隙補零。檔案轉為分段儲存，
+ * 只有受影響的段落會被複製或配置。
+ *
+ * @param node   檔案節點指標
+ * @param offset 起始位置
+ * @param data   寫入的內容
+ * @param len    內容長度（位元組）
+ * @return true 成功，false 失敗
+ */
+bool vfs_pwrite(vfs_node_t *node, size_t offset, const void *data, size_t len);
+
+/**
+ * @brief 附加內容到檔案結尾
+ *
+ * 等同於在目前檔案大小的位置呼叫 vfs_pwrite()。
+ *
+ * @param node 檔案節點指標
+ * @param data 附加的內容
+ * @param len  內容長度（位元組）
+ * @return true 成功，false 失敗
+ */
+bool vfs_append(vfs_node_t *node, const void *data, size_t len);
+
 /* ========================================================================
  * 目錄操作函式
  * ======================================================================== */
@@ -204,14 +638,118 @@ bool vfs_write_file(vfs_node_t *node, const void *data, size_t size);
  */
 vfs_node_t **vfs_list_dir(vfs_node_t *dir, size_t *count);
 
+/**
+ * @brief 目錄走訪游標
+ *
+ * 逐一取得子節點，不需配置整個子節點陣列；可提前結束走訪。
+ */
+typedef struct vfs_dir_iter {
+    vfs_node_t *dir;               /**< 走訪中的目錄 */
+    vfs_node_t *next;              /**< 插入順序：下一個子節點 */
+    size_t index;                  /**< 名稱順序：下一個位置 */
+    size_t end;                    /**< 名稱順序：走訪範圍的結束位置（不含） */
+    bool sorted;                   /**< 是否依名稱（位元組序）走訪 */
+} vfs_dir_iter_t;
+
+/**
+ * @brief 開始走訪目錄
+ *
+ * 依名稱走訪時使用目錄的排序索引；索引首次使用時建立（O(n log n)），
+ * 之後隨子節點的加入與移除維護，重複走訪不需再排序。
+ *
+ * @param iter   游標（由呼叫者提供）
+ * @param dir    目錄節點
+ * @param sorted true 依名稱排序，false 依插入順序
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ *
+ * @note 走訪期間修改該目錄（建立、刪除、移動、重新命名子節點）會使游標失效
+ */
+bool vfs_dir_iter_begin(vfs_dir_iter_t *iter, vfs_node_t *dir, bool sorted);
+
+/**
+ * @brief 開始走訪目錄中名稱以指定前綴開頭的子節點（依名稱排序）
+ *
+ * 以排序索引上的二分搜尋定位前綴範圍，成本為 O(前綴長度 × log n)，
+ * 與目錄中不符合的子節點數量無關。
+ *
+ * @param iter   游標（由呼叫者提供）
+ * @param dir    目錄節點
+ * @param prefix 名稱前綴（不需以 '\0' 結尾）
+ * @param len    前綴長度（0 表示所有子節點）
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool vfs_dir_iter_begin_prefix(vfs_dir_iter_t *iter, vfs_node_t *dir, const char *prefix, size_t len);
+
+/**
+ * @brief 取得依名稱走訪時尚未取得的子節點數量
+ *
+ * @param iter 游標
+ * @return 剩餘的子節點數量（依插入順序走訪時回傳 0）
+ */
+size_t vfs_dir_iter_remaining(const vfs_dir_iter_t *iter);
+
+/**
+ * @brief 取得依名稱走訪時剩餘子節點名稱的最長共同前綴長度
+ *
+ * 排序後範圍內所有名稱的共同前綴等於第一個與最後一個名稱的共同前綴，
+ * 不需逐一比較。
+ *
+ * @param iter 游標
+ * @return 共同前綴的位元組數（沒有剩餘子節點時回傳 0）
+ */
+size_t vfs_dir_iter_common_prefix(const vfs_dir_iter_t *iter);
+
+/**
+ * @brief 取得走訪中的下一個子節點
+ *
+ * @param iter 游標
+ * @return 下一個子節點，走訪結束回傳 NULL
+ */
+vfs_node_t *vfs_dir_iter_next(vfs_dir_iter_t *iter);
+
+/**
+ * @brief 取得子樹的節點數（O(1)）
+ *
+ * 目錄的統計在每次建立、刪除、移動時沿祖先鏈增量更新，不需走訪子樹。
+ *
+ * @param node 節點指標
+ * @return 子樹中的節點數（含自身；檔案為 1，NULL 為 0）
+ */
+size_t vfs_subtree_nodes(const vfs_node_t *node);
+
+/**
+ * @brief 取得子樹內檔案的總大小（O(1)）
+ *
+ * @param node 節點指標
+ * @return 子樹中所有檔案的位元組總數（檔案為其大小，NULL 為 0）
+ */
+size_t vfs_subtree_size(const vfs_node_t *node);
+
 /**
  * @brief 取得節點的完整路徑
  *
- * 從節點向上追溯建構完整路徑字串。
+ * 從節點向上追溯建構完整路徑字串；遇到已快取路徑的祖先時直接複製其路徑，
+ * 只配置一次記憶體。
  *
  * @param node 節點指標
  * @return 完整路徑字串（需由呼叫者釋放），失敗回傳 NULL
  */
 char *vfs_get_path(vfs_node_t *node);
 
+/**
+ * @brief 借用節點的完整路徑（經由路徑快取）
+ *
+ * 路徑保存在 VFS 的路徑快取中，重複查詢同一節點不需配置記憶體，
+ * 適合每個命令都要顯示的提示符。重新命名或移動節點時，
+ * 只有該節點子樹中的快取項目會失效。
+ *
+ * @param node 節點指標
+ * @param len  輸出參數，路徑長度（可為 NULL）
+ * @return 唯讀路徑字串，失敗回傳 NULL
+ *
+ * @note 字串在下一次變更 VFS 結構（重新命名、移動、刪除）或下一次呼叫
+ *       vfs_peek_path() 前有效，需要保留時請自行複製
+ */
+const char *vfs_peek_path(vfs_node_t *node, size_t *len);
+
 #endif // VFS_H
@@ -0,0 +1,306 @@
+/**
+ * @file vfs_autosave.c
+ * @brief VFS 背景自動儲存模組實作
+ *
+ * 背景執行緒每隔 AUTOSAVE_POLL_SECONDS 秒醒來，在讀取鎖下檢查變更累計，
+ * 到期時執行一次儲存；停止時以條件變數立即喚醒。
+ *
+ * 寫出快照時只在寫入鎖內複製目錄樹（內容區塊以參考計數共用），
+ * 序列化與寫檔都在鎖外進行，最後再取得寫入鎖發布新的 image_id 與變更累計；
+ * 儲存期間的變更仍計入變更累計，留待下次儲存。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 clock_gettime） */
+
+#include "vfs_autosave.h"
+#include "vfs_persist.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/** 背景執行緒檢查變更累計的間隔（秒） */
+#define AUTOSAVE_POLL_SECONDS 1
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/**
+ * @brief 背景自動儲存
+ */
+struct vfs_autosave {
+    pthread_t thread;                      /**< 背景執行緒 */
+    vfs_t *vfs;                            /**< 儲存的 VFS */
+    vfs_journal_t *journal;                /**< 附加在 VFS 上的日誌（可為 NULL） */
+    char *image_path;                      /**< 映像檔路徑 */
+    char *key;                             /**< 加密密鑰字串 */
+    unsigned interval;                     /**< 儲存間隔（秒） */
+    size_t dirty_bytes;                    /**< 變更量門檻（位元組） */
+    pthread_mutex_t lock;                  /**< 保護 stop */
+    pthread_cond_t wake;                   /**< 停止時喚醒背景執行緒 */
+    bool stop;                             /**< 是否要求停止 */
+    bool ok;                               /**< 最近一次儲存是否成功（僅背景執行緒寫入） */
+    char message[256];                     /**< 最近一次失敗的原因 */
+};
+
+/* ========================================================================
+ * 內部輔助函式
+ * ======================================================================== */
+
+/**
+ * @brief 扣除已持久化的變更累計（呼叫端持有寫入鎖）
+ *
+ * @param vfs   VFS 實例
+ * @param ops   開始儲存時的變更操作數
+ * @param bytes 開始儲存時的變更位元組數
+ */
+static void settle_dirty(vfs_t *vfs, uint64_t ops, uint64_t bytes) {
+    vfs->dirty_ops -= (ops < vfs->dirty_ops) ? ops : vfs->dirty_ops;
+    vfs->dirty_bytes -= (bytes < vfs->dirty_bytes) ? bytes : vfs->dirty_bytes;
+}
+
+/**
+ * @brief fsync 日誌（不持有鎖）
+ *
+ * 每筆記錄寫出時都已 fflush，開始時記錄的變更都在 fsync 範圍內。
+ */
+static bool sync_journal(vfs_autosave_t *autosave, uint64_t ops, uint64_t bytes) {
+    if (!vfs_journal_fsync(autosave->journal)) {
+        return false;
+    }
+    
+    vfs_write_lock(autosave->vfs);
+    settle_dirty(autosave->vfs, ops, bytes);
+    vfs_unlock(autosave->vfs);
+    return true;
+}
+
+/**
+ * @brief 寫出完整快照（不持有鎖）
+ *
+ * 有日誌時寫成暫存的新映像檔，再於寫入鎖內讓其生效並改用新日誌。
+ */
+static bool save_snapshot(vfs_autosave_t *autosave) {
+    vfs_t *vfs = autosave->vfs;
+    vfs_journal_t *journal = autosave->journal;
+    
+    vfs_write_lock(vfs);
+    vfs_t *snapshot = vfs_snapshot(vfs);
+    if (snapshot != NULL && journal != NULL && vfs_journal_rebase_begin(journal) == 0) {
+        vfs_snapshot_release(snapshot);
+        snapshot = NULL;
+    }
+    uint64_t ops = vfs->dirty_ops;
+    uint64_t bytes = vfs->dirty_bytes;
+    vfs_unlock(vfs);
+    if (snapshot == NULL) {
+        return false;
+    }
+    
+    bool ok = (journal != NULL)
+                  ? vfs_journal_rebase_stage(journal, snapshot)
+                  : vfs_save_encrypted(snapshot, autosave->image_path, autosave->key);
+    
+    vfs_write_lock(vfs);
+    if (journal != NULL) {
+        if (ok) {
+            ok = vfs_journal_rebase_commit(journal);
+        } else {
+            vfs_journal_rebase_abort(journal);
+        }
+    }
+    if (ok) {
+        vfs->image_id = snapshot->image_id;
+        settle_dirty(vfs, ops, bytes);
+    }
+    vfs_snapshot_release(snapshot);
+    vfs_unlock(vfs);
+    return ok;
+}
+
+/**
+ * @brief 執行一次儲存（呼叫端不持有鎖）
+ *
+ * @param autosave 自動儲存實例
+ * @param compact  是否寫出完整快照（否則只 fsync 日誌）
+ * @param ops      判斷到期時的變更操作數
+ * @param bytes    判斷到期時的變更位元組數
+ * @return true 成功，false 失敗並記錄原因
+ */
+static bool checkpoint(vfs_autosave_t *autosave, bool compact, uint64_t ops, uint64_t bytes) {
+    bool ok = compact ? save_snapshot(autosave) : sync_journal(autosave, ops, bytes);
+    
+    if (!ok) {
+        error_t err = error_get();
+        snprintf(autosave->message, sizeof(autosave->message), "%s", err.message);
+        error_clear();
+    }
+    return ok;
+}
+
+/**
+ * @brief 判斷是否該儲存（呼叫端持有讀取鎖）
+ *
+ * @param autosave 自動儲存實例
+ * @param elapsed  距上次儲存的秒數
+ */
+static bool checkpoint_due(const vfs_autosave_t *autosave, double elapsed) {
+    const vfs_t *vfs = autosave->vfs;
+    bool interval_due = elapsed >= (double)autosave->interval;
+    
+    if (autosave->journal == NULL) {
+        return vfs->dirty_ops > 0 && interval_due;
+    }
+    
+    bool pending = vfs->dirty_ops > 0 || vfs_journal_needs_compaction(autosave->journal);
+    if (!pending) {
+        return false;
+    }
+    
+    /* 上次失敗時只依間隔重試，避免每次檢查都重寫快照 */
+    bool urgent = vfs_journal_needs_compaction(autosave->journal) ||
+                  (autosave->dirty_bytes > 0 && vfs->dirty_bytes >= autosave->dirty_bytes);
+    return interval_due || (urgent && autosave->ok);
+}
+
+/**
+ * @brief 背景執行緒主函式
+ */
+static void *autosave_main(void *arg) {
+    vfs_autosave_t *autosave = (vfs_autosave_t *)arg;
+    time_t last = time(NULL);
+    
+    pthread_mutex_lock(&autosave->lock);
+    while (!autosave->stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += AUTOSAVE_POLL_SECONDS;
+        pthread_cond_timedwait(&autosave->wake, &autosave->lock, &deadline);
+        if (autosave->stop) {
+            break;
+        }
+        pthread_mutex_unlock(&autosave->lock);
+        
+        vfs_read_lock(autosave->vfs);
+        time_t now = time(NULL);
+        bool due = checkpoint_due(autosave, difftime(now, last));
+        bool compact = autosave->journal == NULL ||
+                       vfs_journal_needs_compaction(autosave->journal);
+        uint64_t ops = autosave->vfs->dirty_ops;
+        uint64_t bytes = autosave->vfs->dirty_bytes;
+        vfs_unlock(autosave->vfs);
+        
+        if (due) {
+            autosave->ok = checkpoint(autosave, compact, ops, bytes);
+            last = now;
+        }
+        
+        pthread_mutex_lock(&autosave->lock);
+    }
+    pthread_mutex_unlock(&autosave->lock);
+    
+    return NULL;
+}
+
+/**
+ * @brief 釋放自動儲存實例（不處理執行緒）
+ */
+static void destroy_autosave(vfs_autosave_t *autosave) {
+    pthread_cond_destroy(&autosave->wake);
+    pthread_mutex_destroy(&autosave->lock);
+    safe_free(autosave->image_path);
+    if (autosave->key != NULL) {
+        secure_zero(autosave->key, strlen(autosave->key));
+        safe_free(autosave->key);
+    }
+    safe_free(autosave);
+}
+
+/* ========================================================================
+ * 自動儲存函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 啟動背景自動儲存
+ */
+vfs_autosave_t *vfs_autosave_start(vfs_t *vfs, vfs_journal_t *journal,
+                                   const char *image_path, const char *key,
+                                   unsigned interval, size_t dirty_bytes) {
+    if (vfs == NULL || image_path == NULL || key == NULL || interval == 0) {
+        error_set(ERR_INVALID_INPUT, "無效的參數");
+        return NULL;
+    }
+    
+    vfs_autosave_t *autosave = (vfs_autosave_t *)safe_malloc(sizeof(vfs_autosave_t));
+    if (autosave == NULL) {
+        return NULL;
+    }
+    
+    pthread_mutex_init(&autosave->lock, NULL);
+    pthread_cond_init(&autosave->wake, NULL);
+    autosave->vfs = vfs;
+    autosave->journal = journal;
+    autosave->interval = interval;
+    autosave->dirty_bytes = dirty_bytes;
+    autosave->ok = true;
+    autosave->image_path = safe_strdup(image_path);
+    autosave->key = safe_strdup(key);
+    if (autosave->image_path == NULL || autosave->key == NULL) {
+        destroy_autosave(autosave);
+        return NULL;
+    }
+    
+    /* 先啟用併行模式再建立執行緒，之後呼叫端與背景執行緒以讀寫鎖互斥 */
+    vfs_set_concurrent(vfs, true);
+    vfs_journal_set_auto_compact(journal, false);
+    
+    /* 背景執行緒封鎖所有信號，信號處理函式（結束時儲存）只會在呼叫端執行緒執行 */
+    sigset_t all, saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    int rc = pthread_create(&autosave->thread, NULL, autosave_main, autosave);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    
+    if (rc != 0) {
+        vfs_journal_set_auto_compact(journal, true);
+        vfs_set_concurrent(vfs, false);
+        error_set(ERR_MEMORY, "無法建立自動儲存執行緒");
+        destroy_autosave(autosave);
+        return NULL;
+    }
+    
+    return autosave;
+}
+
+/**
+ * @brief 停止背景自動儲存並釋放資源
+ */
+bool vfs_autosave_stop(vfs_autosave_t *autosave) {
+    if (autosave == NULL) {
+        return true;
+    }
+    
+    pthread_mutex_lock(&autosave->lock);
+    autosave->stop = true;
+    pthread_cond_signal(&autosave->wake);
+    pthread_mutex_unlock(&autosave->lock);
+    pthread_join(autosave->thread, NULL);
+    
+    vfs_journal_set_auto_compact(autosave->journal, true);
+    vfs_set_concurrent(autosave->vfs, false);
+    
+    bool ok = autosave->ok;
+    if (!ok) {
+        error_set(ERR_IO_ERROR, "自動儲存失敗: %s", autosave->message);
+    }
+    
+    destroy_autosave(autosave);
+    return ok;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file vfs_autosave.h
+ * @brief VFS 背景自動儲存模組標頭檔
+ *
+ * 本模組以背景執行緒定期將 VFS 的變更持久化，提供：
+ * - 依時間間隔或累計變更量觸發儲存
+ * - 有日誌時：fsync 日誌，日誌過大時在背景壓縮為新快照
+ * - 無日誌時（批次模式）：以串流方式寫出完整快照
+ *
+ * 結束時只需同步上次自動儲存之後的少量變更。
+ *
+ * @note 設計考量：
+ *   - VFS 以 vfs_t 的 dirty_ops / dirty_bytes 累計自上次持久化以來的變更，
+ *     沒有變更時不做任何 I/O
+ *   - 只在寫入鎖內建立寫入時複製的快照（vfs_snapshot()），序列化與寫檔在鎖外進行，
+ *     讀取與修改命令都不必等待儲存完成；新的 image_id 與變更累計在寫入鎖內發布
+ *   - 完整快照的成本與 VFS 大小成正比，因此無日誌時只依時間間隔觸發，
+ *     變更量門檻僅用於有日誌時提早 fsync
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef VFS_AUTOSAVE_H
+#define VFS_AUTOSAVE_H
+
+#include "vfs.h"
+#include "vfs_journal.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/** @brief 預設的自動儲存間隔（秒） */
+#define VFS_AUTOSAVE_INTERVAL 30u
+
+/** @brief 預設的變更量門檻（位元組；累計超過時不等間隔立即儲存） */
+#define VFS_AUTOSAVE_DIRTY_BYTES (4u * 1024u * 1024u)
+
+/**
+ * @brief 背景自動儲存（不透明型別）
+ */
+typedef struct vfs_autosave vfs_autosave_t;
+
+/* ========================================================================
+ * 自動儲存函式
+ * ======================================================================== */
+
+/**
+ * @brief 啟動背景自動儲存
+ *
+ * 啟用 VFS 的併行模式（見 vfs_set_concurrent()）並建立背景執行緒；
+ * 之後呼叫端存取 VFS 時需持有對應的讀取鎖或寫入鎖。
+ * 有日誌時停用日誌在記錄當下的壓縮，改由背景執行緒處理。
+ *
+ * @param vfs         VFS 實例
+ * @param journal     附加在 VFS 上的日誌（NULL 表示寫出完整快照）
+ * @param image_path  映像檔路徑（無日誌時使用）
+ * @param key         加密密鑰字串（無日誌時使用）
+ * @param interval    儲存間隔（秒，需大於 0）
+ * @param dirty_bytes 變更量門檻（位元組，0 表示只依間隔）
+ * @return 自動儲存實例，失敗回傳 NULL 並設定錯誤訊息（VFS 維持非併行模式）
+ * @note 需在沒有其他執行緒使用此 VFS 時呼叫；以 vfs_autosave_stop() 停止並釋放
+ */
+vfs_autosave_t *vfs_autosave_start(vfs_t *vfs, vfs_journal_t *journal,
+                                   const char *image_path, const char *key,
+                                   unsigned interval, size_t dirty_bytes);
+
+/**
+ * @brief 停止背景自動儲存並釋放資源
+ *
+ * 等待進行中的儲存完成後結束執行緒，並將 VFS 恢復為非併行模式；
+ * 不會另外執行最後一次儲存（由呼叫端透過日誌或完整儲存處理剩餘變更）。
+ *
+ * @param autosave 自動儲存實例（可為 NULL）
+ * @return 最近一次背景儲存成功（或從未執行）回傳 true，否則回傳 false 並設定錯誤訊息
+ * @note 呼叫時不可持有 VFS 的鎖
+ */
+bool vfs_autosave_stop(vfs_autosave_t *autosave);
+
+#endif // VFS_AUTOSAVE_H
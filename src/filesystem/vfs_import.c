@@ -0,0 +1,533 @@
+/**
+ * @file vfs_import.c
+ * @brief 主機目錄匯入/匯出模組實作
+ *
+ * 以深度優先走訪來源目錄樹，目錄在走訪時立即建立，檔案則排入批次。
+ * 批次滿了（或走訪結束）時分兩個階段處理：
+ * 1. 平行階段：執行緒池的工作執行緒各自讀寫一個主機檔案，只存取該項目的緩衝區
+ * 2. 寫入階段：呼叫端執行緒依走訪順序將結果插入 VFS（匯入）或彙整結果（匯出）
+ *
+ * 工作執行緒不修改 VFS，也不設定錯誤訊息，錯誤以 errno 值記錄在項目中，
+ * 由寫入階段轉為錯誤訊息。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 lstat） */
+
+#include "vfs_import.h"
+#include "fileops.h"
+#include "../security/sanitize.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include "../utils/threadpool.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/**
+ * @brief 批次中的一個檔案
+ */
+typedef struct {
+    char *host_path;               /**< 主機檔案路徑 */
+    char *vfs_path;                /**< VFS 檔案路徑（僅匯入使用） */
+    void *data;                    /**< 匯入：新配置的內容區塊；匯出：借用的檔案內容 */
+    size_t size;                   /**< 內容大小 */
+    int err;                       /**< 平行階段的結果（0 成功，否則為 errno 值） */
+} transfer_item_t;
+
+/**
+ * @brief 待處理的檔案批次
+ */
+typedef struct {
+    vfs_t *vfs;                    /**< VFS 實例 */
+    threadpool_t *pool;            /**< 平行讀寫使用的執行緒池（可為 NULL） */
+    vfs_import_stats_t *stats;     /**< 統計 */
+    size_t count;                  /**< 批次中的檔案數 */
+    size_t bytes;                  /**< 批次中的內容總大小 */
+    transfer_item_t items[VFS_IMPORT_BATCH_FILES]; /**< 批次中的檔案（依走訪順序） */
+} transfer_batch_t;
+
+/* ========================================================================
+ * 內部輔助函式
+ * ======================================================================== */
+
+/**
+ * @brief 連接目錄與名稱為新路徑
+ * @return 新配置的路徑字串，失敗回傳 NULL
+ */
+static char *join_path(const char *dir, const char *name) {
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    bool need_slash = (dir_len == 0 || dir[dir_len - 1] != '/');
+    
+    char *path = (char *)safe_malloc(dir_len + need_slash + name_len + 1);
+    if (path == NULL) {
+        return NULL;
+    }
+    
+    memcpy(path, dir, dir_len);
+    if (need_slash) {
+        path[dir_len] = '/';
+    }
+    memcpy(path + dir_len + need_slash, name, name_len + 1);
+    return path;
+}
+
+/**
+ * @brief 建立批次（含執行緒池）
+ * @return 批次指標，失敗回傳 NULL
+ */
+static transfer_batch_t *batch_create(vfs_t *vfs, vfs_import_stats_t *stats) {
+    transfer_batch_t *batch = (transfer_batch_t *)safe_malloc(sizeof(transfer_batch_t));
+    if (batch == NULL) {
+        return NULL;
+    }
+    
+    batch->vfs = vfs;
+    batch->stats = stats;
+    
+    /* 執行緒池建立失敗時改為在呼叫端依序處理 */
+    batch->pool = threadpool_create(0);
+    return batch;
+}
+
+/**
+ * @brief 釋放批次中的項目並清空批次
+ * @param release_data 是否釋放項目的內容區塊（匯入時尚未交給 VFS 的區塊）
+ */
+static void batch_clear(transfer_batch_t *batch, bool release_data) {
+    for (size_t i = 0; i < batch->count; i++) {
+        transfer_item_t *item = &batch->items[i];
+        if (release_data) {
+            vfs_blob_release(item->data);
+        }
+        safe_free(item->host_path);
+        safe_free(item->vfs_path);
+        memset(item, 0, sizeof(*item));
+    }
+    batch->count = 0;
+    batch->bytes = 0;
+}
+
+/**
+ * @brief 銷毀批次（釋放未處理的項目）
+ */
+static void batch_destroy(transfer_batch_t *batch, bool release_data) {
+    if (batch == NULL) {
+        return;
+    }
+    batch_clear(batch, release_data);
+    threadpool_destroy(batch->pool);
+    safe_free(batch);
+}
+
+/**
+ * @brief 檢查加入 size 位元組的檔案前是否需要先處理目前的批次
+ */
+static bool batch_full(const transfer_batch_t *batch, size_t size) {
+    if (batch->count == VFS_IMPORT_BATCH_FILES) {
+        return true;
+    }
+    return batch->count > 0 && batch->bytes + size > VFS_IMPORT_BATCH_BYTES;
+}
+
+/* ========================================================================
+ * 匯入
+ * ======================================================================== */
+
+/**
+ * @brief 平行階段：將一個主機檔案讀入其內容區塊
+ */
+static void import_read_task(void *arg, size_t index) {
+    transfer_item_t *item = &((transfer_batch_t *)arg)->items[index];
+    
+    int fd = open(item->host_path, O_RDONLY);
+    if (fd < 0) {
+        item->err = errno;
+        return;
+    }
+    item->err = fileops_read_fd(fd, item->data, item->size);
+    close(fd);
+}
+
+/**
+ * @brief 處理匯入批次：平行讀取後依序插入 VFS
+ * @return 全部成功回傳 true；失敗時保留失敗項目之前已插入的檔案並回傳 false
+ */
+static bool import_flush(transfer_batch_t *batch) {
+    threadpool_parallel_for(batch->pool, batch->count, import_read_task, batch);
+    
+    bool ok = true;
+    for (size_t i = 0; ok && i < batch->count; i++) {
+        transfer_item_t *item = &batch->items[i];
+        if (item->err != 0) {
+            error_set(ERR_IO_ERROR, "讀取檔案失敗 %s: %s", item->host_path, strerror(item->err));
+            ok = false;
+            break;
+        }
+        
+        /* 目標已是檔案時取代之（排入批次時已排除目錄） */
+        if (vfs_find_node(batch->vfs, item->vfs_path) != NULL &&
+            !vfs_delete_node(batch->vfs, item->vfs_path)) {
+            ok = false;
+            break;
+        }
+        
+        /* 區塊的所有權交給 VFS（失敗時也已釋放） */
+        void *blob = item->data;
+        item->data = NULL;
+        if (vfs_create_file_blob(batch->vfs, item->vfs_path, blob, item->size) == NULL) {
+            ok = false;
+            break;
+        }
+        
+        batch->stats->files++;
+        batch->stats->bytes += item->size;
+    }
+    
+    batch_clear(batch, true);
+    return ok;
+}
+
+/**
+ * @brief 確保 VFS 目錄存在
+ * @return 成功（已存在或已建立）回傳 true；路徑被檔案佔用或建立失敗回傳 false
+ */
+static bool ensure_vfs_dir(vfs_t *vfs, const char *path) {
+    vfs_node_t *node = vfs_find_node(vfs, path);
+    if (node != NULL) {
+        if (node->type != VFS_DIR) {
+            error_set(ERR_INVALID_INPUT, "目標已存在且不是目錄: %s", path);
+            return false;
+        }
+        return true;
+    }
+    return vfs_create_dir(vfs, path) != NULL;
+}
+
+/**
+ * @brief 將一個主機檔案排入匯入批次（取得兩個路徑的所有權）
+ */
+static bool import_queue_file(transfer_batch_t *batch, char *host_path, char *vfs_path,
+                              size_t size) {
+    vfs_node_t *existing = vfs_find_node(batch->vfs, vfs_path);
+    if (existing != NULL && existing->type == VFS_DIR) {
+        batch->stats->skipped++;
+        safe_free(host_path);
+        safe_free(vfs_path);
+        return true;
+    }
+    
+    void *blob = NULL;
+    if ((batch_full(batch, size) && !import_flush(batch)) ||
+        (size > 0 && (blob = vfs_blob_create(NULL, size)) == NULL)) {
+        safe_free(host_path);
+        safe_free(vfs_path);
+        return false;
+    }
+    
+    transfer_item_t *item = &batch->items[batch->count++];
+    item->host_path = host_path;
+    item->vfs_path = vfs_path;
+    item->data = blob;
+    item->size = size;
+    batch->bytes += size;
+    return true;
+}
+
+/**
+ * @brief 遞迴匯入主機目錄的內容（目標目錄需已存在）
+ */
+static bool import_dir(transfer_batch_t *batch, const char *host_dir, const char *vfs_dir) {
+    DIR *dir = opendir(host_dir);
+    if (dir == NULL) {
+        error_set(ERR_IO_ERROR, "無法開啟目錄 %s: %s", host_dir, strerror(errno));
+        return false;
+    }
+    
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        
+        char *host_path = join_path(host_dir, entry->d_name);
+        char *vfs_path = join_path(vfs_dir, entry->d_name);
+        if (host_path == NULL || vfs_path == NULL) {
+            safe_free(host_path);
+            safe_free(vfs_path);
+            ok = false;
+            break;
+        }
+        
+        /* 不跟隨符號連結，只處理一般檔案與目錄 */
+        struct stat st;
+        if (lstat(host_path, &st) != 0) {
+            error_set(ERR_IO_ERROR, "無法讀取檔案資訊 %s: %s", host_path, strerror(errno));
+            ok = false;
+        } else if (S_ISREG(st.st_mode)) {
+            /* 路徑的所有權交給批次 */
+            ok = import_queue_file(batch, host_path, vfs_path, (size_t)st.st_size);
+            continue;
+        } else if (S_ISDIR(st.st_mode)) {
+            ok = ensure_vfs_dir(batch->vfs, vfs_path);
+            if (ok) {
+                batch->stats->dirs++;
+                ok = import_dir(batch, host_path, vfs_path);
+            } else if (vfs_find_node(batch->vfs, vfs_path) != NULL) {
+                /* 目標被同名檔案佔用：略過整個子目錄 */
+                error_clear();
+                batch->stats->skipped++;
+                ok = true;
+            }
+        } else {
+            batch->stats->skipped++;
+        }
+        
+        safe_free(host_path);
+        safe_free(vfs_path);
+    }
+    
+    closedir(dir);
+    return ok;
+}
+
+/* ========================================================================
+ * 匯出
+ * ======================================================================== */
+
+/**
+ * @brief 平行階段：將一個檔案的內容寫入主機檔案
+ */
+static void export_write_task(void *arg, size_t index) {
+    transfer_item_t *item = &((transfer_batch_t *)arg)->items[index];
+    
+    int fd = open(item->host_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        item->err = errno;
+        return;
+    }
+    item->err = fileops_write_fd(fd, item->data, item->size);
+    if (close(fd) != 0 && item->err == 0) {
+        item->err = errno;
+    }
+}
+
+/**
+ * @brief 處理匯出批次：平行寫出後彙整結果
+ * @return 全部成功回傳 true，否則回傳 false 並以第一個失敗的項目設定錯誤訊息
+ */
+static bool export_flush(transfer_batch_t *batch) {
+    threadpool_parallel_for(batch->pool, batch->count, export_write_task, batch);
+    
+    bool ok = true;
+    for (size_t i = 0; i < batch->count; i++) {
+        transfer_item_t *item = &batch->items[i];
+        if (item->err != 0) {
+            if (ok) {
+                error_set(ERR_IO_ERROR, "寫入檔案失敗 %s: %s", item->host_path, strerror(item->err));
+            }
+            ok = false;
+            continue;
+        }
+        batch->stats->files++;
+        batch->stats->bytes += item->size;
+    }
+    
+    /* 匯出的內容是借用的檢視，不釋放 */
+    batch_clear(batch, false);
+    return ok;
+}
+
+/**
+ * @brief 確保主機目錄存在
+ */
+static bool ensure_host_dir(const char *path) {
+    if (mkdir(path, 0755) == 0) {
+        return true;
+    }
+    
+    int err = errno;
+    struct stat st;
+    if (err == EEXIST) {
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            return true;
+        }
+        err = ENOTDIR;
+    }
+    
+    error_set(ERR_IO_ERROR, "無法建立目錄 %s: %s", path, strerror(err));
+    return false;
+}
+
+/**
+ * @brief 將一個 VFS 檔案排入匯出批次（取得 host_path 的所有權）
+ *
+ * 內容在此時（呼叫端執行緒）借用，延遲載入的內容也在此時讀入；
+ * 批次處理完成前不修改 VFS，借用的檢視保持有效。
+ */
+static bool export_queue_file(transfer_batch_t *batch, vfs_node_t *node, char *host_path) {
+    if (batch_full(batch, node->size) && !export_flush(batch)) {
+        safe_free(host_path);
+        return false;
+    }
+    
+    size_t size = 0;
+    const void *data = vfs_peek_file(node, &size);
+    if (data == NULL && size > 0) {
+        safe_free(host_path);
+        return false;
+    }
+    
+    transfer_item_t *item = &batch->items[batch->count++];
+    item->host_path = host_path;
+    item->data = (void *)data;
+    item->size = size;
+    batch->bytes += size;
+    return true;
+}
+
+/**
+ * @brief 遞迴匯出 VFS 目錄的內容（主機目錄需已存在）
+ */
+static bool export_dir(transfer_batch_t *batch, vfs_node_t *dir, const char *host_dir) {
+    vfs_dir_iter_t iter;
+    if (!vfs_dir_iter_begin(&iter, dir, false)) {
+        return false;
+    }
+    
+    vfs_node_t *child;
+    while ((child = vfs_dir_iter_next(&iter)) != NULL) {
+        char *host_path = join_path(host_dir, child->name);
+        if (host_path == NULL) {
+            return false;
+        }
+        
+        if (child->type == VFS_FILE) {
+            /* 路徑的所有權交給批次 */
+            if (!export_queue_file(batch, child, host_path)) {
+                return false;
+            }
+            continue;
+        }
+        
+        bool ok = ensure_host_dir(host_path);
+        if (ok) {
+            batch->stats->dirs++;
+            ok = export_dir(batch, child, host_path);
+        }
+        safe_free(host_path);
+        if (!ok) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/* ========================================================================
+ * 匯入/匯出函式實作
+ * ======================================================================== */
+
+bool vfs_import_tree(vfs_t *vfs, const char *host_dir, const char *vfs_dir,
+                     vfs_import_stats_t *stats) {
+    vfs_import_stats_t local = {0, 0, 0, 0};
+    if (stats == NULL) {
+        stats = &local;
+    }
+    memset(stats, 0, sizeof(*stats));
+    
+    if (vfs == NULL || host_dir == NULL || vfs_dir == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    /* 安全性檢查：路徑遍歷攻擊 */
+    if (is_path_traversal(host_dir)) {
+        return false;
+    }
+    
+    struct stat st;
+    if (stat(host_dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        error_set(ERR_FILE_NOT_FOUND, "主機目錄不存在: %s", host_dir);
+        return false;
+    }
+    
+    if (!ensure_vfs_dir(vfs, vfs_dir)) {
+        return false;
+    }
+    stats->dirs++;
+    
+    transfer_batch_t *batch = batch_create(vfs, stats);
+    if (batch == NULL) {
+        return false;
+    }
+    
+    bool ok = import_dir(batch, host_dir, vfs_dir);
+    if (ok && batch->count > 0) {
+        ok = import_flush(batch);
+    }
+    
+    batch_destroy(batch, true);
+    return ok;
+}
+
+bool vfs_export_tree(vfs_t *vfs, const char *vfs_path, const char *host_path,
+                     vfs_import_stats_t *stats) {
+    vfs_import_stats_t local = {0, 0, 0, 0};
+    if (stats == NULL) {
+        stats = &local;
+    }
+    memset(stats, 0, sizeof(*stats));
+    
+    if (vfs == NULL || vfs_path == NULL || host_path == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return false;
+    }
+    
+    /* 安全性檢查：路徑遍歷攻擊 */
+    if (is_path_traversal(host_path)) {
+        return false;
+    }
+    
+    vfs_node_t *node = vfs_find_node(vfs, vfs_path);
+    if (node == NULL) {
+        error_set(ERR_FILE_NOT_FOUND, "路徑不存在: %s", vfs_path);
+        return false;
+    }
+    
+    transfer_batch_t *batch = batch_create(vfs, stats);
+    if (batch == NULL) {
+        return false;
+    }
+    
+    bool ok;
+    if (node->type == VFS_FILE) {
+        char *path = safe_strdup(host_path);
+        ok = (path != NULL && export_queue_file(batch, node, path));
+    } else {
+        ok = ensure_host_dir(host_path);
+        if (ok) {
+            stats->dirs++;
+            ok = export_dir(batch, node, host_path);
+        }
+    }
+    
+    /* 走訪中途失敗時，已排入批次的檔案仍寫出 */
+    if (batch->count > 0) {
+        ok = export_flush(batch) && ok;
+    }
+    
+    batch_destroy(batch, false);
+    return ok;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file vfs_import.h
+ * @brief 主機目錄匯入/匯出模組標頭檔
+ *
+ * 本模組在主機目錄樹與 VFS 之間整批搬移檔案，提供：
+ * - 匯入：遞迴走訪主機目錄，建立對應的 VFS 目錄與檔案
+ * - 匯出：遞迴走訪 VFS 目錄，寫出對應的主機目錄與檔案
+ * - 搬移統計（檔案數、目錄數、位元組數、略過的項目）
+ *
+ * @note 設計考量：
+ *   - 走訪與 VFS 的修改只在呼叫端執行緒進行（單一寫入者），
+ *     主機檔案的讀寫以批次交給執行緒池平行處理
+ *   - 每批最多 VFS_IMPORT_BATCH_FILES 個檔案、約 VFS_IMPORT_BATCH_BYTES 位元組，
+ *     同時保留在記憶體中的內容有上限
+ *   - 檔案內容直接在主機檔案與 VFS 內容區塊之間傳輸，不經過中間緩衝區
+ *   - 匯入時已存在的檔案會被取代、已存在的目錄會合併；
+ *     符號連結與特殊檔案（裝置、FIFO、socket）一律略過，不跟隨
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef VFS_IMPORT_H
+#define VFS_IMPORT_H
+
+#include "vfs.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/** @brief 每批平行讀寫的最多檔案數 */
+#define VFS_IMPORT_BATCH_FILES 256
+
+/** @brief 每批平行讀寫的內容大小上限（位元組；單一較大的檔案自成一批） */
+#define VFS_IMPORT_BATCH_BYTES (32u * 1024u * 1024u)
+
+/**
+ * @brief 匯入/匯出統計
+ */
+typedef struct {
+    size_t files;                  /**< 搬移的檔案數 */
+    size_t dirs;                   /**< 建立或合併的目錄數（含目標目錄） */
+    size_t bytes;                  /**< 搬移的檔案內容位元組數 */
+    size_t skipped;                /**< 略過的項目數（符號連結、特殊檔案、類型衝突） */
+} vfs_import_stats_t;
+
+/* ========================================================================
+ * 匯入/匯出函式
+ * ======================================================================== */
+
+/**
+ * @brief 將主機目錄樹匯入 VFS
+ *
+ * @param vfs      VFS 實例
+ * @param host_dir 主機上的來源目錄
+ * @param vfs_dir  VFS 中的目標目錄（絕對路徑，不存在時建立）
+ * @param stats    輸出參數，匯入統計（可為 NULL；失敗時為已完成的部分）
+ * @return 全部匯入成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ *         （失敗前已匯入的項目保留在 VFS 中）
+ */
+bool vfs_import_tree(vfs_t *vfs, const char *host_dir, const char *vfs_dir,
+                     vfs_import_stats_t *stats);
+
+/**
+ * @brief 將 VFS 目錄樹匯出到主機
+ *
+ * 來源為檔案時，host_path 即為輸出的主機檔案路徑。
+ * 主機上已存在的同名檔案會被覆寫，已存在的目錄會合併。
+ *
+ * @param vfs       VFS 實例
+ * @param vfs_path  VFS 中的來源目錄或檔案（絕對路徑）
+ * @param host_path 主機上的目標目錄（不存在時建立）或檔案路徑
+ * @param stats     輸出參數，匯出統計（可為 NULL；失敗時為已完成的部分）
+ * @return 全部匯出成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool vfs_export_tree(vfs_t *vfs, const char *vfs_path, const char *host_path,
+                     vfs_import_stats_t *stats);
+
+#endif // VFS_IMPORT_H
@@ -0,0 +1,900 @@
+/**
+ * @file vfs_journal.c
+ * @brief VFS 預寫日誌模組實作
+ *
+ * 日誌檔格式：
+ * - 明文檔頭：魔數、對應的映像檔識別碼與 nonce
+ * - 檔頭之後接 journal_kdf_t（salt 與 scrypt 成本參數），密鑰以 kdf_derive() 衍生
+ * - 之後為記錄串流，串流位置自 journal_kdf_t 結尾起算
+ * - 每次重新開始日誌都使用新的隨機 nonce 與 salt（工作階段快取中已有密鑰時沿用其 salt），
+ *   不同日誌不會共用密鑰流
+ *
+ * 每筆記錄格式（little-endian 主機序）：
+ *   u32 payload_len | payload | tag[16]
+ *   payload = u32 op | i64 mtime | u32 path_len | path
+ *           | u32 path2_len | path2 | u64 data_len | data
+ * payload_len 與 payload 以 ChaCha20 加密；tag 為明文的 Poly1305 標籤，
+ * 涵蓋檔頭、journal_kdf_t 與該筆記錄的密文。一次性密鑰與映像檔相同的方式產生：
+ * 取自另一個 nonce（最後一個位元組翻轉最高位元）下以記錄編號為計數器的密鑰流。
+ *
+ * 重播時遇到長度不符或標籤錯誤的記錄（寫到一半的尾端記錄，或遭竄改）即停止。
+ * 尾端的無效記錄不會被截斷後覆寫（同一段密鑰流會被重複使用），
+ * 而是將重播後的 VFS 寫成新快照，再以新的 nonce 重新開始日誌。
+ * 舊版日誌（YUNJRNL1／YUNJRNL2）的記錄未經驗證，不再重播。
+ *
+ * 背景壓縮（vfs_journal_rebase_*()）在不持有鎖時寫出快照；建立快照的同時開始
+ * 暫存的新日誌（".next"，檔頭為新映像檔的識別碼），之後的記錄同時附加到兩份日誌，
+ * 各自以自己的 nonce 與密鑰加密。新快照與新日誌依序以 rename 生效，
+ * 載入時若新日誌尚未改名則由 vfs_journal_open() 接手。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vfs_journal.h"
+#include "vfs_persist.h"
+#include "vfs.h"
+#include "../security/chacha20.h"
+#include "../security/poly1305.h"
+#include "../security/kdf.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/** 日誌檔頭魔數 */
+#define JOURNAL_MAGIC "YUNJRNL3"
+
+/** 日誌檔名後綴 */
+#define JOURNAL_SUFFIX ".journal"
+
+/** 背景壓縮寫出的新快照與新日誌的暫存檔名後綴 */
+#define STAGED_SUFFIX ".next"
+
+/** 單筆記錄 payload 的最小長度（op + mtime + 三個長度欄位） */
+#define RECORD_MIN_PAYLOAD (4 + 8 + 4 + 4 + 8)
+
+/** 記錄驗證標籤大小（位元組） */
+#define RECORD_TAG_SIZE POLY1305_TAG_SIZE
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/**
+ * @brief 日誌明文檔頭
+ */
+typedef struct {
+    char magic[8];                         /**< JOURNAL_MAGIC */
+    uint64_t image_id;                     /**< 對應的映像檔識別碼 */
+    uint8_t nonce[12];                     /**< 記錄串流使用的 nonce */
+    uint32_t reserved;                     /**< 保留 */
+} journal_header_t;
+
+_Static_assert(sizeof(journal_header_t) == 32, "journal_header_t 必須為 32 位元組");
+
+/**
+ * @brief 日誌的密鑰衍生參數區段（緊接在檔頭之後；只含位元組，與位元組序無關）
+ */
+typedef struct {
+    uint8_t salt[KDF_SALT_SIZE];           /**< scrypt salt */
+    uint8_t log_n;                         /**< 成本參數 N 的以 2 為底對數 */
+    uint8_t r;                             /**< 區塊大小參數 */
+    uint8_t p;                             /**< 平行度參數 */
+    uint8_t reserved[13];                  /**< 保留（寫出時為 0） */
+} journal_kdf_t;
+
+_Static_assert(sizeof(journal_kdf_t) == 32, "journal_kdf_t 必須為 32 位元組");
+
+/**
+ * @brief VFS 日誌
+ */
+struct vfs_journal {
+    vfs_observer_t base;                   /**< 觀察者介面（需為第一個成員） */
+    vfs_t *vfs;                            /**< 記錄中的 VFS */
+    char *image_path;                      /**< 映像檔路徑 */
+    char *journal_path;                    /**< 日誌檔路徑 */
+    char *staged_image_path;               /**< 背景壓縮的新快照暫存路徑 */
+    char *staged_journal_path;             /**< 背景壓縮的新日誌暫存路徑 */
+    char *key_str;                         /**< 密鑰字串（壓縮時寫出新快照） */
+    FILE *file;                            /**< 以附加模式開啟的日誌檔 */
+    uint8_t key[32];                       /**< 目前日誌的加密密鑰（依日誌檔頭衍生） */
+    journal_header_t header;               /**< 目前日誌的檔頭（含 nonce；標籤涵蓋） */
+    journal_kdf_t kdf;                     /**< 目前日誌的密鑰衍生參數（標籤涵蓋） */
+    uint64_t stream_len;                   /**< 已寫入的記錄串流長度 */
+    uint64_t record_count;                 /**< 已寫入的記錄數（下一筆記錄的標籤編號） */
+    FILE *staged;                          /**< 背景壓縮中的新日誌檔（其餘時間為 NULL） */
+    journal_header_t staged_header;        /**< 新日誌的檔頭（含新映像檔的識別碼） */
+    journal_kdf_t staged_kdf;              /**< 新日誌的密鑰衍生參數 */
+    uint8_t staged_key[32];                /**< 新日誌的加密密鑰 */
+    uint64_t staged_len;                   /**< 新日誌的記錄串流長度 */
+    uint64_t staged_count;                 /**< 新日誌的記錄數 */
+    bool staged_failed;                    /**< 新日誌是否發生寫入錯誤 */
+    bool failed;                           /**< 是否發生寫入錯誤 */
+    bool auto_compact;                     /**< 超過門檻時是否在記錄當下立即壓縮 */
+};
+
+/* ========================================================================
+ * 內部輔助函式
+ * ======================================================================== */
+
+static void journal_record(vfs_observer_t *observer, vfs_op_t op, const char *path,
+                           const char *path2, const void *data, size_t size, time_t mtime);
+
+/**
+ * @brief 計算一筆記錄的驗證標籤
+ *
+ * @param key        加密密鑰
+ * @param header     日誌檔頭
+ * @param kdf        日誌的密鑰衍生參數
+ * @param index      記錄編號
+ * @param ciphertext 記錄密文（payload_len 與 payload）
+ * @param len        密文長度
+ * @param tag        輸出的標籤
+ */
+static void record_tag(const uint8_t *key, const journal_header_t *header,
+                       const journal_kdf_t *kdf, uint64_t index,
+                       const uint8_t *ciphertext, size_t len, uint8_t *tag) {
+    uint8_t mac_nonce[12];
+    uint8_t one_time[POLY1305_KEY_SIZE];
+    memcpy(mac_nonce, header->nonce, sizeof(mac_nonce));
+    mac_nonce[11] ^= 0x80;
+    memset(one_time, 0, sizeof(one_time));
+    chacha20_encrypt_at(key, mac_nonce, index * CHACHA20_BLOCK_SIZE, one_time, one_time,
+                        sizeof(one_time));
+    
+    poly1305_ctx_t ctx;
+    poly1305_init(&ctx, one_time);
+    poly1305_update(&ctx, (const uint8_t *)header, sizeof(*header));
+    poly1305_update(&ctx, (const uint8_t *)kdf, sizeof(*kdf));
+    poly1305_update(&ctx, ciphertext, len);
+    poly1305_final(&ctx, tag);
+    secure_zero(one_time, sizeof(one_time));
+}
+
+/**
+ * @brief 加密一筆記錄並附上驗證標籤
+ *
+ * @param key        加密密鑰
+ * @param header     日誌檔頭
+ * @param kdf        日誌的密鑰衍生參數
+ * @param stream_pos 記錄在串流中的位置
+ * @param index      記錄編號
+ * @param record     明文記錄（payload_len 與 payload），其後需保留 RECORD_TAG_SIZE 位元組
+ * @param cipher_len 記錄長度（不含標籤）
+ */
+static void record_seal(const uint8_t *key, const journal_header_t *header,
+                        const journal_kdf_t *kdf, uint64_t stream_pos, uint64_t index,
+                        uint8_t *record, size_t cipher_len) {
+    chacha20_encrypt_at(key, header->nonce, stream_pos, record, record, cipher_len);
+    record_tag(key, header, kdf, index, record, cipher_len, record + cipher_len);
+}
+
+/**
+ * @brief 建立新的日誌檔並寫入檔頭
+ *
+ * 每個日誌使用新的隨機 nonce，即使屬於同一映像檔也不會重複使用密鑰流。
+ *
+ * @param journal  日誌實例（提供密鑰字串）
+ * @param path     日誌檔路徑
+ * @param image_id 對應的映像檔識別碼
+ * @param header   輸出的檔頭
+ * @param kdf      輸出的密鑰衍生參數
+ * @param key      輸出的加密密鑰
+ * @return 以寫入模式開啟、位於檔頭之後的日誌檔，失敗回傳 NULL
+ */
+static FILE *journal_create(vfs_journal_t *journal, const char *path, uint64_t image_id,
+                            journal_header_t *header, journal_kdf_t *kdf, uint8_t *key) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        error_set(ERR_IO_ERROR, "無法建立日誌檔: %s", path);
+        return NULL;
+    }
+    
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, JOURNAL_MAGIC, sizeof(header->magic));
+    header->image_id = image_id;
+    vfs_persist_random(header->nonce, sizeof(header->nonce));
+    
+    /* 工作階段中剛儲存或載入過映像檔時沿用其 salt 與密鑰，不重新衍生；否則使用新的隨機 salt */
+    memset(kdf, 0, sizeof(*kdf));
+    kdf_params_t params = vfs_persist_kdf();
+    vfs_persist_random(kdf->salt, sizeof(kdf->salt));
+    if (!kdf_session_key(journal->key_str, &params, kdf->salt, key)) {
+        fclose(file);
+        remove(path);
+        return NULL;
+    }
+    kdf->log_n = params.log_n;
+    kdf->r = params.r;
+    kdf->p = params.p;
+    
+    if (fwrite(header, sizeof(*header), 1, file) != 1 ||
+        fwrite(kdf, sizeof(*kdf), 1, file) != 1 || fflush(file) != 0) {
+        fclose(file);
+        remove(path);
+        error_set(ERR_IO_ERROR, "寫入日誌檔頭失敗: %s", path);
+        return NULL;
+    }
+    return file;
+}
+
+/**
+ * @brief 重新建立空白日誌（寫入新檔頭）
+ *
+ * @param journal 日誌實例
+ * @return true 成功，false 失敗
+ */
+static bool journal_reset(vfs_journal_t *journal) {
+    if (journal->file != NULL) {
+        fclose(journal->file);
+        journal->file = NULL;
+    }
+    
+    journal_header_t header;
+    journal_kdf_t kdf;
+    FILE *file = journal_create(journal, journal->journal_path, journal->vfs->image_id,
+                                &header, &kdf, journal->key);
+    if (file == NULL) {
+        return false;
+    }
+    
+    journal->header = header;
+    journal->kdf = kdf;
+    journal->file = file;
+    journal->stream_len = 0;
+    journal->record_count = 0;
+    journal->failed = false;
+    return true;
+}
+
+/**
+ * @brief 從記錄緩衝區讀取固定長度欄位
+ */
+static bool read_field(const uint8_t *buf, size_t len, size_t *pos, void *out, size_t n) {
+    if (len - *pos < n) {
+        return false;
+    }
+    memcpy(out, buf + *pos, n);
+    *pos += n;
+    return true;
+}
+
+/**
+ * @brief 從記錄緩衝區讀取以長度為前綴的字串
+ *
+ * *out 指向緩衝區內的字串（無結尾字元），長度為 0 時設為 NULL。
+ */
+static bool read_string(const uint8_t *buf, size_t len, size_t *pos,
+                        const char **out, uint32_t *out_len) {
+    if (!read_field(buf, len, pos, out_len, sizeof(*out_len)) || len - *pos < *out_len) {
+        return false;
+    }
+    *out = (*out_len > 0) ? (const char *)(buf + *pos) : NULL;
+    *pos += *out_len;
+    return true;
+}
+
+/**
+ * @brief 套用一筆記錄到 VFS
+ *
+ * 記錄的操作在原 VFS 上都已成功執行，依序套用可得到相同狀態；
+ * 個別操作失敗時略過並繼續。
+ */
+static void apply_record(vfs_t *vfs, const uint8_t *payload, size_t len) {
+    size_t pos = 0;
+    uint32_t op = 0;
+    int64_t mtime = 0;
+    const char *path_ptr = NULL;
+    const char *path2_ptr = NULL;
+    uint32_t path_len = 0;
+    uint32_t path2_len = 0;
+    uint64_t data_len = 0;
+    
+    if (!read_field(payload, len, &pos, &op, sizeof(op)) ||
+        !read_field(payload, len, &pos, &mtime, sizeof(mtime)) ||
+        !read_string(payload, len, &pos, &path_ptr, &path_len) ||
+        !read_string(payload, len, &pos, &path2_ptr, &path2_len) ||
+        !read_field(payload, len, &pos, &data_len, sizeof(data_len)) ||
+        len - pos != data_len || path_len == 0) {
+        return;
+    }
+    const void *data = payload + pos;
+    
+    char *path = safe_strndup(path_ptr, path_len);
+    char *path2 = (path2_len > 0) ? safe_strndup(path2_ptr, path2_len) : NULL;
+    if (path == NULL || (path2_len > 0 && path2 == NULL)) {
+        safe_free(path);
+        safe_free(path2);
+        return;
+    }
+    
+    vfs_node_t *node = NULL;
+    switch ((vfs_op_t)op) {
+        case VFS_OP_CREATE_FILE:
+            node = vfs_create_file(vfs, path, data, (size_t)data_len);
+            break;
+        case VFS_OP_CREATE_DIR:
+            node = vfs_create_dir(vfs, path);
+            break;
+        case VFS_OP_WRITE:
+            node = vfs_find_node(vfs, path);
+            if (node != NULL && !vfs_write_file(node, data, (size_t)data_len)) {
+                node = NULL;
+            }
+            break;
+        case VFS_OP_PWRITE:
+            node = vfs_find_node(vfs, path);
+            if (node != NULL) {
+                uint64_t where = 0;
+                if (data_len < sizeof(where) || node->type != VFS_FILE) {
+                    node = NULL;
+                    break;
+                }
+                memcpy(&where, data, sizeof(where));
+                if (where > SIZE_MAX ||
+                    !vfs_pwrite(node, (size_t)where, (const uint8_t *)data + sizeof(where),
+                                (size_t)data_len - sizeof(where))) {
+                    node = NULL;
+                }
+            }
+            break;
+        case VFS_OP_DELETE:
+            vfs_delete_node(vfs, path);
+            break;
+        case VFS_OP_RENAME:
+            if (path2 != NULL) {
+                vfs_rename_node(vfs, path, path2);
+            }
+            break;
+        case VFS_OP_MOVE:
+            if (path2 != NULL) {
+                vfs_move_node(vfs, path, path2);
+            }
+            break;
+        default:
+            break;
+    }
+    
+    /* 還原建立與寫入操作的時間戳記 */
+    if (node != NULL && mtime != 0) {
+        node->mtime = (time_t)mtime;
+    }
+    
+    error_clear();
+    safe_free(path);
+    safe_free(path2);
+}
+
+/**
+ * @brief 重播既有日誌
+ *
+ * 日誌不存在、檔頭無效、為舊版格式或屬於其他映像檔時視為空日誌。
+ *
+ * @param journal 日誌實例
+ * @param usable  輸出參數，日誌屬於目前的映像檔且可重播
+ * @param torn    輸出參數，有效記錄之後還有無法驗證的尾端資料
+ * @return 有效記錄串流的長度；日誌無法使用時回傳 0 並將 *usable 設為 false
+ */
+static uint64_t journal_replay(vfs_journal_t *journal, bool *usable, bool *torn) {
+    *usable = false;
+    *torn = false;
+    
+    FILE *file = fopen(journal->journal_path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    journal_header_t header;
+    journal_kdf_t kdf;
+    kdf_params_t params = { 0, 0, 0 };
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0 &&
+              header.image_id == journal->vfs->image_id &&
+              fread(&kdf, sizeof(kdf), 1, file) == 1;
+    if (ok) {
+        params.log_n = kdf.log_n;
+        params.r = kdf.r;
+        params.p = kdf.p;
+        ok = kdf_params_valid(&params) &&
+             kdf_derive(journal->key_str, kdf.salt, &params, journal->key);
+    }
+    if (!ok) {
+        fclose(file);
+        return 0;
+    }
+    size_t header_len = sizeof(header) + sizeof(kdf);
+    
+    /* 讀取整段記錄串流（密文；各記錄驗證後才解密） */
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return 0;
+    }
+    long end = ftell(file);
+    if (end < (long)header_len || fseek(file, (long)header_len, SEEK_SET) != 0) {
+        fclose(file);
+        return 0;
+    }
+    size_t stream_len = (size_t)end - header_len;
+    
+    uint8_t *stream = NULL;
+    if (stream_len > 0) {
+        stream = (uint8_t *)safe_malloc(stream_len);
+        if (stream == NULL || fread(stream, 1, stream_len, file) != stream_len) {
+            safe_free(stream);
+            fclose(file);
+            return 0;
+        }
+    }
+    fclose(file);
+    
+    /* 重播時暫時移除觀察者，避免重播的操作再次寫入日誌 */
+    vfs_observer_t *observer = journal->vfs->observer;
+    journal->vfs->observer = NULL;
+    
+    size_t pos = 0;
+    uint64_t count = 0;
+    while (stream_len - pos >= sizeof(uint32_t) + RECORD_TAG_SIZE) {
+        uint32_t payload_len;
+        chacha20_encrypt_at(journal->key, header.nonce, pos, stream + pos,
+                            (uint8_t *)&payload_len, sizeof(payload_len));
+        if (payload_len < RECORD_MIN_PAYLOAD ||
+            stream_len - pos - sizeof(uint32_t) - RECORD_TAG_SIZE < (size_t)payload_len) {
+            break;
+        }
+        
+        /* 先驗證密文，通過後才解密並套用 */
+        size_t cipher_len = sizeof(uint32_t) + payload_len;
+        uint8_t tag[RECORD_TAG_SIZE];
+        record_tag(journal->key, &header, &kdf, count, stream + pos, cipher_len, tag);
+        if (!poly1305_verify(tag, stream + pos + cipher_len)) {
+            break;
+        }
+        
+        uint8_t *payload = stream + pos + sizeof(uint32_t);
+        chacha20_encrypt_at(journal->key, header.nonce, pos + sizeof(uint32_t), payload, payload,
+                            payload_len);
+        apply_record(journal->vfs, payload, payload_len);
+        pos += cipher_len + RECORD_TAG_SIZE;
+        count++;
+    }
+    
+    journal->vfs->observer = observer;
+    
+    if (stream != NULL) {
+        secure_zero(stream, stream_len);
+        safe_free(stream);
+    }
+    
+    journal->header = header;
+    journal->kdf = kdf;
+    journal->record_count = count;
+    *torn = (pos != stream_len);
+    *usable = true;
+    return pos;
+}
+
+/**
+ * @brief 接手背景壓縮中斷時留下的新日誌
+ *
+ * 新快照已改名生效、新日誌尚未改名時中斷，暫存的新日誌才是目前映像檔的日誌；
+ * 其餘情況下暫存檔都已過期，直接刪除。
+ *
+ * @param journal 日誌實例
+ */
+static void journal_recover_staged(vfs_journal_t *journal) {
+    remove(journal->staged_image_path);
+    
+    FILE *file = fopen(journal->staged_journal_path, "rb");
+    if (file == NULL) {
+        return;
+    }
+    journal_header_t header;
+    bool current = fread(&header, sizeof(header), 1, file) == 1 &&
+                   memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0 &&
+                   header.image_id == journal->vfs->image_id;
+    fclose(file);
+    
+    if (!current || rename(journal->staged_journal_path, journal->journal_path) != 0) {
+        remove(journal->staged_journal_path);
+    }
+}
+
+/**
+ * @brief 附加一筆記錄到日誌
+ *
+ * 觀察者回呼：組出記錄、加密後寫出並 fflush，
+ * 日誌超過門檻時立即壓縮為新快照。
+ */
+static void journal_record(vfs_observer_t *observer, vfs_op_t op, const char *path,
+                           const char *path2, const void *data, size_t size, time_t mtime) {
+    vfs_journal_t *journal = (vfs_journal_t *)observer;
+    bool primary = !journal->failed && journal->file != NULL;
+    bool staged = journal->staged != NULL && !journal->staged_failed;
+    if ((!primary && !staged) || path == NULL) {
+        return;
+    }
+    
+    uint32_t path_len = (uint32_t)strlen(path);
+    uint32_t path2_len = (path2 != NULL) ? (uint32_t)strlen(path2) : 0;
+    uint64_t data_len = (data != NULL) ? (uint64_t)size : 0;
+    
+    size_t payload_len = RECORD_MIN_PAYLOAD + path_len + path2_len + (size_t)data_len;
+    if (payload_len > UINT32_MAX) {
+        /* 單筆記錄無法容納，改以下次壓縮寫出完整快照 */
+        journal->failed = true;
+        journal->staged_failed = true;
+        return;
+    }
+    
+    /* 記錄寫出後即不再需要，放在執行緒的暫存區段 */
+    size_t cipher_len = sizeof(uint32_t) + payload_len;
+    size_t record_len = cipher_len + RECORD_TAG_SIZE;
+    arena_t *scratch = scratch_arena();
+    arena_mark_t mark = arena_mark(scratch);
+    uint8_t *record = (uint8_t *)arena_alloc(scratch, record_len);
+    if (record == NULL) {
+        journal->failed = true;
+        journal->staged_failed = true;
+        return;
+    }
+    
+    uint32_t u32 = (uint32_t)payload_len;
+    int64_t i64 = (int64_t)mtime;
+    size_t pos = 0;
+    memcpy(record + pos, &u32, sizeof(u32));               pos += sizeof(u32);
+    u32 = (uint32_t)op;
+    memcpy(record + pos, &u32, sizeof(u32));               pos += sizeof(u32);
+    memcpy(record + pos, &i64, sizeof(i64));               pos += sizeof(i64);
+    memcpy(record + pos, &path_len, sizeof(path_len));     pos += sizeof(path_len);
+    memcpy(record + pos, path, path_len);                  pos += path_len;
+    memcpy(record + pos, &path2_len, sizeof(path2_len));   pos += sizeof(path2_len);
+    if (path2_len > 0) {
+        memcpy(record + pos, path2, path2_len);            pos += path2_len;
+    }
+    memcpy(record + pos, &data_len, sizeof(data_len));     pos += sizeof(data_len);
+    if (data_len > 0) {
+        memcpy(record + pos, data, (size_t)data_len);      pos += (size_t)data_len;
+    }
+    
+    /* 背景壓縮期間同時附加到新日誌（密鑰與 nonce 不同，另外加密一份） */
+    if (staged) {
+        uint8_t *copy = (uint8_t *)arena_alloc(scratch, record_len);
+        if (copy == NULL) {
+            journal->staged_failed = true;
+        } else {
+            memcpy(copy, record, cipher_len);
+            record_seal(journal->staged_key, &journal->staged_header, &journal->staged_kdf,
+                        journal->staged_len, journal->staged_count, copy, cipher_len);
+            if (fwrite(copy, 1, record_len, journal->staged) != record_len ||
+                fflush(journal->staged) != 0) {
+                journal->staged_failed = true;
+            } else {
+                journal->staged_len += record_len;
+                journal->staged_count++;
+            }
+        }
+    }
+    
+    if (primary) {
+        record_seal(journal->key, &journal->header, &journal->kdf, journal->stream_len,
+                    journal->record_count, record, cipher_len);
+        if (fwrite(record, 1, record_len, journal->file) != record_len ||
+            fflush(journal->file) != 0) {
+            journal->failed = true;
+        } else {
+            journal->stream_len += record_len;
+            journal->record_count++;
+        }
+    }
+    arena_rewind(scratch, mark);
+    
+    if (journal->auto_compact && journal->stream_len >= VFS_JOURNAL_COMPACT_SIZE) {
+        vfs_journal_compact(journal);
+    }
+}
+
+/* ========================================================================
+ * 日誌生命週期函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 開啟日誌並附加到 VFS
+ */
+vfs_journal_t *vfs_journal_open(vfs_t *vfs, const char *image_path, const char *key) {
+    if (vfs == NULL || image_path == NULL || key == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    vfs_journal_t *journal = (vfs_journal_t *)safe_malloc(sizeof(vfs_journal_t));
+    if (journal == NULL) {
+        return NULL;
+    }
+    memset(journal, 0, sizeof(vfs_journal_t));
+    
+    size_t path_len = strlen(image_path);
+    journal->base.record = journal_record;
+    journal->vfs = vfs;
+    journal->auto_compact = true;
+    journal->image_path = safe_strdup(image_path);
+    journal->key_str = safe_strdup(key);
+    journal->journal_path = (char *)safe_malloc(path_len + sizeof(JOURNAL_SUFFIX));
+    journal->staged_image_path = (char *)safe_malloc(path_len + sizeof(STAGED_SUFFIX));
+    journal->staged_journal_path = (char *)safe_malloc(path_len + sizeof(JOURNAL_SUFFIX) +
+                                                       sizeof(STAGED_SUFFIX) - 1);
+    if (journal->image_path == NULL || journal->key_str == NULL || journal->journal_path == NULL ||
+        journal->staged_image_path == NULL || journal->staged_journal_path == NULL) {
+        vfs_journal_close(journal);
+        return NULL;
+    }
+    memcpy(journal->journal_path, image_path, path_len);
+    memcpy(journal->journal_path + path_len, JOURNAL_SUFFIX, sizeof(JOURNAL_SUFFIX));
+    memcpy(journal->staged_image_path, image_path, path_len);
+    memcpy(journal->staged_image_path + path_len, STAGED_SUFFIX, sizeof(STAGED_SUFFIX));
+    memcpy(journal->staged_journal_path, journal->journal_path, path_len + sizeof(JOURNAL_SUFFIX) - 1);
+    memcpy(journal->staged_journal_path + path_len + sizeof(JOURNAL_SUFFIX) - 1, STAGED_SUFFIX,
+           sizeof(STAGED_SUFFIX));
+    
+    /* 尚未對應任何映像檔時先寫出快照，作為日誌的基準 */
+    if (vfs->image_id == 0 && !vfs_save_encrypted(vfs, image_path, key)) {
+        vfs_journal_close(journal);
+        return NULL;
+    }
+    
+    journal_recover_staged(journal);
+    
+    bool usable = false;
+    bool torn = false;
+    uint64_t stream_len = journal_replay(journal, &usable, &torn);
+    
+    if (usable && torn) {
+        /* 不截斷後覆寫尾端：重播的結果寫成新快照，再以新的 nonce 重新開始日誌 */
+        if (!vfs_journal_compact(journal)) {
+            vfs_journal_close(journal);
+            return NULL;
+        }
+    } else if (usable) {
+        journal->file = fopen(journal->journal_path, "ab");
+        if (journal->file == NULL) {
+            error_set(ERR_IO_ERROR, "無法打開日誌檔: %s", journal->journal_path);
+            vfs_journal_close(journal);
+            return NULL;
+        }
+        journal->stream_len = stream_len;
+        
+        /* 重播的操作都已在日誌檔中 */
+        vfs_mark_clean(vfs);
+    } else if (!journal_reset(journal)) {
+        vfs_journal_close(journal);
+        return NULL;
+    }
+    
+    vfs->observer = &journal->base;
+    return journal;
+}
+
+/**
+ * @brief 將日誌寫入持久儲存
+ */
+bool vfs_journal_sync(vfs_journal_t *journal) {
+    if (journal == NULL || journal->file == NULL) {
+        error_set(ERR_INVALID_INPUT, "日誌未開啟");
+        return false;
+    }
+    
+    if (journal->failed || fflush(journal->file) != 0 || fsync(fileno(journal->file)) != 0) {
+        journal->failed = true;
+        error_set(ERR_IO_ERROR, "日誌寫入失敗: %s", journal->journal_path);
+        return false;
+    }
+    vfs_mark_clean(journal->vfs);
+    return true;
+}
+
+/**
+ * @brief 壓縮日誌
+ *
+ * 先以 rename 原子地寫出新快照，再重新開始日誌；
+ * 兩步之間中斷時，舊日誌的識別碼與新快照不符，載入時會被忽略。
+ */
+bool vfs_journal_compact(vfs_journal_t *journal) {
+    if (journal == NULL) {
+        error_set(ERR_INVALID_INPUT, "日誌為 NULL");
+        return false;
+    }
+    
+    if (!vfs_save_encrypted(journal->vfs, journal->image_path, journal->key_str)) {
+        return false;
+    }
+    return journal_reset(journal);
+}
+
+/**
+ * @brief 將已寫出的記錄 fsync
+ */
+bool vfs_journal_fsync(vfs_journal_t *journal) {
+    if (journal == NULL || journal->file == NULL) {
+        error_set(ERR_INVALID_INPUT, "日誌未開啟");
+        return false;
+    }
+    
+    if (fsync(fileno(journal->file)) != 0) {
+        error_set(ERR_IO_ERROR, "日誌寫入失敗: %s", journal->journal_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 開始背景壓縮：建立新日誌
+ */
+uint64_t vfs_journal_rebase_begin(vfs_journal_t *journal) {
+    if (journal == NULL || journal->staged != NULL) {
+        error_set(ERR_INVALID_INPUT, "日誌為 NULL 或已在壓縮中");
+        return 0;
+    }
+    
+    journal->staged = journal_create(journal, journal->staged_journal_path, vfs_persist_image_id(),
+                                     &journal->staged_header, &journal->staged_kdf,
+                                     journal->staged_key);
+    if (journal->staged == NULL) {
+        return 0;
+    }
+    journal->staged_len = 0;
+    journal->staged_count = 0;
+    journal->staged_failed = false;
+    return journal->staged_header.image_id;
+}
+
+/**
+ * @brief 將快照寫成暫存的新映像檔
+ *
+ * 新日誌的檔頭與檔案只在持有寫入鎖時改變，此處只讀取。
+ */
+bool vfs_journal_rebase_stage(vfs_journal_t *journal, vfs_t *snapshot) {
+    if (journal == NULL || snapshot == NULL || journal->staged == NULL) {
+        error_set(ERR_INVALID_INPUT, "沒有進行中的壓縮");
+        return false;
+    }
+    
+    if (!vfs_save_encrypted_as(snapshot, journal->staged_image_path, journal->key_str,
+                               journal->staged_header.image_id)) {
+        return false;
+    }
+    
+    /* 先 fsync 儲存期間附加的記錄，寫入鎖內只剩最後一小段 */
+    if (fsync(fileno(journal->staged)) != 0) {
+        error_set(ERR_IO_ERROR, "寫入日誌檔失敗: %s", journal->staged_journal_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 讓暫存的新映像檔生效並改用新日誌
+ *
+ * 依序：fsync 新日誌 → 新快照改名生效 → 新日誌改名生效。
+ * 新快照生效前失敗時維持原狀；之後中斷或改名失敗時，由 vfs_journal_open() 接手暫存的新日誌。
+ */
+bool vfs_journal_rebase_commit(vfs_journal_t *journal) {
+    if (journal == NULL || journal->staged == NULL) {
+        error_set(ERR_INVALID_INPUT, "沒有進行中的壓縮");
+        return false;
+    }
+    
+    bool ok = true;
+    if (journal->staged_failed || fsync(fileno(journal->staged)) != 0) {
+        error_set(ERR_IO_ERROR, "寫入日誌檔失敗: %s", journal->staged_journal_path);
+        ok = false;
+    }
+    if (ok && rename(journal->staged_image_path, journal->image_path) != 0) {
+        error_set(ERR_IO_ERROR, "無法更新映像檔: %s", journal->image_path);
+        ok = false;
+    }
+    if (!ok) {
+        vfs_journal_rebase_abort(journal);
+        return false;
+    }
+    
+    /* 新快照已生效，舊日誌從此作廢 */
+    if (journal->file != NULL) {
+        fclose(journal->file);
+    }
+    journal->file = journal->staged;
+    journal->staged = NULL;
+    journal->header = journal->staged_header;
+    journal->kdf = journal->staged_kdf;
+    memcpy(journal->key, journal->staged_key, sizeof(journal->key));
+    secure_zero(journal->staged_key, sizeof(journal->staged_key));
+    journal->stream_len = journal->staged_len;
+    journal->record_count = journal->staged_count;
+    journal->failed = false;
+    
+    if (rename(journal->staged_journal_path, journal->journal_path) != 0) {
+        /* 停用新日誌：下次壓縮寫出完整快照，中斷時由 vfs_journal_open() 接手暫存檔 */
+        fclose(journal->file);
+        journal->file = NULL;
+        journal->failed = true;
+    }
+    return true;
+}
+
+/**
+ * @brief 放棄背景壓縮
+ */
+void vfs_journal_rebase_abort(vfs_journal_t *journal) {
+    if (journal == NULL) {
+        return;
+    }
+    
+    if (journal->staged != NULL) {
+        fclose(journal->staged);
+        journal->staged = NULL;
+    }
+    remove(journal->staged_journal_path);
+    remove(journal->staged_image_path);
+    secure_zero(journal->staged_key, sizeof(journal->staged_key));
+}
+
+/**
+ * @brief 設定是否在記錄當下壓縮
+ */
+void vfs_journal_set_auto_compact(vfs_journal_t *journal, bool enabled) {
+    if (journal != NULL) {
+        journal->auto_compact = enabled;
+    }
+}
+
+/**
+ * @brief 檢查日誌是否需要壓縮
+ */
+bool vfs_journal_needs_compaction(const vfs_journal_t *journal) {
+    if (journal == NULL) {
+        return false;
+    }
+    return journal->failed || journal->file == NULL ||
+           journal->stream_len >= VFS_JOURNAL_COMPACT_SIZE;
+}
+
+/**
+ * @brief 關閉日誌
+ */
+bool vfs_journal_close(vfs_journal_t *journal) {
+    if (journal == NULL) {
+        return true;
+    }
+    
+    bool ok = true;
+    if (journal->vfs != NULL && journal->vfs->observer == &journal->base) {
+        journal->vfs->observer = NULL;
+        if (vfs_journal_needs_compaction(journal)) {
+            ok = vfs_journal_compact(journal);
+        } else {
+            ok = vfs_journal_sync(journal);
+        }
+    }
+    
+    if (journal->file != NULL) {
+        fclose(journal->file);
+    }
+    if (journal->staged != NULL) {
+        vfs_journal_rebase_abort(journal);
+    }
+    safe_free(journal->image_path);
+    safe_free(journal->journal_path);
+    safe_free(journal->staged_image_path);
+    safe_free(journal->staged_journal_path);
+    if (journal->key_str != NULL) {
+        secure_zero(journal->key_str, strlen(journal->key_str));
+        safe_free(journal->key_str);
+    }
+    secure_zero(journal, sizeof(vfs_journal_t));
+    safe_free(journal);
+    return ok;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file vfs_journal.h
+ * @brief VFS 預寫日誌（write-ahead journal）模組標頭檔
+ *
+ * 本模組在映像檔旁維護一份僅附加（append-only）的加密日誌，提供：
+ * - 即時記錄 VFS 的變更操作（建立、寫入、刪除、重新命名、移動）
+ * - 載入映像檔後重播日誌，還原上次未寫入映像檔的變更
+ * - 日誌超過門檻時壓縮為新的映像檔快照
+ *
+ * 儲存成本因此與變更量成正比，而非整個檔案系統的大小；
+ * 程式異常結束時，已記錄的操作也不會遺失。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef VFS_JOURNAL_H
+#define VFS_JOURNAL_H
+
+#include "vfs.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/**
+ * @brief 日誌超過此大小時壓縮為新的映像檔快照（位元組）
+ */
+#define VFS_JOURNAL_COMPACT_SIZE (8u * 1024u * 1024u)
+
+/**
+ * @brief VFS 日誌（不透明型別）
+ */
+typedef struct vfs_journal vfs_journal_t;
+
+/* ========================================================================
+ * 日誌生命週期函式
+ * ======================================================================== */
+
+/**
+ * @brief 開啟日誌並附加到 VFS
+ *
+ * 若日誌檔屬於目前載入的映像檔，先重播其中的操作；
+ * 之後的變更操作會即時附加到日誌。VFS 尚未對應任何映像檔時，
+ * 會先寫出一份快照作為日誌的基準。
+ *
+ * @param vfs        VFS 實例
+ * @param image_path 映像檔路徑（日誌檔為 image_path 加上 ".journal"）
+ * @param key        加密密鑰字串
+ * @return 日誌實例，失敗回傳 NULL（VFS 維持不變，可改用完整儲存）
+ */
+vfs_journal_t *vfs_journal_open(vfs_t *vfs, const char *image_path, const char *key);
+
+/**
+ * @brief 將日誌寫入持久儲存（fsync）
+ *
+ * @param journal 日誌實例
+ * @return true 成功，false 失敗或日誌先前已寫入失敗
+ */
+bool vfs_journal_sync(vfs_journal_t *journal);
+
+/**
+ * @brief 壓縮日誌
+ *
+ * 將目前的 VFS 寫成新的映像檔快照，並以新快照為基準重新開始日誌。
+ *
+ * @param journal 日誌實例
+ * @return true 成功，false 失敗
+ */
+bool vfs_journal_compact(vfs_journal_t *journal);
+
+/* ========================================================================
+ * 背景壓縮
+ *
+ * 背景執行緒分三步壓縮，只有首尾兩步需要持有 VFS 的寫入鎖：
+ *   1. 持有寫入鎖：vfs_snapshot() 並以 vfs_journal_rebase_begin() 開始新日誌
+ *   2. 不持有鎖：vfs_journal_rebase_stage() 將快照寫成暫存的新映像檔
+ *   3. 持有寫入鎖：vfs_journal_rebase_commit() 讓新快照生效並改用新日誌；
+ *      第二步失敗時改呼叫 vfs_journal_rebase_abort()
+ * 第一步之後的記錄同時附加到目前的日誌與新日誌，期間中斷時目前的日誌仍完整。
+ * ======================================================================== */
+
+/**
+ * @brief 將已寫出的記錄寫入持久儲存（fsync）
+ *
+ * 與 vfs_journal_sync() 不同，不檢查也不修改日誌與 VFS 的狀態，
+ * 負責壓縮的背景執行緒可在不持有 VFS 鎖時呼叫。
+ *
+ * @param journal 日誌實例
+ * @return true 成功，false 失敗
+ */
+bool vfs_journal_fsync(vfs_journal_t *journal);
+
+/**
+ * @brief 開始背景壓縮：建立暫存的新日誌
+ *
+ * @param journal 日誌實例
+ * @return 新映像檔的識別碼，失敗回傳 0
+ * @note 呼叫端需持有 VFS 的寫入鎖，並在同一次鎖內建立快照
+ */
+uint64_t vfs_journal_rebase_begin(vfs_journal_t *journal);
+
+/**
+ * @brief 將快照寫成暫存的新映像檔（image_path 加上 ".next"）
+ *
+ * @param journal  日誌實例
+ * @param snapshot vfs_snapshot() 建立的快照（成功時 image_id 為新映像檔的識別碼）
+ * @return true 成功，false 失敗
+ * @note 不需持有 VFS 的鎖
+ */
+bool vfs_journal_rebase_stage(vfs_journal_t *journal, vfs_t *snapshot);
+
+/**
+ * @brief 讓暫存的新映像檔生效並改用新日誌
+ *
+ * 成功後呼叫端需將 VFS 的 image_id 更新為快照的 image_id。
+ *
+ * @param journal 日誌實例
+ * @return true 新映像檔已生效，false 失敗（已放棄壓縮，映像檔與日誌維持原狀）
+ * @note 呼叫端需持有 VFS 的寫入鎖
+ */
+bool vfs_journal_rebase_commit(vfs_journal_t *journal);
+
+/**
+ * @brief 放棄背景壓縮，刪除暫存的新映像檔與新日誌
+ *
+ * @param journal 日誌實例（可為 NULL）
+ * @note 呼叫端需持有 VFS 的寫入鎖
+ */
+void vfs_journal_rebase_abort(vfs_journal_t *journal);
+
+/**
+ * @brief 設定日誌超過門檻時是否在記錄當下立即壓縮
+ *
+ * 預設啟用。由背景執行緒負責壓縮時停用，變更操作不會因
+ * 寫出完整快照而停頓；日誌會持續附加，直到背景執行緒以
+ * vfs_journal_rebase_commit() 改用新日誌。
+ *
+ * @param journal 日誌實例（可為 NULL）
+ * @param enabled true 啟用
+ */
+void vfs_journal_set_auto_compact(vfs_journal_t *journal, bool enabled);
+
+/**
+ * @brief 檢查日誌是否需要壓縮
+ *
+ * 日誌超過 VFS_JOURNAL_COMPACT_SIZE 或先前寫入失敗時需要壓縮。
+ *
+ * @param journal 日誌實例
+ * @return true 需要壓縮
+ */
+bool vfs_journal_needs_compaction(const vfs_journal_t *journal);
+
+/**
+ * @brief 關閉日誌
+ *
+ * 將日誌從 VFS 移除並寫入持久儲存；必要時先壓縮。
+ *
+ * @param journal 日誌實例（可為 NULL）
+ * @return true 所有變更皆已持久化，false 失敗
+ */
+bool vfs_journal_close(vfs_journal_t *journal);
+
+#endif // VFS_JOURNAL_H
@@ -4,394 +4,2074 @@
  *
  * 實作虛擬檔案系統的序列化、加密儲存與載入功能。
  *
+ * 映像檔格式（v3）：
+ * - 明文檔頭（image_header_t，64 位元組）：魔數、版本、nonce 與各區段長度
+ * - 加密串流：先是所有檔案內容（內容區），接著是中繼資料樹（中繼資料區）
+ *
+ * 檔頭與區塊索引一律為小端序，中繼資料樹以位元組為單位編碼（與主機的位元組序、
+ * size_t / time_t 寬度皆無關），x86 與 ARM 主機可互相載入映像檔。每個節點為
+ *   type(u8) | name_len | size | mtime | ctime | 內容位置或子節點數量 | 名稱
+ * 除 type 外的整數欄位皆為 LEB128 varint（時間戳記先以 zigzag 轉為無號數），
+ * 名稱放在最後，固定欄位最多 NODE_HEADER_MAX 位元組，解碼時一次檢查邊界即可。
+ * v2 映像檔（中繼資料依主機 ABI 寫入原生寬度的整數）仍可載入。
+ *
+ * 中繼資料中的檔案節點只記錄內容在串流中的位置，載入時僅重建節點，
+ * 檔案內容於首次存取時才從映像檔讀取並解密（ChaCha20 可依區塊計數器隨機存取）。
+ * 映像檔以唯讀 mmap 對應，內容直接從對應區解密到目的緩衝區，無法對應時改用 pread。
+ * 舊版 v1 映像檔（整份加密、內容內嵌）仍可載入。
+ *
+ * 壓縮映像檔（檔頭旗標 VFS_IMAGE_FLAG_LZ）：
+ * - 串流（內容區加中繼資料區）切成 PERSIST_BLOCK_SIZE 的區塊，各自以 LZ 壓縮後依序存放，
+ *   壓縮後沒有變小的區塊存放原始資料；之後加密的方式與未壓縮時相同
+ * - 區塊資料之後為區塊索引：每個區塊壓縮後的長度（u32），同樣加密
+ * - 節點記錄的內容位置仍是壓縮前的串流位置，讀取時解壓縮涵蓋的區塊
+ *
+ * 區塊驗證標籤（檔頭旗標 VFS_IMAGE_FLAG_TAGS）：
+ * - 每次儲存使用隨機 nonce；串流以壓縮前 PERSIST_BLOCK_SIZE 的區塊為驗證單位
+ *   （壓縮時即每個壓縮區塊），對各單位的密文計算 Poly1305 標籤
+ * - 所有標籤以明文接在檔案最後，再加上一個總標籤，涵蓋檔頭、區塊索引密文與所有單位的標籤
+ * - 一次性的 Poly1305 密鑰取自另一個 nonce（最後一個位元組翻轉最高位元）下
+ *   以單位編號為計數器的 ChaCha20 密鑰流，與加密用的密鑰流不重疊
+ * - 載入時只驗證總標籤；各單位在首次讀取時才驗證，通過後不再重複驗證，
+ *   延遲載入與平行讀取不受影響
+ * - v3 映像檔必須有此旗標；沒有標籤的只接受舊版 v2 映像檔
+ *
+ * 密鑰衍生（檔頭旗標 VFS_IMAGE_FLAG_KDF）：
+ * - 檔頭之後接 image_kdf_t（salt 與 scrypt 成本參數），加密串流由其後開始
+ * - 密鑰以 kdf_derive() 衍生並留在工作階段快取中；同一工作階段的自動儲存
+ *   沿用相同的 salt，不重新衍生。總標籤同時涵蓋此區段
+ * - 沒有此旗標的舊映像檔仍以 chacha20_derive_key() 衍生密鑰
+ *
  * @author Yun
  * @date 2025
  */
 
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 pread） */
+
 #include "vfs_persist.h"
 #include "vfs.h"
 #include "../security/chacha20.h"
+#include "../security/poly1305.h"
+#include "../security/kdf.h"
 #include "../utils/memory.h"
 #include "../utils/error.h"
+#include "../utils/threadpool.h"
+#include "../utils/lzblock.h"
+#include "../utils/trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-/** 檔案格式魔數，用於識別有效的 VFS 檔案 */
+/** v1 檔案格式魔數（位於加密資料開頭） */
 #define VFS_MAGIC "YUNVFS01"
 
+/** v1 檔案格式版本號 */
+#define VFS_VERSION_V1 1
+
+/** 映像檔明文檔頭魔數（v2 起） */
+#define VFS_IMAGE_MAGIC "YUNVFS02"
+
+/** 中繼資料區魔數，用於驗證密鑰 */
+#define VFS_META_MAGIC "YUNVMETA"
+
 /** 檔案格式版本號 */
-#define VFS_VERSION 1
+#define VFS_VERSION 3
+
+/** 中繼資料依主機 ABI 寫入的檔案格式版本號 */
+#define VFS_VERSION_V2 2
+
+/** 64 位元 varint 的最大長度（位元組） */
+#define VARINT_MAX 10
+
+/** v3 節點固定欄位（type 加上五個 varint）的最大長度 */
+#define NODE_HEADER_MAX (1 + 5 * VARINT_MAX)
+
+/** 串流儲存的區塊大小（需為 ChaCha20 區塊大小 64 的倍數，並足以分給多個執行緒加密） */
+#define PERSIST_CHUNK_SIZE (1024 * 1024)
+
+/** 壓縮映像檔中每個壓縮區塊的大小（壓縮前；PERSIST_CHUNK_SIZE 需為其倍數） */
+#define PERSIST_BLOCK_SIZE (64 * 1024)
+
+/** 每個串流區塊包含的壓縮區塊數 */
+#define PERSIST_CHUNK_BLOCKS (PERSIST_CHUNK_SIZE / PERSIST_BLOCK_SIZE)
+
+/** 檔頭旗標：串流以區塊壓縮 */
+#define VFS_IMAGE_FLAG_LZ 0x1u
+
+/** 檔頭旗標：各驗證單位附有 Poly1305 標籤 */
+#define VFS_IMAGE_FLAG_TAGS 0x2u
+
+/** 檔頭旗標：檔頭之後接 image_kdf_t，密鑰以 scrypt 衍生 */
+#define VFS_IMAGE_FLAG_KDF 0x4u
+
+/** 驗證標籤大小（位元組） */
+#define PERSIST_TAG_SIZE POLY1305_TAG_SIZE
+
+/** 未驗證的單位達到此數量時以執行緒池平行驗證（較少時在呼叫端驗證，不佔用執行緒池） */
+#define PERSIST_VERIFY_PARALLEL_MIN (CHACHA20_PARALLEL_MIN / PERSIST_BLOCK_SIZE)
+
+/** v1 映像檔使用的固定 nonce（v2 起每次儲存使用隨機 nonce，記錄於檔頭） */
+static const uint8_t DEFAULT_NONCE[12] = {
+    'y', 'u', 'n', 'h', 'o', 'n', 'g', 'i', 's', 'b', 'e', 's'
+};
+
+/** 平行加解密的平行度設定（0 表示使用 threadpool_default_threads()） */
+static size_t g_persist_threads = 0;
+
+/** 平行加解密使用的執行緒池（首次需要時建立） */
+static threadpool_t *g_persist_pool = NULL;
+
+/** 保護 g_persist_threads 與 g_persist_pool */
+static pthread_mutex_t g_persist_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** 儲存時是否合併相同的檔案內容 */
+static bool g_persist_dedup = true;
+
+/** 儲存時是否壓縮串流 */
+static bool g_persist_compress = true;
+
+/** 儲存時使用的密鑰衍生成本參數 */
+static kdf_params_t g_persist_kdf = { KDF_DEFAULT_LOG_N, KDF_DEFAULT_R, KDF_DEFAULT_P };
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/**
+ * @brief 映像檔明文檔頭
+ */
+typedef struct {
+    char magic[8];                         /**< VFS_IMAGE_MAGIC */
+    uint32_t version;                      /**< 格式版本號 */
+    uint32_t flags;                        /**< 格式旗標（VFS_IMAGE_FLAG_*） */
+    uint8_t nonce[12];                     /**< 加密串流使用的 nonce */
+    uint32_t reserved;                     /**< 保留 */
+    uint64_t content_len;                  /**< 內容區長度 */
+    uint64_t meta_len;                     /**< 中繼資料區長度 */
+    uint64_t image_id;                     /**< 映像檔識別碼（每次儲存皆不同，供日誌比對） */
+    uint64_t stored_len;                   /**< 壓縮時區塊資料的長度（區塊索引由此開始；未壓縮時為 0） */
+} image_header_t;
+
+_Static_assert(sizeof(image_header_t) == 64, "image_header_t 必須為 64 位元組");
+
+/**
+ * @brief 密鑰衍生參數區段（緊接在檔頭之後；只含位元組，與位元組序無關）
+ */
+typedef struct {
+    uint8_t salt[KDF_SALT_SIZE];           /**< scrypt salt */
+    uint8_t log_n;                         /**< 成本參數 N 的以 2 為底對數 */
+    uint8_t r;                             /**< 區塊大小參數 */
+    uint8_t p;                             /**< 平行度參數 */
+    uint8_t reserved[13];                  /**< 保留（寫出時為 0） */
+} image_kdf_t;
+
+_Static_assert(sizeof(image_kdf_t) == 32, "image_kdf_t 必須為 32 位元組");
+
+/**
+ * @brief 串流加密寫入器
+ *
+ * 序列化資料先累積在固定大小的區塊中，區塊滿時以對應的 ChaCha20
+ * 區塊計數器就地加密並寫出，峰值記憶體與 VFS 大小無關。
+ */
+typedef struct {
+    FILE *file;                            /**< 輸出檔案 */
+    threadpool_t *pool;                    /**< 平行加密使用的執行緒池（可為 NULL） */
+    uint8_t key[32];                       /**< 衍生後的加密密鑰 */
+    uint8_t nonce[12];                     /**< nonce */
+    uint8_t chunk[PERSIST_CHUNK_SIZE];     /**< 目前區塊 */
+    size_t used;                           /**< 區塊已使用位元組數 */
+    uint64_t written;                      /**< 已寫出的密文位元組數 */
+    uint64_t consumed;                     /**< 已寫出的串流位元組數（壓縮前） */
+    uint8_t *packed;                       /**< 壓縮輸出（每個壓縮區塊一段；NULL 表示不壓縮） */
+    uint32_t packed_len[PERSIST_CHUNK_BLOCKS]; /**< 目前區塊中各壓縮區塊壓縮後的長度 */
+    uint32_t *index;                       /**< 已寫出的所有壓縮區塊長度（區塊索引） */
+    size_t index_count;                    /**< 區塊索引項數 */
+    size_t index_capacity;                 /**< 區塊索引配置容量 */
+    uint8_t *tags;                         /**< 已寫出的各驗證單位標籤 */
+    size_t tag_count;                      /**< 驗證標籤數 */
+    size_t tag_capacity;                   /**< 驗證標籤配置容量 */
+    bool failed;                           /**< 是否發生寫入錯誤 */
+} stream_writer_t;
+
+/**
+ * @brief 計算串流區塊中各驗證單位標籤的平行工作
+ */
+typedef struct {
+    stream_writer_t *writer;               /**< 串流寫入器 */
+    const uint8_t *out;                    /**< 已加密的輸出 */
+    size_t out_len;                        /**< 輸出長度 */
+} tag_job_t;
+
+/**
+ * @brief 儲存時記錄的內容位置表
+ *
+ * 內容區與中繼資料區以相同順序走訪樹狀結構，
+ * 因此中繼資料只需依序取用內容寫出時記錄的位置。
+ */
+typedef struct {
+    uint64_t *offsets;                     /**< 各檔案內容的串流位置 */
+    size_t count;                          /**< 已記錄數量 */
+    size_t capacity;                       /**< 配置容量 */
+    size_t cursor;                         /**< 中繼資料寫出時的讀取位置 */
+} extent_table_t;
+
+/**
+ * @brief 內容去重表的一項
+ *
+ * 記錄已寫入內容區的一份內容；之後內容相同的檔案直接引用同一位置。
+ * 記憶體中的內容以雜湊比對、再逐位元組確認；仍在映像檔中的延遲載入內容
+ * 以原映像檔中的位置比對（上次儲存時已去重，不必解密計算雜湊）。
+ */
+typedef struct {
+    uint64_t hash;                         /**< 內容雜湊（0 表示空槽） */
+    uint64_t offset;                       /**< 內容在串流中的位置 */
+    size_t size;                           /**< 內容大小 */
+    vfs_node_t *node;                      /**< 內容在記憶體中的來源節點（延遲載入時為 NULL） */
+    uint64_t backing_offset;               /**< 延遲載入內容在原映像檔中的位置 */
+} dedup_entry_t;
+
+/**
+ * @brief 內容去重表（開放定址雜湊表）
+ */
+typedef struct {
+    dedup_entry_t *slots;                  /**< 雜湊槽 */
+    size_t capacity;                       /**< 槽數（2 的冪次） */
+    size_t count;                          /**< 已使用的槽數 */
+} dedup_table_t;
+
+/**
+ * @brief 內容雜湊的串流計算狀態
+ *
+ * 內容可能分段儲存，各段依序餵入；結果只與內容有關，與儲存方式無關。
+ */
+typedef struct {
+    uint64_t lanes[4];                     /**< 四條獨立的累積值 */
+    uint8_t tail[32];                      /**< 未滿一個區塊的剩餘位元組 */
+    size_t tail_len;                       /**< 剩餘位元組數 */
+    uint64_t total;                        /**< 已處理的總位元組數 */
+} content_hasher_t;
+
+/**
+ * @brief 映像檔後備儲存
+ *
+ * 延遲載入的檔案內容由此讀取，VFS 銷毀時關閉檔案並清除密鑰。
+ */
+typedef struct {
+    vfs_backing_t base;                    /**< 後備儲存介面（需為第一個成員） */
+    int fd;                                /**< 映像檔描述子 */
+    const uint8_t *map;                    /**< 映像檔唯讀對應（NULL 表示使用 pread） */
+    size_t map_len;                        /**< 對應長度 */
+    uint8_t key[32];                       /**< 衍生後的加密密鑰 */
+    uint8_t nonce[12];                     /**< nonce */
+    uint64_t stream_base;                  /**< 加密串流在檔案中的起始位置 */
+    uint64_t *block_offsets;               /**< 壓縮時各區塊在加密串流中的位置（count + 1 項，NULL 表示未壓縮） */
+    size_t block_count;                    /**< 壓縮區塊數 */
+    uint64_t logical_len;                  /**< 壓縮前的串流長度 */
+    pthread_mutex_t cache_lock;            /**< 保護以下解壓縮快取 */
+    size_t cached_block;                   /**< 快取的區塊編號（SIZE_MAX 表示無） */
+    uint8_t *cache;                        /**< 最近解壓縮的區塊（小檔案多半共用同一區塊） */
+    uint8_t *tags;                         /**< 各驗證單位的標籤（NULL 表示映像檔沒有標籤） */
+    atomic_uchar *verified;                /**< 各驗證單位是否已通過驗證 */
+    size_t unit_count;                     /**< 驗證單位（壓縮前區塊）數 */
+} image_backing_t;
+
+/**
+ * @brief 平行驗證一段範圍內各驗證單位的工作
+ */
+typedef struct {
+    image_backing_t *backing;              /**< 映像檔後備儲存 */
+    size_t first;                          /**< 第一個驗證單位 */
+} verify_job_t;
+
+/**
+ * @brief v3 節點的固定欄位（名稱之前的部分）
+ */
+typedef struct {
+    uint8_t type_marker;                   /**< 節點類型加 1（0 表示 NULL 節點） */
+    uint64_t name_len;                     /**< 名稱長度 */
+    uint64_t size;                         /**< 資料大小 */
+    uint64_t mtime;                        /**< 修改時間（zigzag） */
+    uint64_t ctime;                        /**< 建立時間（zigzag） */
+    uint64_t value;                        /**< 檔案：內容位置；目錄：子節點數量 */
+} node_header_t;
+
+/**
+ * @brief 反序列化內容
+ */
+typedef struct {
+    vfs_t *vfs;                            /**< 目標 VFS */
+    const uint8_t *buffer;                 /**< 來源緩衝區 */
+    size_t buffer_size;                    /**< 緩衝區大小 */
+    uint32_t version;                      /**< 格式版本號 */
+    uint64_t content_len;                  /**< 內容區長度（v2） */
+} load_ctx_t;
 
 /* ========================================================================
  * 內部輔助函式宣告
  * ======================================================================== */
 
-static size_t serialize_node(vfs_node_t *node, uint8_t *buffer, size_t buffer_size, size_t offset);
-static vfs_node_t *deserialize_node(const uint8_t *buffer, size_t buffer_size, size_t *offset, vfs_node_t *parent);
-static size_t calculate_serialized_size(vfs_node_t *node);
+static bool serialize_node(stream_writer_t *writer, vfs_node_t *node, extent_table_t *extents);
+static bool write_contents(stream_writer_t *writer, vfs_node_t *node, extent_table_t *extents,
+                           dedup_table_t *blobs);
+static vfs_node_t *deserialize_node(load_ctx_t *ctx, size_t *offset, vfs_node_t *parent);
+static vfs_node_t *decode_node(load_ctx_t *ctx, size_t *offset, vfs_node_t *parent);
+static void writer_flush(stream_writer_t *writer);
+static void writer_put(stream_writer_t *writer, const void *data, size_t len);
+static void writer_put_backing(stream_writer_t *writer, vfs_backing_t *backing,
+                               uint64_t offset, size_t len);
+static threadpool_t *persist_pool(void);
+static const uint8_t *map_image(int fd, size_t size);
+static vfs_t *load_image_v1(FILE *file, const char *key);
+static vfs_t *load_image_v2(FILE *file, const image_header_t *header, const char *key);
 
 /* ========================================================================
- * 內部輔助函式實作
+ * 可攜編碼
  * ======================================================================== */
 
 /**
- * @brief 計算節點序列化後的大小
- *
- * 遞迴計算節點及其所有子節點序列化所需的位元組數。
+ * @brief 在主機位元組序與小端序之間轉換 32 位元整數（轉換是對稱的，讀寫共用）
+ */
+static uint32_t le32(uint32_t value) {
+    uint8_t b[4];
+    memcpy(b, &value, sizeof(b));
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+           ((uint32_t)b[3] << 24);
+}
+
+/**
+ * @brief 在主機位元組序與小端序之間轉換 64 位元整數
+ */
+static uint64_t le64(uint64_t value) {
+    uint8_t b[8];
+    memcpy(b, &value, sizeof(b));
+    uint64_t result = 0;
+    for (int i = 7; i >= 0; i--) {
+        result = (result << 8) | b[i];
+    }
+    return result;
+}
+
+/**
+ * @brief 在主機位元組序與映像檔的小端序之間轉換檔頭的整數欄位
+ */
+static void header_convert(image_header_t *header) {
+    header->version = le32(header->version);
+    header->flags = le32(header->flags);
+    header->reserved = le32(header->reserved);
+    header->content_len = le64(header->content_len);
+    header->meta_len = le64(header->meta_len);
+    header->image_id = le64(header->image_id);
+    header->stored_len = le64(header->stored_len);
+}
+
+/**
+ * @brief 以小端序寫出檔頭
+ */
+static bool write_header(FILE *file, const image_header_t *header) {
+    image_header_t disk = *header;
+    header_convert(&disk);
+    return fwrite(&disk, sizeof(disk), 1, file) == 1;
+}
+
+/**
+ * @brief 將有號整數轉為無號數，絕對值小的負數也只需少量位元組
+ */
+static uint64_t zigzag_encode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (value < 0 ? UINT64_MAX : 0);
+}
+
+/**
+ * @brief zigzag_encode() 的反向轉換
+ */
+static int64_t zigzag_decode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * @brief 以 LEB128 編碼無號整數
  *
- * @param node 節點指標
- * @return 序列化所需的位元組數
+ * @param dst   輸出位置（至少 VARINT_MAX 位元組）
+ * @param value 數值
+ * @return 寫出的位元組數
  */
-static size_t calculate_serialized_size(vfs_node_t *node) {
-    if (node == NULL) {
-        return sizeof(uint32_t);  /* NULL 標記 */
+static size_t varint_encode(uint8_t *dst, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        dst[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
     }
-    
-    size_t size = sizeof(uint32_t);           /* 類型標記 */
-    size += sizeof(uint32_t);                  /* 名稱長度 */
-    size += strlen(node->name) + 1;            /* 名稱（含結尾） */
-    size += sizeof(size_t);                    /* 資料大小 */
-    size += sizeof(time_t) * 2;                /* mtime, ctime */
-    
-    if (node->type == VFS_FILE) {
-        /* 檔案：只有在有資料時才計算大小 */
-        if (node->data != NULL && node->size > 0) {
-            size += node->size;                    /* 檔案內容 */
+    dst[n++] = (uint8_t)value;
+    return n;
+}
+
+/**
+ * @brief 解碼 LEB128 無號整數（不檢查邊界）
+ *
+ * @param src   讀取位置（呼叫端確保之後至少有 VARINT_MAX 位元組可讀）
+ * @param value 輸出參數，數值
+ * @return 下一個欄位的位置，超過 VARINT_MAX 位元組仍未結束或數值超出 64 位元時回傳 NULL
+ */
+static const uint8_t *varint_decode(const uint8_t *src, uint64_t *value) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        uint8_t b = *src++;
+        // 第 10 個位元組只剩最高位元可用，其餘位元會超出 64 位元
+        if (shift == 63 && b > 1) {
+            return NULL;
         }
-    } else {
-        /* 目錄：遞迴計算子節點 */
-        size += sizeof(uint32_t);              /* 子節點數量 */
-        vfs_node_t *child = node->children;
-        while (child != NULL) {
-            size += calculate_serialized_size(child);
-            child = child->next;
+        result |= (uint64_t)(b & 0x7F) << shift;
+        if (b < 0x80) {
+            *value = result;
+            return src;
         }
     }
+    return NULL;
+}
+
+/**
+ * @brief 解碼 v3 節點的固定欄位（不檢查邊界）
+ *
+ * @param src    讀取位置（呼叫端確保之後至少有 NODE_HEADER_MAX 位元組可讀）
+ * @param header 輸出參數，固定欄位
+ * @return 固定欄位的長度，varint 損壞時回傳 0
+ */
+static size_t decode_node_header(const uint8_t *src, node_header_t *header) {
+    const uint8_t *p = src;
+    header->type_marker = *p++;
+    if (header->type_marker == 0) {
+        return 1;  /* NULL 節點 */
+    }
     
-    return size;
+    if ((p = varint_decode(p, &header->name_len)) == NULL ||
+        (p = varint_decode(p, &header->size)) == NULL ||
+        (p = varint_decode(p, &header->mtime)) == NULL ||
+        (p = varint_decode(p, &header->ctime)) == NULL ||
+        (p = varint_decode(p, &header->value)) == NULL) {
+        return 0;
+    }
+    return (size_t)(p - src);
+}
+
+/* ========================================================================
+ * 驗證標籤
+ * ======================================================================== */
+
+/**
+ * @brief 產生驗證單位的一次性 Poly1305 密鑰
+ *
+ * @param key      衍生後的加密密鑰
+ * @param nonce    映像檔 nonce
+ * @param index    驗證單位編號（總標籤使用單位數）
+ * @param one_time 輸出的 32 位元組密鑰
+ */
+static void unit_key(const uint8_t *key, const uint8_t *nonce, uint64_t index, uint8_t *one_time) {
+    uint8_t mac_nonce[12];
+    memcpy(mac_nonce, nonce, sizeof(mac_nonce));
+    mac_nonce[11] ^= 0x80;
+    memset(one_time, 0, POLY1305_KEY_SIZE);
+    chacha20_encrypt_at(key, mac_nonce, index * CHACHA20_BLOCK_SIZE, one_time, one_time,
+                        POLY1305_KEY_SIZE);
+}
+
+/**
+ * @brief 計算一個驗證單位的標籤
+ */
+static void compute_tag(const uint8_t *key, const uint8_t *nonce, uint64_t index,
+                        const uint8_t *data, size_t len, uint8_t *tag) {
+    uint8_t one_time[POLY1305_KEY_SIZE];
+    unit_key(key, nonce, index, one_time);
+    poly1305_auth(tag, data, len, one_time);
+    secure_zero(one_time, sizeof(one_time));
 }
 
 /**
- * @brief 序列化節點到緩衝區
+ * @brief 計算總標籤（涵蓋檔頭、區塊索引密文與所有單位的標籤）
  *
- * 將節點資料寫入二進位緩衝區，遞迴處理子節點。
+ * @param key       衍生後的加密密鑰
+ * @param header    映像檔檔頭（主機位元組序）
+ * @param kdf       密鑰衍生參數區段（舊映像檔為 NULL）
+ * @param index     區塊索引密文（未壓縮時為 NULL）
+ * @param index_len 區塊索引長度
+ * @param tags      各驗證單位的標籤
+ * @param count     驗證單位數
+ * @param tag       輸出的總標籤
+ */
+static void compute_table_tag(const uint8_t *key, const image_header_t *header,
+                              const image_kdf_t *kdf, const uint8_t *index, size_t index_len,
+                              const uint8_t *tags, size_t count, uint8_t *tag) {
+    image_header_t disk = *header;
+    header_convert(&disk);
+    
+    uint8_t one_time[POLY1305_KEY_SIZE];
+    unit_key(key, header->nonce, count, one_time);
+    poly1305_ctx_t ctx;
+    poly1305_init(&ctx, one_time);
+    poly1305_update(&ctx, (const uint8_t *)&disk, sizeof(disk));
+    if (kdf != NULL) {
+        poly1305_update(&ctx, (const uint8_t *)kdf, sizeof(*kdf));
+    }
+    poly1305_update(&ctx, index, index_len);
+    poly1305_update(&ctx, tags, count * PERSIST_TAG_SIZE);
+    poly1305_final(&ctx, tag);
+    secure_zero(one_time, sizeof(one_time));
+}
+
+/* ========================================================================
+ * 串流寫入
+ * ======================================================================== */
+
+/**
+ * @brief 平行迴圈工作：壓縮目前區塊中的第 index 個壓縮區塊
  *
- * @param node        節點指標
- * @param buffer      目標緩衝區
- * @param buffer_size 緩衝區大小
- * @param offset      目前寫入位置
- * @return 新的寫入位置
+ * 壓縮後沒有變小時改存原始資料，載入端以長度相等判斷。
  */
-static size_t serialize_node(vfs_node_t *node, uint8_t *buffer, size_t buffer_size, size_t offset) {
-    if (node == NULL) {
-        if (offset + sizeof(uint32_t) > buffer_size) return offset;
-        *(uint32_t *)(buffer + offset) = 0;  /* NULL 標記 */
-        return offset + sizeof(uint32_t);
+static void compress_block_task(void *arg, size_t index) {
+    stream_writer_t *writer = (stream_writer_t *)arg;
+    const uint8_t *src = writer->chunk + index * PERSIST_BLOCK_SIZE;
+    size_t len = writer->used - index * PERSIST_BLOCK_SIZE;
+    if (len > PERSIST_BLOCK_SIZE) {
+        len = PERSIST_BLOCK_SIZE;
     }
+    uint8_t *dst = writer->packed + index * lz_compress_bound(PERSIST_BLOCK_SIZE);
     
-    /* 寫入節點類型 */
-    if (offset + sizeof(uint32_t) > buffer_size) return offset;
-    /* 注意：vfs_node_type_t 目前 VFS_FILE == 0，與 NULL 標記衝突。
-     * 因此序列化時統一寫入 (type + 1)，保留 0 給 NULL。 */
-    *(uint32_t *)(buffer + offset) = (uint32_t)node->type + 1;
-    offset += sizeof(uint32_t);
+    size_t packed = lz_compress(src, len, dst, len - 1);
+    if (packed == 0) {
+        memcpy(dst, src, len);
+        packed = len;
+    }
+    writer->packed_len[index] = (uint32_t)packed;
+}
+
+/**
+ * @brief 壓縮目前區塊，結果依序併入 packed 開頭
+ *
+ * @param writer 串流寫入器
+ * @return 壓縮後的總長度，區塊索引無法擴充時回傳 0
+ */
+static size_t writer_compress(stream_writer_t *writer) {
+    size_t blocks = (writer->used + PERSIST_BLOCK_SIZE - 1) / PERSIST_BLOCK_SIZE;
     
-    /* 寫入名稱長度與名稱 */
-    uint32_t name_len = (uint32_t)strlen(node->name);
-    if (offset + sizeof(uint32_t) + name_len + 1 > buffer_size) return offset;
-    *(uint32_t *)(buffer + offset) = name_len;
-    offset += sizeof(uint32_t);
-    memcpy(buffer + offset, node->name, name_len + 1);
-    offset += name_len + 1;
+    if (writer->index_count + blocks > writer->index_capacity) {
+        size_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 256;
+        uint32_t *index = (uint32_t *)safe_realloc(writer->index, capacity * sizeof(uint32_t));
+        if (index == NULL) {
+            return 0;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
     
-    /* 寫入資料大小 */
-    if (offset + sizeof(size_t) > buffer_size) return offset;
-    *(size_t *)(buffer + offset) = node->size;
-    offset += sizeof(size_t);
+    threadpool_parallel_for(writer->pool, blocks, compress_block_task, writer);
     
-    /* 寫入時間戳記 */
-    if (offset + sizeof(time_t) * 2 > buffer_size) return offset;
-    *(time_t *)(buffer + offset) = node->mtime;
-    offset += sizeof(time_t);
-    *(time_t *)(buffer + offset) = node->ctime;
-    offset += sizeof(time_t);
+    /* 各壓縮區塊原本分開存放，依序往前搬成連續資料 */
+    size_t total = 0;
+    for (size_t i = 0; i < blocks; i++) {
+        memmove(writer->packed + total, writer->packed + i * lz_compress_bound(PERSIST_BLOCK_SIZE),
+                writer->packed_len[i]);
+        total += writer->packed_len[i];
+        writer->index[writer->index_count++] = le32(writer->packed_len[i]);
+    }
+    return total;
+}
+
+/**
+ * @brief 平行迴圈工作：計算已加密的目前區塊中第 index 個驗證單位的標籤
+ */
+static void tag_block_task(void *arg, size_t index) {
+    tag_job_t *job = (tag_job_t *)arg;
+    stream_writer_t *writer = job->writer;
     
-    if (node->type == VFS_FILE) {
-        /* 寫入檔案內容 */
-        if (node->data != NULL && node->size > 0) {
-            if (offset + node->size > buffer_size) return offset;
-            memcpy(buffer + offset, node->data, node->size);
-            offset += node->size;
+    size_t start = 0;
+    size_t len;
+    if (writer->packed != NULL) {
+        for (size_t i = 0; i < index; i++) {
+            start += writer->packed_len[i];
         }
+        len = writer->packed_len[index];
     } else {
-        /* 目錄：計算並寫入子節點數量 */
-        uint32_t child_count = 0;
-        vfs_node_t *child = node->children;
-        while (child != NULL) {
-            child_count++;
-            child = child->next;
+        start = index * PERSIST_BLOCK_SIZE;
+        len = job->out_len - start;
+        if (len > PERSIST_BLOCK_SIZE) {
+            len = PERSIST_BLOCK_SIZE;
         }
-        
-        if (offset + sizeof(uint32_t) > buffer_size) return offset;
-        *(uint32_t *)(buffer + offset) = child_count;
-        offset += sizeof(uint32_t);
-        
-        /* 遞迴序列化子節點 */
-        child = node->children;
-        while (child != NULL) {
-            offset = serialize_node(child, buffer, buffer_size, offset);
-            child = child->next;
+    }
+    
+    size_t unit = writer->tag_count + index;
+    compute_tag(writer->key, writer->nonce, unit, job->out + start, len,
+                writer->tags + unit * PERSIST_TAG_SIZE);
+}
+
+/**
+ * @brief 計算已加密的目前區塊中各驗證單位的標籤
+ *
+ * @param writer  串流寫入器
+ * @param out     已加密的輸出
+ * @param out_len 輸出長度
+ * @return true 成功，false 標籤表無法擴充
+ */
+static bool writer_tag(stream_writer_t *writer, const uint8_t *out, size_t out_len) {
+    size_t units = (writer->used + PERSIST_BLOCK_SIZE - 1) / PERSIST_BLOCK_SIZE;
+    
+    if (writer->tag_count + units > writer->tag_capacity) {
+        size_t capacity = writer->tag_capacity ? writer->tag_capacity * 2 : 256;
+        uint8_t *tags = (uint8_t *)safe_realloc(writer->tags, capacity * PERSIST_TAG_SIZE);
+        if (tags == NULL) {
+            return false;
         }
+        writer->tags = tags;
+        writer->tag_capacity = capacity;
     }
     
-    return offset;
+    tag_job_t job = {writer, out, out_len};
+    threadpool_parallel_for(writer->pool, units, tag_block_task, &job);
+    writer->tag_count += units;
+    return true;
 }
 
 /**
- * @brief 從緩衝區反序列化節點
+ * @brief 加密並寫出目前區塊
  *
- * 從二進位緩衝區讀取並重建節點結構，遞迴處理子節點。
+ * 區塊依序寫出，串流位置即為 written；區塊由執行緒池分段平行加密，
+ * 再平行計算其中各驗證單位的標籤。
+ * 壓縮時先平行壓縮各壓縮區塊，加密的是壓縮後的資料。
  *
- * @param buffer      來源緩衝區
- * @param buffer_size 緩衝區大小
- * @param offset      目前讀取位置（會被更新）
- * @param parent      父節點指標
- * @return 重建的節點，失敗回傳 NULL
+ * @param writer 串流寫入器
  */
-static vfs_node_t *deserialize_node(const uint8_t *buffer, size_t buffer_size, size_t *offset, vfs_node_t *parent) {
-    if (*offset + sizeof(uint32_t) > buffer_size) {
-        error_set(ERR_INVALID_INPUT, "反序列化時緩衝區超出範圍 (offset=%zu, buffer_size=%zu)", *offset, buffer_size);
-        return NULL;
+static void writer_flush(stream_writer_t *writer) {
+    if (writer->used == 0 || writer->failed) {
+        return;
     }
     
-    /* 讀取類型標記 */
-    uint32_t type_marker = *(uint32_t *)(buffer + *offset);
-    *offset += sizeof(uint32_t);
+    uint8_t *out = writer->chunk;
+    size_t out_len = writer->used;
+    if (writer->packed != NULL) {
+        out = writer->packed;
+        out_len = writer_compress(writer);
+        if (out_len == 0) {
+            writer->failed = true;
+            return;
+        }
+    }
     
-    if (type_marker == 0) {
-        return NULL;  /* NULL 節點 */
+    chacha20_xor_parallel(writer->pool, writer->key, writer->nonce, writer->written,
+                          out, out, out_len);
+    
+    if (!writer_tag(writer, out, out_len) ||
+        fwrite(out, 1, out_len, writer->file) != out_len) {
+        writer->failed = true;
     }
+    
+    writer->written += out_len;
+    writer->consumed += writer->used;
+    writer->used = 0;
+}
 
-    /* 反序列化時回復 type = (marker - 1) */
-    type_marker -= 1;
-    if (type_marker > (uint32_t)VFS_DIR) {
-        error_set(ERR_INVALID_INPUT, "反序列化時節點類型無效: %u", (unsigned)(type_marker + 1));
-        return NULL;
+/**
+ * @brief 將資料附加到串流
+ *
+ * @param writer 串流寫入器
+ * @param data   資料
+ * @param len    資料長度
+ */
+static void writer_put(stream_writer_t *writer, const void *data, size_t len) {
+    const uint8_t *src = (const uint8_t *)data;
+    
+    while (len > 0 && !writer->failed) {
+        size_t space = PERSIST_CHUNK_SIZE - writer->used;
+        size_t n = len < space ? len : space;
+        
+        memcpy(writer->chunk + writer->used, src, n);
+        writer->used += n;
+        src += n;
+        len -= n;
+        
+        if (writer->used == PERSIST_CHUNK_SIZE) {
+            writer_flush(writer);
+        }
     }
-    vfs_node_type_t type = (vfs_node_type_t)type_marker;
+}
+
+/**
+ * @brief 將後備儲存中的內容直接讀入串流區塊
+ *
+ * 儲存尚未載入的檔案時使用，不需先把整個檔案載入記憶體。
+ */
+static void writer_put_backing(stream_writer_t *writer, vfs_backing_t *backing,
+                               uint64_t offset, size_t len) {
+    while (len > 0 && !writer->failed) {
+        size_t space = PERSIST_CHUNK_SIZE - writer->used;
+        size_t n = len < space ? len : space;
+        
+        if (!backing->read(backing, offset, writer->chunk + writer->used, n)) {
+            writer->failed = true;
+            return;
+        }
+        writer->used += n;
+        offset += n;
+        len -= n;
+        
+        if (writer->used == PERSIST_CHUNK_SIZE) {
+            writer_flush(writer);
+        }
+    }
+}
+
+/**
+ * @brief 目前的串流寫入位置
+ */
+static uint64_t writer_position(const stream_writer_t *writer) {
+    return writer->consumed + writer->used;
+}
+
+/* ========================================================================
+ * 內容去重
+ * ======================================================================== */
+
+/** 雜湊區塊內每個 64 位元字所乘的常數 */
+#define HASH_PRIME1 0x9E3779B185EBCA87ull
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4Full
+
+/** 延遲載入內容的雜湊種子，與記憶體內容的雜湊區隔 */
+#define HASH_LAZY_SEED 0x165667B19E3779F9ull
+
+/**
+ * @brief 64 位元整數的最終混合（MurmurHash3 fmix64）
+ */
+static uint64_t hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief 將一個 32 位元組區塊併入四條累積值
+ */
+static void hasher_block(content_hasher_t *hasher, const uint8_t *block) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t word;
+        memcpy(&word, block + i * 8, sizeof(word));
+        uint64_t lane = hasher->lanes[i] + word * HASH_PRIME2;
+        lane = (lane << 31) | (lane >> 33);
+        hasher->lanes[i] = lane * HASH_PRIME1;
+    }
+}
+
+/**
+ * @brief 初始化內容雜湊
+ */
+static void hasher_init(content_hasher_t *hasher) {
+    memset(hasher, 0, sizeof(*hasher));
+    for (int i = 0; i < 4; i++) {
+        hasher->lanes[i] = HASH_PRIME1 * (uint64_t)(i + 1);
+    }
+}
+
+/**
+ * @brief 餵入一段內容
+ */
+static void hasher_update(content_hasher_t *hasher, const uint8_t *data, size_t len) {
+    hasher->total += len;
     
-    /* 讀取名稱 */
-    if (*offset + sizeof(uint32_t) > buffer_size) {
-        error_set(ERR_INVALID_INPUT, "反序列化時名稱長度欄位超出緩衝區範圍 (offset=%zu, buffer_size=%zu)", *offset, buffer_size);
-        return NULL;
+    if (hasher->tail_len > 0) {
+        size_t n = sizeof(hasher->tail) - hasher->tail_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(hasher->tail + hasher->tail_len, data, n);
+        hasher->tail_len += n;
+        data += n;
+        len -= n;
+        if (hasher->tail_len < sizeof(hasher->tail)) {
+            return;
+        }
+        hasher_block(hasher, hasher->tail);
+        hasher->tail_len = 0;
     }
-    uint32_t name_len = *(uint32_t *)(buffer + *offset);
-    *offset += sizeof(uint32_t);
     
-    if (*offset + name_len + 1 > buffer_size) {
-        error_set(ERR_INVALID_INPUT, "反序列化時名稱長度超出緩衝區範圍 (name_len=%u, offset=%zu, buffer_size=%zu)", name_len, *offset, buffer_size);
-        return NULL;
+    while (len >= sizeof(hasher->tail)) {
+        hasher_block(hasher, data);
+        data += sizeof(hasher->tail);
+        len -= sizeof(hasher->tail);
+    }
+    
+    memcpy(hasher->tail, data, len);
+    hasher->tail_len = len;
+}
+
+/**
+ * @brief 取得雜湊結果（不為 0）
+ */
+static uint64_t hasher_final(const content_hasher_t *hasher) {
+    uint64_t h = hasher->total * HASH_PRIME1;
+    for (int i = 0; i < 4; i++) {
+        h = hash_mix(h ^ hasher->lanes[i]);
+    }
+    for (size_t i = 0; i < hasher->tail_len; i++) {
+        h = (h ^ hasher->tail[i]) * HASH_PRIME2;
+    }
+    h = hash_mix(h);
+    return h != 0 ? h : 1;
+}
+
+/**
+ * @brief 取得檢視中從 pos 開始的一段連續內容
+ *
+ * @param view 非延遲載入的內容檢視
+ * @param size 內容大小
+ * @param pos  起始位置（小於 size）
+ * @param len  輸出參數，這段內容的長度
+ */
+static const uint8_t *view_span(const vfs_content_view_t *view, size_t size, size_t pos, size_t *len) {
+    if (view->extents != NULL) {
+        size_t in_chunk = pos % VFS_EXTENT_SIZE;
+        size_t n = VFS_EXTENT_SIZE - in_chunk;
+        *len = (n < size - pos) ? n : size - pos;
+        return (const uint8_t *)view->extents->chunks[pos / VFS_EXTENT_SIZE] + in_chunk;
+    }
+    *len = size - pos;
+    return (const uint8_t *)view->data + pos;
+}
+
+/**
+ * @brief 計算記憶體中內容的雜湊
+ */
+static uint64_t content_hash(const vfs_content_view_t *view, size_t size) {
+    content_hasher_t hasher;
+    hasher_init(&hasher);
+    
+    size_t pos = 0;
+    while (pos < size) {
+        size_t len;
+        const uint8_t *span = view_span(view, size, pos, &len);
+        hasher_update(&hasher, span, len);
+        pos += len;
+    }
+    return hasher_final(&hasher);
+}
+
+/**
+ * @brief 逐位元組比對兩份記憶體中的內容
+ */
+static bool content_equal(const vfs_content_view_t *a, const vfs_content_view_t *b, size_t size) {
+    size_t pos = 0;
+    while (pos < size) {
+        size_t len_a, len_b;
+        const uint8_t *span_a = view_span(a, size, pos, &len_a);
+        const uint8_t *span_b = view_span(b, size, pos, &len_b);
+        size_t n = (len_a < len_b) ? len_a : len_b;
+        if (span_a != span_b && memcmp(span_a, span_b, n) != 0) {
+            return false;
+        }
+        pos += n;
+    }
+    return true;
+}
+
+/**
+ * @brief 查詢內容相同的已寫出項目，找不到時回傳可插入的空槽
+ *
+ * @param blobs 去重表（capacity 需大於 count）
+ * @param hash  內容雜湊
+ * @param node  要寫出的節點
+ * @param view  節點的內容檢視
+ * @return 雜湊相同且內容相同的項目，或空槽（hash 為 0）
+ */
+static dedup_entry_t *dedup_probe(dedup_table_t *blobs, uint64_t hash, vfs_node_t *node,
+                                  const vfs_content_view_t *view) {
+    size_t mask = blobs->capacity - 1;
+    for (size_t i = (size_t)hash & mask; ; i = (i + 1) & mask) {
+        dedup_entry_t *entry = &blobs->slots[i];
+        if (entry->hash == 0) {
+            return entry;
+        }
+        if (entry->hash != hash || entry->size != node->size) {
+            continue;
+        }
+        if (view->lazy) {
+            if (entry->node == NULL && entry->backing_offset == node->backing_offset) {
+                return entry;
+            }
+        } else if (entry->node != NULL) {
+            vfs_content_view_t other;
+            vfs_content_view(entry->node, &other);
+            if (!other.lazy && content_equal(view, &other, node->size)) {
+                return entry;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 擴大去重表（負載超過一半時）
+ *
+ * @return true 成功，false 記憶體不足（呼叫端改為不去重）
+ */
+static bool dedup_grow(dedup_table_t *blobs) {
+    if (blobs->count * 2 < blobs->capacity) {
+        return true;
+    }
+    
+    size_t capacity = blobs->capacity ? blobs->capacity * 2 : 1024;
+    dedup_entry_t *slots = (dedup_entry_t *)safe_calloc(capacity, sizeof(dedup_entry_t));
+    if (slots == NULL) {
+        error_clear();
+        return false;
+    }
+    
+    for (size_t i = 0; i < blobs->capacity; i++) {
+        dedup_entry_t *entry = &blobs->slots[i];
+        if (entry->hash == 0) {
+            continue;
+        }
+        size_t j = (size_t)entry->hash & (capacity - 1);
+        while (slots[j].hash != 0) {
+            j = (j + 1) & (capacity - 1);
+        }
+        slots[j] = *entry;
+    }
+    
+    safe_free(blobs->slots);
+    blobs->slots = slots;
+    blobs->capacity = capacity;
+    return true;
+}
+
+/* ========================================================================
+ * 序列化
+ * ======================================================================== */
+
+/**
+ * @brief 寫出節點子樹中所有檔案內容（內容區）
+ *
+ * 啟用去重時，內容與先前寫出的檔案相同者不再寫出，直接記錄先前的位置。
+ *
+ * @param writer  串流寫入器
+ * @param node    節點指標
+ * @param extents 內容位置表（依走訪順序記錄）
+ * @param blobs   內容去重表（NULL 表示不去重）
+ * @return true 成功，false 失敗
+ */
+static bool write_contents(stream_writer_t *writer, vfs_node_t *node, extent_table_t *extents,
+                           dedup_table_t *blobs) {
+    if (node == NULL) {
+        return true;
+    }
+    
+    if (node->type == VFS_FILE) {
+        if (extents->count == extents->capacity) {
+            size_t capacity = extents->capacity ? extents->capacity * 2 : 256;
+            uint64_t *offsets = (uint64_t *)safe_realloc(extents->offsets, capacity * sizeof(uint64_t));
+            if (offsets == NULL) {
+                return false;
+            }
+            extents->offsets = offsets;
+            extents->capacity = capacity;
+        }
+        uint64_t position = writer_position(writer);
+        
+        if (node->size > 0) {
+            /* 取快照：併行模式下其他讀取者可能同時載入或合併此檔案的內容 */
+            vfs_content_view_t view;
+            vfs_content_view(node, &view);
+            
+            /* 相同內容已寫出時直接引用 */
+            dedup_entry_t *entry = NULL;
+            if (blobs != NULL && dedup_grow(blobs)) {
+                uint64_t hash = view.lazy ? hash_mix(node->backing_offset ^ HASH_LAZY_SEED) | 1
+                                          : content_hash(&view, node->size);
+                entry = dedup_probe(blobs, hash, node, &view);
+                if (entry->hash != 0) {
+                    extents->offsets[extents->count++] = entry->offset;
+                    return true;
+                }
+                entry->hash = hash;
+                entry->offset = position;
+                entry->size = node->size;
+                entry->node = view.lazy ? NULL : node;
+                entry->backing_offset = node->backing_offset;
+                blobs->count++;
+            }
+            
+            if (view.lazy) {
+                writer_put_backing(writer, node->owner->backing, node->backing_offset, node->size);
+            } else if (view.extents != NULL) {
+                /* 分段儲存：依序寫出各段 */
+                size_t rest = node->size;
+                for (size_t i = 0; i < view.extents->count && rest > 0; i++) {
+                    size_t n = (rest < VFS_EXTENT_SIZE) ? rest : VFS_EXTENT_SIZE;
+                    writer_put(writer, view.extents->chunks[i], n);
+                    rest -= n;
+                }
+            } else if (view.data != NULL) {
+                writer_put(writer, view.data, node->size);
+            }
+        }
+        extents->offsets[extents->count++] = position;
+        return !writer->failed;
+    }
+    
+    for (vfs_node_t *child = node->children; child != NULL; child = child->next) {
+        if (!write_contents(writer, child, extents, blobs)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 序列化節點中繼資料到串流（v3 編碼）
+ *
+ * 將節點資料寫入串流寫入器，遞迴處理子節點。
+ * 檔案節點只寫入內容在串流中的位置。
+ *
+ * @param writer  串流寫入器
+ * @param node    節點指標
+ * @param extents 內容位置表
+ * @return true 成功，false 寫入失敗
+ */
+static bool serialize_node(stream_writer_t *writer, vfs_node_t *node, extent_table_t *extents) {
+    if (node == NULL) {
+        uint8_t marker = 0;  /* NULL 標記 */
+        writer_put(writer, &marker, sizeof(marker));
+        return !writer->failed;
+    }
+    
+    /* 檔案記錄內容位置，目錄記錄子節點數量 */
+    uint64_t value = 0;
+    if (node->type == VFS_FILE) {
+        value = extents->offsets[extents->cursor++];
+    } else {
+        for (vfs_node_t *child = node->children; child != NULL; child = child->next) {
+            value++;
+        }
+    }
+    
+    /* 固定欄位先在堆疊上編碼，整段寫入
+     * 注意：vfs_node_type_t 目前 VFS_FILE == 0，與 NULL 標記衝突，
+     * 因此統一寫入 (type + 1)，保留 0 給 NULL。 */
+    size_t name_len = strlen(node->name);
+    uint8_t head[NODE_HEADER_MAX];
+    size_t head_len = 0;
+    head[head_len++] = (uint8_t)(node->type + 1);
+    head_len += varint_encode(head + head_len, name_len);
+    head_len += varint_encode(head + head_len, node->size);
+    head_len += varint_encode(head + head_len, zigzag_encode((int64_t)node->mtime));
+    head_len += varint_encode(head + head_len, zigzag_encode((int64_t)node->ctime));
+    head_len += varint_encode(head + head_len, value);
+    writer_put(writer, head, head_len);
+    writer_put(writer, node->name, name_len);
+    
+    /* 遞迴序列化子節點 */
+    if (node->type == VFS_DIR) {
+        for (vfs_node_t *child = node->children; child != NULL; child = child->next) {
+            if (!serialize_node(writer, child, extents)) {
+                return false;
+            }
+        }
+    }
+    
+    return !writer->failed;
+}
+
+/* ========================================================================
+ * 反序列化
+ * ======================================================================== */
+
+/**
+ * @brief 從緩衝區反序列化節點（v1 / v2 編碼）
+ *
+ * 從二進位緩衝區讀取並重建節點結構，遞迴處理子節點。
+ * v1 的檔案內容內嵌於緩衝區；v2 只記錄內容位置並標記為延遲載入。
+ * 整數欄位為寫入端主機的原生寬度與位元組序。
+ *
+ * @param ctx    反序列化內容
+ * @param offset 目前讀取位置（會被更新）
+ * @param parent 父節點指標
+ * @return 重建的節點，失敗回傳 NULL
+ */
+static vfs_node_t *deserialize_node(load_ctx_t *ctx, size_t *offset, vfs_node_t *parent) {
+    vfs_t *vfs = ctx->vfs;
+    const uint8_t *buffer = ctx->buffer;
+    size_t buffer_size = ctx->buffer_size;
+    
+    if (*offset + sizeof(uint32_t) > buffer_size) {
+        error_set(ERR_INVALID_INPUT, "反序列化時緩衝區超出範圍 (offset=%zu, buffer_size=%zu)", *offset, buffer_size);
+        return NULL;
+    }
+    
+    /* 讀取類型標記 */
+    uint32_t type_marker = *(uint32_t *)(buffer + *offset);
+    *offset += sizeof(uint32_t);
+    
+    if (type_marker == 0) {
+        return NULL;  /* NULL 節點 */
+    }
+    
+    /* 反序列化時回復 type = (marker - 1) */
+    type_marker -= 1;
+    if (type_marker > (uint32_t)VFS_DIR) {
+        error_set(ERR_INVALID_INPUT, "反序列化時節點類型無效: %u", (unsigned)(type_marker + 1));
+        return NULL;
+    }
+    vfs_node_type_t type = (vfs_node_type_t)type_marker;
+    
+    /* 讀取名稱 */
+    if (*offset + sizeof(uint32_t) > buffer_size) {
+        error_set(ERR_INVALID_INPUT, "反序列化時名稱長度欄位超出緩衝區範圍 (offset=%zu, buffer_size=%zu)", *offset, buffer_size);
+        return NULL;
+    }
+    uint32_t name_len = *(uint32_t *)(buffer + *offset);
+    *offset += sizeof(uint32_t);
+    
+    if (*offset + name_len + 1 > buffer_size) {
+        error_set(ERR_INVALID_INPUT, "反序列化時名稱長度超出緩衝區範圍 (name_len=%u, offset=%zu, buffer_size=%zu)", name_len, *offset, buffer_size);
+        return NULL;
+    }
+    
+    /* 從節點配置池建立節點（名稱直接取自緩衝區） */
+    vfs_node_t *node = vfs_node_alloc(vfs, (const char *)(buffer + *offset), name_len, type);
+    if (node == NULL) {
+        error_set(ERR_MEMORY, "無法配置記憶體來建立節點");
+        return NULL;
+    }
+    *offset += name_len + 1;
+    node->parent = parent;
+    
+    /* 讀取大小 */
+    if (*offset + sizeof(size_t) > buffer_size) {
+        vfs_node_free(vfs, node);
+        error_set(ERR_INVALID_INPUT, "反序列化時大小欄位超出緩衝區範圍");
+        return NULL;
+    }
+    size_t size = *(size_t *)(buffer + *offset);
+    *offset += sizeof(size_t);
+    
+    /* 讀取時間戳記 */
+    if (*offset + sizeof(time_t) * 2 > buffer_size) {
+        vfs_node_free(vfs, node);
+        error_set(ERR_INVALID_INPUT, "反序列化時時間戳記超出緩衝區範圍");
+        return NULL;
+    }
+    node->mtime = *(time_t *)(buffer + *offset);
+    *offset += sizeof(time_t);
+    node->ctime = *(time_t *)(buffer + *offset);
+    *offset += sizeof(time_t);
+    
+    if (type == VFS_FILE && ctx->version >= VFS_VERSION_V2) {
+        /* 讀取內容位置，內容留在映像檔中延遲載入 */
+        if (*offset + sizeof(uint64_t) > buffer_size) {
+            vfs_node_free(vfs, node);
+            error_set(ERR_INVALID_INPUT, "反序列化時內容位置欄位超出緩衝區範圍");
+            return NULL;
+        }
+        uint64_t extent_offset = *(uint64_t *)(buffer + *offset);
+        *offset += sizeof(uint64_t);
+        
+        if ((uint64_t)size > ctx->content_len || extent_offset > ctx->content_len - size) {
+            vfs_node_free(vfs, node);
+            error_set(ERR_INVALID_INPUT, "反序列化時檔案內容超出內容區範圍 (size=%zu, offset=%llu)",
+                      size, (unsigned long long)extent_offset);
+            return NULL;
+        }
+        
+        node->size = size;
+        if (size > 0) {
+            node->flags |= VFS_NODE_LAZY;
+            node->backing_offset = extent_offset;
+        }
+    } else if (type == VFS_FILE) {
+        /* v1：讀取內嵌的檔案內容 */
+        if (size > 0) {
+            if (*offset + size > buffer_size) {
+                vfs_node_free(vfs, node);
+                error_set(ERR_INVALID_INPUT, "反序列化時檔案內容超出緩衝區範圍 (size=%zu, offset=%zu, buffer_size=%zu)", size, *offset, buffer_size);
+                return NULL;
+            }
+            node->data = vfs_blob_create(buffer + *offset, size);
+            if (node->data == NULL) {
+                vfs_node_free(vfs, node);
+                error_set(ERR_MEMORY, "無法配置記憶體來讀取檔案內容");
+                return NULL;
+            }
+            node->size = size;
+            *offset += size;
+        }
+    } else {
+        node->size = size;
+        
+        /* 讀取子節點 */
+        if (*offset + sizeof(uint32_t) > buffer_size) {
+            vfs_node_free(vfs, node);
+            error_set(ERR_INVALID_INPUT, "反序列化時子節點數量超出緩衝區範圍");
+            return NULL;
+        }
+        uint32_t child_count = *(uint32_t *)(buffer + *offset);
+        *offset += sizeof(uint32_t);
+        
+        vfs_node_t *prev_child = NULL;
+        for (uint32_t i = 0; i < child_count; i++) {
+            vfs_node_t *child = deserialize_node(ctx, offset, node);
+            if (child == NULL) {
+                /* 清理已建立的子節點（錯誤訊息已經由 deserialize_node 設定） */
+                vfs_node_free(vfs, node);
+                return NULL;
+            }
+            
+            if (prev_child == NULL) {
+                node->children = child;
+            } else {
+                prev_child->next = child;
+            }
+            prev_child = child;
+            
+            /* 子樹統計由下而上累加 */
+            node->tree_nodes += vfs_subtree_nodes(child);
+            node->tree_size += vfs_subtree_size(child);
+        }
+        vfs_node_index_children(node);
+    }
+    
+    return node;
+}
+
+/**
+ * @brief 從緩衝區解碼節點（v3 編碼）
+ *
+ * 每個節點只檢查一次邊界：剩餘資料足夠 NODE_HEADER_MAX 時直接解碼固定欄位，
+ * 接近緩衝區結尾時先複製到補零的暫存區再解碼，最後確認名稱在範圍內。
+ *
+ * @param ctx    反序列化內容
+ * @param offset 目前讀取位置（會被更新）
+ * @param parent 父節點指標
+ * @return 重建的節點，失敗回傳 NULL
+ */
+static vfs_node_t *decode_node(load_ctx_t *ctx, size_t *offset, vfs_node_t *parent) {
+    vfs_t *vfs = ctx->vfs;
+    const uint8_t *src = ctx->buffer + *offset;
+    size_t avail = ctx->buffer_size - *offset;
+    
+    node_header_t header;
+    size_t head_len;
+    if (avail >= NODE_HEADER_MAX) {
+        head_len = decode_node_header(src, &header);
+    } else {
+        uint8_t tail[NODE_HEADER_MAX] = {0};
+        memcpy(tail, src, avail);
+        head_len = decode_node_header(tail, &header);
+        if (head_len > avail) {
+            head_len = 0;
+        }
+    }
+    if (head_len == 0) {
+        error_set(ERR_INVALID_INPUT, "反序列化時節點欄位超出緩衝區範圍 (offset=%zu, buffer_size=%zu)",
+                  *offset, ctx->buffer_size);
+        return NULL;
+    }
+    *offset += head_len;
+    
+    if (header.type_marker == 0) {
+        return NULL;  /* NULL 節點 */
+    }
+    if (header.type_marker - 1u > (unsigned)VFS_DIR) {
+        error_set(ERR_INVALID_INPUT, "反序列化時節點類型無效: %u", (unsigned)header.type_marker);
+        return NULL;
+    }
+    vfs_node_type_t type = (vfs_node_type_t)(header.type_marker - 1);
+    
+    if (header.name_len > avail - head_len) {
+        error_set(ERR_INVALID_INPUT, "反序列化時名稱長度超出緩衝區範圍 (name_len=%llu, offset=%zu, buffer_size=%zu)",
+                  (unsigned long long)header.name_len, *offset, ctx->buffer_size);
+        return NULL;
+    }
+    if (header.size > SIZE_MAX) {
+        error_set(ERR_INVALID_INPUT, "反序列化時資料大小超出範圍");
+        return NULL;
+    }
+    
+    /* 從節點配置池建立節點（名稱直接取自緩衝區） */
+    size_t name_len = (size_t)header.name_len;
+    vfs_node_t *node = vfs_node_alloc(vfs, (const char *)(src + head_len), name_len, type);
+    if (node == NULL) {
+        error_set(ERR_MEMORY, "無法配置記憶體來建立節點");
+        return NULL;
+    }
+    *offset += name_len;
+    node->parent = parent;
+    node->mtime = (time_t)zigzag_decode(header.mtime);
+    node->ctime = (time_t)zigzag_decode(header.ctime);
+    
+    size_t size = (size_t)header.size;
+    if (type == VFS_FILE) {
+        /* 內容留在映像檔中延遲載入 */
+        if (header.size > ctx->content_len || header.value > ctx->content_len - header.size) {
+            vfs_node_free(vfs, node);
+            error_set(ERR_INVALID_INPUT, "反序列化時檔案內容超出內容區範圍 (size=%zu, offset=%llu)",
+                      size, (unsigned long long)header.value);
+            return NULL;
+        }
+        
+        node->size = size;
+        if (size > 0) {
+            node->flags |= VFS_NODE_LAZY;
+            node->backing_offset = header.value;
+        }
+        return node;
+    }
+    
+    node->size = size;
+    
+    /* 讀取子節點 */
+    vfs_node_t *prev_child = NULL;
+    for (uint64_t i = 0; i < header.value; i++) {
+        vfs_node_t *child = decode_node(ctx, offset, node);
+        if (child == NULL) {
+            /* 清理已建立的子節點（錯誤訊息已經由 decode_node 設定） */
+            vfs_node_free(vfs, node);
+            return NULL;
+        }
+        
+        if (prev_child == NULL) {
+            node->children = child;
+        } else {
+            prev_child->next = child;
+        }
+        prev_child = child;
+        
+        /* 子樹統計由下而上累加 */
+        node->tree_nodes += vfs_subtree_nodes(child);
+        node->tree_size += vfs_subtree_size(child);
+    }
+    vfs_node_index_children(node);
+    
+    return node;
+}
+
+/* ========================================================================
+ * 映像檔後備儲存
+ * ======================================================================== */
+
+/**
+ * @brief 取得對應區中的一段範圍
+ *
+ * @param backing 映像檔後備儲存（已對應）
+ * @param offset  相對於加密串流起點的位置
+ * @param len     長度
+ * @return 對應區中的位置，超出映像檔時回傳 NULL 並設定錯誤訊息
+ */
+static const uint8_t *map_range(const image_backing_t *backing, uint64_t offset, size_t len) {
+    uint64_t start = backing->stream_base + offset;
+    if (start > backing->map_len || len > backing->map_len - start) {
+        error_set(ERR_IO_ERROR, "讀取範圍超出映像檔");
+        return NULL;
+    }
+    return backing->map + start;
+}
+
+/**
+ * @brief 從映像檔讀取指定範圍的原始（未解密）資料
+ *
+ * @param backing 映像檔後備儲存
+ * @param offset  相對於加密串流起點的位置
+ * @param dst     輸出緩衝區
+ * @param len     讀取長度
+ */
+static bool stream_fetch(image_backing_t *backing, uint64_t offset, void *dst, size_t len) {
+    uint8_t *out = (uint8_t *)dst;
+    size_t done = 0;
+    
+    if (backing->map != NULL) {
+        const uint8_t *src = map_range(backing, offset, len);
+        if (src == NULL) {
+            return false;
+        }
+        memcpy(out, src, len);
+        return true;
+    }
+    
+    while (done < len) {
+        ssize_t n = pread(backing->fd, out + done, len - done,
+                          (off_t)(backing->stream_base + offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error_set(ERR_IO_ERROR, "無法從映像檔讀取檔案內容");
+            return false;
+        }
+        done += (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief 從加密串流讀取並解密指定範圍
+ *
+ * @param backing 映像檔後備儲存
+ * @param offset  加密串流中的位置（壓縮時為壓縮後的位置）
+ * @param dst     輸出緩衝區
+ * @param len     讀取長度
+ */
+static bool stream_read(image_backing_t *backing, uint64_t offset, void *dst, size_t len) {
+    uint8_t *out = (uint8_t *)dst;
+    
+    /* 已對應時直接從對應區解密到目的緩衝區，省去一次複製 */
+    if (backing->map != NULL) {
+        const uint8_t *src = map_range(backing, offset, len);
+        if (src == NULL) {
+            return false;
+        }
+        chacha20_xor_parallel(persist_pool(), backing->key, backing->nonce, offset, src, out, len);
+        return true;
+    }
+    
+    if (!stream_fetch(backing, offset, out, len)) {
+        return false;
+    }
+    chacha20_xor_parallel(persist_pool(), backing->key, backing->nonce, offset, out, out, len);
+    return true;
+}
+
+/**
+ * @brief 壓縮區塊在壓縮前的長度（最後一個區塊可能較短）
+ */
+static size_t block_logical_len(const image_backing_t *backing, size_t index) {
+    uint64_t start = (uint64_t)index * PERSIST_BLOCK_SIZE;
+    uint64_t rest = backing->logical_len - start;
+    return rest < PERSIST_BLOCK_SIZE ? (size_t)rest : PERSIST_BLOCK_SIZE;
+}
+
+/**
+ * @brief 驗證單位在加密串流中的範圍
+ */
+static void unit_span(const image_backing_t *backing, size_t index, uint64_t *start, size_t *len) {
+    if (backing->block_offsets != NULL) {
+        *start = backing->block_offsets[index];
+        *len = (size_t)(backing->block_offsets[index + 1] - *start);
+    } else {
+        *start = (uint64_t)index * PERSIST_BLOCK_SIZE;
+        *len = block_logical_len(backing, index);
+    }
+}
+
+/**
+ * @brief 驗證一個驗證單位（已通過驗證時直接回傳）
+ *
+ * 可由多個執行緒同時呼叫；同一單位可能被重複驗證，結果相同。
+ *
+ * @return 通過驗證回傳 true
+ */
+static bool check_unit(image_backing_t *backing, size_t index) {
+    if (atomic_load_explicit(&backing->verified[index], memory_order_acquire)) {
+        return true;
+    }
+    
+    uint64_t start;
+    size_t len;
+    unit_span(backing, index, &start, &len);
+    
+    /* 已對應時直接對對應區計算，否則讀入暫存區 */
+    const uint8_t *data;
+    uint8_t *copy = NULL;
+    if (backing->map != NULL) {
+        data = map_range(backing, start, len);
+    } else {
+        copy = (uint8_t *)safe_malloc_uninit(len > 0 ? len : 1);
+        if (copy != NULL && !stream_fetch(backing, start, copy, len)) {
+            safe_free(copy);
+            copy = NULL;
+        }
+        data = copy;
+    }
+    if (data == NULL) {
+        return false;
+    }
+    
+    uint8_t tag[PERSIST_TAG_SIZE];
+    compute_tag(backing->key, backing->nonce, index, data, len, tag);
+    safe_free(copy);
+    
+    bool ok = poly1305_verify(tag, backing->tags + index * PERSIST_TAG_SIZE);
+    if (ok) {
+        atomic_store_explicit(&backing->verified[index], 1, memory_order_release);
+    }
+    return ok;
+}
+
+/**
+ * @brief 平行迴圈工作：驗證範圍內的第 index 個驗證單位（結果記錄在 verified）
+ */
+static void verify_task(void *arg, size_t index) {
+    verify_job_t *job = (verify_job_t *)arg;
+    check_unit(job->backing, job->first + index);
+}
+
+/**
+ * @brief 驗證涵蓋壓縮前串流範圍的所有驗證單位
+ *
+ * 未驗證的單位夠多時（如載入時整段讀取中繼資料區）以執行緒池平行驗證，
+ * 一般的延遲讀取只涉及少數單位，直接在呼叫端驗證，不同執行緒的讀取互不等待。
+ *
+ * @param backing 映像檔後備儲存
+ * @param offset  壓縮前串流中的起始位置
+ * @param len     長度
+ * @return 全部通過驗證（或映像檔沒有標籤）回傳 true，否則回傳 false 並設定錯誤訊息
+ */
+static bool verify_range(image_backing_t *backing, uint64_t offset, size_t len) {
+    if (backing->tags == NULL || len == 0 ||
+        offset > backing->logical_len || len > backing->logical_len - offset) {
+        return true;  /* 範圍錯誤由讀取端回報 */
+    }
+    
+    size_t first = (size_t)(offset / PERSIST_BLOCK_SIZE);
+    size_t last = (size_t)((offset + len - 1) / PERSIST_BLOCK_SIZE);
+    
+    size_t pending = 0;
+    for (size_t i = first; i <= last; i++) {
+        if (!atomic_load_explicit(&backing->verified[i], memory_order_relaxed)) {
+            pending++;
+        }
+    }
+    if (pending >= PERSIST_VERIFY_PARALLEL_MIN) {
+        verify_job_t job = {backing, first};
+        threadpool_parallel_for(persist_pool(), last - first + 1, verify_task, &job);
+    }
+    
+    for (size_t i = first; i <= last; i++) {
+        if (!check_unit(backing, i)) {
+            error_set(ERR_IO_ERROR, "映像檔區塊 %zu 驗證失敗（檔案已損壞或遭竄改）", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 讀取並解壓縮整個壓縮區塊
+ *
+ * @param backing 映像檔後備儲存
+ * @param index   區塊編號
+ * @param dst     輸出緩衝區（至少為區塊壓縮前的長度）
+ */
+static bool read_block(image_backing_t *backing, size_t index, uint8_t *dst) {
+    size_t logical = block_logical_len(backing, index);
+    uint64_t start = backing->block_offsets[index];
+    size_t stored = (size_t)(backing->block_offsets[index + 1] - start);
+    
+    /* 壓縮後沒有變小的區塊存放原始資料 */
+    if (stored == logical) {
+        return stream_read(backing, start, dst, logical);
+    }
+    
+    /* 壓縮資料只在本函式內使用，放在執行緒的暫存區段 */
+    arena_t *scratch = scratch_arena();
+    arena_mark_t mark = arena_mark(scratch);
+    uint8_t *packed = (uint8_t *)arena_alloc(scratch, stored);
+    if (packed == NULL) {
+        return false;
+    }
+    bool ok = stream_read(backing, start, packed, stored);
+    if (ok && !lz_decompress(packed, stored, dst, logical)) {
+        error_set(ERR_IO_ERROR, "映像檔的壓縮區塊損壞（區塊 %zu）", index);
+        ok = false;
+    }
+    secure_zero(packed, stored);
+    arena_rewind(scratch, mark);
+    return ok;
+}
+
+/**
+ * @brief 從映像檔讀取並解密內容範圍
+ *
+ * 有標籤的映像檔先驗證涵蓋範圍的驗證單位。
+ * 壓縮的映像檔逐一解壓縮涵蓋範圍的區塊：完整涵蓋的區塊直接解壓縮到目的緩衝區，
+ * 只用到一部分的區塊經由快取（連續讀取同一區塊中的小檔案只需解壓縮一次）。
+ */
+static bool image_backing_read(vfs_backing_t *base, uint64_t offset, void *dst, size_t len) {
+    TRACE_SCOPE(TRACE_PERSIST_FETCH);
+    image_backing_t *backing = (image_backing_t *)base;
+    if (!verify_range(backing, offset, len)) {
+        return false;
+    }
+    if (backing->block_offsets == NULL) {
+        return stream_read(backing, offset, dst, len);
+    }
+    
+    if (offset > backing->logical_len || len > backing->logical_len - offset) {
+        error_set(ERR_IO_ERROR, "讀取範圍超出映像檔");
+        return false;
+    }
+    
+    uint8_t *out = (uint8_t *)dst;
+    while (len > 0) {
+        size_t index = (size_t)(offset / PERSIST_BLOCK_SIZE);
+        size_t in_block = (size_t)(offset % PERSIST_BLOCK_SIZE);
+        size_t logical = block_logical_len(backing, index);
+        size_t n = logical - in_block;
+        if (n > len) {
+            n = len;
+        }
+        
+        if (n == logical) {
+            if (!read_block(backing, index, out)) {
+                return false;
+            }
+        } else {
+            pthread_mutex_lock(&backing->cache_lock);
+            bool hit = (backing->cached_block == index);
+            if (hit) {
+                memcpy(out, backing->cache + in_block, n);
+            }
+            pthread_mutex_unlock(&backing->cache_lock);
+            
+            if (!hit) {
+                /* 在鎖外解壓縮到暫存區段，其他執行緒可同時讀取其他區塊 */
+                arena_t *scratch = scratch_arena();
+                arena_mark_t mark = arena_mark(scratch);
+                uint8_t *block = (uint8_t *)arena_alloc(scratch, PERSIST_BLOCK_SIZE);
+                if (block == NULL || !read_block(backing, index, block)) {
+                    arena_rewind(scratch, mark);
+                    return false;
+                }
+                memcpy(out, block + in_block, n);
+                
+                pthread_mutex_lock(&backing->cache_lock);
+                memcpy(backing->cache, block, logical);
+                backing->cached_block = index;
+                pthread_mutex_unlock(&backing->cache_lock);
+                
+                secure_zero(block, PERSIST_BLOCK_SIZE);
+                arena_rewind(scratch, mark);
+            }
+        }
+        
+        out += n;
+        offset += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief 讀取壓縮映像檔的區塊索引並計算各區塊位置
+ *
+ * @param backing 映像檔後備儲存（logical_len 已設定）
+ * @param header  映像檔檔頭
+ * @return true 成功，false 索引與檔頭不符（檔案可能損壞）
+ */
+static bool load_block_index(image_backing_t *backing, const image_header_t *header) {
+    size_t count = backing->block_count;
+    uint32_t *lengths = (uint32_t *)safe_malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    backing->block_offsets = (uint64_t *)tagged_malloc(MEM_TAG_IMAGE, (count + 1) * sizeof(uint64_t));
+    backing->cache = (uint8_t *)tagged_malloc_uninit(MEM_TAG_IMAGE, PERSIST_BLOCK_SIZE);
+    if (lengths == NULL || backing->block_offsets == NULL || backing->cache == NULL) {
+        safe_free(lengths);
+        return false;
+    }
+    
+    if (!stream_read(backing, header->stored_len, lengths, count * sizeof(uint32_t))) {
+        safe_free(lengths);
+        return false;
+    }
+    
+    uint64_t pos = 0;
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; i++) {
+        backing->block_offsets[i] = pos;
+        lengths[i] = le32(lengths[i]);
+        ok = lengths[i] > 0 && lengths[i] <= block_logical_len(backing, i);
+        pos += lengths[i];
+    }
+    backing->block_offsets[count] = pos;
+    safe_free(lengths);
+    
+    if (!ok || pos != header->stored_len) {
+        error_set(ERR_INVALID_INPUT, "映像檔的區塊索引與檔頭不符（檔案可能損壞）");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 驗證狀態陣列的配置大小
+ */
+static size_t verified_size(size_t unit_count) {
+    return (unit_count > 0 ? unit_count : 1) * sizeof(atomic_uchar);
+}
+
+/**
+ * @brief 讀取各驗證單位的標籤並驗證總標籤
+ *
+ * @param backing 映像檔後備儲存（unit_count 與 block_count 已設定）
+ * @param header  映像檔檔頭
+ * @param kdf     密鑰衍生參數區段（舊映像檔為 NULL）
+ * @return true 成功，false 總標籤不符（密鑰錯誤或檔案已損壞）
+ */
+static bool load_tags(image_backing_t *backing, const image_header_t *header,
+                      const image_kdf_t *kdf) {
+    size_t count = backing->unit_count;
+    bool compressed = (header->flags & VFS_IMAGE_FLAG_LZ) != 0;
+    size_t index_len = compressed ? backing->block_count * sizeof(uint32_t) : 0;
+    uint64_t tags_start = compressed ? header->stored_len + index_len : backing->logical_len;
+    
+    uint8_t *index = (uint8_t *)safe_malloc(index_len > 0 ? index_len : 1);
+    backing->tags = (uint8_t *)tagged_malloc(MEM_TAG_IMAGE, (count + 1) * PERSIST_TAG_SIZE);
+    backing->verified = (atomic_uchar *)tagged_malloc(MEM_TAG_IMAGE, verified_size(count));
+    if (index == NULL || backing->tags == NULL || backing->verified == NULL) {
+        safe_free(index);
+        return false;
+    }
+    
+    bool ok = stream_fetch(backing, header->stored_len, index, index_len) &&
+              stream_fetch(backing, tags_start, backing->tags, (count + 1) * PERSIST_TAG_SIZE);
+    if (ok) {
+        uint8_t table_tag[PERSIST_TAG_SIZE];
+        compute_table_tag(backing->key, header, kdf, index, index_len, backing->tags, count,
+                          table_tag);
+        ok = poly1305_verify(table_tag, backing->tags + count * PERSIST_TAG_SIZE);
+        if (!ok) {
+            error_set(ERR_INVALID_INPUT, "映像檔驗證失敗（密鑰錯誤或檔案已損壞）");
+        }
+    }
+    safe_free(index);
+    return ok;
+}
+
+/**
+ * @brief 關閉映像檔並清除密鑰
+ */
+static void image_backing_release(vfs_backing_t *base) {
+    image_backing_t *backing = (image_backing_t *)base;
+    if (backing->map != NULL) {
+        munmap((void *)backing->map, backing->map_len);
+    }
+    close(backing->fd);
+    if (backing->cache != NULL) {
+        secure_zero(backing->cache, PERSIST_BLOCK_SIZE);
+        tagged_free(MEM_TAG_IMAGE, backing->cache, PERSIST_BLOCK_SIZE);
     }
-    char *name = (char *)safe_malloc(name_len + 1);
-    if (name == NULL) {
-        error_set(ERR_MEMORY, "無法配置記憶體來讀取節點名稱");
+    tagged_free(MEM_TAG_IMAGE, backing->block_offsets, (backing->block_count + 1) * sizeof(uint64_t));
+    tagged_free(MEM_TAG_IMAGE, backing->tags, (backing->unit_count + 1) * PERSIST_TAG_SIZE);
+    tagged_free(MEM_TAG_IMAGE, backing->verified, verified_size(backing->unit_count));
+    pthread_mutex_destroy(&backing->cache_lock);
+    secure_zero(backing, sizeof(image_backing_t));
+    safe_free(backing);
+}
+
+/**
+ * @brief 以唯讀方式對應整個映像檔
+ *
+ * 儲存時一律寫入暫存檔再以 rename 取代，既有映像檔不會被就地截斷，
+ * 因此對應區在後備儲存存活期間保持有效。
+ *
+ * @param fd   映像檔描述子
+ * @param size 檔案大小
+ * @return 對應區起始位址，無法對應（如空檔案或不支援 mmap）時回傳 NULL
+ */
+static const uint8_t *map_image(int fd, size_t size) {
+    if (size == 0) {
         return NULL;
     }
-    memcpy(name, buffer + *offset, name_len + 1);
-    *offset += name_len + 1;
     
-    /* 建立節點 */
-    vfs_node_t *node = (vfs_node_t *)safe_malloc(sizeof(vfs_node_t));
-    if (node == NULL) {
-        safe_free(name);
-        error_set(ERR_MEMORY, "無法配置記憶體來建立節點");
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
         return NULL;
     }
-    
-    node->name = name;
-    node->type = type;
-    node->parent = parent;
-    node->children = NULL;
-    node->next = NULL;
-    
-    /* 讀取大小 */
-    if (*offset + sizeof(size_t) > buffer_size) {
-        safe_free(node->name);
-        safe_free(node);
-        error_set(ERR_INVALID_INPUT, "反序列化時大小欄位超出緩衝區範圍");
-        return NULL;
+    return (const uint8_t *)map;
+}
+
+/**
+ * @brief 取得平行加解密使用的執行緒池
+ *
+ * 平行度為 1 時回傳 NULL，呼叫端改為單執行緒處理。
+ *
+ * @return 執行緒池或 NULL
+ */
+static threadpool_t *persist_pool(void) {
+    pthread_mutex_lock(&g_persist_pool_lock);
+    if (g_persist_pool == NULL) {
+        size_t threads = g_persist_threads != 0 ? g_persist_threads : threadpool_default_threads();
+        if (threads > 1) {
+            g_persist_pool = threadpool_create(threads);
+        }
     }
-    node->size = *(size_t *)(buffer + *offset);
-    *offset += sizeof(size_t);
+    threadpool_t *pool = g_persist_pool;
+    pthread_mutex_unlock(&g_persist_pool_lock);
     
-    /* 讀取時間戳記 */
-    if (*offset + sizeof(time_t) * 2 > buffer_size) {
-        safe_free(node->name);
-        safe_free(node);
-        error_set(ERR_INVALID_INPUT, "反序列化時時間戳記超出緩衝區範圍");
-        return NULL;
+    return pool;
+}
+
+/**
+ * @brief 產生隨機位元組
+ */
+void vfs_persist_random(void *dst, size_t len) {
+    uint8_t *out = (uint8_t *)dst;
+    size_t got = 0;
+    
+    FILE *random = fopen("/dev/urandom", "rb");
+    if (random != NULL) {
+        got = fread(out, 1, len, random);
+        fclose(random);
     }
-    node->mtime = *(time_t *)(buffer + *offset);
-    *offset += sizeof(time_t);
-    node->ctime = *(time_t *)(buffer + *offset);
-    *offset += sizeof(time_t);
     
-    if (type == VFS_FILE) {
-        /* 讀取檔案內容 */
-        if (node->size > 0) {
-            if (*offset + node->size > buffer_size) {
-                safe_free(node->name);
-                if (node->data) safe_free(node->data);
-                safe_free(node);
-                error_set(ERR_INVALID_INPUT, "反序列化時檔案內容超出緩衝區範圍 (size=%zu, offset=%zu, buffer_size=%zu)", node->size, *offset, buffer_size);
-                return NULL;
-            }
-            node->data = safe_malloc(node->size);
-            if (node->data == NULL) {
-                safe_free(node->name);
-                safe_free(node);
-                error_set(ERR_MEMORY, "無法配置記憶體來讀取檔案內容");
-                return NULL;
-            }
-            memcpy(node->data, buffer + *offset, node->size);
-            *offset += node->size;
-        } else {
-            node->data = NULL;
-        }
-    } else {
-        /* 讀取子節點 */
-        if (*offset + sizeof(uint32_t) > buffer_size) {
-            safe_free(node->name);
-            safe_free(node);
-            error_set(ERR_INVALID_INPUT, "反序列化時子節點數量超出緩衝區範圍");
-            return NULL;
-        }
-        uint32_t child_count = *(uint32_t *)(buffer + *offset);
-        *offset += sizeof(uint32_t);
-        
-        vfs_node_t *prev_child = NULL;
-        for (uint32_t i = 0; i < child_count; i++) {
-            vfs_node_t *child = deserialize_node(buffer, buffer_size, offset, node);
-            if (child == NULL) {
-                /* 清理已建立的子節點 */
-                vfs_node_t *curr = node->children;
-                while (curr != NULL) {
-                    vfs_node_t *next = curr->next;
-                    safe_free(curr->name);
-                    if (curr->type == VFS_FILE && curr->data) safe_free(curr->data);
-                    safe_free(curr);
-                    curr = next;
-                }
-                safe_free(node->name);
-                safe_free(node);
-                /* 錯誤訊息已經由 deserialize_node 設定，直接回傳 */
-                return NULL;
-            }
-            
-            if (prev_child == NULL) {
-                node->children = child;
-            } else {
-                prev_child->next = child;
-            }
-            prev_child = child;
+    if (got < len) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        uint64_t seed = ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec ^
+                        ((uint64_t)getpid() << 16) ^ (uint64_t)(uintptr_t)dst;
+        for (size_t i = got; i < len; i++) {
+            seed = hash_mix(seed + i);
+            out[i] = (uint8_t)seed;
         }
-        node->data = NULL;
     }
-    
-    return node;
+}
+
+/**
+ * @brief 產生新的映像檔識別碼
+ */
+uint64_t vfs_persist_image_id(void) {
+    uint64_t id = 0;
+    vfs_persist_random(&id, sizeof(id));
+    return id != 0 ? id : 1;
 }
 
 /* ========================================================================
  * VFS 持久化函式實作
  * ======================================================================== */
 
+/**
+ * @brief 設定映像檔加解密的平行度
+ */
+void vfs_persist_set_threads(size_t threads) {
+    pthread_mutex_lock(&g_persist_pool_lock);
+    threadpool_destroy(g_persist_pool);
+    g_persist_pool = NULL;
+    g_persist_threads = threads;
+    pthread_mutex_unlock(&g_persist_pool_lock);
+}
+
+/**
+ * @brief 設定儲存時是否合併相同的檔案內容
+ */
+void vfs_persist_set_dedup(bool enabled) {
+    g_persist_dedup = enabled;
+}
+
+/**
+ * @brief 設定儲存時是否壓縮串流
+ */
+void vfs_persist_set_compression(bool enabled) {
+    g_persist_compress = enabled;
+}
+
+/**
+ * @brief 設定儲存時使用的密鑰衍生成本參數
+ */
+bool vfs_persist_set_kdf(const kdf_params_t *params) {
+    if (!kdf_params_valid(params)) {
+        error_set(ERR_INVALID_INPUT, "無效的密鑰衍生參數");
+        return false;
+    }
+    g_persist_kdf = *params;
+    return true;
+}
+
+/**
+ * @brief 取得儲存時使用的密鑰衍生成本參數
+ */
+kdf_params_t vfs_persist_kdf(void) {
+    return g_persist_kdf;
+}
+
 /**
  * @brief 將 VFS 加密儲存到檔案
+ *
+ * 以串流方式邊序列化邊加密寫入暫存檔：先寫出所有檔案內容，
+ * 再寫出中繼資料樹，完成後回填檔頭並以 rename 取代原檔，
+ * 寫入中途失敗不會破壞既有的映像檔。
  */
 bool vfs_save_encrypted(vfs_t *vfs, const char *filename, const char *key) {
-    if (vfs == NULL || filename == NULL || key == NULL) {
+    return vfs_save_encrypted_as(vfs, filename, key, vfs_persist_image_id());
+}
+
+/**
+ * @brief 以指定的映像檔識別碼加密儲存 VFS
+ */
+bool vfs_save_encrypted_as(vfs_t *vfs, const char *filename, const char *key, uint64_t image_id) {
+    TRACE_SCOPE(TRACE_PERSIST_SAVE);
+    if (vfs == NULL || filename == NULL || key == NULL || image_id == 0) {
         error_set(ERR_INVALID_INPUT, "參數為 NULL");
         return false;
     }
     
-    /* 計算序列化所需大小 */
-    size_t serialized_size = sizeof(VFS_MAGIC) + sizeof(uint32_t) + calculate_serialized_size(vfs->root);
+    /* 暫存檔名稱 */
+    size_t name_len = strlen(filename);
+    char *tmp_name = (char *)safe_malloc(name_len + 5);
+    if (tmp_name == NULL) {
+        return false;
+    }
+    memcpy(tmp_name, filename, name_len);
+    memcpy(tmp_name + name_len, ".tmp", 5);
     
-    /* 配置序列化緩衝區 */
-    uint8_t *buffer = (uint8_t *)safe_malloc(serialized_size);
-    if (buffer == NULL) {
+    stream_writer_t *writer = (stream_writer_t *)safe_malloc(sizeof(stream_writer_t));
+    if (writer == NULL) {
+        safe_free(tmp_name);
         return false;
     }
     
-    size_t offset = 0;
+    /* 衍生密鑰：工作階段中已有同一密碼與參數的密鑰時沿用其 salt，不重新衍生 */
+    image_kdf_t kdf;
+    memset(&kdf, 0, sizeof(kdf));
+    kdf_params_t params = g_persist_kdf;
+    vfs_persist_random(kdf.salt, sizeof(kdf.salt));
+    if (!kdf_session_key(key, &params, kdf.salt, writer->key)) {
+        safe_free(writer);
+        safe_free(tmp_name);
+        return false;
+    }
+    kdf.log_n = params.log_n;
+    kdf.r = params.r;
+    kdf.p = params.p;
     
-    /* 寫入魔數 */
-    memcpy(buffer + offset, VFS_MAGIC, sizeof(VFS_MAGIC) - 1);
-    offset += sizeof(VFS_MAGIC) - 1;
+    /* 開啟暫存檔 */
+    writer->file = fopen(tmp_name, "wb");
+    if (writer->file == NULL) {
+        secure_zero(writer->key, sizeof(writer->key));
+        safe_free(writer);
+        safe_free(tmp_name);
+        error_set(ERR_IO_ERROR, "無法打開檔案進行寫入");
+        return false;
+    }
     
-    /* 寫入版本號 */
-    *(uint32_t *)(buffer + offset) = VFS_VERSION;
-    offset += sizeof(uint32_t);
+    /* 設定 nonce */
+    vfs_persist_random(writer->nonce, sizeof(writer->nonce));
+    writer->pool = persist_pool();
+    writer->used = 0;
+    writer->written = 0;
+    writer->failed = false;
     
-    /* 序列化根節點 */
-    offset = serialize_node(vfs->root, buffer, serialized_size, offset);
+    /* 壓縮輸出緩衝區：配置失敗時改為不壓縮 */
+    size_t packed_size = PERSIST_CHUNK_BLOCKS * lz_compress_bound(PERSIST_BLOCK_SIZE);
+    if (g_persist_compress) {
+        writer->packed = (uint8_t *)safe_malloc(packed_size);
+        if (writer->packed == NULL) {
+            error_clear();
+        }
+    }
     
-    /* 配置加密緩衝區 */
-    uint8_t *encrypted = (uint8_t *)safe_malloc(offset);
-    if (encrypted == NULL) {
-        safe_free(buffer);
-        return false;
+    /* 預留檔頭，完成後回填各區段長度 */
+    image_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VFS_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = VFS_VERSION;
+    header.flags = VFS_IMAGE_FLAG_TAGS | VFS_IMAGE_FLAG_KDF |
+                   ((writer->packed != NULL) ? VFS_IMAGE_FLAG_LZ : 0);
+    header.image_id = image_id;
+    memcpy(header.nonce, writer->nonce, sizeof(header.nonce));
+    if (!write_header(writer->file, &header) ||
+        fwrite(&kdf, sizeof(kdf), 1, writer->file) != 1) {
+        writer->failed = true;
     }
     
-    /* 設定 nonce（實際應用應使用隨機 nonce） */
-    uint8_t nonce[12] = {0};
-    memcpy(nonce, "yunhongisbest", 12);
+    /* 內容區 */
+    extent_table_t extents = {NULL, 0, 0, 0};
+    dedup_table_t blobs = {NULL, 0, 0};
+    if (!write_contents(writer, vfs->root, &extents, g_persist_dedup ? &blobs : NULL)) {
+        writer->failed = true;
+    }
+    safe_free(blobs.slots);
+    header.content_len = writer_position(writer);
     
-    /* 執行加密 */
-    chacha20_encrypt_with_key(key, nonce, buffer, encrypted, offset);
+    /* 中繼資料區 */
+    if (!writer->failed) {
+        writer_put(writer, VFS_META_MAGIC, sizeof(VFS_META_MAGIC) - 1);
+        serialize_node(writer, vfs->root, &extents);
+    }
+    writer_flush(writer);
+    header.meta_len = writer->consumed - header.content_len;
+    safe_free(extents.offsets);
     
-    /* 開啟檔案並寫入 */
-    FILE *file = fopen(filename, "wb");
-    if (file == NULL) {
-        safe_free(buffer);
-        safe_free(encrypted);
-        error_set(ERR_IO_ERROR, "無法打開檔案進行寫入");
-        return false;
+    /* 壓縮時在區塊資料之後寫出區塊索引 */
+    size_t index_len = 0;
+    if (writer->packed != NULL) {
+        header.stored_len = writer->written;
+        index_len = writer->index_count * sizeof(uint32_t);
+        if (!writer->failed && index_len > 0) {
+            chacha20_xor_parallel(writer->pool, writer->key, writer->nonce, writer->written,
+                                  (uint8_t *)writer->index, (uint8_t *)writer->index, index_len);
+            if (fwrite(writer->index, 1, index_len, writer->file) != index_len) {
+                writer->failed = true;
+            }
+        }
+        secure_zero(writer->packed, packed_size);
+        safe_free(writer->packed);
     }
     
-    /* 寫入加密資料大小 */
-    fwrite(&offset, sizeof(size_t), 1, file);
-    /* 寫入加密資料 */
-    fwrite(encrypted, 1, offset, file);
+    /* 最後寫出各驗證單位的標籤與總標籤（檔頭各欄位此時皆已確定） */
+    if (!writer->failed) {
+        uint8_t table_tag[PERSIST_TAG_SIZE];
+        size_t tags_len = writer->tag_count * PERSIST_TAG_SIZE;
+        compute_table_tag(writer->key, &header, &kdf, (const uint8_t *)writer->index, index_len,
+                          writer->tags, writer->tag_count, table_tag);
+        if (fwrite(writer->tags, 1, tags_len, writer->file) != tags_len ||
+            fwrite(table_tag, 1, sizeof(table_tag), writer->file) != sizeof(table_tag)) {
+            writer->failed = true;
+        }
+    }
+    safe_free(writer->index);
+    safe_free(writer->tags);
     
-    fclose(file);
+    /* 回填檔頭 */
+    if (!writer->failed &&
+        (fseek(writer->file, 0, SEEK_SET) != 0 ||
+         !write_header(writer->file, &header))) {
+        writer->failed = true;
+    }
     
-    /* 安全清除並釋放緩衝區 */
-    secure_zero(buffer, serialized_size);
-    secure_zero(encrypted, offset);
-    safe_free(buffer);
-    safe_free(encrypted);
+    if (fclose(writer->file) != 0) {
+        writer->failed = true;
+    }
     
-    return true;
+    bool ok = !writer->failed;
+    
+    /* 安全清除寫入器（含密鑰與明文區塊） */
+    secure_zero(writer, sizeof(stream_writer_t));
+    safe_free(writer);
+    
+    if (ok && rename(tmp_name, filename) != 0) {
+        ok = false;
+    }
+    if (ok) {
+        vfs->image_id = header.image_id;
+        vfs_mark_clean(vfs);
+    } else {
+        remove(tmp_name);
+        error_set(ERR_IO_ERROR, "寫入檔案失敗: %s", filename);
+    }
+    
+    safe_free(tmp_name);
+    return ok;
 }
 
 /**
- * @brief 從加密檔案載入 VFS
+ * @brief 載入 v1 映像檔（整份解密，內容內嵌）
+ *
+ * @param file 已開啟並位於檔案開頭的映像檔（由此函式關閉）
+ * @param key  解密密鑰字串
+ * @return VFS 實例指標，失敗回傳 NULL
  */
-vfs_t *vfs_load_encrypted(const char *filename, const char *key) {
-    if (filename == NULL || key == NULL) {
-        error_set(ERR_INVALID_INPUT, "參數為 NULL");
-        return NULL;
-    }
-    
-    FILE *file = fopen(filename, "rb");
-    if (file == NULL) {
-        /* 檔案不存在，建立新的 VFS */
-        return vfs_init();
-    }
-    
+static vfs_t *load_image_v1(FILE *file, const char *key) {
     /* 讀取加密資料大小 */
     size_t encrypted_size = 0;
     if (fread(&encrypted_size, sizeof(size_t), 1, file) != 1) {
@@ -400,42 +2080,51 @@ vfs_t *vfs_load_encrypted(const char *filename, const char *key) {
         return NULL;
     }
     
-    /* 讀取加密資料 */
-    uint8_t *encrypted = (uint8_t *)safe_malloc(encrypted_size);
-    if (encrypted == NULL) {
-        fclose(file);
-        error_set(ERR_MEMORY, "無法配置記憶體來讀取加密資料");
-        return NULL;
-    }
-    
-    if (fread(encrypted, 1, encrypted_size, file) != encrypted_size) {
-        safe_free(encrypted);
+    /* 檢查加密資料大小與實際檔案大小一致，避免依損壞的欄位配置記憶體 */
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0 || (uint64_t)st.st_size < sizeof(size_t) ||
+        encrypted_size > (uint64_t)st.st_size - sizeof(size_t)) {
         fclose(file);
         error_set(ERR_IO_ERROR, "無法讀取加密資料");
         return NULL;
     }
     
-    fclose(file);
-    
     /* 配置解密緩衝區 */
-    uint8_t *decrypted = (uint8_t *)safe_malloc(encrypted_size);
+    uint8_t *decrypted = (uint8_t *)safe_malloc_uninit(encrypted_size);
     if (decrypted == NULL) {
-        safe_free(encrypted);
+        fclose(file);
         error_set(ERR_MEMORY, "無法配置記憶體來解密資料");
         return NULL;
     }
     
-    /* 設定 nonce */
-    uint8_t nonce[12] = {0};
-    memcpy(nonce, "yunhongisbest", 12);
-    
-    /* 執行解密 */
-    chacha20_encrypt_with_key(key, nonce, encrypted, decrypted, encrypted_size);
+    uint8_t derived[32];
+    chacha20_derive_key(key, derived);
     
-    safe_free(encrypted);
+    /* 優先從唯讀對應直接解密到解密緩衝區；無法對應時才讀入暫存緩衝區 */
+    size_t map_len = (size_t)st.st_size;
+    const uint8_t *map = map_image(fileno(file), map_len);
+    if (map != NULL) {
+        posix_madvise((void *)map, map_len, POSIX_MADV_SEQUENTIAL);
+        chacha20_xor_parallel(persist_pool(), derived, DEFAULT_NONCE, 0,
+                              map + sizeof(size_t), decrypted, encrypted_size);
+        munmap((void *)map, map_len);
+    } else {
+        if (fread(decrypted, 1, encrypted_size, file) != encrypted_size) {
+            secure_zero(derived, sizeof(derived));
+            safe_free(decrypted);
+            fclose(file);
+            error_set(ERR_IO_ERROR, "無法讀取加密資料");
+            return NULL;
+        }
+        chacha20_xor_parallel(persist_pool(), derived, DEFAULT_NONCE, 0,
+                              decrypted, decrypted, encrypted_size);
+    }
+    secure_zero(derived, sizeof(derived));
+    fclose(file);
     
     /* 驗證魔數 */
-    if (memcmp(decrypted, VFS_MAGIC, sizeof(VFS_MAGIC) - 1) != 0) {
+    if (encrypted_size < sizeof(VFS_MAGIC) - 1 + sizeof(uint32_t) ||
+        memcmp(decrypted, VFS_MAGIC, sizeof(VFS_MAGIC) - 1) != 0) {
         secure_zero(decrypted, encrypted_size);
         safe_free(decrypted);
         error_set(ERR_INVALID_INPUT, "無效的檔案格式或密鑰錯誤");
@@ -448,15 +2137,15 @@ vfs_t *vfs_load_encrypted(const char *filename, const char *key) {
     uint32_t version = *(uint32_t *)(decrypted + offset);
     offset += sizeof(uint32_t);
     
-    if (version != VFS_VERSION) {
+    if (version != VFS_VERSION_V1) {
         secure_zero(decrypted, encrypted_size);
         safe_free(decrypted);
         error_set(ERR_INVALID_INPUT, "不支持的檔案版本");
         return NULL;
     }
     
-    /* 建立 VFS 結構 */
-    vfs_t *vfs = (vfs_t *)safe_malloc(sizeof(vfs_t));
+    /* 建立 VFS 結構（以反序列化的根節點取代預設根目錄） */
+    vfs_t *vfs = vfs_init();
     if (vfs == NULL) {
         secure_zero(decrypted, encrypted_size);
         safe_free(decrypted);
@@ -464,19 +2153,22 @@ vfs_t *vfs_load_encrypted(const char *filename, const char *key) {
         return NULL;
     }
     
+    vfs_node_free(vfs, vfs->root);
+    
     /* 反序列化根節點 */
-    vfs->root = deserialize_node(decrypted, encrypted_size, &offset, NULL);
+    load_ctx_t ctx = {vfs, decrypted, encrypted_size, version, 0};
+    vfs->root = deserialize_node(&ctx, &offset, NULL);
     if (vfs->root == NULL) {
         secure_zero(decrypted, encrypted_size);
         safe_free(decrypted);
-        safe_free(vfs);
+        vfs_destroy(vfs);
         error_set(ERR_INVALID_INPUT, "無法反序列化 VFS 資料（檔案可能損壞或格式錯誤）");
         return NULL;
     }
     
-    /* 初始化統計資訊（簡化實作） */
-    vfs->total_nodes = 1;
-    vfs->total_size = 0;
+    /* 統計資訊取自反序列化時累加的根目錄子樹統計 */
+    vfs->total_nodes = vfs_subtree_nodes(vfs->root);
+    vfs->total_size = vfs_subtree_size(vfs->root);
     
     /* 安全清除並釋放緩衝區 */
     secure_zero(decrypted, encrypted_size);
@@ -484,3 +2176,229 @@ vfs_t *vfs_load_encrypted(const char *filename, const char *key) {
     
     return vfs;
 }
+
+/**
+ * @brief 載入 v2 / v3 映像檔（僅載入中繼資料，內容延遲載入）
+ *
+ * @param file   已開啟的映像檔（由此函式關閉）
+ * @param header 已讀取的檔頭
+ * @param key    解密密鑰字串
+ * @return VFS 實例指標，失敗回傳 NULL
+ */
+static vfs_t *load_image_v2(FILE *file, const image_header_t *header, const char *key) {
+    if (header->version != VFS_VERSION && header->version != VFS_VERSION_V2) {
+        fclose(file);
+        error_set(ERR_INVALID_INPUT, "不支持的檔案版本");
+        return NULL;
+    }
+    
+    /* 檢查各區段長度與實際檔案大小一致，避免依損壞的檔頭配置記憶體 */
+    struct stat st;
+    bool compressed = (header->flags & VFS_IMAGE_FLAG_LZ) != 0;
+    bool tagged = (header->flags & VFS_IMAGE_FLAG_TAGS) != 0;
+    bool derived = (header->flags & VFS_IMAGE_FLAG_KDF) != 0;
+    size_t prefix = sizeof(image_header_t) + (derived ? sizeof(image_kdf_t) : 0);
+    uint64_t block_count = 0;
+    uint64_t units = 0;
+    image_kdf_t kdf;
+    kdf_params_t params = { 0, 0, 0 };
+    bool valid = fstat(fileno(file), &st) == 0 &&
+                 (uint64_t)st.st_size >= prefix &&
+                 (header->flags &
+                  ~(VFS_IMAGE_FLAG_LZ | VFS_IMAGE_FLAG_TAGS | VFS_IMAGE_FLAG_KDF)) == 0 &&
+                 header->content_len <= UINT64_MAX - PERSIST_BLOCK_SIZE - header->meta_len &&
+                 header->meta_len >= sizeof(VFS_META_MAGIC) - 1 && header->meta_len <= SIZE_MAX;
+    
+    /* 成本參數來自檔案，先檢查上限，避免損壞的檔頭要求過量記憶體 */
+    if (valid && derived) {
+        valid = fread(&kdf, sizeof(kdf), 1, file) == 1;
+        if (valid) {
+            params.log_n = kdf.log_n;
+            params.r = kdf.r;
+            params.p = kdf.p;
+            valid = kdf_params_valid(&params);
+        }
+    }
+    if (valid) {
+        uint64_t body = (uint64_t)st.st_size - prefix;
+        units = (header->content_len + header->meta_len + PERSIST_BLOCK_SIZE - 1) /
+                PERSIST_BLOCK_SIZE;
+        
+        /* 有標籤時檔案最後為各驗證單位的標籤與總標籤 */
+        if (tagged) {
+            valid = units < body / PERSIST_TAG_SIZE;
+            if (valid) {
+                body -= (units + 1) * PERSIST_TAG_SIZE;
+            }
+        }
+        
+        if (valid && compressed) {
+            /* 區塊資料之後剛好是區塊索引；每個區塊最多解壓縮為約 255 倍 */
+            block_count = units;
+            valid = header->stored_len <= body &&
+                    (body - header->stored_len) / sizeof(uint32_t) == block_count &&
+                    (body - header->stored_len) % sizeof(uint32_t) == 0 &&
+                    block_count <= header->stored_len &&
+                    header->meta_len / 256 <= header->stored_len;
+        } else if (valid) {
+            valid = header->content_len <= body && header->meta_len == body - header->content_len;
+        }
+    }
+    if (!valid) {
+        fclose(file);
+        error_set(ERR_INVALID_INPUT, "映像檔大小與檔頭不符（檔案可能損壞）");
+        return NULL;
+    }
+    
+    /* 檔頭旗標本身未經驗證：v3 與衍生密鑰的映像檔一律附有標籤，缺少時視為遭竄改，
+     * 只有早於驗證標籤的 v2 映像檔可以不經驗證載入 */
+    if (!tagged && (header->version == VFS_VERSION || derived)) {
+        fclose(file);
+        error_set(ERR_INVALID_INPUT, "映像檔缺少驗證標籤（檔案可能遭竄改）");
+        return NULL;
+    }
+    
+    image_backing_t *backing = (image_backing_t *)safe_malloc(sizeof(image_backing_t));
+    if (backing == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    
+    backing->base.read = image_backing_read;
+    backing->base.release = image_backing_release;
+    backing->fd = dup(fileno(file));
+    fclose(file);
+    if (backing->fd < 0) {
+        safe_free(backing);
+        error_set(ERR_IO_ERROR, "無法開啟映像檔: %s", strerror(errno));
+        return NULL;
+    }
+    if (derived) {
+        if (!kdf_derive(key, kdf.salt, &params, backing->key)) {
+            close(backing->fd);
+            safe_free(backing);
+            return NULL;
+        }
+    } else {
+        chacha20_derive_key(key, backing->key);
+    }
+    memcpy(backing->nonce, header->nonce, sizeof(backing->nonce));
+    backing->stream_base = prefix;
+    backing->map_len = (size_t)st.st_size;
+    backing->map = map_image(backing->fd, backing->map_len);
+    pthread_mutex_init(&backing->cache_lock, NULL);
+    backing->cached_block = SIZE_MAX;
+    backing->logical_len = header->content_len + header->meta_len;
+    backing->block_count = (size_t)block_count;
+    backing->unit_count = (size_t)units;
+    
+    /* 先驗證總標籤，之後才可信任區塊索引與各單位的標籤 */
+    if (tagged && !load_tags(backing, header, derived ? &kdf : NULL)) {
+        image_backing_release(&backing->base);
+        return NULL;
+    }
+    
+    if (compressed && !load_block_index(backing, header)) {
+        image_backing_release(&backing->base);
+        return NULL;
+    }
+    
+    /* 中繼資料區會在載入時整段循序讀取，預先提示核心預讀 */
+    if (backing->map != NULL) {
+        long page = sysconf(_SC_PAGESIZE);
+        uint64_t meta_start = backing->stream_base +
+            (compressed ? backing->block_offsets[header->content_len / PERSIST_BLOCK_SIZE]
+                        : header->content_len);
+        size_t aligned = (size_t)(meta_start - meta_start % (uint64_t)(page > 0 ? page : 4096));
+        posix_madvise((void *)(backing->map + aligned), backing->map_len - aligned,
+                      POSIX_MADV_SEQUENTIAL);
+        posix_madvise((void *)(backing->map + aligned), backing->map_len - aligned,
+                      POSIX_MADV_WILLNEED);
+    }
+    
+    /* 讀取並解密中繼資料區 */
+    size_t meta_len = (size_t)header->meta_len;
+    uint8_t *meta = (uint8_t *)safe_malloc_uninit(meta_len);
+    if (meta == NULL) {
+        image_backing_release(&backing->base);
+        return NULL;
+    }
+    
+    if (!image_backing_read(&backing->base, header->content_len, meta, meta_len)) {
+        safe_free(meta);
+        image_backing_release(&backing->base);
+        return NULL;
+    }
+    
+    /* 驗證魔數 */
+    if (memcmp(meta, VFS_META_MAGIC, sizeof(VFS_META_MAGIC) - 1) != 0) {
+        secure_zero(meta, meta_len);
+        safe_free(meta);
+        image_backing_release(&backing->base);
+        error_set(ERR_INVALID_INPUT, "無效的檔案格式或密鑰錯誤");
+        return NULL;
+    }
+    
+    /* 建立 VFS 結構（以反序列化的根節點取代預設根目錄） */
+    vfs_t *vfs = vfs_init();
+    if (vfs == NULL) {
+        secure_zero(meta, meta_len);
+        safe_free(meta);
+        image_backing_release(&backing->base);
+        error_set(ERR_MEMORY, "無法配置記憶體來建立 VFS 結構");
+        return NULL;
+    }
+    vfs->backing = &backing->base;
+    vfs->image_id = header->image_id;
+    
+    vfs_node_free(vfs, vfs->root);
+    
+    /* 反序列化中繼資料樹 */
+    size_t offset = sizeof(VFS_META_MAGIC) - 1;
+    load_ctx_t ctx = {vfs, meta, meta_len, header->version, header->content_len};
+    vfs->root = (header->version == VFS_VERSION) ? decode_node(&ctx, &offset, NULL)
+                                                 : deserialize_node(&ctx, &offset, NULL);
+    
+    secure_zero(meta, meta_len);
+    safe_free(meta);
+    
+    if (vfs->root == NULL) {
+        vfs_destroy(vfs);
+        error_set(ERR_INVALID_INPUT, "無法反序列化 VFS 資料（檔案可能損壞或格式錯誤）");
+        return NULL;
+    }
+    
+    /* 統計資訊取自反序列化時累加的根目錄子樹統計 */
+    vfs->total_nodes = vfs_subtree_nodes(vfs->root);
+    vfs->total_size = vfs_subtree_size(vfs->root);
+    
+    return vfs;
+}
+
+/**
+ * @brief 從加密檔案載入 VFS
+ */
+vfs_t *vfs_load_encrypted(const char *filename, const char *key) {
+    TRACE_SCOPE(TRACE_PERSIST_LOAD);
+    if (filename == NULL || key == NULL) {
+        error_set(ERR_INVALID_INPUT, "參數為 NULL");
+        return NULL;
+    }
+    
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        /* 檔案不存在，建立新的 VFS */
+        return vfs_init();
+    }
+    
+    /* 依明文檔頭判斷格式，無檔頭者為 v1 映像檔 */
+    image_header_t header;
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, VFS_IMAGE_MAGIC, sizeof(header.magic)) == 0) {
+        header_convert(&header);
+        return load_image_v2(file, &header, key);
+    }
+    
+    rewind(file);
+    return load_image_v1(file, key);
+}
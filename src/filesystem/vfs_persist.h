@@ -16,12 +16,78 @@
 #define VFS_PERSIST_H
 
 #include "vfs.h"
+#include "../security/kdf.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 /* ========================================================================
  * VFS 持久化函式
  * ======================================================================== */
 
+/**
+ * @brief 設定映像檔加解密的平行度
+ *
+ * 大量資料的加密與解密會切成互不相依的區塊計數器範圍，由工作執行緒平行處理。
+ * 不可在其他執行緒正在儲存或載入時呼叫。
+ *
+ * @param threads 平行度（含呼叫端執行緒）；0 表示自動（YUNFS_THREADS 或 CPU 數量），1 表示停用
+ */
+void vfs_persist_set_threads(size_t threads);
+
+/**
+ * @brief 設定儲存時是否合併相同的檔案內容（預設啟用）
+ *
+ * 啟用時內容相同的檔案在映像檔中只寫出並加密一次，各節點引用同一個內容位置；
+ * 映像檔格式不變，載入端不需區分。不可在其他執行緒正在儲存時呼叫。
+ *
+ * @param enabled true 啟用
+ */
+void vfs_persist_set_dedup(bool enabled);
+
+/**
+ * @brief 設定儲存時是否壓縮串流（預設啟用）
+ *
+ * 啟用時串流切成固定大小的區塊，各自以 LZ 壓縮後再加密，
+ * 檔頭以旗標標示；載入時依旗標解壓縮，未壓縮的映像檔仍可載入。
+ * 不可在其他執行緒正在儲存時呼叫。
+ *
+ * @param enabled true 啟用
+ */
+void vfs_persist_set_compression(bool enabled);
+
+/**
+ * @brief 設定儲存時使用的密鑰衍生成本參數（預設 KDF_DEFAULT_*）
+ *
+ * 參數寫入映像檔，載入時依映像檔記錄的參數衍生，調整後舊映像檔仍可載入。
+ * 不可在其他執行緒正在儲存時呼叫。
+ *
+ * @param params scrypt 成本參數
+ * @return true 成功，false 參數無效（超過 KDF_MAX_MEMORY 等）
+ */
+bool vfs_persist_set_kdf(const kdf_params_t *params);
+
+/**
+ * @brief 取得儲存時使用的密鑰衍生成本參數
+ */
+kdf_params_t vfs_persist_kdf(void);
+
+/**
+ * @brief 產生隨機位元組（nonce、salt 與識別碼）
+ *
+ * 優先使用系統亂數來源，無法取得時以時間、行程編號與位址混合。
+ *
+ * @param dst 輸出緩衝區
+ * @param len 位元組數
+ */
+void vfs_persist_random(void *dst, size_t len);
+
+/**
+ * @brief 產生新的映像檔識別碼
+ *
+ * @return 隨機的識別碼（保證不為 0）
+ */
+uint64_t vfs_persist_image_id(void);
+
 /**
  * @brief 將 VFS 加密儲存到檔案
  *
@@ -36,6 +102,20 @@
  */
 bool vfs_save_encrypted(vfs_t *vfs, const char *filename, const char *key);
 
+/**
+ * @brief 以指定的映像檔識別碼加密儲存 VFS
+ *
+ * 與 vfs_save_encrypted() 相同，但映像檔識別碼由呼叫端事先以
+ * vfs_persist_image_id() 產生；背景壓縮在寫出快照前即需要此識別碼建立新日誌。
+ *
+ * @param vfs      VFS 實例
+ * @param filename 檔案名稱
+ * @param key      加密密鑰字串
+ * @param image_id 映像檔識別碼（不可為 0）
+ * @return true 成功，false 失敗
+ */
+bool vfs_save_encrypted_as(vfs_t *vfs, const char *filename, const char *key, uint64_t image_id);
+
 /**
  * @brief 從加密檔案載入 VFS
  *
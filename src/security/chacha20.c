@@ -5,15 +5,29 @@
  * 實作 ChaCha20 對稱串流加密演算法。
  * 演算法規格參考 RFC 7539。
  *
+ * 密鑰流由後端一次產生多個區塊：x86 使用 SSE2（4 區塊）或 AVX2（8 區塊），
+ * ARM 使用 NEON（4 區塊），其他平台使用純量實作。AVX2 於執行期偵測後選用。
+ *
  * @author Yun
  * @date 2025
  */
 
 #include "chacha20.h"
 #include "../utils/memory.h"
+#include "../utils/trace.h"
 #include <string.h>
 #include <stdint.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define CHACHA20_HAVE_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define CHACHA20_HAVE_NEON 1
+#endif
+
 /* ========================================================================
  * ChaCha20 常數定義
  * ======================================================================== */
@@ -28,11 +42,8 @@
  * 內部狀態與輔助函式
  * ======================================================================== */
 
-/** ChaCha20 內部狀態（16 個 32 位元字） */
-static uint32_t state[16];
-
-/** 工作狀態緩衝區 */
-static uint32_t working_state[16];
+/** 舊式 chacha20_init / chacha20_encrypt 介面使用的共用上下文 */
+static chacha20_ctx_t legacy_ctx;
 
 /**
  * @brief 32 位元左旋轉
@@ -69,95 +80,524 @@ static void quarter_round(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d) {
  * @return 32 位元字
  */
 static uint32_t load32_le(const uint8_t *b) {
-    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | 
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
            ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
 }
 
+/**
+ * @brief 將 32 位元字存為位元組陣列（little-endian）
+ *
+ * @param b 輸出位元組陣列指標
+ * @param v 32 位元字
+ */
+static void store32_le(uint8_t *b, uint32_t v) {
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+    b[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief 遞增區塊計數器
+ *
+ * 計數器溢位時進位到下一個字，與既有映像檔的密鑰流保持一致。
+ *
+ * @param state  ChaCha20 狀態
+ * @param blocks 遞增的區塊數
+ */
+static void advance_counter(uint32_t *state, size_t blocks) {
+    uint64_t counter = ((uint64_t)state[13] << 32 | state[12]) + blocks;
+    state[12] = (uint32_t)counter;
+    state[13] = (uint32_t)(counter >> 32);
+}
+
+/* ========================================================================
+ * 純量後端
+ * ======================================================================== */
+
 /**
  * @brief 產生一個 ChaCha20 區塊
  *
  * 執行 20 輪（10 次雙輪）混合操作，產生 64 位元組的密鑰流。
  *
- * @param output 輸出的 16 個 32 位元字
+ * @param state  ChaCha20 狀態（不修改）
+ * @param output 輸出的 64 位元組密鑰流
  */
-static void chacha20_block(uint32_t *output) {
-    /* 複製狀態到工作緩衝區 */
-    memcpy(working_state, state, sizeof(state));
+static void chacha20_block(const uint32_t *state, uint8_t *output) {
+    uint32_t x[16];
+    memcpy(x, state, sizeof(x));
     
     /* 執行 10 次雙輪（共 20 輪） */
     for (int i = 0; i < 10; i++) {
         /* 行輪 */
-        quarter_round(&working_state[0], &working_state[4], &working_state[8], &working_state[12]);
-        quarter_round(&working_state[1], &working_state[5], &working_state[9], &working_state[13]);
-        quarter_round(&working_state[2], &working_state[6], &working_state[10], &working_state[14]);
-        quarter_round(&working_state[3], &working_state[7], &working_state[11], &working_state[15]);
+        quarter_round(&x[0], &x[4], &x[8], &x[12]);
+        quarter_round(&x[1], &x[5], &x[9], &x[13]);
+        quarter_round(&x[2], &x[6], &x[10], &x[14]);
+        quarter_round(&x[3], &x[7], &x[11], &x[15]);
         
         /* 對角線輪 */
-        quarter_round(&working_state[0], &working_state[5], &working_state[10], &working_state[15]);
-        quarter_round(&working_state[1], &working_state[6], &working_state[11], &working_state[12]);
-        quarter_round(&working_state[2], &working_state[7], &working_state[8], &working_state[13]);
-        quarter_round(&working_state[3], &working_state[4], &working_state[9], &working_state[14]);
+        quarter_round(&x[0], &x[5], &x[10], &x[15]);
+        quarter_round(&x[1], &x[6], &x[11], &x[12]);
+        quarter_round(&x[2], &x[7], &x[8], &x[13]);
+        quarter_round(&x[3], &x[4], &x[9], &x[14]);
     }
     
     /* 將工作狀態加回原始狀態 */
     for (int i = 0; i < 16; i++) {
-        output[i] = working_state[i] + state[i];
+        store32_le(output + i * 4, x[i] + state[i]);
     }
+}
+
+/**
+ * @brief 純量後端：逐區塊加密
+ *
+ * @param state   ChaCha20 狀態（計數器指向第一個區塊，不修改）
+ * @param input   輸入資料
+ * @param output  輸出資料
+ * @param nblocks 完整區塊數
+ */
+static void blocks_scalar(const uint32_t *state, const uint8_t *input,
+                          uint8_t *output, size_t nblocks) {
+    uint32_t local[16];
+    uint8_t keystream[CHACHA20_BLOCK_SIZE];
+    memcpy(local, state, sizeof(local));
     
-    /* 遞增計數器 */
-    state[12]++;
-    if (state[12] == 0) {
-        state[13]++;  /* 處理溢位 */
+    for (size_t b = 0; b < nblocks; b++) {
+        chacha20_block(local, keystream);
+        for (size_t i = 0; i < CHACHA20_BLOCK_SIZE; i++) {
+            output[i] = input[i] ^ keystream[i];
+        }
+        advance_counter(local, 1);
+        input += CHACHA20_BLOCK_SIZE;
+        output += CHACHA20_BLOCK_SIZE;
     }
+    
+    secure_zero(keystream, sizeof(keystream));
 }
 
 /* ========================================================================
- * 公開函式實作
+ * SIMD 後端
+ *
+ * 每個向量的第 j 個通道存放第 j 個區塊的同一個狀態字，
+ * 因此四分之一輪可同時作用於多個區塊；最後轉置回各區塊的位元組順序。
+ * 批次內計數器會溢位時改用純量後端，以維持進位行為。
  * ======================================================================== */
 
+#if defined(__SSE2__)
+
+#define SSE_ROTL(v, n) _mm_or_si128(_mm_slli_epi32((v), (n)), _mm_srli_epi32((v), 32 - (n)))
+
+#define SSE_QR(a, b, c, d) do {                                     \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL(d, 16); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL(b, 12); \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL(d, 8);  \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL(b, 7);  \
+} while (0)
+
 /**
- * @brief 初始化 ChaCha20 加密狀態
+ * @brief SSE2 後端：一次處理 4 個區塊
  */
-void chacha20_init(const uint8_t *key, const uint8_t *nonce, uint32_t counter) {
+static void blocks_sse2(const uint32_t *state, const uint8_t *input,
+                        uint8_t *output, size_t nblocks) {
+    uint32_t local[16];
+    memcpy(local, state, sizeof(local));
+    
+    while (nblocks >= 4 && local[12] <= UINT32_MAX - 4) {
+        __m128i x[16], orig[16];
+        for (int i = 0; i < 16; i++) {
+            orig[i] = _mm_set1_epi32((int)local[i]);
+        }
+        orig[12] = _mm_add_epi32(orig[12], _mm_set_epi32(3, 2, 1, 0));
+        memcpy(x, orig, sizeof(x));
+        
+        for (int r = 0; r < 10; r++) {
+            SSE_QR(x[0], x[4], x[8], x[12]);
+            SSE_QR(x[1], x[5], x[9], x[13]);
+            SSE_QR(x[2], x[6], x[10], x[14]);
+            SSE_QR(x[3], x[7], x[11], x[15]);
+            SSE_QR(x[0], x[5], x[10], x[15]);
+            SSE_QR(x[1], x[6], x[11], x[12]);
+            SSE_QR(x[2], x[7], x[8], x[13]);
+            SSE_QR(x[3], x[4], x[9], x[14]);
+        }
+        
+        for (int g = 0; g < 4; g++) {
+            /* 轉置 4x4：第 g 組四個字 → 四個區塊各自的 16 位元組 */
+            __m128i a = _mm_add_epi32(x[4 * g + 0], orig[4 * g + 0]);
+            __m128i b = _mm_add_epi32(x[4 * g + 1], orig[4 * g + 1]);
+            __m128i c = _mm_add_epi32(x[4 * g + 2], orig[4 * g + 2]);
+            __m128i d = _mm_add_epi32(x[4 * g + 3], orig[4 * g + 3]);
+            __m128i ab_lo = _mm_unpacklo_epi32(a, b);
+            __m128i ab_hi = _mm_unpackhi_epi32(a, b);
+            __m128i cd_lo = _mm_unpacklo_epi32(c, d);
+            __m128i cd_hi = _mm_unpackhi_epi32(c, d);
+            __m128i rows[4] = {
+                _mm_unpacklo_epi64(ab_lo, cd_lo),
+                _mm_unpackhi_epi64(ab_lo, cd_lo),
+                _mm_unpacklo_epi64(ab_hi, cd_hi),
+                _mm_unpackhi_epi64(ab_hi, cd_hi)
+            };
+            for (int j = 0; j < 4; j++) {
+                size_t off = (size_t)j * CHACHA20_BLOCK_SIZE + (size_t)g * 16;
+                __m128i in = _mm_loadu_si128((const __m128i *)(input + off));
+                _mm_storeu_si128((__m128i *)(output + off), _mm_xor_si128(in, rows[j]));
+            }
+        }
+        
+        advance_counter(local, 4);
+        input += 4 * CHACHA20_BLOCK_SIZE;
+        output += 4 * CHACHA20_BLOCK_SIZE;
+        nblocks -= 4;
+    }
+    
+    blocks_scalar(local, input, output, nblocks);
+}
+
+#endif /* __SSE2__ */
+
+#if defined(CHACHA20_HAVE_AVX2)
+
+#define AVX_ROTL(v, n) _mm256_or_si256(_mm256_slli_epi32((v), (n)), _mm256_srli_epi32((v), 32 - (n)))
+
+#define AVX_QR(a, b, c, d) do {                                           \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = AVX_ROTL(d, 16); \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL(b, 12); \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = AVX_ROTL(d, 8);  \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL(b, 7);  \
+} while (0)
+
+/**
+ * @brief AVX2 後端：一次處理 8 個區塊
+ */
+__attribute__((target("avx2")))
+static void blocks_avx2(const uint32_t *state, const uint8_t *input,
+                        uint8_t *output, size_t nblocks) {
+    uint32_t local[16];
+    memcpy(local, state, sizeof(local));
+    
+    while (nblocks >= 8 && local[12] <= UINT32_MAX - 8) {
+        __m256i x[16], orig[16];
+        for (int i = 0; i < 16; i++) {
+            orig[i] = _mm256_set1_epi32((int)local[i]);
+        }
+        orig[12] = _mm256_add_epi32(orig[12], _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        memcpy(x, orig, sizeof(x));
+        
+        for (int r = 0; r < 10; r++) {
+            AVX_QR(x[0], x[4], x[8], x[12]);
+            AVX_QR(x[1], x[5], x[9], x[13]);
+            AVX_QR(x[2], x[6], x[10], x[14]);
+            AVX_QR(x[3], x[7], x[11], x[15]);
+            AVX_QR(x[0], x[5], x[10], x[15]);
+            AVX_QR(x[1], x[6], x[11], x[12]);
+            AVX_QR(x[2], x[7], x[8], x[13]);
+            AVX_QR(x[3], x[4], x[9], x[14]);
+        }
+        
+        /* 每個 128 位元通道內轉置 4x4：rows[g][j] 的低半為區塊 j、高半為區塊 j+4 */
+        __m256i rows[4][4];
+        for (int g = 0; g < 4; g++) {
+            __m256i a = _mm256_add_epi32(x[4 * g + 0], orig[4 * g + 0]);
+            __m256i b = _mm256_add_epi32(x[4 * g + 1], orig[4 * g + 1]);
+            __m256i c = _mm256_add_epi32(x[4 * g + 2], orig[4 * g + 2]);
+            __m256i d = _mm256_add_epi32(x[4 * g + 3], orig[4 * g + 3]);
+            __m256i ab_lo = _mm256_unpacklo_epi32(a, b);
+            __m256i ab_hi = _mm256_unpackhi_epi32(a, b);
+            __m256i cd_lo = _mm256_unpacklo_epi32(c, d);
+            __m256i cd_hi = _mm256_unpackhi_epi32(c, d);
+            rows[g][0] = _mm256_unpacklo_epi64(ab_lo, cd_lo);
+            rows[g][1] = _mm256_unpackhi_epi64(ab_lo, cd_lo);
+            rows[g][2] = _mm256_unpacklo_epi64(ab_hi, cd_hi);
+            rows[g][3] = _mm256_unpackhi_epi64(ab_hi, cd_hi);
+        }
+        
+        for (int j = 0; j < 4; j++) {
+            /* 組合兩組的同一半，得到區塊 j 與 j+4 各 32 位元組 */
+            for (int h = 0; h < 2; h++) {
+                __m256i lo = _mm256_permute2x128_si256(rows[2 * h][j], rows[2 * h + 1][j], 0x20);
+                __m256i hi = _mm256_permute2x128_si256(rows[2 * h][j], rows[2 * h + 1][j], 0x31);
+                size_t off_lo = (size_t)j * CHACHA20_BLOCK_SIZE + (size_t)h * 32;
+                size_t off_hi = (size_t)(j + 4) * CHACHA20_BLOCK_SIZE + (size_t)h * 32;
+                __m256i in_lo = _mm256_loadu_si256((const __m256i *)(input + off_lo));
+                __m256i in_hi = _mm256_loadu_si256((const __m256i *)(input + off_hi));
+                _mm256_storeu_si256((__m256i *)(output + off_lo), _mm256_xor_si256(in_lo, lo));
+                _mm256_storeu_si256((__m256i *)(output + off_hi), _mm256_xor_si256(in_hi, hi));
+            }
+        }
+        
+        advance_counter(local, 8);
+        input += 8 * CHACHA20_BLOCK_SIZE;
+        output += 8 * CHACHA20_BLOCK_SIZE;
+        nblocks -= 8;
+    }
+
+#if defined(__SSE2__)
+    blocks_sse2(local, input, output, nblocks);
+#else
+    blocks_scalar(local, input, output, nblocks);
+#endif
+}
+
+#endif /* CHACHA20_HAVE_AVX2 */
+
+#if defined(CHACHA20_HAVE_NEON)
+
+#define NEON_ROTL(v, n) vorrq_u32(vshlq_n_u32((v), (n)), vshrq_n_u32((v), 32 - (n)))
+
+#define NEON_QR(a, b, c, d) do {                                  \
+    a = vaddq_u32(a, b); d = veorq_u32(d, a); d = NEON_ROTL(d, 16); \
+    c = vaddq_u32(c, d); b = veorq_u32(b, c); b = NEON_ROTL(b, 12); \
+    a = vaddq_u32(a, b); d = veorq_u32(d, a); d = NEON_ROTL(d, 8);  \
+    c = vaddq_u32(c, d); b = veorq_u32(b, c); b = NEON_ROTL(b, 7);  \
+} while (0)
+
+/**
+ * @brief NEON 後端：一次處理 4 個區塊
+ */
+static void blocks_neon(const uint32_t *state, const uint8_t *input,
+                        uint8_t *output, size_t nblocks) {
+    static const uint32_t lane_offsets[4] = {0, 1, 2, 3};
+    uint32_t local[16];
+    memcpy(local, state, sizeof(local));
+    
+    while (nblocks >= 4 && local[12] <= UINT32_MAX - 4) {
+        uint32x4_t x[16], orig[16];
+        for (int i = 0; i < 16; i++) {
+            orig[i] = vdupq_n_u32(local[i]);
+        }
+        orig[12] = vaddq_u32(orig[12], vld1q_u32(lane_offsets));
+        memcpy(x, orig, sizeof(x));
+        
+        for (int r = 0; r < 10; r++) {
+            NEON_QR(x[0], x[4], x[8], x[12]);
+            NEON_QR(x[1], x[5], x[9], x[13]);
+            NEON_QR(x[2], x[6], x[10], x[14]);
+            NEON_QR(x[3], x[7], x[11], x[15]);
+            NEON_QR(x[0], x[5], x[10], x[15]);
+            NEON_QR(x[1], x[6], x[11], x[12]);
+            NEON_QR(x[2], x[7], x[8], x[13]);
+            NEON_QR(x[3], x[4], x[9], x[14]);
+        }
+        
+        for (int g = 0; g < 4; g++) {
+            uint32x4_t a = vaddq_u32(x[4 * g + 0], orig[4 * g + 0]);
+            uint32x4_t b = vaddq_u32(x[4 * g + 1], orig[4 * g + 1]);
+            uint32x4_t c = vaddq_u32(x[4 * g + 2], orig[4 * g + 2]);
+            uint32x4_t d = vaddq_u32(x[4 * g + 3], orig[4 * g + 3]);
+            uint32x4x2_t ab = vtrnq_u32(a, b);
+            uint32x4x2_t cd = vtrnq_u32(c, d);
+            uint32x4_t rows[4] = {
+                vcombine_u32(vget_low_u32(ab.val[0]), vget_low_u32(cd.val[0])),
+                vcombine_u32(vget_low_u32(ab.val[1]), vget_low_u32(cd.val[1])),
+                vcombine_u32(vget_high_u32(ab.val[0]), vget_high_u32(cd.val[0])),
+                vcombine_u32(vget_high_u32(ab.val[1]), vget_high_u32(cd.val[1]))
+            };
+            for (int j = 0; j < 4; j++) {
+                size_t off = (size_t)j * CHACHA20_BLOCK_SIZE + (size_t)g * 16;
+                uint8x16_t in = vld1q_u8(input + off);
+                vst1q_u8(output + off, veorq_u8(in, vreinterpretq_u8_u32(rows[j])));
+            }
+        }
+        
+        advance_counter(local, 4);
+        input += 4 * CHACHA20_BLOCK_SIZE;
+        output += 4 * CHACHA20_BLOCK_SIZE;
+        nblocks -= 4;
+    }
+    
+    blocks_scalar(local, input, output, nblocks);
+}
+
+#endif /* CHACHA20_HAVE_NEON */
+
+/**
+ * @brief 依執行環境選擇最快的後端
+ */
+static chacha20_blocks_fn select_backend(void) {
+#if defined(CHACHA20_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return blocks_avx2;
+    }
+#endif
+#if defined(__SSE2__)
+    return blocks_sse2;
+#elif defined(CHACHA20_HAVE_NEON)
+    return blocks_neon;
+#else
+    return blocks_scalar;
+#endif
+}
+
+/* ========================================================================
+ * 上下文函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 初始化 ChaCha20 上下文
+ */
+void chacha20_ctx_init(chacha20_ctx_t *ctx, const uint8_t *key, const uint8_t *nonce,
+                       uint32_t counter) {
     /* 設定初始化常數 */
-    state[0] = CHACHA20_CONSTANT_0;
-    state[1] = CHACHA20_CONSTANT_1;
-    state[2] = CHACHA20_CONSTANT_2;
-    state[3] = CHACHA20_CONSTANT_3;
+    ctx->state[0] = CHACHA20_CONSTANT_0;
+    ctx->state[1] = CHACHA20_CONSTANT_1;
+    ctx->state[2] = CHACHA20_CONSTANT_2;
+    ctx->state[3] = CHACHA20_CONSTANT_3;
     
     /* 載入 256 位元密鑰（8 個 32 位元字） */
     for (int i = 0; i < 8; i++) {
-        state[4 + i] = load32_le(key + i * 4);
+        ctx->state[4 + i] = load32_le(key + i * 4);
     }
     
-    /* 設定計數器 */
-    state[12] = counter;
+    /* 設定計數器並載入 96 位元 nonce（3 個 32 位元字） */
+    ctx->state[12] = counter;
+    ctx->state[13] = load32_le(nonce);
+    ctx->state[14] = load32_le(nonce + 4);
+    ctx->state[15] = load32_le(nonce + 8);
     
-    /* 載入 96 位元 nonce（3 個 32 位元字） */
-    state[13] = load32_le(nonce);
-    state[14] = load32_le(nonce + 4);
-    state[15] = load32_le(nonce + 8);
+    ctx->nonce0 = ctx->state[13];
+    ctx->keystream_pos = CHACHA20_BLOCK_SIZE;
+    ctx->blocks = select_backend();
+}
+
+/**
+ * @brief 將上下文移動到串流中的任意位置
+ */
+void chacha20_ctx_seek(chacha20_ctx_t *ctx, uint64_t offset) {
+    uint64_t block = offset / CHACHA20_BLOCK_SIZE;
+    ctx->state[12] = 0;
+    ctx->state[13] = ctx->nonce0;
+    advance_counter(ctx->state, (size_t)block);
+    
+    /* 起始位置不在區塊邊界時，預先產生該區塊並略過前段 */
+    ctx->keystream_pos = CHACHA20_BLOCK_SIZE;
+    size_t skip = (size_t)(offset % CHACHA20_BLOCK_SIZE);
+    if (skip != 0) {
+        chacha20_block(ctx->state, ctx->keystream);
+        advance_counter(ctx->state, 1);
+        ctx->keystream_pos = skip;
+    }
+}
+
+/**
+ * @brief 以上下文加密或解密資料
+ */
+void chacha20_ctx_xor(chacha20_ctx_t *ctx, const uint8_t *input, uint8_t *output, size_t len) {
+    /* 先用完上次剩餘的密鑰流 */
+    while (len > 0 && ctx->keystream_pos < CHACHA20_BLOCK_SIZE) {
+        *output++ = *input++ ^ ctx->keystream[ctx->keystream_pos++];
+        len--;
+    }
+    
+    /* 完整區塊交給後端批次處理 */
+    size_t nblocks = len / CHACHA20_BLOCK_SIZE;
+    if (nblocks > 0) {
+        ctx->blocks(ctx->state, input, output, nblocks);
+        advance_counter(ctx->state, nblocks);
+        input += nblocks * CHACHA20_BLOCK_SIZE;
+        output += nblocks * CHACHA20_BLOCK_SIZE;
+        len -= nblocks * CHACHA20_BLOCK_SIZE;
+    }
+    
+    /* 尾端不足一個區塊，保留剩餘密鑰流供下次使用 */
+    if (len > 0) {
+        chacha20_block(ctx->state, ctx->keystream);
+        advance_counter(ctx->state, 1);
+        for (size_t i = 0; i < len; i++) {
+            output[i] = input[i] ^ ctx->keystream[i];
+        }
+        ctx->keystream_pos = len;
+    }
+}
+
+/**
+ * @brief 清除上下文中的密鑰資料
+ */
+void chacha20_ctx_wipe(chacha20_ctx_t *ctx) {
+    secure_zero(ctx, sizeof(chacha20_ctx_t));
+}
+
+/* ========================================================================
+ * 公開函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 初始化 ChaCha20 加密狀態
+ */
+void chacha20_init(const uint8_t *key, const uint8_t *nonce, uint32_t counter) {
+    chacha20_ctx_init(&legacy_ctx, key, nonce, counter);
 }
 
 /**
  * @brief 加密或解密資料
  */
 void chacha20_encrypt(const uint8_t *input, uint8_t *output, size_t len) {
-    uint32_t keystream[16];
-    size_t pos = 0;
+    /* 舊介面每次呼叫都從新的區塊開始，捨棄上次剩餘的密鑰流 */
+    legacy_ctx.keystream_pos = CHACHA20_BLOCK_SIZE;
+    chacha20_ctx_xor(&legacy_ctx, input, output, len);
+}
+
+/**
+ * @brief 從串流任意位置開始加密或解密資料
+ */
+void chacha20_encrypt_at(const uint8_t *key, const uint8_t *nonce, uint64_t offset,
+                         const uint8_t *input, uint8_t *output, size_t len) {
+    chacha20_ctx_t ctx;
+    chacha20_ctx_init(&ctx, key, nonce, 0);
+    chacha20_ctx_seek(&ctx, offset);
+    chacha20_ctx_xor(&ctx, input, output, len);
+    chacha20_ctx_wipe(&ctx);
+}
+
+/**
+ * @brief 平行加密的工作描述
+ */
+typedef struct {
+    const uint8_t *key;                    /**< 32 位元組密鑰 */
+    const uint8_t *nonce;                  /**< 12 位元組 nonce */
+    uint64_t offset;                       /**< 資料起始的串流位置 */
+    const uint8_t *input;                  /**< 輸入資料 */
+    uint8_t *output;                       /**< 輸出資料 */
+    size_t len;                            /**< 資料總長度 */
+    size_t piece;                          /**< 每個片段的長度（區塊大小的倍數） */
+} parallel_job_t;
+
+/**
+ * @brief 處理第 index 個片段
+ */
+static void parallel_piece(void *arg, size_t index) {
+    const parallel_job_t *job = (const parallel_job_t *)arg;
+    size_t start = index * job->piece;
+    size_t len = job->len - start < job->piece ? job->len - start : job->piece;
     
-    while (pos < len) {
-        /* 產生 64 位元組的密鑰流 */
-        chacha20_block(keystream);
-        
-        /* 使用 XOR 進行加密/解密 */
-        size_t block_pos = 0;
-        while (block_pos < 64 && pos < len) {
-            output[pos] = input[pos] ^ ((uint8_t *)keystream)[block_pos];
-            pos++;
-            block_pos++;
-        }
+    chacha20_encrypt_at(job->key, job->nonce, job->offset + start,
+                        job->input + start, job->output + start, len);
+}
+
+/**
+ * @brief 以執行緒池平行加密或解密串流中的一段資料
+ */
+void chacha20_xor_parallel(threadpool_t *pool, const uint8_t *key, const uint8_t *nonce,
+                           uint64_t offset, const uint8_t *input, uint8_t *output, size_t len) {
+    TRACE_SCOPE(TRACE_CHACHA20);
+    size_t threads = threadpool_size(pool);
+    if (threads <= 1 || len < CHACHA20_PARALLEL_MIN) {
+        chacha20_encrypt_at(key, nonce, offset, input, output, len);
+        return;
+    }
+    
+    /* 每個執行緒一個片段；片段邊界對齊到串流中的區塊邊界 */
+    size_t piece = (len + threads - 1) / threads;
+    piece = (piece + CHACHA20_BLOCK_SIZE - 1) / CHACHA20_BLOCK_SIZE * CHACHA20_BLOCK_SIZE;
+    size_t head = (size_t)((CHACHA20_BLOCK_SIZE - offset % CHACHA20_BLOCK_SIZE) % CHACHA20_BLOCK_SIZE);
+    if (head != 0) {
+        chacha20_encrypt_at(key, nonce, offset, input, output, head);
     }
+    
+    parallel_job_t job = {
+        key, nonce, offset + head, input + head, output + head, len - head, piece
+    };
+    threadpool_parallel_for(pool, (job.len + piece - 1) / piece, parallel_piece, &job);
 }
 
 /**
@@ -182,10 +622,13 @@ void chacha20_derive_key(const char *key_str, uint8_t *key) {
 /**
  * @brief 使用密鑰字串進行加密或解密
  */
-void chacha20_encrypt_with_key(const char *key_str, const uint8_t *nonce, 
+void chacha20_encrypt_with_key(const char *key_str, const uint8_t *nonce,
                                 const uint8_t *input, uint8_t *output, size_t len) {
     uint8_t key[32];
+    chacha20_ctx_t ctx;
     chacha20_derive_key(key_str, key);
-    chacha20_init(key, nonce, 0);
-    chacha20_encrypt(input, output, len);
+    chacha20_ctx_init(&ctx, key, nonce, 0);
+    chacha20_ctx_xor(&ctx, input, output, len);
+    chacha20_ctx_wipe(&ctx);
+    secure_zero(key, sizeof(key));
 }
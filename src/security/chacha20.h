@@ -18,9 +18,87 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "../utils/threadpool.h"
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/** ChaCha20 區塊大小（位元組） */
+#define CHACHA20_BLOCK_SIZE 64
+
+/** 平行處理的最小資料量，較小的資料切分成本高於收益（位元組） */
+#define CHACHA20_PARALLEL_MIN (256 * 1024)
+
+/**
+ * @brief 批次區塊加密後端
+ *
+ * 以 state 的計數器為起點處理 nblocks 個完整區塊，不修改 state。
+ */
+typedef void (*chacha20_blocks_fn)(const uint32_t *state, const uint8_t *input,
+                                   uint8_t *output, size_t nblocks);
+
+/**
+ * @brief ChaCha20 加密上下文
+ *
+ * 所有狀態皆存放在上下文中，不同執行緒可各自使用獨立的上下文。
+ */
+typedef struct {
+    uint32_t state[16];                    /**< ChaCha20 狀態（計數器指向下一個區塊） */
+    uint32_t nonce0;                       /**< nonce 第一個字（計數器進位的基準） */
+    uint8_t keystream[CHACHA20_BLOCK_SIZE]; /**< 尚未用完的密鑰流區塊 */
+    size_t keystream_pos;                  /**< keystream 已使用的位元組數 */
+    chacha20_blocks_fn blocks;             /**< 執行期選用的 SIMD 或純量後端 */
+} chacha20_ctx_t;
+
+/* ========================================================================
+ * ChaCha20 上下文函式
+ * ======================================================================== */
+
+/**
+ * @brief 初始化 ChaCha20 上下文
+ *
+ * 同時依 CPU 功能選擇批次加密後端（AVX2、SSE2、NEON 或純量）。
+ *
+ * @param ctx     上下文
+ * @param key     32 位元組密鑰
+ * @param nonce   12 位元組 nonce
+ * @param counter 初始區塊計數器
+ */
+void chacha20_ctx_init(chacha20_ctx_t *ctx, const uint8_t *key, const uint8_t *nonce,
+                       uint32_t counter);
+
+/**
+ * @brief 將上下文移動到串流中的任意位置
+ *
+ * @param ctx    上下文
+ * @param offset 串流位置（位元組，自計數器 0 起算）
+ */
+void chacha20_ctx_seek(chacha20_ctx_t *ctx, uint64_t offset);
+
+/**
+ * @brief 以上下文加密或解密資料
+ *
+ * 連續呼叫等同處理一段連續的串流，長度不必為區塊大小的倍數。
+ *
+ * @param ctx    上下文
+ * @param input  輸入資料
+ * @param output 輸出資料（可與 input 相同以就地處理）
+ * @param len    資料長度
+ */
+void chacha20_ctx_xor(chacha20_ctx_t *ctx, const uint8_t *input, uint8_t *output, size_t len);
+
+/**
+ * @brief 清除上下文中的密鑰資料
+ *
+ * @param ctx 上下文
+ */
+void chacha20_ctx_wipe(chacha20_ctx_t *ctx);
 
 /* ========================================================================
  * ChaCha20 核心函式
+ *
+ * 以下函式共用一個全域上下文，不可重入；新程式碼請使用 chacha20_ctx_*。
  * ======================================================================== */
 
 /**
@@ -64,10 +142,48 @@ void chacha20_encrypt(const uint8_t *input, uint8_t *output, size_t len);
  * @param input   輸入資料
  * @param output  輸出資料
  * @param len     資料長度
+ *
+ * @note 每次呼叫都會以 chacha20_derive_key 重新衍生密鑰，僅適用於舊格式；
+ *       新資料請以 kdf_derive（kdf.h）衍生一次後改用 chacha20_encrypt_at
  */
 void chacha20_encrypt_with_key(const char *key_str, const uint8_t *nonce, 
                                 const uint8_t *input, uint8_t *output, size_t len);
 
+/**
+ * @brief 從串流任意位置開始加密或解密資料
+ *
+ * 依 offset 計算對應的區塊計數器並略過區塊內的前置位元組，
+ * 讓呼叫者可隨機存取以同一組密鑰與 nonce 加密的串流。
+ *
+ * @param key    32 位元組密鑰
+ * @param nonce  12 位元組 nonce
+ * @param offset 資料在串流中的起始位置（位元組）
+ * @param input  輸入資料
+ * @param output 輸出資料（可與 input 相同以就地處理）
+ * @param len    資料長度
+ */
+void chacha20_encrypt_at(const uint8_t *key, const uint8_t *nonce, uint64_t offset,
+                         const uint8_t *input, uint8_t *output, size_t len);
+
+/**
+ * @brief 以執行緒池平行加密或解密串流中的一段資料
+ *
+ * 密鑰流區塊只取決於密鑰、nonce 與計數器，因此資料可依區塊邊界切成
+ * 互不相依的片段，各執行緒以獨立的上下文處理。資料量小於
+ * CHACHA20_PARALLEL_MIN 或 pool 為 NULL 時在呼叫端處理。
+ * 結果與 chacha20_encrypt_at 相同。
+ *
+ * @param pool   執行緒池（可為 NULL）
+ * @param key    32 位元組密鑰
+ * @param nonce  12 位元組 nonce
+ * @param offset 資料在串流中的起始位置（位元組）
+ * @param input  輸入資料
+ * @param output 輸出資料（可與 input 相同以就地處理）
+ * @param len    資料長度
+ */
+void chacha20_xor_parallel(threadpool_t *pool, const uint8_t *key, const uint8_t *nonce,
+                           uint64_t offset, const uint8_t *input, uint8_t *output, size_t len);
+
 /**
  * @brief 從密鑰字串衍生 32 位元組密鑰
  *
@@ -76,7 +192,8 @@ void chacha20_encrypt_with_key(const char *key_str, const uint8_t *nonce,
  * @param key_str 密鑰字串
  * @param key     輸出的 32 位元組密鑰陣列
  *
- * @note 此為簡化實作，正式環境建議使用標準 KDF
+ * @note 此為簡化實作（非標準 KDF），只用於載入舊版映像檔與日誌；
+ *       新寫出的檔案以 kdf.h 的 scrypt 衍生密鑰
  */
 void chacha20_derive_key(const char *key_str, uint8_t *key);
 
@@ -0,0 +1,628 @@
+/**
+ * @file kdf.c
+ * @brief 密鑰衍生模組實作
+ *
+ * scrypt 依 RFC 7914 實作：以 PBKDF2-HMAC-SHA256 展開密碼，
+ * 每個 128 * r 位元組的區塊經 ROMix（Salsa20/8 BlockMix）混合後，
+ * 再以 PBKDF2 壓縮成最終密鑰。SHA-256 依 FIPS 180-4 實作，僅供本模組使用。
+ *
+ * 衍生結果放入小型快取（以互斥鎖保護），同一工作階段中的多次儲存、
+ * 日誌重設與延遲載入不會重複進行耗時的衍生。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "kdf.h"
+#include "../utils/memory.h"
+#include "../utils/error.h"
+#include <pthread.h>
+#include <string.h>
+
+/** SHA-256 區塊大小（位元組） */
+#define SHA256_BLOCK_SIZE 64
+
+/** SHA-256 摘要大小（位元組） */
+#define SHA256_DIGEST_SIZE 32
+
+/** 快取的密鑰數量 */
+#define KDF_CACHE_SIZE 4
+
+/** 成本參數 log_n 的上限 */
+#define KDF_MAX_LOG_N 30
+
+/* ========================================================================
+ * 內部輔助函式
+ * ======================================================================== */
+
+/**
+ * @brief 從位元組陣列載入 32 位元字（little-endian）
+ */
+static uint32_t load32_le(const uint8_t *b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+           ((uint32_t)b[3] << 24);
+}
+
+/**
+ * @brief 將 32 位元字存入位元組陣列（little-endian）
+ */
+static void store32_le(uint8_t *b, uint32_t v) {
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+    b[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief 從位元組陣列載入 32 位元字（big-endian）
+ */
+static uint32_t load32_be(const uint8_t *b) {
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) |
+           (uint32_t)b[3];
+}
+
+/**
+ * @brief 將 32 位元字存入位元組陣列（big-endian）
+ */
+static void store32_be(uint8_t *b, uint32_t v) {
+    b[0] = (uint8_t)(v >> 24);
+    b[1] = (uint8_t)(v >> 16);
+    b[2] = (uint8_t)(v >> 8);
+    b[3] = (uint8_t)v;
+}
+
+/**
+ * @brief 32 位元循環左移
+ */
+static uint32_t rotl32(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+/* ========================================================================
+ * SHA-256 / HMAC / PBKDF2
+ * ======================================================================== */
+
+/**
+ * @brief SHA-256 計算上下文
+ */
+typedef struct {
+    uint32_t state[8];                     /**< 雜湊狀態 */
+    uint64_t length;                       /**< 已處理的位元組數 */
+    uint8_t buffer[SHA256_BLOCK_SIZE];     /**< 未滿一個區塊的剩餘資料 */
+    size_t leftover;                       /**< 剩餘資料長度 */
+} sha256_ctx_t;
+
+/**
+ * @brief HMAC-SHA256 上下文（內外兩層雜湊）
+ */
+typedef struct {
+    sha256_ctx_t inner;                    /**< 已餵入 key ^ ipad 的內層雜湊 */
+    sha256_ctx_t outer;                    /**< 已餵入 key ^ opad 的外層雜湊 */
+} hmac_ctx_t;
+
+/** SHA-256 回合常數 */
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * @brief 處理一個 64 位元組區塊
+ */
+static void sha256_block(sha256_ctx_t *ctx, const uint8_t *block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = load32_be(block + i * 4);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotl32(w[i - 15], 25) ^ rotl32(w[i - 15], 14) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotl32(w[i - 2], 15) ^ rotl32(w[i - 2], 13) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+    uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotl32(e, 26) ^ rotl32(e, 21) ^ rotl32(e, 7)) +
+                      ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotl32(a, 30) ^ rotl32(a, 19) ^ rotl32(a, 10)) +
+                      ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+    ctx->state[5] += f;
+    ctx->state[6] += g;
+    ctx->state[7] += h;
+    secure_zero(w, sizeof(w));
+}
+
+/**
+ * @brief 初始化 SHA-256 上下文
+ */
+static void sha256_init(sha256_ctx_t *ctx) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->length = 0;
+    ctx->leftover = 0;
+}
+
+/**
+ * @brief 餵入資料
+ */
+static void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t len) {
+    ctx->length += len;
+    
+    if (ctx->leftover > 0) {
+        size_t want = SHA256_BLOCK_SIZE - ctx->leftover;
+        if (want > len) {
+            want = len;
+        }
+        memcpy(ctx->buffer + ctx->leftover, data, want);
+        ctx->leftover += want;
+        data += want;
+        len -= want;
+        if (ctx->leftover < SHA256_BLOCK_SIZE) {
+            return;
+        }
+        sha256_block(ctx, ctx->buffer);
+        ctx->leftover = 0;
+    }
+    
+    while (len >= SHA256_BLOCK_SIZE) {
+        sha256_block(ctx, data);
+        data += SHA256_BLOCK_SIZE;
+        len -= SHA256_BLOCK_SIZE;
+    }
+    
+    if (len > 0) {
+        memcpy(ctx->buffer, data, len);
+        ctx->leftover = len;
+    }
+}
+
+/**
+ * @brief 輸出摘要並清除上下文
+ */
+static void sha256_final(sha256_ctx_t *ctx, uint8_t *digest) {
+    uint64_t bits = ctx->length * 8;
+    
+    /* 補上 0x80 與 0，最後 8 位元組為訊息位元長度（big-endian） */
+    ctx->buffer[ctx->leftover++] = 0x80;
+    if (ctx->leftover > SHA256_BLOCK_SIZE - 8) {
+        memset(ctx->buffer + ctx->leftover, 0, SHA256_BLOCK_SIZE - ctx->leftover);
+        sha256_block(ctx, ctx->buffer);
+        ctx->leftover = 0;
+    }
+    memset(ctx->buffer + ctx->leftover, 0, SHA256_BLOCK_SIZE - 8 - ctx->leftover);
+    store32_be(ctx->buffer + 56, (uint32_t)(bits >> 32));
+    store32_be(ctx->buffer + 60, (uint32_t)bits);
+    sha256_block(ctx, ctx->buffer);
+    
+    for (int i = 0; i < 8; i++) {
+        store32_be(digest + i * 4, ctx->state[i]);
+    }
+    secure_zero(ctx, sizeof(*ctx));
+}
+
+/**
+ * @brief 以密鑰初始化 HMAC-SHA256 上下文
+ */
+static void hmac_init(hmac_ctx_t *ctx, const uint8_t *key, size_t key_len) {
+    uint8_t block[SHA256_BLOCK_SIZE];
+    memset(block, 0, sizeof(block));
+    
+    /* 超過區塊大小的密鑰先雜湊 */
+    if (key_len > SHA256_BLOCK_SIZE) {
+        sha256_ctx_t hash;
+        sha256_init(&hash);
+        sha256_update(&hash, key, key_len);
+        sha256_final(&hash, block);
+    } else if (key_len > 0) {
+        memcpy(block, key, key_len);
+    }
+    
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        block[i] ^= 0x36;
+    }
+    sha256_init(&ctx->inner);
+    sha256_update(&ctx->inner, block, sizeof(block));
+    
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        block[i] ^= 0x36 ^ 0x5c;
+    }
+    sha256_init(&ctx->outer);
+    sha256_update(&ctx->outer, block, sizeof(block));
+    
+    secure_zero(block, sizeof(block));
+}
+
+/**
+ * @brief 輸出 HMAC 值並清除上下文
+ */
+static void hmac_final(hmac_ctx_t *ctx, uint8_t *mac) {
+    uint8_t inner[SHA256_DIGEST_SIZE];
+    sha256_final(&ctx->inner, inner);
+    sha256_update(&ctx->outer, inner, sizeof(inner));
+    sha256_final(&ctx->outer, mac);
+    secure_zero(inner, sizeof(inner));
+}
+
+/**
+ * @brief PBKDF2-HMAC-SHA256（迭代次數固定為 1，scrypt 只需要這個形式）
+ */
+static void pbkdf2_sha256(const uint8_t *password, size_t password_len,
+                          const uint8_t *salt, size_t salt_len, uint8_t *out, size_t out_len) {
+    /* 以密碼初始化一次，每個輸出區塊複製已餵入密鑰的上下文 */
+    hmac_ctx_t base;
+    hmac_init(&base, password, password_len);
+    
+    uint8_t counter[4];
+    uint8_t mac[SHA256_DIGEST_SIZE];
+    for (uint32_t i = 1; out_len > 0; i++) {
+        hmac_ctx_t ctx = base;
+        store32_be(counter, i);
+        sha256_update(&ctx.inner, salt, salt_len);
+        sha256_update(&ctx.inner, counter, sizeof(counter));
+        hmac_final(&ctx, mac);
+        
+        size_t n = out_len < sizeof(mac) ? out_len : sizeof(mac);
+        memcpy(out, mac, n);
+        out += n;
+        out_len -= n;
+    }
+    
+    secure_zero(&base, sizeof(base));
+    secure_zero(mac, sizeof(mac));
+}
+
+/* ========================================================================
+ * scrypt
+ * ======================================================================== */
+
+/**
+ * @brief Salsa20/8 核心：B = Salsa20/8(B)
+ */
+static void salsa20_8(uint32_t *b) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+    
+    for (int i = 0; i < 8; i += 2) {
+        /* 行運算 */
+        x[4] ^= rotl32(x[0] + x[12], 7);
+        x[8] ^= rotl32(x[4] + x[0], 9);
+        x[12] ^= rotl32(x[8] + x[4], 13);
+        x[0] ^= rotl32(x[12] + x[8], 18);
+        x[9] ^= rotl32(x[5] + x[1], 7);
+        x[13] ^= rotl32(x[9] + x[5], 9);
+        x[1] ^= rotl32(x[13] + x[9], 13);
+        x[5] ^= rotl32(x[1] + x[13], 18);
+        x[14] ^= rotl32(x[10] + x[6], 7);
+        x[2] ^= rotl32(x[14] + x[10], 9);
+        x[6] ^= rotl32(x[2] + x[14], 13);
+        x[10] ^= rotl32(x[6] + x[2], 18);
+        x[3] ^= rotl32(x[15] + x[11], 7);
+        x[7] ^= rotl32(x[3] + x[15], 9);
+        x[11] ^= rotl32(x[7] + x[3], 13);
+        x[15] ^= rotl32(x[11] + x[7], 18);
+        
+        /* 列運算 */
+        x[1] ^= rotl32(x[0] + x[3], 7);
+        x[2] ^= rotl32(x[1] + x[0], 9);
+        x[3] ^= rotl32(x[2] + x[1], 13);
+        x[0] ^= rotl32(x[3] + x[2], 18);
+        x[6] ^= rotl32(x[5] + x[4], 7);
+        x[7] ^= rotl32(x[6] + x[5], 9);
+        x[4] ^= rotl32(x[7] + x[6], 13);
+        x[5] ^= rotl32(x[4] + x[7], 18);
+        x[11] ^= rotl32(x[10] + x[9], 7);
+        x[8] ^= rotl32(x[11] + x[10], 9);
+        x[9] ^= rotl32(x[8] + x[11], 13);
+        x[10] ^= rotl32(x[9] + x[8], 18);
+        x[12] ^= rotl32(x[15] + x[14], 7);
+        x[13] ^= rotl32(x[12] + x[15], 9);
+        x[14] ^= rotl32(x[13] + x[12], 13);
+        x[15] ^= rotl32(x[14] + x[13], 18);
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        b[i] += x[i];
+    }
+}
+
+/**
+ * @brief scryptBlockMix：in 為 2r 個 64 位元組區塊，結果寫入 out
+ *
+ * 輸出順序為偶數區塊在前、奇數區塊在後（RFC 7914 第 4 節）。
+ */
+static void block_mix(const uint32_t *in, uint32_t *out, size_t r) {
+    uint32_t x[16];
+    memcpy(x, in + (2 * r - 1) * 16, sizeof(x));
+    
+    for (size_t i = 0; i < 2 * r; i++) {
+        for (int j = 0; j < 16; j++) {
+            x[j] ^= in[i * 16 + j];
+        }
+        salsa20_8(x);
+        memcpy(out + ((i & 1) * r + i / 2) * 16, x, sizeof(x));
+    }
+}
+
+/**
+ * @brief scryptROMix：以 N 個區塊的表 v 混合 b（32 * r 個字）
+ *
+ * @param b  區塊（原地更新）
+ * @param n  成本參數 N
+ * @param r  區塊大小參數
+ * @param v  工作表（n * 32 * r 個字）
+ * @param xy 暫存區（2 * 32 * r 個字）
+ */
+static void ro_mix(uint32_t *b, uint64_t n, size_t r, uint32_t *v, uint32_t *xy) {
+    size_t words = 32 * r;
+    uint32_t *x = xy;
+    uint32_t *y = xy + words;
+    
+    memcpy(x, b, words * sizeof(uint32_t));
+    for (uint64_t i = 0; i < n; i++) {
+        memcpy(v + i * words, x, words * sizeof(uint32_t));
+        block_mix(x, y, r);
+        memcpy(x, y, words * sizeof(uint32_t));
+    }
+    
+    for (uint64_t i = 0; i < n; i++) {
+        /* Integerify：最後一個 64 位元組區塊的第一個字（N <= 2^30，取低 32 位元即可） */
+        uint64_t j = x[(2 * r - 1) * 16] & (n - 1);
+        const uint32_t *vj = v + j * words;
+        for (size_t k = 0; k < words; k++) {
+            x[k] ^= vj[k];
+        }
+        block_mix(x, y, r);
+        memcpy(x, y, words * sizeof(uint32_t));
+    }
+    
+    memcpy(b, x, words * sizeof(uint32_t));
+}
+
+/* ========================================================================
+ * 密鑰衍生函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 預設的成本參數
+ */
+kdf_params_t kdf_default_params(void) {
+    kdf_params_t params = { KDF_DEFAULT_LOG_N, KDF_DEFAULT_R, KDF_DEFAULT_P };
+    return params;
+}
+
+/**
+ * @brief 檢查成本參數是否有效（含記憶體上限）
+ */
+bool kdf_params_valid(const kdf_params_t *params) {
+    if (params == NULL || params->log_n == 0 || params->log_n > KDF_MAX_LOG_N ||
+        params->r == 0 || params->p == 0) {
+        return false;
+    }
+    
+    /* 工作表 128 * r * N 與展開的區塊 128 * r * p 都不得超過上限 */
+    uint64_t block = 128ull * params->r;
+    return block << params->log_n <= KDF_MAX_MEMORY &&
+           block * params->p <= KDF_MAX_MEMORY;
+}
+
+/**
+ * @brief 以 scrypt 衍生密鑰（不使用快取）
+ */
+bool kdf_scrypt(const uint8_t *password, size_t password_len,
+                const uint8_t *salt, size_t salt_len,
+                const kdf_params_t *params, uint8_t *out, size_t out_len) {
+    if ((password == NULL && password_len > 0) || (salt == NULL && salt_len > 0) ||
+        out == NULL || out_len == 0 || !kdf_params_valid(params)) {
+        error_set(ERR_INVALID_INPUT, "無效的密鑰衍生參數");
+        return false;
+    }
+    
+    size_t r = params->r;
+    size_t p = params->p;
+    uint64_t n = 1ull << params->log_n;
+    size_t words = 32 * r;
+    size_t block_bytes = words * sizeof(uint32_t);
+    
+    uint8_t *b = safe_malloc_uninit(block_bytes * p);
+    uint32_t *v = safe_malloc_uninit((size_t)n * block_bytes);
+    uint32_t *xy = safe_malloc_uninit(3 * block_bytes);
+    if (b == NULL || v == NULL || xy == NULL) {
+        safe_free(b);
+        safe_free(v);
+        safe_free(xy);
+        error_set(ERR_MEMORY, "密鑰衍生記憶體不足");
+        return false;
+    }
+    
+    pbkdf2_sha256(password, password_len, salt, salt_len, b, block_bytes * p);
+    
+    /* 每個區塊以 little-endian 字處理；xy 前段放區塊，後段為 ROMix 的暫存區 */
+    for (size_t i = 0; i < p; i++) {
+        uint8_t *chunk = b + i * block_bytes;
+        for (size_t k = 0; k < words; k++) {
+            xy[k] = load32_le(chunk + k * 4);
+        }
+        ro_mix(xy, n, r, v, xy + words);
+        for (size_t k = 0; k < words; k++) {
+            store32_le(chunk + k * 4, xy[k]);
+        }
+    }
+    
+    pbkdf2_sha256(password, password_len, b, block_bytes * p, out, out_len);
+    
+    secure_zero(b, block_bytes * p);
+    secure_zero(v, (size_t)n * block_bytes);
+    secure_zero(xy, 3 * block_bytes);
+    safe_free(b);
+    safe_free(v);
+    safe_free(xy);
+    return true;
+}
+
+/* ========================================================================
+ * 工作階段快取
+ * ======================================================================== */
+
+/**
+ * @brief 快取項目
+ */
+typedef struct {
+    char *password;                        /**< 密碼副本（NULL 表示未使用） */
+    uint8_t salt[KDF_SALT_SIZE];           /**< salt */
+    kdf_params_t params;                   /**< 成本參數 */
+    uint8_t key[KDF_KEY_SIZE];             /**< 衍生的密鑰 */
+    uint64_t last_used;                    /**< 最近使用的序號（淘汰最久未用的項目） */
+} kdf_cache_entry_t;
+
+/** 快取與保護它的互斥鎖 */
+static kdf_cache_entry_t g_kdf_cache[KDF_CACHE_SIZE];
+static uint64_t g_kdf_clock = 0;
+static pthread_mutex_t g_kdf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief 清除一個快取項目
+ */
+static void cache_entry_wipe(kdf_cache_entry_t *entry) {
+    if (entry->password != NULL) {
+        secure_zero(entry->password, strlen(entry->password));
+        safe_free(entry->password);
+    }
+    secure_zero(entry, sizeof(*entry));
+}
+
+/**
+ * @brief 兩組參數是否相同
+ */
+static bool params_equal(const kdf_params_t *a, const kdf_params_t *b) {
+    return a->log_n == b->log_n && a->r == b->r && a->p == b->p;
+}
+
+/**
+ * @brief 尋找快取項目（呼叫端需持有 g_kdf_lock）
+ *
+ * @param salt 要比對的 salt；NULL 表示任何 salt 皆可
+ */
+static kdf_cache_entry_t *cache_find(const char *password, const uint8_t *salt,
+                                     const kdf_params_t *params) {
+    for (int i = 0; i < KDF_CACHE_SIZE; i++) {
+        kdf_cache_entry_t *entry = &g_kdf_cache[i];
+        if (entry->password != NULL && params_equal(&entry->params, params) &&
+            strcmp(entry->password, password) == 0 &&
+            (salt == NULL || memcmp(entry->salt, salt, KDF_SALT_SIZE) == 0)) {
+            entry->last_used = ++g_kdf_clock;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 衍生密鑰並加入快取（呼叫端需持有 g_kdf_lock）
+ */
+static bool cache_insert(const char *password, const uint8_t *salt,
+                         const kdf_params_t *params, uint8_t *key) {
+    if (!kdf_scrypt((const uint8_t *)password, strlen(password), salt, KDF_SALT_SIZE,
+                    params, key, KDF_KEY_SIZE)) {
+        return false;
+    }
+    
+    /* 淘汰空的或最久未用的項目；密碼複製失敗時仍回傳密鑰，只是不快取 */
+    kdf_cache_entry_t *victim = &g_kdf_cache[0];
+    for (int i = 1; i < KDF_CACHE_SIZE && victim->password != NULL; i++) {
+        if (g_kdf_cache[i].password == NULL || g_kdf_cache[i].last_used < victim->last_used) {
+            victim = &g_kdf_cache[i];
+        }
+    }
+    cache_entry_wipe(victim);
+    victim->password = safe_strdup(password);
+    if (victim->password != NULL) {
+        memcpy(victim->salt, salt, KDF_SALT_SIZE);
+        victim->params = *params;
+        memcpy(victim->key, key, KDF_KEY_SIZE);
+        victim->last_used = ++g_kdf_clock;
+    }
+    return true;
+}
+
+/**
+ * @brief 衍生 KDF_KEY_SIZE 位元組的加密密鑰（使用工作階段快取）
+ */
+bool kdf_derive(const char *password, const uint8_t *salt, const kdf_params_t *params,
+                uint8_t *key) {
+    if (password == NULL || salt == NULL || key == NULL || params == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的密鑰衍生參數");
+        return false;
+    }
+    
+    /* 衍生期間持有鎖：同時要求同一密鑰的執行緒等待結果，而不是各自重算 */
+    pthread_mutex_lock(&g_kdf_lock);
+    bool ok = true;
+    kdf_cache_entry_t *entry = cache_find(password, salt, params);
+    if (entry != NULL) {
+        memcpy(key, entry->key, KDF_KEY_SIZE);
+    } else {
+        ok = cache_insert(password, salt, params, key);
+    }
+    pthread_mutex_unlock(&g_kdf_lock);
+    return ok;
+}
+
+/**
+ * @brief 取得工作階段的密鑰（寫出新檔案時使用）
+ */
+bool kdf_session_key(const char *password, const kdf_params_t *params, uint8_t *salt,
+                     uint8_t *key) {
+    if (password == NULL || salt == NULL || key == NULL || params == NULL) {
+        error_set(ERR_INVALID_INPUT, "無效的密鑰衍生參數");
+        return false;
+    }
+    
+    pthread_mutex_lock(&g_kdf_lock);
+    bool ok = true;
+    kdf_cache_entry_t *entry = cache_find(password, NULL, params);
+    if (entry != NULL) {
+        memcpy(salt, entry->salt, KDF_SALT_SIZE);
+        memcpy(key, entry->key, KDF_KEY_SIZE);
+    } else {
+        ok = cache_insert(password, salt, params, key);
+    }
+    pthread_mutex_unlock(&g_kdf_lock);
+    return ok;
+}
+
+/**
+ * @brief 清除工作階段快取中的所有密碼與密鑰
+ */
+void kdf_cache_clear(void) {
+    pthread_mutex_lock(&g_kdf_lock);
+    for (int i = 0; i < KDF_CACHE_SIZE; i++) {
+        cache_entry_wipe(&g_kdf_cache[i]);
+    }
+    g_kdf_clock = 0;
+    pthread_mutex_unlock(&g_kdf_lock);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file kdf.h
+ * @brief 密鑰衍生模組標頭檔
+ *
+ * 本模組將使用者密碼衍生為 32 位元組加密密鑰，提供：
+ * - scrypt（RFC 7914）：記憶體密集的密鑰衍生，成本參數可調整
+ * - 工作階段快取：同一密碼、salt 與參數只衍生一次，
+ *   之後的儲存、日誌與延遲載入直接取用快取的密鑰
+ *
+ * @note 設計考量：
+ *   - scrypt 每次衍生需要 128 * r * 2^log_n 位元組記憶體，
+ *     預設參數（2^15, 8, 1）約 32 MiB，攻擊者難以大量平行猜測
+ *   - 參數記錄在映像檔中，載入時依映像檔的參數衍生；
+ *     參數上限（KDF_MAX_MEMORY）避免損壞的檔頭要求過量記憶體
+ *   - 快取以 secure_zero 清除，kdf_cache_clear() 於工作階段結束時呼叫
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef KDF_H
+#define KDF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/** salt 大小（位元組） */
+#define KDF_SALT_SIZE 16
+
+/** 衍生密鑰大小（位元組） */
+#define KDF_KEY_SIZE 32
+
+/** 預設成本：N = 2^KDF_DEFAULT_LOG_N */
+#define KDF_DEFAULT_LOG_N 15
+
+/** 預設區塊大小參數 r */
+#define KDF_DEFAULT_R 8
+
+/** 預設平行度參數 p */
+#define KDF_DEFAULT_P 1
+
+/** 單次衍生允許使用的最大記憶體（位元組） */
+#define KDF_MAX_MEMORY (256ull * 1024ull * 1024ull)
+
+/**
+ * @brief scrypt 成本參數
+ */
+typedef struct {
+    uint8_t log_n;                         /**< CPU/記憶體成本 N 的以 2 為底對數 */
+    uint8_t r;                             /**< 區塊大小參數 */
+    uint8_t p;                             /**< 平行度參數 */
+} kdf_params_t;
+
+/* ========================================================================
+ * 密鑰衍生函式
+ * ======================================================================== */
+
+/**
+ * @brief 預設的成本參數
+ */
+kdf_params_t kdf_default_params(void);
+
+/**
+ * @brief 檢查成本參數是否有效（含記憶體上限）
+ */
+bool kdf_params_valid(const kdf_params_t *params);
+
+/**
+ * @brief 以 scrypt 衍生密鑰（不使用快取）
+ *
+ * @param password     密碼
+ * @param password_len 密碼長度
+ * @param salt         salt
+ * @param salt_len     salt 長度
+ * @param params       成本參數
+ * @param out          輸出的衍生密鑰
+ * @param out_len      衍生密鑰長度
+ * @return 成功回傳 true，參數無效或記憶體不足回傳 false 並設定錯誤訊息
+ */
+bool kdf_scrypt(const uint8_t *password, size_t password_len,
+                const uint8_t *salt, size_t salt_len,
+                const kdf_params_t *params, uint8_t *out, size_t out_len);
+
+/**
+ * @brief 衍生 KDF_KEY_SIZE 位元組的加密密鑰（使用工作階段快取）
+ *
+ * @param password 密碼字串
+ * @param salt     KDF_SALT_SIZE 位元組 salt
+ * @param params   成本參數
+ * @param key      輸出的密鑰
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool kdf_derive(const char *password, const uint8_t *salt, const kdf_params_t *params,
+                uint8_t *key);
+
+/**
+ * @brief 取得工作階段的密鑰（寫出新檔案時使用）
+ *
+ * 快取中已有相同密碼與參數的密鑰時沿用其 salt 與密鑰，不重新衍生；
+ * 否則以 salt 中呼叫端提供的新 salt 衍生並加入快取。
+ *
+ * @param password 密碼字串
+ * @param params   成本參數
+ * @param salt     輸入輸出參數：新 salt；回傳時為實際使用的 salt
+ * @param key      輸出的密鑰
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool kdf_session_key(const char *password, const kdf_params_t *params, uint8_t *salt,
+                     uint8_t *key);
+
+/**
+ * @brief 清除工作階段快取中的所有密碼與密鑰
+ */
+void kdf_cache_clear(void);
+
+#endif // KDF_H
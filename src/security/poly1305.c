@@ -0,0 +1,256 @@
+/**
+ * @file poly1305.c
+ * @brief Poly1305 訊息驗證碼模組實作
+ *
+ * 實作 Poly1305 一次性訊息驗證碼，演算法規格參考 RFC 8439。
+ * 130 位元的累積值以五個 26 位元字表示（poly1305-donna 的 32 位元版本），
+ * 每個 16 位元組區塊做一次乘法與模 2^130 - 5 的部分化簡，最後才完整化簡。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "poly1305.h"
+#include "../utils/memory.h"
+#include <string.h>
+
+/** 26 位元字的遮罩 */
+#define LIMB_MASK 0x3ffffffu
+
+/* ========================================================================
+ * 內部輔助函式
+ * ======================================================================== */
+
+/**
+ * @brief 從位元組陣列載入 32 位元字（little-endian）
+ */
+static uint32_t load32_le(const uint8_t *b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+           ((uint32_t)b[3] << 24);
+}
+
+/**
+ * @brief 將 32 位元字存入位元組陣列（little-endian）
+ */
+static void store32_le(uint8_t *b, uint32_t v) {
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+    b[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief 處理完整的 16 位元組區塊
+ *
+ * @param ctx   Poly1305 上下文
+ * @param data  資料（長度為 16 的倍數）
+ * @param len   資料長度
+ * @param hibit 區塊結尾補上的 1 位元（最後一個不完整區塊已自行補上，傳入 0）
+ */
+static void poly1305_blocks(poly1305_ctx_t *ctx, const uint8_t *data, size_t len, uint32_t hibit) {
+    const uint32_t r0 = ctx->r[0], r1 = ctx->r[1], r2 = ctx->r[2], r3 = ctx->r[3], r4 = ctx->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2], h3 = ctx->h[3], h4 = ctx->h[4];
+    
+    while (len >= 16) {
+        /* h += m */
+        h0 += load32_le(data) & LIMB_MASK;
+        h1 += (load32_le(data + 3) >> 2) & LIMB_MASK;
+        h2 += (load32_le(data + 6) >> 4) & LIMB_MASK;
+        h3 += (load32_le(data + 9) >> 6) & LIMB_MASK;
+        h4 += (load32_le(data + 12) >> 8) | hibit;
+        
+        /* h *= r（超過 2^130 的部分乘以 5 折回） */
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 +
+                      (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 +
+                      (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 +
+                      (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 +
+                      (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 +
+                      (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+        
+        /* 部分化簡（進位） */
+        uint32_t c = (uint32_t)(d0 >> 26);
+        h0 = (uint32_t)d0 & LIMB_MASK;
+        d1 += c;
+        c = (uint32_t)(d1 >> 26);
+        h1 = (uint32_t)d1 & LIMB_MASK;
+        d2 += c;
+        c = (uint32_t)(d2 >> 26);
+        h2 = (uint32_t)d2 & LIMB_MASK;
+        d3 += c;
+        c = (uint32_t)(d3 >> 26);
+        h3 = (uint32_t)d3 & LIMB_MASK;
+        d4 += c;
+        c = (uint32_t)(d4 >> 26);
+        h4 = (uint32_t)d4 & LIMB_MASK;
+        h0 += c * 5;
+        c = h0 >> 26;
+        h0 &= LIMB_MASK;
+        h1 += c;
+        
+        data += 16;
+        len -= 16;
+    }
+    
+    ctx->h[0] = h0;
+    ctx->h[1] = h1;
+    ctx->h[2] = h2;
+    ctx->h[3] = h3;
+    ctx->h[4] = h4;
+}
+
+/* ========================================================================
+ * Poly1305 函式實作
+ * ======================================================================== */
+
+/**
+ * @brief 初始化 Poly1305 上下文
+ */
+void poly1305_init(poly1305_ctx_t *ctx, const uint8_t *key) {
+    /* r 依規格清除部分位元（clamp） */
+    ctx->r[0] = load32_le(key) & 0x3ffffff;
+    ctx->r[1] = (load32_le(key + 3) >> 2) & 0x3ffff03;
+    ctx->r[2] = (load32_le(key + 6) >> 4) & 0x3ffc0ff;
+    ctx->r[3] = (load32_le(key + 9) >> 6) & 0x3f03fff;
+    ctx->r[4] = (load32_le(key + 12) >> 8) & 0x00fffff;
+    
+    memset(ctx->h, 0, sizeof(ctx->h));
+    for (int i = 0; i < 4; i++) {
+        ctx->pad[i] = load32_le(key + 16 + i * 4);
+    }
+    ctx->leftover = 0;
+}
+
+/**
+ * @brief 餵入資料
+ */
+void poly1305_update(poly1305_ctx_t *ctx, const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    
+    /* 先補滿上次剩餘的區塊 */
+    if (ctx->leftover > 0) {
+        size_t want = 16 - ctx->leftover;
+        if (want > len) {
+            want = len;
+        }
+        memcpy(ctx->buffer + ctx->leftover, data, want);
+        ctx->leftover += want;
+        data += want;
+        len -= want;
+        if (ctx->leftover < 16) {
+            return;
+        }
+        poly1305_blocks(ctx, ctx->buffer, 16, 1u << 24);
+        ctx->leftover = 0;
+    }
+    
+    /* 完整區塊直接處理 */
+    if (len >= 16) {
+        size_t full = len & ~(size_t)15;
+        poly1305_blocks(ctx, data, full, 1u << 24);
+        data += full;
+        len -= full;
+    }
+    
+    if (len > 0) {
+        memcpy(ctx->buffer, data, len);
+        ctx->leftover = len;
+    }
+}
+
+/**
+ * @brief 輸出標籤並清除上下文
+ */
+void poly1305_final(poly1305_ctx_t *ctx, uint8_t *tag) {
+    /* 最後一個不完整區塊：補上 1 位元組 0x01，其餘為 0 */
+    if (ctx->leftover > 0) {
+        ctx->buffer[ctx->leftover] = 1;
+        memset(ctx->buffer + ctx->leftover + 1, 0, 16 - ctx->leftover - 1);
+        poly1305_blocks(ctx, ctx->buffer, 16, 0);
+    }
+    
+    /* 完整進位 */
+    uint32_t h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2], h3 = ctx->h[3], h4 = ctx->h[4];
+    uint32_t c = h1 >> 26;
+    h1 &= LIMB_MASK;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= LIMB_MASK;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= LIMB_MASK;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= LIMB_MASK;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= LIMB_MASK;
+    h1 += c;
+    
+    /* 計算 g = h - p = h + 5 - 2^130，h >= p 時以 g 取代 h（不使用分支） */
+    uint32_t g0 = h0 + 5;
+    c = g0 >> 26;
+    g0 &= LIMB_MASK;
+    uint32_t g1 = h1 + c;
+    c = g1 >> 26;
+    g1 &= LIMB_MASK;
+    uint32_t g2 = h2 + c;
+    c = g2 >> 26;
+    g2 &= LIMB_MASK;
+    uint32_t g3 = h3 + c;
+    c = g3 >> 26;
+    g3 &= LIMB_MASK;
+    uint32_t g4 = h4 + c - (1u << 26);
+    
+    uint32_t mask = (g4 >> 31) - 1;  /* g 非負時為全 1 */
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+    
+    /* h 轉回四個 32 位元字（取模 2^128） */
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+    
+    /* tag = (h + s) mod 2^128 */
+    uint64_t f = (uint64_t)h0 + ctx->pad[0];
+    store32_le(tag, (uint32_t)f);
+    f = (uint64_t)h1 + ctx->pad[1] + (f >> 32);
+    store32_le(tag + 4, (uint32_t)f);
+    f = (uint64_t)h2 + ctx->pad[2] + (f >> 32);
+    store32_le(tag + 8, (uint32_t)f);
+    f = (uint64_t)h3 + ctx->pad[3] + (f >> 32);
+    store32_le(tag + 12, (uint32_t)f);
+    
+    secure_zero(ctx, sizeof(*ctx));
+}
+
+/**
+ * @brief 計算一則訊息的標籤
+ */
+void poly1305_auth(uint8_t *tag, const uint8_t *data, size_t len, const uint8_t *key) {
+    poly1305_ctx_t ctx;
+    poly1305_init(&ctx, key);
+    poly1305_update(&ctx, data, len);
+    poly1305_final(&ctx, tag);
+}
+
+/**
+ * @brief 以常數時間比對兩個標籤
+ */
+bool poly1305_verify(const uint8_t *a, const uint8_t *b) {
+    uint8_t diff = 0;
+    for (int i = 0; i < POLY1305_TAG_SIZE; i++) {
+        diff |= (uint8_t)(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
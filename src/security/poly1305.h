@@ -0,0 +1,93 @@
+/**
+ * @file poly1305.h
+ * @brief Poly1305 訊息驗證碼模組標頭檔
+ *
+ * 本模組實作 Poly1305 一次性訊息驗證碼（RFC 8439），提供：
+ * - 串流計算：初始化、分段餵入資料、輸出 16 位元組標籤
+ * - 單次計算與常數時間的標籤比對
+ *
+ * Poly1305 的密鑰只能使用一次：每則訊息需以不同的 32 位元組密鑰計算，
+ * 通常由 ChaCha20 依訊息編號產生的密鑰流取得。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef POLY1305_H
+#define POLY1305_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ========================================================================
+ * 型別定義
+ * ======================================================================== */
+
+/** Poly1305 密鑰大小（位元組） */
+#define POLY1305_KEY_SIZE 32
+
+/** Poly1305 標籤大小（位元組） */
+#define POLY1305_TAG_SIZE 16
+
+/**
+ * @brief Poly1305 計算上下文
+ *
+ * 以 26 位元為一個字表示 130 位元的數值，只需 32x32→64 位元乘法，
+ * 在 32 位元平台上同樣適用。
+ */
+typedef struct {
+    uint32_t r[5];                         /**< 乘數 r（已套用 clamp） */
+    uint32_t h[5];                         /**< 累積值 */
+    uint32_t pad[4];                       /**< 最後加上的 s */
+    uint8_t buffer[16];                    /**< 未滿一個區塊的剩餘資料 */
+    size_t leftover;                       /**< 剩餘資料長度 */
+} poly1305_ctx_t;
+
+/* ========================================================================
+ * Poly1305 函式
+ * ======================================================================== */
+
+/**
+ * @brief 初始化 Poly1305 上下文
+ *
+ * @param ctx Poly1305 上下文
+ * @param key 32 位元組一次性密鑰
+ */
+void poly1305_init(poly1305_ctx_t *ctx, const uint8_t *key);
+
+/**
+ * @brief 餵入資料
+ *
+ * @param ctx  Poly1305 上下文
+ * @param data 資料
+ * @param len  資料長度
+ */
+void poly1305_update(poly1305_ctx_t *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief 輸出標籤並清除上下文
+ *
+ * @param ctx Poly1305 上下文
+ * @param tag 輸出的 16 位元組標籤
+ */
+void poly1305_final(poly1305_ctx_t *ctx, uint8_t *tag);
+
+/**
+ * @brief 計算一則訊息的標籤
+ *
+ * @param tag  輸出的 16 位元組標籤
+ * @param data 訊息
+ * @param len  訊息長度
+ * @param key  32 位元組一次性密鑰
+ */
+void poly1305_auth(uint8_t *tag, const uint8_t *data, size_t len, const uint8_t *key);
+
+/**
+ * @brief 以常數時間比對兩個標籤
+ *
+ * @return 相同回傳 true
+ */
+bool poly1305_verify(const uint8_t *a, const uint8_t *b);
+
+#endif // POLY1305_H
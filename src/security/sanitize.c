@@ -195,7 +195,12 @@ bool is_path_traversal(const char *path) {
     if (path == NULL) {
         return false;
     }
-    
+
+    /* 快速路徑：不含 ".." 的路徑不可能超出根目錄，免去解析與配置 */
+    if (strstr(path, "..") == NULL) {
+        return false;
+    }
+
     /* 先解析路徑中的 ../ 和 ./ */
     char *resolved = resolve_dot_dot(path);
     if (resolved == NULL) {
@@ -16,6 +16,18 @@
 #include <unistd.h>
 #include <termios.h>
 #include <sys/ioctl.h>
+#include <poll.h>
+
+/* ============================================================================
+ * 常數定義
+ * ============================================================================ */
+
+/** 單獨的 Escape 與 Escape 序列的判斷等待時間（毫秒） */
+#define INPUT_ESCAPE_TIMEOUT_MS 25
+
+/** 括號貼上的開始與結束標記（不含開頭的 ESC） */
+#define PASTE_BEGIN_PARAM 200
+#define PASTE_END_SEQ "[201~"
 
 /* ============================================================================
  * 模組內部狀態
@@ -27,6 +39,126 @@ static struct termios g_original_termios;
 /** 終端機是否已初始化 */
 static bool g_terminal_initialized = false;
 
+/** 輸入環形緩衝區：一次 read 取得所有已到達的位元組 */
+static unsigned char g_ring[INPUT_RING_SIZE];
+static size_t g_ring_head = 0;    /**< 下一個要讀取的位置 */
+static size_t g_ring_count = 0;   /**< 尚未讀取的位元組數 */
+
+/** 是否位於括號貼上的內容中 */
+static bool g_in_paste = false;
+
+/** 貼上內容中上一個位元組是否為 '\r'（用於合併 "\r\n"） */
+static bool g_paste_cr = false;
+
+/* ============================================================================
+ * 環形緩衝區操作
+ * ============================================================================ */
+
+/**
+ * @brief 從終端機讀入更多位元組
+ * 
+ * @param timeout_ms 等待時間（毫秒），負值表示阻塞直到有輸入
+ * @return 有讀入資料（或緩衝區已滿）回傳 true
+ */
+static bool ring_fill(int timeout_ms) {
+    if (g_ring_count == INPUT_RING_SIZE) {
+        return true;
+    }
+    
+    if (timeout_ms >= 0) {
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+    }
+    
+    /* 填入尾端之後連續的空間，剩餘部分留待下次 */
+    size_t tail = (g_ring_head + g_ring_count) % INPUT_RING_SIZE;
+    size_t space = INPUT_RING_SIZE - g_ring_count;
+    if (space > INPUT_RING_SIZE - tail) {
+        space = INPUT_RING_SIZE - tail;
+    }
+    
+    ssize_t n = read(STDIN_FILENO, g_ring + tail, space);
+    if (n <= 0) {
+        return false;
+    }
+    g_ring_count += (size_t)n;
+    return true;
+}
+
+/**
+ * @brief 查看第 index 個尚未讀取的位元組（不移除）
+ * 
+ * @param index 位移
+ * @param c 輸出參數
+ * @param timeout_ms 資料不足時的等待時間（同 ring_fill）
+ * @return 成功回傳 true
+ */
+static bool ring_peek(size_t index, unsigned char *c, int timeout_ms) {
+    while (g_ring_count <= index) {
+        if (index >= INPUT_RING_SIZE || !ring_fill(timeout_ms)) {
+            return false;
+        }
+    }
+    *c = g_ring[(g_ring_head + index) % INPUT_RING_SIZE];
+    return true;
+}
+
+/**
+ * @brief 取出下一個位元組
+ * 
+ * @param c 輸出參數
+ * @param timeout_ms 無資料時的等待時間（同 ring_fill）
+ * @return 成功回傳 true
+ */
+static bool ring_get(unsigned char *c, int timeout_ms) {
+    if (!ring_peek(0, c, timeout_ms)) {
+        return false;
+    }
+    g_ring_head = (g_ring_head + 1) % INPUT_RING_SIZE;
+    g_ring_count--;
+    return true;
+}
+
+/**
+ * @brief 檢查接下來是否為括號貼上的結束標記，是則將其移除
+ */
+static bool consume_paste_end(void) {
+    unsigned char c;
+    if (!ring_peek(0, &c, 0) || c != '\x1b') {
+        return false;
+    }
+    
+    size_t len = strlen(PASTE_END_SEQ);
+    for (size_t i = 0; i < len; i++) {
+        if (!ring_peek(i + 1, &c, INPUT_ESCAPE_TIMEOUT_MS) || c != (unsigned char)PASTE_END_SEQ[i]) {
+            return false;
+        }
+    }
+    
+    g_ring_head = (g_ring_head + len + 1) % INPUT_RING_SIZE;
+    g_ring_count -= len + 1;
+    return true;
+}
+
+/**
+ * @brief 正規化貼上內容的換行（"\r" 與 "\r\n" 都轉為 '\n'）
+ * @return 應略過此位元組時回傳 false
+ */
+static bool normalize_paste_byte(unsigned char *c) {
+    bool after_cr = g_paste_cr;
+    g_paste_cr = (*c == '\r');
+    
+    if (*c == '\n' && after_cr) {
+        return false;
+    }
+    if (*c == '\r') {
+        *c = '\n';
+    }
+    return true;
+}
+
 /* ============================================================================
  * 終端機初始化與清理
  * ============================================================================ */
@@ -59,6 +191,13 @@ bool input_init(void) {
         return false;
     }
     
+    /* 啟用括號貼上模式：終端機以 ESC[200~ 與 ESC[201~ 包住貼上的內容 */
+    g_ring_head = 0;
+    g_ring_count = 0;
+    g_in_paste = false;
+    fputs("\x1b[?2004h", stdout);
+    fflush(stdout);
+    
     g_terminal_initialized = true;
     return true;
 }
@@ -68,6 +207,8 @@ bool input_init(void) {
  */
 void input_cleanup(void) {
     if (g_terminal_initialized) {
+        fputs("\x1b[?2004l", stdout);
+        fflush(stdout);
         tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_original_termios);
         g_terminal_initialized = false;
     }
@@ -78,92 +219,191 @@ void input_cleanup(void) {
  * ============================================================================ */
 
 /**
- * @brief 讀取單一按鍵輸入
+ * @brief 解析 ESC 之後的序列
+ * @return 為括號貼上的開始標記時回傳 true（key 不具意義）
  */
-bool input_read_key(key_input_t *key) {
-    if (key == NULL) {
+static bool parse_escape(key_input_t *key) {
+    unsigned char c;
+    
+    /* 短時間內沒有後續位元組，視為單獨的 Escape 鍵 */
+    if (!ring_get(&c, INPUT_ESCAPE_TIMEOUT_MS)) {
+        key->key = '\x1b';
         return false;
     }
     
-    /* 初始化按鍵結構 */
-    memset(key, 0, sizeof(key_input_t));
+    key->escape = true;
+    key->key = '\x1b';
     
-    char c;
-    if (read(STDIN_FILENO, &c, 1) != 1) {
+    if (c == '[') {
+        /* CSI 序列：參數（數字與分號）後接一個結束字元 */
+        char seq[sizeof(key->escape_seq)];
+        size_t len = 0;
+        seq[len++] = '[';
+        int param = 0;
+        bool first_param = true;
+        
+        for (;;) {
+            if (!ring_get(&c, INPUT_ESCAPE_TIMEOUT_MS)) {
+                return false;
+            }
+            if (len < sizeof(seq) - 1) {
+                seq[len++] = (char)c;
+            }
+            if (c >= '0' && c <= '9') {
+                if (first_param && param < 10000) {
+                    param = param * 10 + (c - '0');
+                }
+            } else if (c == ';') {
+                first_param = false;
+            } else {
+                break;
+            }
+        }
+        seq[len] = '\0';
+        memcpy(key->escape_seq, seq, len + 1);
+        
+        if (c == '~') {
+            /* 處理功能鍵 */
+            switch (param) {
+                case 1: key->key = 'H'; break;  /* Home */
+                case 3: key->key = 'D'; break;  /* Delete */
+                case 4: key->key = 'F'; break;  /* End */
+                case 5: key->key = 'P'; break;  /* Page Up */
+                case 6: key->key = 'N'; break;  /* Page Down */
+                case PASTE_BEGIN_PARAM: return true;
+                default: break;
+            }
+        } else {
+            /* 處理方向鍵 */
+            switch (c) {
+                case 'A': key->key = 'k'; break;  /* 上 */
+                case 'B': key->key = 'j'; break;  /* 下 */
+                case 'C': key->key = 'l'; break;  /* 右 */
+                case 'D': key->key = 'h'; break;  /* 左 */
+                case 'H': key->key = 'H'; break;  /* Home */
+                case 'F': key->key = 'F'; break;  /* End */
+                default: break;
+            }
+        }
+    } else if (c == 'O') {
+        /* 處理 xterm 風格的功能鍵 */
+        if (!ring_get(&c, INPUT_ESCAPE_TIMEOUT_MS)) {
+            return false;
+        }
+        switch (c) {
+            case 'H': key->key = 'H'; break;  /* Home */
+            case 'F': key->key = 'F'; break;  /* End */
+            default: break;
+        }
+        key->escape_seq[0] = 'O';
+        key->escape_seq[1] = (char)c;
+        key->escape_seq[2] = '\0';
+    }
+    
+    return false;
+}
+
+/**
+ * @brief 讀取單一按鍵輸入
+ */
+bool input_read_key(key_input_t *key) {
+    if (key == NULL) {
         return false;
     }
     
-    /* 處理 Escape 序列 */
-    if (c == '\x1b') {
-        key->escape = true;
-        char seq[3];
+    for (;;) {
+        /* 初始化按鍵結構 */
+        memset(key, 0, sizeof(key_input_t));
         
-        if (read(STDIN_FILENO, &seq[0], 1) != 1) return false;
-        if (read(STDIN_FILENO, &seq[1], 1) != 1) return false;
+        unsigned char c;
         
-        if (seq[0] == '[') {
-            if (seq[1] >= '0' && seq[1] <= '9') {
-                if (read(STDIN_FILENO, &seq[2], 1) != 1) return false;
-                if (seq[2] == '~') {
-                    /* 處理功能鍵 */
-                    switch (seq[1]) {
-                        case '1': key->key = 'H'; break;  /* Home */
-                        case '3': key->key = 'D'; break;  /* Delete */
-                        case '4': key->key = 'F'; break;  /* End */
-                        case '5': key->key = 'P'; break;  /* Page Up */
-                        case '6': key->key = 'N'; break;  /* Page Down */
-                        default: key->key = c; break;
-                    }
-                }
-            } else {
-                /* 處理方向鍵 */
-                switch (seq[1]) {
-                    case 'A': key->key = 'k'; break;  /* 上 */
-                    case 'B': key->key = 'j'; break;  /* 下 */
-                    case 'C': key->key = 'l'; break;  /* 右 */
-                    case 'D': key->key = 'h'; break;  /* 左 */
-                    case 'H': key->key = 'H'; break;  /* Home */
-                    case 'F': key->key = 'F'; break;  /* End */
-                    default: key->key = c; break;
+        /* 貼上內容原樣回傳，不解讀控制字元與 Escape 序列 */
+        if (g_in_paste) {
+            if (consume_paste_end()) {
+                g_in_paste = false;
+                if (!input_pending()) {
+                    return false;
                 }
+                continue;
             }
-            memcpy(key->escape_seq, seq, 3);
-            key->escape_seq[3] = '\0';
-        } else if (seq[0] == 'O') {
-            /* 處理 xterm 風格的功能鍵 */
-            switch (seq[1]) {
-                case 'H': key->key = 'H'; break;  /* Home */
-                case 'F': key->key = 'F'; break;  /* End */
-                default: key->key = c; break;
+            if (!ring_get(&c, -1)) {
+                return false;
+            }
+            if (!normalize_paste_byte(&c)) {
+                continue;
+            }
+            key->paste = true;
+            key->key = (char)c;
+            return true;
+        }
+        
+        if (!ring_get(&c, -1)) {
+            return false;
+        }
+        
+        /* 處理 Escape 序列 */
+        if (c == '\x1b') {
+            if (parse_escape(key)) {
+                g_in_paste = true;
+                g_paste_cr = false;
+                continue;
+            }
+        } else if (c == '\r' || c == '\n') {
+            key->key = '\n';
+        } else if (c == '\x7f') {
+            key->key = '\b';  /* Backspace */
+        } else if (c < 32) {
+            /* 處理控制字元 */
+            switch (c) {
+                case '\x01': key->ctrl = true; key->key = 'a'; break;  /* Ctrl+A */
+                case '\x03': key->ctrl = true; key->key = 'c'; break;  /* Ctrl+C */
+                case '\x05': key->ctrl = true; key->key = 'e'; break;  /* Ctrl+E */
+                case '\x06': key->ctrl = true; key->key = 'f'; break;  /* Ctrl+F */
+                case '\x08': key->ctrl = true; key->key = 'h'; break;  /* Ctrl+H */
+                case '\x0b': key->ctrl = true; key->key = 'k'; break;  /* Ctrl+K */
+                case '\x0c': key->ctrl = true; key->key = 'l'; break;  /* Ctrl+L */
+                case '\x12': key->ctrl = true; key->key = 'r'; break;  /* Ctrl+R */
+                case '\x15': key->ctrl = true; key->key = 'u'; break;  /* Ctrl+U */
+                case '\x17': key->ctrl = true; key->key = 'w'; break;  /* Ctrl+W */
+                default: key->key = (char)c; break;
             }
-            memcpy(key->escape_seq, seq, 2);
-            key->escape_seq[2] = '\0';
         } else {
-            key->key = c;
+            key->key = (char)c;
         }
-    } else if (c == '\r' || c == '\n') {
-        key->key = '\n';
-    } else if (c == '\x7f') {
-        key->key = '\b';  /* Backspace */
-    } else if (c < 32) {
-        /* 處理控制字元 */
-        switch (c) {
-            case '\x01': key->ctrl = true; key->key = 'a'; break;  /* Ctrl+A */
-            case '\x03': key->ctrl = true; key->key = 'c'; break;  /* Ctrl+C */
-            case '\x05': key->ctrl = true; key->key = 'e'; break;  /* Ctrl+E */
-            case '\x06': key->ctrl = true; key->key = 'f'; break;  /* Ctrl+F */
-            case '\x08': key->ctrl = true; key->key = 'h'; break;  /* Ctrl+H */
-            case '\x0b': key->ctrl = true; key->key = 'k'; break;  /* Ctrl+K */
-            case '\x0c': key->ctrl = true; key->key = 'l'; break;  /* Ctrl+L */
-            case '\x15': key->ctrl = true; key->key = 'u'; break;  /* Ctrl+U */
-            case '\x17': key->ctrl = true; key->key = 'w'; break;  /* Ctrl+W */
-            default: key->key = c; break;
+        
+        return true;
+    }
+}
+
+/**
+ * @brief 檢查是否還有尚未處理的輸入
+ */
+bool input_pending(void) {
+    return g_ring_count > 0 || ring_fill(0);
+}
+
+/**
+ * @brief 讀取括號貼上中已到達的內容
+ */
+size_t input_read_paste(char *out, size_t size) {
+    if (out == NULL) {
+        return 0;
+    }
+    
+    size_t n = 0;
+    unsigned char c;
+    while (g_in_paste && n < size && ring_peek(0, &c, 0)) {
+        /* ESC 可能是結束標記，交給 input_read_key 判斷 */
+        if (c == '\x1b') {
+            break;
+        }
+        ring_get(&c, 0);
+        if (normalize_paste_byte(&c)) {
+            out[n++] = (char)c;
         }
-    } else {
-        key->key = c;
     }
     
-    return true;
+    return n;
 }
 
 /**
@@ -5,6 +5,8 @@
  * 本模組負責終端機的原始模式設定與鍵盤輸入處理，包含：
  * - 終端機原始模式（Raw Mode）的初始化與清理
  * - 按鍵讀取與解析（含特殊鍵、Escape 序列）
+ * - 批次讀取：一次 read 將所有已到達的位元組放入環形緩衝區
+ * - 括號貼上（Bracketed Paste）：貼上的內容原樣回傳，不解讀為指令
  * - 命令列輸入讀取
  *
  * @author Yun
@@ -17,6 +19,13 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/* ============================================================================
+ * 常數定義
+ * ============================================================================ */
+
+/** @brief 輸入環形緩衝區大小（位元組） */
+#define INPUT_RING_SIZE 4096
+
 /* ============================================================================
  * 資料結構定義
  * ============================================================================ */
@@ -32,6 +41,7 @@ typedef struct key_input {
     bool alt;              /**< Alt 鍵是否按下 */
     bool shift;            /**< Shift 鍵是否按下 */
     bool escape;           /**< 是否為 Escape 序列 */
+    bool paste;            /**< 是否為括號貼上的內容（key 為原始位元組，換行已轉為 '\n'） */
     char escape_seq[16];   /**< Escape 序列內容 */
 } key_input_t;
 
@@ -42,7 +52,8 @@ typedef struct key_input {
 /**
  * @brief 初始化輸入系統
  *
- * 將終端機設定為原始模式（Raw Mode），以便逐字元讀取輸入。
+ * 將終端機設定為原始模式（Raw Mode），以便逐字元讀取輸入，
+ * 並啟用終端機的括號貼上模式。
  *
  * @return true 成功，false 失敗
  *
@@ -65,13 +76,35 @@ void input_cleanup(void);
  * @brief 讀取單一按鍵輸入
  *
  * 阻塞式讀取，直到使用者按下按鍵。
- * 自動處理 Escape 序列（方向鍵、功能鍵等）。
+ * 自動處理 Escape 序列（方向鍵、功能鍵等）；單獨的 ESC 在短暫等待後視為 Escape 鍵。
+ * 括號貼上的內容以 paste 標記回傳。
  *
  * @param key 輸出參數，儲存按鍵資訊
  * @return true 成功讀取，false 讀取失敗或參數無效
  */
 bool input_read_key(key_input_t *key);
 
+/**
+ * @brief 檢查是否還有尚未處理的輸入（不阻塞）
+ *
+ * 主迴圈可據此先處理完所有已到達的按鍵，再重繪一次畫面。
+ *
+ * @return 環形緩衝區或終端機中還有資料時回傳 true
+ */
+bool input_pending(void);
+
+/**
+ * @brief 讀取括號貼上中已到達的內容（不阻塞）
+ *
+ * 在 input_read_key() 回傳 paste 為 true 的按鍵後呼叫，
+ * 一次取出其後連續的貼上內容，遇到貼上結束或資料暫時用完時停止。
+ *
+ * @param out 輸出緩衝區
+ * @param size 緩衝區大小
+ * @return 讀取的位元組數，0 表示目前沒有更多貼上內容
+ */
+size_t input_read_paste(char *out, size_t size);
+
 /**
  * @brief 讀取一行輸入
  *
@@ -5,16 +5,23 @@
  * 實作終端機螢幕的控制與渲染功能。
  * 使用 ANSI 跳脫序列控制游標與顏色。
  *
+ * 渲染採雙緩衝：保留上一次輸出的各行內容，新畫面逐行比對後
+ * 只輸出有變化的行，整個畫面累積在同一個輸出緩衝區，
+ * 由 screen_flush() 以單一 write(2) 送出。
+ *
  * @author Yun
  * @date 2025
  */
 
 #include "screen.h"
 #include "../utils/error.h"
+#include "../utils/trace.h"
 #include "colors.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <errno.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
@@ -22,18 +29,187 @@
  * 模組內部狀態
  * ============================================================================ */
 
+/**
+ * @brief 可增長的位元組字串（畫面行內容與輸出緩衝區共用）
+ */
+typedef struct {
+    char *data;     /**< 內容（不以 '\0' 結尾） */
+    size_t len;     /**< 目前長度 */
+    size_t cap;     /**< 已配置容量 */
+} screen_str_t;
+
 /** 螢幕尺寸（預設值） */
 static screen_size_t g_screen_size = {24, 80};
 
 /** 螢幕是否已初始化 */
 static bool g_screen_initialized = false;
 
-/** 螢幕緩衝區（用於雙緩衝渲染） */
-static char **g_screen_buffer = NULL;
+/** 螢幕緩衝區：上一次已輸出到終端機的各行內容（用於雙緩衝差異比對） */
+static screen_str_t *g_screen_buffer = NULL;
+
+/** 各行內容是否有效（false 表示終端機上的內容未知，必須重繪） */
+static bool *g_screen_valid = NULL;
 
 /** 緩衝區行數 */
 static size_t g_screen_rows = 0;
 
+/** 緩衝區建立時的列數（列數改變時需全部重繪） */
+static size_t g_screen_cols = 0;
+
+/** 下一次 screen_flush() 要寫出的位元組 */
+static screen_str_t g_output = {NULL, 0, 0};
+
+/** 目前正在組合的單行內容 */
+static screen_str_t g_line = {NULL, 0, 0};
+
+/* ============================================================================
+ * 內部輔助函式
+ * ============================================================================ */
+
+/**
+ * @brief 附加位元組到字串，失敗時保持原內容
+ */
+static bool str_append(screen_str_t *str, const char *data, size_t len) {
+    if (str->len + len > str->cap) {
+        size_t cap = str->cap ? str->cap : 256;
+        while (cap < str->len + len) {
+            cap *= 2;
+        }
+        char *grown = (char *)realloc(str->data, cap);
+        if (grown == NULL) {
+            return false;
+        }
+        str->data = grown;
+        str->cap = cap;
+    }
+    
+    memcpy(str->data + str->len, data, len);
+    str->len += len;
+    return true;
+}
+
+/**
+ * @brief 以格式化字串附加內容
+ */
+static bool str_printf(screen_str_t *str, const char *fmt, ...) {
+    char tmp[64];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    
+    if (n < 0 || (size_t)n >= sizeof(tmp)) {
+        return false;
+    }
+    return str_append(str, tmp, (size_t)n);
+}
+
+/**
+ * @brief 附加 count 個相同字元
+ */
+static void str_fill(screen_str_t *str, char c, size_t count) {
+    char tmp[64];
+    memset(tmp, c, sizeof(tmp));
+    while (count > 0) {
+        size_t n = count < sizeof(tmp) ? count : sizeof(tmp);
+        if (!str_append(str, tmp, n)) {
+            return;
+        }
+        count -= n;
+    }
+}
+
+/**
+ * @brief 釋放螢幕緩衝區
+ */
+static void free_screen_buffer(void) {
+    if (g_screen_buffer != NULL) {
+        for (size_t i = 0; i < g_screen_rows; i++) {
+            free(g_screen_buffer[i].data);
+        }
+        free(g_screen_buffer);
+        g_screen_buffer = NULL;
+    }
+    free(g_screen_valid);
+    g_screen_valid = NULL;
+    g_screen_rows = 0;
+}
+
+/**
+ * @brief 確保螢幕緩衝區符合目前尺寸
+ *
+ * 尺寸改變時重新配置，並安排一次清除螢幕與全部重繪。
+ */
+static bool ensure_screen_buffer(screen_size_t size) {
+    if (g_screen_buffer != NULL && g_screen_rows == size.rows && g_screen_cols == size.cols) {
+        return true;
+    }
+    
+    free_screen_buffer();
+    g_screen_buffer = (screen_str_t *)calloc(size.rows, sizeof(screen_str_t));
+    g_screen_valid = (bool *)calloc(size.rows, sizeof(bool));
+    if (g_screen_buffer == NULL || g_screen_valid == NULL) {
+        free_screen_buffer();
+        return false;
+    }
+    
+    g_screen_rows = size.rows;
+    g_screen_cols = size.cols;
+    str_append(&g_output, "\033[2J", 4);
+    return true;
+}
+
+/**
+ * @brief 將組合好的行（g_line）與上一個畫面比對，只輸出有變化的行
+ *
+ * @param row 螢幕行號（從 0 開始）
+ */
+static void commit_line(size_t row) {
+    if (g_screen_buffer == NULL || row >= g_screen_rows) {
+        return;
+    }
+    
+    screen_str_t *prev = &g_screen_buffer[row];
+    if (g_screen_valid[row] && prev->len == g_line.len &&
+        (g_line.len == 0 || memcmp(prev->data, g_line.data, g_line.len) == 0)) {
+        return;
+    }
+    
+    /* 定位到行首、清除整行後輸出內容 */
+    str_printf(&g_output, "\033[%zu;1H\033[0m\033[2K", row + 1);
+    str_append(&g_output, g_line.data, g_line.len);
+    str_append(&g_output, "\033[0m", 4);
+    
+    prev->len = 0;
+    g_screen_valid[row] = str_append(prev, g_line.data, g_line.len);
+}
+
+/**
+ * @brief 寫出全部位元組（處理部分寫入與訊號中斷）
+ */
+static void write_all(const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+/**
+ * @brief 使上一個畫面失效（終端機內容已被其他輸出改變）
+ */
+static void invalidate_screen_buffer(void) {
+    if (g_screen_valid != NULL) {
+        memset(g_screen_valid, 0, g_screen_rows * sizeof(bool));
+    }
+}
+
 /* ============================================================================
  * 螢幕初始化與清理
  * ============================================================================ */
@@ -46,11 +222,9 @@ bool screen_init(void) {
     g_screen_size = size;
     g_screen_initialized = true;
     
-    /* 配置螢幕緩衝區 */
-    g_screen_rows = size.rows;
-    g_screen_buffer = (char **)calloc(g_screen_rows, sizeof(char *));
-    
-    return true;
+    /* 配置螢幕緩衝區（第一個畫面會完整繪製） */
+    g_output.len = 0;
+    return ensure_screen_buffer(size);
 }
 
 /**
@@ -58,13 +232,11 @@ bool screen_init(void) {
  */
 void screen_cleanup(void) {
     /* 釋放螢幕緩衝區 */
-    if (g_screen_buffer != NULL) {
-        for (size_t i = 0; i < g_screen_rows; i++) {
-            free(g_screen_buffer[i]);
-        }
-        free(g_screen_buffer);
-        g_screen_buffer = NULL;
-    }
+    free_screen_buffer();
+    free(g_output.data);
+    free(g_line.data);
+    g_output = (screen_str_t){NULL, 0, 0};
+    g_line = (screen_str_t){NULL, 0, 0};
     
     /* 恢復終端機設定 */
     printf("\033[?25h");       /* 顯示游標 */
@@ -96,6 +268,7 @@ screen_size_t screen_get_size(void) {
 void screen_clear(void) {
     printf("\033[2J\033[H");
     fflush(stdout);
+    invalidate_screen_buffer();
 }
 
 /**
@@ -130,20 +303,19 @@ void screen_show_cursor(void) {
  * @brief 重新繪製螢幕
  */
 void screen_refresh(buffer_t *buf, cursor_t *cursor, size_t first_line) {
+    TRACE_SCOPE(TRACE_SCREEN_REFRESH);
     if (buf == NULL || cursor == NULL) {
         return;
     }
     
     screen_size_t size = screen_get_size();
-    
-    /* 清除螢幕並移至左上角 */
-    printf("\033[2J\033[H");
+    if (size.rows < 3 || !ensure_screen_buffer(size)) {
+        return;
+    }
     
     /* 計算可顯示的行數（保留狀態列與命令列） */
     size_t display_rows = size.rows - 2;
-    if (display_rows < 1) {
-        display_rows = 1;
-    }
+    size_t screen_rows = display_rows;
     
     /* 調整捲動位置，確保游標可見 */
     if (cursor->row < first_line) {
@@ -158,56 +330,45 @@ void screen_refresh(buffer_t *buf, cursor_t *cursor, size_t first_line) {
         display_rows = buf->line_count;
     }
     
-    size_t last_line = first_line + display_rows;
-    if (last_line > buf->line_count) {
-        last_line = buf->line_count;
-    }
-    
-    /* 逐行渲染 */
+    /* 逐行組合並與上一個畫面比對 */
     size_t line_num = first_line;
     line_t *line = buffer_get_line(buf, first_line);
+    size_t max_col = (size.cols > 6) ? size.cols - 6 : 0;  /* 保留行號空間 */
     
-    for (size_t row = 0; row < display_rows && line != NULL; row++) {
-        /* 顯示行號（灰色，右對齊） */
-        printf("\033[90m%4zu\033[0m ", line_num + 1);
-        
-        /* 顯示行內容 */
-        size_t col = 0;
-        size_t line_len = line->length;
-        size_t max_col = size.cols - 6;  /* 保留行號空間 */
+    for (size_t row = 0; row < screen_rows; row++) {
+        g_line.len = 0;
         
-        bool is_cursor_line = (line_num == cursor->row);
-        
-        for (size_t i = 0; i < line_len && col < max_col; i++) {
-            char c = line->text[i];
+        if (row < display_rows && line != NULL) {
+            /* 顯示行號（灰色，右對齊） */
+            str_printf(&g_line, "\033[90m%4zu\033[0m ", line_num + 1);
+            
+            /* 顯示行內容 */
+            size_t line_len = line->length;
+            size_t visible = line_len < max_col ? line_len : max_col;
+            bool is_cursor_line = (line_num == cursor->row);
             
-            if (is_cursor_line && col == cursor->col) {
+            if (is_cursor_line && cursor->col < visible) {
                 /* 游標位置：反色顯示 */
-                printf("\033[30;47m%c\033[0m", c);
+                str_append(&g_line, line->text, cursor->col);
+                str_append(&g_line, "\033[30;47m", 8);
+                str_append(&g_line, line->text + cursor->col, 1);
+                str_append(&g_line, "\033[0m", 4);
+                str_append(&g_line, line->text + cursor->col + 1, visible - cursor->col - 1);
             } else {
-                printf("%c", c);
+                str_append(&g_line, line->text, visible);
             }
-            col++;
-        }
-        
-        /* 若游標在行尾之後 */
-        if (is_cursor_line && cursor->col >= line_len && col < max_col) {
-            printf("\033[30;47m \033[0m");
-        }
-        
-        /* 填充剩餘空間 */
-        while (col < max_col) {
-            printf(" ");
-            col++;
+            
+            /* 若游標在行尾之後 */
+            if (is_cursor_line && cursor->col >= line_len && visible < max_col) {
+                str_append(&g_line, "\033[30;47m \033[0m", 13);
+            }
+            
+            line = line->next;
+            line_num++;
         }
         
-        printf("\r\n");
-        
-        line = line->next;
-        line_num++;
+        commit_line(row);
     }
-    
-    fflush(stdout);
 }
 
 /**
@@ -215,26 +376,23 @@ void screen_refresh(buffer_t *buf, cursor_t *cursor, size_t first_line) {
  */
 void screen_show_status(const char *status, bool is_error) {
     screen_size_t size = screen_get_size();
-    
-    /* 移至狀態列位置 */
-    screen_set_cursor(size.rows - 2, 0);
-    
-    /* 清除狀態列並設定藍色背景 */
-    printf("\033[44m");
-    for (size_t i = 0; i < size.cols; i++) {
-        printf(" ");
+    if (size.rows < 2 || !ensure_screen_buffer(size)) {
+        return;
     }
-    screen_set_cursor(size.rows - 2, 0);
+    
+    /* 先以藍色背景填滿整行，再回到行首覆寫文字 */
+    g_line.len = 0;
+    str_append(&g_line, "\033[44m", 5);
+    str_fill(&g_line, ' ', size.cols);
+    str_append(&g_line, "\r", 1);
     
     /* 根據是否為錯誤選擇文字顏色 */
-    if (is_error) {
-        printf("\033[91m%s\033[0m", status ? status : "");  /* 紅色 */
-    } else {
-        printf("\033[97m%s\033[0m", status ? status : "");  /* 白色 */
+    str_append(&g_line, is_error ? "\033[91m" : "\033[97m", 5);  /* 紅色／白色 */
+    if (status != NULL) {
+        str_append(&g_line, status, strlen(status));
     }
     
-    printf("\033[0m");
-    fflush(stdout);
+    commit_line(size.rows - 2);
 }
 
 /**
@@ -242,23 +400,33 @@ void screen_show_status(const char *status, bool is_error) {
  */
 void screen_show_command(const char *command) {
     screen_size_t size = screen_get_size();
+    if (size.rows < 1 || !ensure_screen_buffer(size)) {
+        return;
+    }
     
-    /* 移至命令列位置 */
-    screen_set_cursor(size.rows - 1, 0);
-    
-    /* 清除命令列 */
-    printf("\033[0m");
-    for (size_t i = 0; i < size.cols; i++) {
-        printf(" ");
+    /* 顯示命令（青色，搜尋命令本身以 / 開頭，不加冒號） */
+    g_line.len = 0;
+    str_append(&g_line, "\033[36m", 5);
+    if (command == NULL || command[0] != '/') {
+        str_append(&g_line, ":", 1);
+    }
+    if (command != NULL) {
+        str_append(&g_line, command, strlen(command));
     }
-    screen_set_cursor(size.rows - 1, 0);
     
-    /* 顯示命令（青色） */
-    if (command != NULL && strlen(command) > 0) {
-        printf("\033[36m:%s\033[0m", command);
-    } else {
-        printf("\033[36m:\033[0m");
+    commit_line(size.rows - 1);
+}
+
+/**
+ * @brief 將累積的畫面變更一次寫出
+ */
+void screen_flush(void) {
+    if (g_output.len == 0) {
+        return;
     }
     
+    /* 先送出 stdio 中尚未輸出的內容，確保順序正確 */
     fflush(stdout);
+    write_all(g_output.data, g_output.len);
+    g_output.len = 0;
 }
@@ -7,6 +7,7 @@
  * - 游標位置控制
  * - 緩衝區內容渲染
  * - 狀態列與命令列顯示
+ * - 差異比對的雙緩衝輸出
  *
  * @author Yun
  * @date 2025
@@ -102,7 +103,8 @@ void screen_show_cursor(void);
 /**
  * @brief 重新繪製螢幕
  *
- * 根據緩衝區內容與游標位置重新繪製整個螢幕。
+ * 根據緩衝區內容與游標位置組合新畫面，只有與上一個畫面不同的行
+ * 才會輸出；實際輸出延後到 screen_flush()。
  *
  * @param buf        文字緩衝區
  * @param cursor     游標位置
@@ -113,7 +115,7 @@ void screen_refresh(buffer_t *buf, cursor_t *cursor, size_t first_line);
 /**
  * @brief 顯示狀態列
  *
- * 在螢幕底部顯示狀態訊息。
+ * 在螢幕底部顯示狀態訊息（輸出延後到 screen_flush()）。
  *
  * @param status   狀態訊息字串
  * @param is_error 是否為錯誤訊息（影響顯示顏色）
@@ -123,10 +125,17 @@ void screen_show_status(const char *status, bool is_error);
 /**
  * @brief 顯示命令列
  *
- * 在螢幕最底部顯示命令輸入區。
+ * 在螢幕最底部顯示命令輸入區（輸出延後到 screen_flush()）。
  *
  * @param command 目前輸入的命令字串
  */
 void screen_show_command(const char *command);
 
+/**
+ * @brief 將累積的畫面變更送到終端機
+ *
+ * 以單一 write(2) 寫出自上次呼叫以來所有變化的行；沒有變化時不做任何事。
+ */
+void screen_flush(void);
+
 #endif // SCREEN_H
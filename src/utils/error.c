@@ -17,8 +17,8 @@
  * 模組內部狀態
  * ============================================================================ */
 
-/** 全域錯誤狀態 */
-static error_t g_error = {ERR_OK, "", 0, NULL};
+/** 錯誤狀態（每個執行緒各自一份） */
+static _Thread_local error_t g_error = {ERR_OK, "", 0, NULL};
 
 /* ============================================================================
  * 錯誤處理函式
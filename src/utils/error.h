@@ -7,6 +7,9 @@
  * - 錯誤訊息設定與取得
  * - 錯誤輸出與清除
  *
+ * 錯誤狀態為每個執行緒各自一份（_Thread_local），工作執行緒設定的錯誤
+ * 不會覆寫其他執行緒的錯誤訊息。
+ *
  * @author Yun
  * @date 2025
  */
@@ -0,0 +1,270 @@
+/**
+ * @file lzblock.c
+ * @brief LZ 區塊壓縮模組實作
+ *
+ * 壓縮端沿用 LZ4 的限制：最短匹配 4 位元組、最後 LAST_LITERALS 位元組
+ * 一律為字面資料、距離結尾 MF_LIMIT 位元組內不再開始新的匹配；
+ * 連續找不到匹配時逐漸加大跳躍步伐，無法壓縮的資料也能快速掃過。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "lzblock.h"
+#include <stdint.h>
+#include <string.h>
+
+/** 最短匹配長度 */
+#define MIN_MATCH 4
+
+/** 區塊結尾必須為字面資料的位元組數 */
+#define LAST_LITERALS 5
+
+/** 距離結尾此位元組數內不再開始新的匹配 */
+#define MF_LIMIT 12
+
+/** 雜湊表大小（2 的冪次） */
+#define HASH_BITS 12
+
+/** 字面長度或匹配長度欄位的最大值（超過時使用延伸位元組） */
+#define RUN_MASK 15
+
+/* ============================================================================
+ * 內部輔助函式
+ * ============================================================================ */
+
+/**
+ * @brief 讀取 4 位元組（不要求對齊）
+ */
+static uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief 4 位元組序列的雜湊值
+ */
+static uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief 寫出長度欄位的延伸位元組
+ *
+ * @param op  輸出位置
+ * @param len 長度減去 RUN_MASK 後的值
+ * @return 寫出後的輸出位置
+ */
+static uint8_t *put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/**
+ * @brief 讀取長度欄位的延伸位元組
+ *
+ * @param ip   讀取位置（會被更新）
+ * @param iend 輸入結尾
+ * @param len  輸入輸出參數，加上延伸位元組的長度
+ * @return 成功回傳 true，輸入不足回傳 false
+ */
+static bool get_length(const uint8_t **ip, const uint8_t *iend, size_t *len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend) {
+            return false;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+/**
+ * @brief 寫出一個 sequence 的 token、字面長度與字面資料
+ *
+ * @return 寫出後的輸出位置，輸出空間不足時回傳 NULL
+ */
+static uint8_t *put_literals(uint8_t *op, const uint8_t *oend, const uint8_t *lit,
+                             size_t lit_len, size_t reserve) {
+    /* token + 延伸位元組 + 字面資料 + 之後的匹配欄位 */
+    size_t need = 1 + lit_len / 255 + 1 + lit_len + reserve;
+    if ((size_t)(oend - op) < need) {
+        return NULL;
+    }
+    
+    if (lit_len >= RUN_MASK) {
+        *op++ = (uint8_t)(RUN_MASK << 4);
+        op = put_length(op, lit_len - RUN_MASK);
+    } else {
+        *op++ = (uint8_t)(lit_len << 4);
+    }
+    memcpy(op, lit, lit_len);
+    return op + lit_len;
+}
+
+/* ============================================================================
+ * 壓縮函式實作
+ * ============================================================================ */
+
+/**
+ * @brief 壓縮結果的最大可能大小
+ */
+size_t lz_compress_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+/**
+ * @brief 壓縮一個區塊
+ */
+size_t lz_compress(const void *src, size_t len, void *dst, size_t capacity) {
+    if (src == NULL || dst == NULL || len > LZ_BLOCK_MAX) {
+        return 0;
+    }
+    
+    const uint8_t *base = (const uint8_t *)src;
+    const uint8_t *ip = base;
+    const uint8_t *anchor = base;
+    const uint8_t *iend = base + len;
+    uint8_t *op = (uint8_t *)dst;
+    const uint8_t *oend = op + capacity;
+    
+    if (len > MF_LIMIT) {
+        const uint8_t *mflimit = iend - MF_LIMIT;
+        const uint8_t *matchlimit = iend - LAST_LITERALS;
+        uint32_t table[1u << HASH_BITS];
+        memset(table, 0, sizeof(table));
+        
+        ip++;
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            const uint8_t *ref = base + table[h];
+            table[h] = (uint32_t)(ip - base);
+            
+            if (ref >= ip || ip - ref > 65535 || read32(ref) != seq) {
+                /* 連續未匹配時加大步伐 */
+                ip += 1 + ((size_t)(ip - anchor) >> 6);
+                continue;
+            }
+            
+            /* 向前延伸匹配 */
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            
+            /* 向後延伸匹配 */
+            const uint8_t *mp = ip + MIN_MATCH;
+            const uint8_t *rp = ref + MIN_MATCH;
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            size_t match_len = (size_t)(mp - ip) - MIN_MATCH;
+            
+            /* 字面資料之後還需 offset 與匹配長度延伸位元組的空間 */
+            uint8_t *token = op;
+            op = put_literals(op, oend, anchor, (size_t)(ip - anchor), 2 + match_len / 255 + 1);
+            if (op == NULL) {
+                return 0;
+            }
+            
+            size_t offset = (size_t)(ip - ref);
+            *op++ = (uint8_t)(offset & 0xFF);
+            *op++ = (uint8_t)(offset >> 8);
+            if (match_len >= RUN_MASK) {
+                *token |= RUN_MASK;
+                op = put_length(op, match_len - RUN_MASK);
+            } else {
+                *token |= (uint8_t)match_len;
+            }
+            
+            ip = mp;
+            anchor = ip;
+            
+            /* 匹配結尾附近的位置也加入雜湊表，提高下一次匹配的機率 */
+            table[hash4(read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+        }
+    }
+    
+    /* 最後一個 sequence 只有字面資料 */
+    op = put_literals(op, oend, anchor, (size_t)(iend - anchor), 0);
+    if (op == NULL) {
+        return 0;
+    }
+    return (size_t)(op - (uint8_t *)dst);
+}
+
+/**
+ * @brief 解壓縮一個區塊
+ */
+bool lz_decompress(const void *src, size_t len, void *dst, size_t dst_len) {
+    if ((src == NULL && len > 0) || (dst == NULL && dst_len > 0)) {
+        return false;
+    }
+    
+    const uint8_t *ip = (const uint8_t *)src;
+    const uint8_t *iend = ip + len;
+    uint8_t *base = (uint8_t *)dst;
+    uint8_t *op = base;
+    uint8_t *oend = base + dst_len;
+    
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        
+        /* 字面資料 */
+        size_t lit_len = token >> 4;
+        if (lit_len == RUN_MASK && !get_length(&ip, iend, &lit_len)) {
+            return false;
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, lit_len);
+        op += lit_len;
+        ip += lit_len;
+        
+        if (ip == iend) {
+            break;  /* 最後一個 sequence */
+        }
+        
+        /* 匹配 */
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - base)) {
+            return false;
+        }
+        
+        size_t match_len = token & RUN_MASK;
+        if (match_len == RUN_MASK && !get_length(&ip, iend, &match_len)) {
+            return false;
+        }
+        match_len += MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) {
+            return false;
+        }
+        
+        /* 來源與目的重疊時（重複的短樣式）以倍增的長度分段複製 */
+        const uint8_t *ref = op - offset;
+        while (match_len > 0) {
+            size_t n = (size_t)(op - ref);
+            if (n > match_len) {
+                n = match_len;
+            }
+            memcpy(op, ref, n);
+            op += n;
+            match_len -= n;
+        }
+    }
+    
+    return op == oend;
+}
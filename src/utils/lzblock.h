@@ -0,0 +1,68 @@
+/**
+ * @file lzblock.h
+ * @brief LZ 區塊壓縮模組標頭檔
+ *
+ * 本模組提供 LZ4 區塊格式的快速壓縮與解壓縮，包含：
+ * - 壓縮：以 4 位元組雜湊表貪婪搜尋重複序列
+ * - 解壓縮：逐一檢查輸入與輸出邊界，損壞的資料不會造成越界存取
+ *
+ * 每個區塊獨立壓縮（不參照其他區塊），可平行處理並隨機存取。
+ *
+ * @note 區塊格式（與 LZ4 block format 相容）：
+ *   一連串 sequence，每個 sequence 為
+ *   token | [字面長度延伸] | 字面資料 | offset(u16 LE) | [匹配長度延伸]；
+ *   token 高 4 位元為字面長度、低 4 位元為匹配長度減 4，值為 15 時後接延伸位元組。
+ *   最後一個 sequence 只有字面資料。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef LZBLOCK_H
+#define LZBLOCK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/** @brief 可壓縮的最大區塊大小（位元組；匹配距離以 16 位元表示） */
+#define LZ_BLOCK_MAX (64u * 1024u)
+
+/* ============================================================================
+ * 壓縮函式
+ * ============================================================================ */
+
+/**
+ * @brief 壓縮結果的最大可能大小
+ *
+ * @param len 原始資料長度
+ * @return 壓縮輸出緩衝區所需的大小
+ */
+size_t lz_compress_bound(size_t len);
+
+/**
+ * @brief 壓縮一個區塊
+ *
+ * @param src      原始資料
+ * @param len      原始資料長度（不超過 LZ_BLOCK_MAX）
+ * @param dst      輸出緩衝區
+ * @param capacity 輸出緩衝區大小
+ * @return 壓縮後的長度；輸出放不下 capacity 時回傳 0（呼叫端改存原始資料）
+ */
+size_t lz_compress(const void *src, size_t len, void *dst, size_t capacity);
+
+/**
+ * @brief 解壓縮一個區塊
+ *
+ * @param src     壓縮資料
+ * @param len     壓縮資料長度
+ * @param dst     輸出緩衝區
+ * @param dst_len 原始資料長度（解壓縮結果必須剛好為此長度）
+ * @return 成功回傳 true，資料損壞回傳 false
+ */
+bool lz_decompress(const void *src, size_t len, void *dst, size_t dst_len);
+
+#endif // LZBLOCK_H
@@ -4,19 +4,32 @@
  *
  * 實作安全的記憶體配置、釋放與追蹤功能。
  *
+ * 區段配置器的區塊以鏈結串列串接（新區塊在前），回收時從目前區塊往回釋放；
+ * 每個區段保留一個預設大小的備用區塊，反覆在區塊邊界配置與回收時不會每次呼叫 malloc。
+ *
+ * 分類統計的每個分類各佔一條快取線，以 relaxed 原子運算累加，
+ * 不同執行緒配置不同分類時不互相干擾；最大值以 CAS 迴圈更新。
+ *
  * @author Yun
  * @date 2025
  */
 
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 strnlen） */
+
 #include "memory.h"
 #include "error.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <errno.h>
+#include <pthread.h>
 
 #ifdef DEBUG
 #include <stdio.h>
-#include <stdint.h>
 
 /* ============================================================================
  * Debug 模式記憶體追蹤結構
@@ -43,6 +56,72 @@ static size_t g_total_allocated = 0;
 static size_t g_total_freed = 0;
 #endif
 
+/* ============================================================================
+ * 區段配置器結構
+ * ============================================================================ */
+
+/** 區段配置的對齊（位元組） */
+#define ARENA_ALIGN alignof(max_align_t)
+
+/**
+ * @brief 區段中的一個區塊（資料緊接在結構之後）
+ */
+typedef struct arena_block {
+    struct arena_block *prev;   /**< 前一個（較舊的）區塊 */
+    size_t capacity;            /**< 資料區大小 */
+    size_t used;                /**< 已使用的位元組數 */
+    max_align_t data[];         /**< 資料區 */
+} arena_block_t;
+
+/**
+ * @brief 區段配置器
+ */
+struct arena {
+    arena_block_t *current;     /**< 目前配置中的區塊（永不為 NULL） */
+    arena_block_t *spare;       /**< 回收後保留的備用區塊（可為 NULL） */
+    size_t block_size;          /**< 預設區塊大小 */
+};
+
+/** 暫存區段的執行緒結束清理鍵 */
+static pthread_key_t g_scratch_key;
+
+/** 確保 g_scratch_key 只建立一次 */
+static pthread_once_t g_scratch_once = PTHREAD_ONCE_INIT;
+
+/** g_scratch_key 是否建立成功 */
+static bool g_scratch_key_ready = false;
+
+/** 呼叫端執行緒的暫存區段 */
+static _Thread_local arena_t *t_scratch = NULL;
+
+/* ============================================================================
+ * 分類統計結構
+ * ============================================================================ */
+
+/**
+ * @brief 一個分類的計數器（獨占一條快取線）
+ */
+typedef struct {
+    alignas(64) atomic_size_t current;  /**< 目前配置中的位元組數 */
+    atomic_size_t peak;                 /**< 最大位元組數 */
+    atomic_size_t allocs;               /**< 累計配置次數 */
+    atomic_size_t frees;                /**< 累計釋放次數 */
+} mem_counter_t;
+
+/** 各分類的計數器，最後一個為合計 */
+static mem_counter_t g_mem_counters[MEM_TAG_COUNT + 1];
+
+/** 分類的顯示名稱 */
+static const char *const g_mem_tag_names[MEM_TAG_COUNT] = {
+    "vfs-node",
+    "file-data",
+    "vfs-index",
+    "buffer",
+    "undo",
+    "image",
+    "arena",
+};
+
 /* ============================================================================
  * 安全記憶體配置函式
  * ============================================================================ */
@@ -67,6 +146,23 @@ void *safe_malloc(size_t size) {
     return ptr;
 }
 
+/**
+ * @brief 配置未初始化的記憶體
+ */
+void *safe_malloc_uninit(size_t size) {
+    if (size == 0) {
+        error_set(ERR_INVALID_INPUT, "嘗試分配 0 大小的記憶體");
+        return NULL;
+    }
+    
+    void *ptr = malloc(size);
+    if (ptr == NULL) {
+        error_set(ERR_MEMORY, "記憶體分配失敗: %s", strerror(errno));
+        return NULL;
+    }
+    return ptr;
+}
+
 /**
  * @brief 安全的陣列記憶體配置
  */
@@ -132,7 +228,7 @@ char *safe_strdup(const char *s) {
     }
     
     size_t len = strlen(s);
-    char *dup = (char *)safe_malloc(len + 1);
+    char *dup = (char *)safe_malloc_uninit(len + 1);
     if (dup == NULL) {
         return NULL;
     }
@@ -152,7 +248,7 @@ char *safe_strndup(const char *s, size_t n) {
     }
     
     size_t len = strnlen(s, n);
-    char *dup = (char *)safe_malloc(len + 1);
+    char *dup = (char *)safe_malloc_uninit(len + 1);
     if (dup == NULL) {
         return NULL;
     }
@@ -162,6 +258,386 @@ char *safe_strndup(const char *s, size_t n) {
     return dup;
 }
 
+/* ============================================================================
+ * 區段配置器
+ * ============================================================================ */
+
+/**
+ * @brief 配置新區塊
+ */
+static arena_block_t *arena_block_new(size_t capacity) {
+    if (capacity > SIZE_MAX - sizeof(arena_block_t)) {
+        error_set(ERR_MEMORY, "記憶體分配大小溢出");
+        return NULL;
+    }
+    arena_block_t *block = (arena_block_t *)tagged_malloc_uninit(MEM_TAG_ARENA,
+                                                                 sizeof(arena_block_t) + capacity);
+    if (block != NULL) {
+        block->prev = NULL;
+        block->capacity = capacity;
+        block->used = 0;
+    }
+    return block;
+}
+
+/**
+ * @brief 釋放區塊
+ */
+static void arena_block_free(arena_block_t *block) {
+    if (block != NULL) {
+        tagged_free(MEM_TAG_ARENA, block, sizeof(arena_block_t) + block->capacity);
+    }
+}
+
+/**
+ * @brief 釋放目前區塊並回到前一個區塊（預設大小的區塊留作備用）
+ */
+static void arena_pop_block(arena_t *arena) {
+    arena_block_t *block = arena->current;
+    arena->current = block->prev;
+    
+    if (block->capacity == arena->block_size && arena->spare == NULL) {
+        arena->spare = block;
+    } else {
+        arena_block_free(block);
+    }
+}
+
+/**
+ * @brief 建立區段配置器
+ */
+arena_t *arena_create(size_t block_size) {
+    if (block_size == 0) {
+        block_size = ARENA_DEFAULT_BLOCK;
+    }
+    
+    arena_t *arena = (arena_t *)safe_malloc(sizeof(arena_t));
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena->block_size = block_size;
+    arena->current = arena_block_new(block_size);
+    if (arena->current == NULL) {
+        safe_free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+/**
+ * @brief 從區段配置記憶體
+ */
+void *arena_alloc(arena_t *arena, size_t size) {
+    if (arena == NULL || size == 0) {
+        error_set(ERR_INVALID_INPUT, "無效的區段配置");
+        return NULL;
+    }
+    
+    /* 以對齊後的大小遞增，下一次配置的起點自然對齊 */
+    if (size > SIZE_MAX - ARENA_ALIGN) {
+        error_set(ERR_MEMORY, "記憶體分配大小溢出");
+        return NULL;
+    }
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    
+    arena_block_t *block = arena->current;
+    if (block->capacity - block->used < aligned) {
+        if (aligned <= arena->block_size && arena->spare != NULL) {
+            block = arena->spare;
+            arena->spare = NULL;
+            block->used = 0;
+        } else {
+            block = arena_block_new(aligned > arena->block_size ? aligned : arena->block_size);
+            if (block == NULL) {
+                return NULL;
+            }
+        }
+        block->prev = arena->current;
+        arena->current = block;
+    }
+    
+    void *ptr = (unsigned char *)block->data + block->used;
+    block->used += aligned;
+    return ptr;
+}
+
+/**
+ * @brief 在區段中複製最多 n 個字元的字串
+ */
+char *arena_strndup(arena_t *arena, const char *s, size_t n) {
+    if (s == NULL) {
+        error_set(ERR_INVALID_INPUT, "嘗試複製 NULL 字串");
+        return NULL;
+    }
+    
+    size_t len = strnlen(s, n);
+    char *dup = (char *)arena_alloc(arena, len + 1);
+    if (dup != NULL) {
+        memcpy(dup, s, len);
+        dup[len] = '\0';
+    }
+    return dup;
+}
+
+/**
+ * @brief 記錄目前的配置位置
+ */
+arena_mark_t arena_mark(const arena_t *arena) {
+    arena_mark_t mark = { NULL, 0 };
+    if (arena != NULL) {
+        mark.block = arena->current;
+        mark.used = arena->current->used;
+    }
+    return mark;
+}
+
+/**
+ * @brief 回收 mark 之後的所有配置
+ */
+void arena_rewind(arena_t *arena, arena_mark_t mark) {
+    if (arena == NULL || mark.block == NULL) {
+        return;
+    }
+    
+    while (arena->current != mark.block && arena->current->prev != NULL) {
+        arena_pop_block(arena);
+    }
+    if (arena->current == mark.block) {
+        arena->current->used = mark.used;
+    }
+}
+
+/**
+ * @brief 回收所有配置（保留第一個區塊）
+ */
+void arena_reset(arena_t *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    
+    while (arena->current->prev != NULL) {
+        arena_pop_block(arena);
+    }
+    arena->current->used = 0;
+}
+
+/**
+ * @brief 釋放區段配置器與所有區塊
+ */
+void arena_destroy(arena_t *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    
+    arena_block_t *block = arena->current;
+    while (block != NULL) {
+        arena_block_t *prev = block->prev;
+        arena_block_free(block);
+        block = prev;
+    }
+    arena_block_free(arena->spare);
+    safe_free(arena);
+}
+
+/**
+ * @brief 執行緒結束時釋放其暫存區段
+ */
+static void scratch_destructor(void *arena) {
+    arena_destroy((arena_t *)arena);
+}
+
+/**
+ * @brief 建立暫存區段的清理鍵
+ */
+static void scratch_key_init(void) {
+    g_scratch_key_ready = pthread_key_create(&g_scratch_key, scratch_destructor) == 0;
+}
+
+/**
+ * @brief 取得呼叫端執行緒的暫存區段
+ */
+arena_t *scratch_arena(void) {
+    if (t_scratch == NULL) {
+        pthread_once(&g_scratch_once, scratch_key_init);
+        t_scratch = arena_create(ARENA_DEFAULT_BLOCK);
+        if (t_scratch != NULL && g_scratch_key_ready) {
+            pthread_setspecific(g_scratch_key, t_scratch);
+        }
+    }
+    return t_scratch;
+}
+
+/**
+ * @brief 提前釋放呼叫端執行緒的暫存區段
+ */
+void scratch_arena_release(void) {
+    if (t_scratch != NULL) {
+        if (g_scratch_key_ready) {
+            pthread_setspecific(g_scratch_key, NULL);
+        }
+        arena_destroy(t_scratch);
+        t_scratch = NULL;
+    }
+}
+
+/* ============================================================================
+ * 分類記憶體統計
+ * ============================================================================ */
+
+/**
+ * @brief 累加一個計數器的用量並更新最大值
+ */
+static void counter_add(mem_counter_t *counter, size_t size) {
+    size_t now = atomic_fetch_add_explicit(&counter->current, size, memory_order_relaxed) + size;
+    size_t peak = atomic_load_explicit(&counter->peak, memory_order_relaxed);
+    while (now > peak &&
+           !atomic_compare_exchange_weak_explicit(&counter->peak, &peak, now,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+        /* 失敗時 peak 已更新為目前值，重新比較 */
+    }
+}
+
+/**
+ * @brief 調整分類與合計的用量
+ */
+static void mem_account(mem_tag_t tag, size_t added, size_t removed) {
+    if ((unsigned)tag >= MEM_TAG_COUNT) {
+        return;
+    }
+    
+    mem_counter_t *targets[2] = { &g_mem_counters[tag], &g_mem_counters[MEM_TAG_COUNT] };
+    for (int i = 0; i < 2; i++) {
+        if (added > 0) {
+            counter_add(targets[i], added);
+        }
+        if (removed > 0) {
+            atomic_fetch_sub_explicit(&targets[i]->current, removed, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief 累加分類與合計的配置或釋放次數
+ */
+static void mem_count(mem_tag_t tag, bool alloc) {
+    if ((unsigned)tag >= MEM_TAG_COUNT) {
+        return;
+    }
+    
+    mem_counter_t *targets[2] = { &g_mem_counters[tag], &g_mem_counters[MEM_TAG_COUNT] };
+    for (int i = 0; i < 2; i++) {
+        atomic_fetch_add_explicit(alloc ? &targets[i]->allocs : &targets[i]->frees, 1,
+                                  memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 記錄不經由標記函式配置的記憶體
+ */
+void mem_account_alloc(mem_tag_t tag, size_t size) {
+    mem_account(tag, size, 0);
+    mem_count(tag, true);
+}
+
+/**
+ * @brief 記錄 mem_account_alloc 記錄過的記憶體已釋放
+ */
+void mem_account_free(mem_tag_t tag, size_t size) {
+    mem_account(tag, 0, size);
+    mem_count(tag, false);
+}
+
+/**
+ * @brief 以分類標記配置記憶體（初始化為零）
+ */
+void *tagged_malloc(mem_tag_t tag, size_t size) {
+    void *ptr = safe_malloc(size);
+    if (ptr != NULL) {
+        mem_account_alloc(tag, size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief 以分類標記配置未初始化的記憶體
+ */
+void *tagged_malloc_uninit(mem_tag_t tag, size_t size) {
+    void *ptr = safe_malloc_uninit(size);
+    if (ptr != NULL) {
+        mem_account_alloc(tag, size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief 以分類標記配置陣列記憶體
+ */
+void *tagged_calloc(mem_tag_t tag, size_t nmemb, size_t size) {
+    void *ptr = safe_calloc(nmemb, size);
+    if (ptr != NULL) {
+        mem_account_alloc(tag, nmemb * size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief 以分類標記重新配置記憶體
+ */
+void *tagged_realloc(mem_tag_t tag, void *ptr, size_t old_size, size_t new_size) {
+    void *new_ptr = safe_realloc(ptr, new_size);
+    if (new_ptr != NULL) {
+        mem_account(tag, new_size, old_size);
+        if (ptr == NULL) {
+            mem_count(tag, true);
+        }
+    }
+    return new_ptr;
+}
+
+/**
+ * @brief 釋放以分類標記配置的記憶體
+ */
+void tagged_free(mem_tag_t tag, void *ptr, size_t size) {
+    if (ptr != NULL) {
+        safe_free(ptr);
+        mem_account_free(tag, size);
+    }
+}
+
+/**
+ * @brief 分類的顯示名稱
+ */
+const char *mem_tag_name(mem_tag_t tag) {
+    return ((unsigned)tag < MEM_TAG_COUNT) ? g_mem_tag_names[tag] : "?";
+}
+
+/**
+ * @brief 讀取計數器的快照
+ */
+static mem_stats_t counter_snapshot(mem_counter_t *counter) {
+    mem_stats_t stats;
+    stats.current = atomic_load_explicit(&counter->current, memory_order_relaxed);
+    stats.peak = atomic_load_explicit(&counter->peak, memory_order_relaxed);
+    stats.allocs = atomic_load_explicit(&counter->allocs, memory_order_relaxed);
+    stats.frees = atomic_load_explicit(&counter->frees, memory_order_relaxed);
+    return stats;
+}
+
+/**
+ * @brief 取得一個分類的用量快照
+ */
+mem_stats_t mem_stats(mem_tag_t tag) {
+    mem_stats_t empty = { 0, 0, 0, 0 };
+    return ((unsigned)tag < MEM_TAG_COUNT) ? counter_snapshot(&g_mem_counters[tag]) : empty;
+}
+
+/**
+ * @brief 取得所有分類合計的用量快照
+ */
+mem_stats_t mem_stats_total(void) {
+    return counter_snapshot(&g_mem_counters[MEM_TAG_COUNT]);
+}
+
 /* ============================================================================
  * 安全性函式
  * ============================================================================ */
@@ -186,6 +662,15 @@ void secure_zero(void *ptr, size_t size) {
  * ============================================================================ */
 
 #ifdef DEBUG
+/**
+ * @brief 配置記憶體並記錄配置位置
+ */
+void *memory_track_malloc(size_t size, const char *file, int line) {
+    void *ptr = safe_malloc(size);
+    memory_track_alloc(ptr, size, file, line);
+    return ptr;
+}
+
 /**
  * @brief 追蹤記憶體配置
  */
@@ -4,7 +4,10 @@
  *
  * 本模組提供安全的記憶體配置與釋放函式，包含：
  * - 自動錯誤檢查與回報
- * - 配置時自動初始化為零
+ * - 配置時自動初始化為零（立即覆寫的緩衝區可用 safe_malloc_uninit 省去清零）
+ * - 區段配置器（arena）：以指標遞增配置短期暫存資料，整批釋放
+ * - 每個執行緒各自的暫存區段（scratch_arena）
+ * - 分類記憶體統計：各子系統以標記配置，release 版本同樣可查詢用量
  * - 敏感資料安全清除
  * - Debug 模式下的記憶體追蹤
  *
@@ -35,6 +38,17 @@
  */
 void *safe_malloc(size_t size);
 
+/**
+ * @brief 配置未初始化的記憶體
+ *
+ * 與 safe_malloc 相同但不清零，用於配置後立即整段覆寫的緩衝區
+ * （複製內容、解密輸出等），省去無用的清零。
+ *
+ * @param size 要配置的位元組數
+ * @return 配置的記憶體指標，失敗回傳 NULL
+ */
+void *safe_malloc_uninit(size_t size);
+
 /**
  * @brief 安全的陣列記憶體配置
  *
@@ -94,6 +108,192 @@ char *safe_strdup(const char *s);
  */
 char *safe_strndup(const char *s, size_t n);
 
+/* ============================================================================
+ * 區段配置器（arena）
+ * ============================================================================ */
+
+/**
+ * @brief 區段配置器
+ *
+ * 從大區塊中以遞增指標配置記憶體，個別配置不需釋放，
+ * 以 arena_rewind / arena_reset 整批回收。空間不足時串接新區塊，
+ * 超過區塊大小的配置獨立成一個區塊。非執行緒安全。
+ */
+typedef struct arena arena_t;
+
+/**
+ * @brief 區段配置位置（arena_mark 取得，arena_rewind 回到此處）
+ */
+typedef struct {
+    void *block;                 /**< 當時的目前區塊 */
+    size_t used;                 /**< 當時目前區塊已使用的位元組數 */
+} arena_mark_t;
+
+/** 預設的區塊大小（位元組） */
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+
+/**
+ * @brief 建立區段配置器
+ *
+ * @param block_size 每個區塊的大小，0 表示 ARENA_DEFAULT_BLOCK
+ * @return 區段配置器，失敗回傳 NULL
+ */
+arena_t *arena_create(size_t block_size);
+
+/**
+ * @brief 從區段配置記憶體（未初始化，依 max_align_t 對齊）
+ *
+ * @param arena 區段配置器（NULL 時回傳 NULL）
+ * @param size  要配置的位元組數
+ * @return 配置的記憶體指標，失敗回傳 NULL
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * @brief 在區段中複製最多 n 個字元的字串
+ *
+ * @return 複製的字串，失敗回傳 NULL
+ */
+char *arena_strndup(arena_t *arena, const char *s, size_t n);
+
+/**
+ * @brief 記錄目前的配置位置
+ */
+arena_mark_t arena_mark(const arena_t *arena);
+
+/**
+ * @brief 回收 mark 之後的所有配置
+ *
+ * mark 之後串接的區塊會被釋放（保留一個預設大小的區塊供下次使用）。
+ * 巢狀使用時需依後進先出的順序回收。
+ */
+void arena_rewind(arena_t *arena, arena_mark_t mark);
+
+/**
+ * @brief 回收所有配置（保留第一個區塊）
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * @brief 釋放區段配置器與所有區塊
+ */
+void arena_destroy(arena_t *arena);
+
+/**
+ * @brief 取得呼叫端執行緒的暫存區段
+ *
+ * 首次呼叫時建立，執行緒結束時釋放。用於函式內的短期暫存資料：
+ * 先以 arena_mark 記錄位置，用完後 arena_rewind；暫存資料不可在回收後使用，
+ * 也不可交給其他執行緒。
+ *
+ * @return 暫存區段，建立失敗回傳 NULL（arena_alloc 對 NULL 回傳 NULL）
+ */
+arena_t *scratch_arena(void);
+
+/**
+ * @brief 提前釋放呼叫端執行緒的暫存區段（主執行緒結束前使用）
+ */
+void scratch_arena_release(void);
+
+/* ============================================================================
+ * 分類記憶體統計
+ * ============================================================================ */
+
+/**
+ * @brief 記憶體用量分類
+ *
+ * 各子系統的長期配置以標記函式配置與釋放，未標記的 safe_malloc 不計入。
+ */
+typedef enum {
+    MEM_TAG_VFS_NODE,            /**< VFS 節點池與長名稱 */
+    MEM_TAG_FILE_DATA,           /**< 檔案內容區塊與分段串列 */
+    MEM_TAG_VFS_INDEX,           /**< 目錄索引與路徑快取 */
+    MEM_TAG_BUFFER,              /**< 編輯器緩衝區的行與載入區塊 */
+    MEM_TAG_UNDO,                /**< 撤銷記錄 */
+    MEM_TAG_IMAGE,               /**< 映像檔後備儲存的區塊索引、標籤與快取 */
+    MEM_TAG_ARENA,               /**< 區段配置器的區塊（含暫存區段） */
+    MEM_TAG_COUNT                /**< 分類數量 */
+} mem_tag_t;
+
+/**
+ * @brief 一個分類的用量快照
+ */
+typedef struct {
+    size_t current;              /**< 目前配置中的位元組數 */
+    size_t peak;                 /**< 曾經達到的最大位元組數 */
+    size_t allocs;               /**< 累計配置次數 */
+    size_t frees;                /**< 累計釋放次數 */
+} mem_stats_t;
+
+/**
+ * @brief 以分類標記配置記憶體（初始化為零）
+ *
+ * 統計以不需鎖的原子計數更新，可在任何執行緒呼叫。
+ * 釋放時需以 tagged_free 傳入相同的分類與大小。
+ *
+ * @param tag  分類
+ * @param size 要配置的位元組數
+ * @return 配置的記憶體指標，失敗回傳 NULL
+ */
+void *tagged_malloc(mem_tag_t tag, size_t size);
+
+/**
+ * @brief 以分類標記配置未初始化的記憶體
+ */
+void *tagged_malloc_uninit(mem_tag_t tag, size_t size);
+
+/**
+ * @brief 以分類標記配置陣列記憶體（初始化為零，檢查乘法溢位）
+ */
+void *tagged_calloc(mem_tag_t tag, size_t nmemb, size_t size);
+
+/**
+ * @brief 以分類標記重新配置記憶體
+ *
+ * @param tag      分類
+ * @param ptr      原有記憶體指標（可為 NULL，此時 old_size 應為 0）
+ * @param old_size 原有大小
+ * @param new_size 新的大小
+ * @return 新的記憶體指標，失敗回傳 NULL（原記憶體與統計不受影響）
+ */
+void *tagged_realloc(mem_tag_t tag, void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * @brief 釋放以分類標記配置的記憶體
+ *
+ * @param tag  配置時的分類
+ * @param ptr  記憶體指標（NULL 時不做任何事）
+ * @param size 配置時的大小
+ */
+void tagged_free(mem_tag_t tag, void *ptr, size_t size);
+
+/**
+ * @brief 記錄不經由標記函式配置的記憶體（如整批讀入後才交給子系統的區塊）
+ */
+void mem_account_alloc(mem_tag_t tag, size_t size);
+
+/**
+ * @brief 記錄 mem_account_alloc 記錄過的記憶體已釋放
+ */
+void mem_account_free(mem_tag_t tag, size_t size);
+
+/**
+ * @brief 分類的顯示名稱
+ */
+const char *mem_tag_name(mem_tag_t tag);
+
+/**
+ * @brief 取得一個分類的用量快照
+ *
+ * 各欄位分別讀取，其他執行緒同時配置時欄位之間可能略有落差。
+ */
+mem_stats_t mem_stats(mem_tag_t tag);
+
+/**
+ * @brief 取得所有分類合計的用量快照（peak 為合計用量的最大值）
+ */
+mem_stats_t mem_stats_total(void);
+
 /* ============================================================================
  * 安全性函式
  * ============================================================================ */
@@ -140,8 +340,15 @@ void memory_track_free(void *ptr, const char *file, int line);
  */
 void memory_print_stats(void);
 
-#define SAFE_MALLOC(size) safe_malloc(size); memory_track_alloc(__builtin_return_address(0), size, __FILE__, __LINE__)
-#define SAFE_FREE(ptr) memory_track_free(ptr, __FILE__, __LINE__); safe_free(ptr)
+/**
+ * @brief 配置記憶體並記錄配置位置（SAFE_MALLOC 使用）
+ *
+ * @return 配置的記憶體指標，失敗回傳 NULL
+ */
+void *memory_track_malloc(size_t size, const char *file, int line);
+
+#define SAFE_MALLOC(size) memory_track_malloc((size), __FILE__, __LINE__)
+#define SAFE_FREE(ptr) do { memory_track_free((ptr), __FILE__, __LINE__); safe_free(ptr); } while (0)
 #else
 #define SAFE_MALLOC(size) safe_malloc(size)
 #define SAFE_FREE(ptr) safe_free(ptr)
@@ -0,0 +1,226 @@
+/**
+ * @file threadpool.c
+ * @brief 工作執行緒池模組實作
+ *
+ * 工作執行緒在條件變數上等待新的平行迴圈，
+ * 以共用的工作索引逐一領取工作，最後一個完成者喚醒呼叫端。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 sysconf） */
+
+#include "threadpool.h"
+#include "memory.h"
+#include "error.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/**
+ * @brief 執行緒池
+ */
+struct threadpool {
+    pthread_t *threads;                    /**< 工作執行緒 */
+    size_t worker_count;                   /**< 工作執行緒數量（不含呼叫端） */
+    pthread_mutex_t lock;                  /**< 保護以下工作狀態 */
+    pthread_cond_t work_cond;              /**< 有新工作或要求結束 */
+    pthread_cond_t done_cond;              /**< 目前的平行迴圈已完成 */
+    pthread_mutex_t run_lock;              /**< 序列化多個呼叫端的平行迴圈 */
+    threadpool_task_fn fn;                 /**< 目前的工作函式（NULL 表示閒置） */
+    void *arg;                             /**< 工作函式參數 */
+    size_t total;                          /**< 工作總數 */
+    size_t next;                           /**< 下一個待領取的工作索引 */
+    size_t remaining;                      /**< 尚未完成的工作數 */
+    bool stop;                             /**< 是否要求工作執行緒結束 */
+};
+
+/* ============================================================================
+ * 內部輔助函式
+ * ============================================================================ */
+
+/**
+ * @brief 領取並執行工作，直到沒有剩餘工作
+ *
+ * 呼叫前後都必須持有 pool->lock。
+ */
+static void run_tasks_locked(threadpool_t *pool) {
+    while (pool->fn != NULL && pool->next < pool->total) {
+        size_t index = pool->next++;
+        threadpool_task_fn fn = pool->fn;
+        void *arg = pool->arg;
+        
+        pthread_mutex_unlock(&pool->lock);
+        fn(arg, index);
+        pthread_mutex_lock(&pool->lock);
+        
+        if (--pool->remaining == 0) {
+            pthread_cond_broadcast(&pool->done_cond);
+        }
+    }
+}
+
+/**
+ * @brief 工作執行緒主迴圈
+ */
+static void *worker_main(void *arg) {
+    threadpool_t *pool = (threadpool_t *)arg;
+    
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop) {
+        if (pool->fn == NULL || pool->next >= pool->total) {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+            continue;
+        }
+        run_tasks_locked(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * 執行緒池函式實作
+ * ============================================================================ */
+
+/**
+ * @brief 建立執行緒池
+ */
+threadpool_t *threadpool_create(size_t threads) {
+    if (threads == 0) {
+        threads = threadpool_default_threads();
+    }
+    if (threads > THREADPOOL_MAX_THREADS) {
+        threads = THREADPOOL_MAX_THREADS;
+    }
+    
+    threadpool_t *pool = (threadpool_t *)safe_malloc(sizeof(threadpool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+    
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pool->worker_count = 0;
+    pool->threads = NULL;
+    
+    if (threads > 1) {
+        pool->threads = (pthread_t *)safe_malloc(sizeof(pthread_t) * (threads - 1));
+        if (pool->threads == NULL) {
+            threadpool_destroy(pool);
+            return NULL;
+        }
+        
+        for (size_t i = 0; i < threads - 1; i++) {
+            if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+                break;
+            }
+            pool->worker_count++;
+        }
+        
+        /* 無法建立任何執行緒時仍可在呼叫端依序執行 */
+        if (pool->worker_count == 0) {
+            error_set(ERR_MEMORY, "無法建立工作執行緒");
+        }
+    }
+    
+    return pool;
+}
+
+/**
+ * @brief 銷毀執行緒池
+ */
+void threadpool_destroy(threadpool_t *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (size_t i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->run_lock);
+    pthread_mutex_destroy(&pool->lock);
+    safe_free(pool->threads);
+    safe_free(pool);
+}
+
+/**
+ * @brief 取得執行緒池的平行度
+ */
+size_t threadpool_size(const threadpool_t *pool) {
+    return (pool != NULL) ? pool->worker_count + 1 : 1;
+}
+
+/**
+ * @brief 平行執行 count 個工作並等待全部完成
+ */
+void threadpool_parallel_for(threadpool_t *pool, size_t count, threadpool_task_fn fn, void *arg) {
+    if (fn == NULL || count == 0) {
+        return;
+    }
+    
+    /* 沒有工作執行緒或只有一個工作時直接在呼叫端執行 */
+    if (pool == NULL || pool->worker_count == 0 || count == 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(arg, i);
+        }
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->run_lock);
+    pthread_mutex_lock(&pool->lock);
+    
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->total = count;
+    pool->next = 0;
+    pool->remaining = count;
+    pthread_cond_broadcast(&pool->work_cond);
+    
+    /* 呼叫端也參與工作，完成後等待其他執行緒手上的工作 */
+    run_tasks_locked(pool);
+    while (pool->remaining > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    
+    pool->fn = NULL;
+    pool->arg = NULL;
+    
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+/**
+ * @brief 取得預設平行度
+ */
+size_t threadpool_default_threads(void) {
+    const char *env = getenv("YUNFS_THREADS");
+    if (env != NULL && *env != '\0') {
+        char *end = NULL;
+        unsigned long value = strtoul(env, &end, 10);
+        if (end != NULL && *end == '\0' && value > 0) {
+            return value > THREADPOOL_MAX_THREADS ? THREADPOOL_MAX_THREADS : (size_t)value;
+        }
+    }
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return 1;
+    }
+    return cpus > THREADPOOL_MAX_THREADS ? THREADPOOL_MAX_THREADS : (size_t)cpus;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file threadpool.h
+ * @brief 工作執行緒池模組標頭檔
+ *
+ * 本模組提供固定大小的工作執行緒池，包含：
+ * - 建立與銷毀執行緒池
+ * - 平行迴圈（parallel for）：將 count 個獨立工作分配給所有執行緒
+ *
+ * 呼叫端執行緒也會參與工作，因此大小為 N 的執行緒池只額外建立 N-1 個執行緒。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/** @brief 執行緒池平行度上限 */
+#define THREADPOOL_MAX_THREADS 64
+
+/**
+ * @brief 執行緒池（不透明型別）
+ */
+typedef struct threadpool threadpool_t;
+
+/**
+ * @brief 平行迴圈的工作函式
+ *
+ * @param arg   呼叫 threadpool_parallel_for 時傳入的參數
+ * @param index 工作編號（0 到 count-1）
+ */
+typedef void (*threadpool_task_fn)(void *arg, size_t index);
+
+/* ============================================================================
+ * 執行緒池函式
+ * ============================================================================ */
+
+/**
+ * @brief 建立執行緒池
+ *
+ * @param threads 平行度（含呼叫端執行緒），0 表示使用 threadpool_default_threads()
+ * @return 執行緒池指標，失敗回傳 NULL
+ */
+threadpool_t *threadpool_create(size_t threads);
+
+/**
+ * @brief 銷毀執行緒池並等待所有工作執行緒結束
+ *
+ * @param pool 執行緒池（可為 NULL）
+ */
+void threadpool_destroy(threadpool_t *pool);
+
+/**
+ * @brief 取得執行緒池的平行度（含呼叫端執行緒）
+ *
+ * @param pool 執行緒池（NULL 視為 1）
+ * @return 平行度
+ */
+size_t threadpool_size(const threadpool_t *pool);
+
+/**
+ * @brief 平行執行 count 個工作並等待全部完成
+ *
+ * 工作之間不可互相依賴；pool 為 NULL 時在呼叫端依序執行。
+ * 同一執行緒池同時只執行一個平行迴圈，工作函式內不可再對同一執行緒池呼叫本函式。
+ *
+ * @param pool  執行緒池（可為 NULL）
+ * @param count 工作數量
+ * @param fn    工作函式
+ * @param arg   傳給工作函式的參數
+ */
+void threadpool_parallel_for(threadpool_t *pool, size_t count, threadpool_task_fn fn, void *arg);
+
+/**
+ * @brief 取得預設平行度
+ *
+ * 優先使用環境變數 YUNFS_THREADS，否則為線上 CPU 數量（上限 THREADPOOL_MAX_THREADS）。
+ *
+ * @return 預設平行度（至少為 1）
+ */
+size_t threadpool_default_threads(void);
+
+#endif // THREADPOOL_H
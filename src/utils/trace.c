@@ -0,0 +1,351 @@
+/**
+ * @file trace.c
+ * @brief 效能追蹤模組實作
+ *
+ * 每個探針有一組原子計數器與直方圖。耗時 v 小於 16 奈秒時直接對應到第 v 格；
+ * 否則以最高位元 e 與其後 3 個位元決定格子：16 + (e - 4) * 8 + 次 3 位元，
+ * 64 位元的耗時共需 496 格。百分位數取所在格子的上界。
+ *
+ * Chrome trace 事件存放在預先配置的陣列中，記錄時以原子遞增取得位置，
+ * 陣列用完後的事件只計入統計。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* 啟用 POSIX 擴充功能（如 clock_gettime） */
+
+#include "trace.h"
+#include "memory.h"
+#include "error.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/** 直接對應的小數值格數 */
+#define TRACE_LINEAR 16
+
+/** 每個 2 的冪次區間的格數（2^TRACE_SUB_BITS） */
+#define TRACE_SUB_BITS 3
+
+/** 直方圖格數 */
+#define TRACE_BUCKETS (TRACE_LINEAR + (64 - 4) * (1 << TRACE_SUB_BITS))
+
+/* ============================================================================
+ * 內部結構
+ * ============================================================================ */
+
+/**
+ * @brief 一個探針的統計
+ */
+typedef struct {
+    atomic_uint_fast64_t total;                    /**< 總耗時 */
+    atomic_uint_fast64_t max;                      /**< 最大耗時 */
+    atomic_uint_fast64_t buckets[TRACE_BUCKETS];   /**< 直方圖 */
+} trace_stats_t;
+
+/**
+ * @brief 一個 Chrome trace 事件
+ */
+typedef struct {
+    uint64_t start;              /**< 開始時間（奈秒） */
+    uint64_t duration;           /**< 耗時（奈秒） */
+    uint32_t tid;                /**< 執行緒編號 */
+    uint32_t probe;              /**< 探針 */
+} trace_event_t;
+
+/** 各探針的統計 */
+static trace_stats_t g_stats[TRACE_PROBE_COUNT];
+
+/** 探針的顯示名稱 */
+static const char *const g_probe_names[TRACE_PROBE_COUNT] = {
+    "vfs.resolve",
+    "vfs.read",
+    "vfs.write",
+    "vfs.create",
+    "vfs.delete",
+    "persist.save",
+    "persist.load",
+    "persist.fetch",
+    "chacha20",
+    "screen.refresh",
+    "vim.search",
+    "vim.undo",
+};
+
+/** 事件陣列（NULL 表示未在記錄） */
+static trace_event_t *_Atomic g_events = NULL;
+
+/** 事件陣列容量 */
+static size_t g_event_capacity = 0;
+
+/** 已取得的事件位置數（可能超過容量） */
+static atomic_size_t g_event_count;
+
+/** 記錄開始的時間 */
+static uint64_t g_capture_start = 0;
+
+/** 輸出檔案路徑 */
+static char *g_capture_path = NULL;
+
+/** 下一個執行緒編號 */
+static atomic_uint g_next_tid = 1;
+
+/** 呼叫端執行緒的編號（0 表示尚未指派） */
+static _Thread_local uint32_t t_tid = 0;
+
+/* ============================================================================
+ * 內部輔助函式
+ * ============================================================================ */
+
+/**
+ * @brief 耗時對應的直方圖格子
+ */
+static size_t bucket_of(uint64_t value) {
+    if (value < TRACE_LINEAR) {
+        return (size_t)value;
+    }
+    unsigned e = 63u - (unsigned)__builtin_clzll(value);
+    size_t sub = (size_t)(value >> (e - TRACE_SUB_BITS)) & ((1u << TRACE_SUB_BITS) - 1);
+    return TRACE_LINEAR + (size_t)(e - 4) * (1u << TRACE_SUB_BITS) + sub;
+}
+
+/**
+ * @brief 直方圖格子的上界
+ */
+static uint64_t bucket_upper(size_t index) {
+    if (index < TRACE_LINEAR) {
+        return index;
+    }
+    unsigned e = (unsigned)((index - TRACE_LINEAR) >> TRACE_SUB_BITS) + 4;
+    uint64_t sub = (index - TRACE_LINEAR) & ((1u << TRACE_SUB_BITS) - 1);
+    uint64_t width = 1ull << (e - TRACE_SUB_BITS);
+    return (((1ull << TRACE_SUB_BITS) + sub) << (e - TRACE_SUB_BITS)) + (width - 1);
+}
+
+/**
+ * @brief 呼叫端執行緒的編號
+ */
+static uint32_t thread_id(void) {
+    if (t_tid == 0) {
+        t_tid = atomic_fetch_add_explicit(&g_next_tid, 1, memory_order_relaxed);
+    }
+    return t_tid;
+}
+
+/* ============================================================================
+ * 計時函式實作
+ * ============================================================================ */
+
+/**
+ * @brief 目前的單調時鐘時間（奈秒）
+ */
+uint64_t trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 開始一個計時區段
+ */
+trace_span_t trace_begin(trace_probe_t probe) {
+    trace_span_t span = { probe, trace_now() };
+    return span;
+}
+
+/**
+ * @brief 結束計時區段並記錄耗時
+ */
+void trace_end(const trace_span_t *span) {
+    uint64_t end = trace_now();
+    trace_record(span->probe, span->start, end - span->start);
+}
+
+/**
+ * @brief 記錄一次已量測的耗時
+ */
+void trace_record(trace_probe_t probe, uint64_t start, uint64_t duration) {
+    if ((unsigned)probe >= TRACE_PROBE_COUNT) {
+        return;
+    }
+    
+    trace_stats_t *stats = &g_stats[probe];
+    atomic_fetch_add_explicit(&stats->total, duration, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->buckets[bucket_of(duration)], 1, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&stats->max, memory_order_relaxed);
+    while (duration > max &&
+           !atomic_compare_exchange_weak_explicit(&stats->max, &max, duration,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+        /* 失敗時 max 已更新為目前值，重新比較 */
+    }
+    
+    trace_event_t *events = atomic_load_explicit(&g_events, memory_order_acquire);
+    if (events != NULL) {
+        size_t slot = atomic_fetch_add_explicit(&g_event_count, 1, memory_order_relaxed);
+        if (slot < g_event_capacity) {
+            events[slot].start = start;
+            events[slot].duration = duration;
+            events[slot].tid = thread_id();
+            events[slot].probe = (uint32_t)probe;
+        }
+    }
+}
+
+/* ============================================================================
+ * 統計查詢實作
+ * ============================================================================ */
+
+/**
+ * @brief 探針的顯示名稱
+ */
+const char *trace_probe_name(trace_probe_t probe) {
+    return ((unsigned)probe < TRACE_PROBE_COUNT) ? g_probe_names[probe] : "?";
+}
+
+/**
+ * @brief 取得探針的統計摘要
+ */
+trace_summary_t trace_summary(trace_probe_t probe) {
+    trace_summary_t summary = { 0, 0, 0, 0, 0, 0 };
+    if ((unsigned)probe >= TRACE_PROBE_COUNT) {
+        return summary;
+    }
+    
+    trace_stats_t *stats = &g_stats[probe];
+    summary.total = atomic_load_explicit(&stats->total, memory_order_relaxed);
+    summary.max = atomic_load_explicit(&stats->max, memory_order_relaxed);
+    
+    /* 以直方圖的合計作為次數，百分位數與次數互相一致 */
+    uint64_t counts[TRACE_BUCKETS];
+    uint64_t count = 0;
+    for (size_t i = 0; i < TRACE_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&stats->buckets[i], memory_order_relaxed);
+        count += counts[i];
+    }
+    summary.count = count;
+    if (count == 0) {
+        return summary;
+    }
+    
+    const double quantiles[3] = { 0.50, 0.90, 0.99 };
+    uint64_t *results[3] = { &summary.p50, &summary.p90, &summary.p99 };
+    uint64_t seen = 0;
+    size_t q = 0;
+    for (size_t i = 0; i < TRACE_BUCKETS && q < 3; i++) {
+        seen += counts[i];
+        while (q < 3 && (double)seen >= quantiles[q] * (double)count) {
+            uint64_t upper = bucket_upper(i);
+            *results[q++] = (upper < summary.max) ? upper : summary.max;
+        }
+    }
+    return summary;
+}
+
+/**
+ * @brief 清除所有探針的統計
+ */
+void trace_reset(void) {
+    for (size_t p = 0; p < TRACE_PROBE_COUNT; p++) {
+        trace_stats_t *stats = &g_stats[p];
+        atomic_store_explicit(&stats->total, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->max, 0, memory_order_relaxed);
+        for (size_t i = 0; i < TRACE_BUCKETS; i++) {
+            atomic_store_explicit(&stats->buckets[i], 0, memory_order_relaxed);
+        }
+    }
+}
+
+/* ============================================================================
+ * Chrome trace 記錄實作
+ * ============================================================================ */
+
+/**
+ * @brief 開始記錄事件
+ */
+bool trace_capture_start(const char *path, size_t max_events) {
+    if (path == NULL || path[0] == '\0') {
+        error_set(ERR_INVALID_INPUT, "未指定追蹤輸出檔案");
+        return false;
+    }
+    if (atomic_load(&g_events) != NULL) {
+        error_set(ERR_INVALID_INPUT, "已在記錄追蹤事件");
+        return false;
+    }
+    
+    if (max_events == 0) {
+        max_events = TRACE_DEFAULT_EVENTS;
+    }
+    if (max_events > SIZE_MAX / sizeof(trace_event_t)) {
+        error_set(ERR_MEMORY, "追蹤事件數量過大: %zu", max_events);
+        return false;
+    }
+    
+    char *copy = safe_strdup(path);
+    trace_event_t *events = (trace_event_t *)safe_malloc_uninit(max_events * sizeof(trace_event_t));
+    if (copy == NULL || events == NULL) {
+        safe_free(copy);
+        safe_free(events);
+        return false;
+    }
+    
+    g_capture_path = copy;
+    g_event_capacity = max_events;
+    g_capture_start = trace_now();
+    atomic_store(&g_event_count, 0);
+    atomic_store_explicit(&g_events, events, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief 是否正在記錄事件
+ */
+bool trace_capturing(void) {
+    return atomic_load_explicit(&g_events, memory_order_relaxed) != NULL;
+}
+
+/**
+ * @brief 停止記錄並寫出 JSON 檔案
+ */
+bool trace_capture_finish(void) {
+    trace_event_t *events = atomic_exchange(&g_events, NULL);
+    if (events == NULL) {
+        return true;
+    }
+    
+    size_t count = atomic_load(&g_event_count);
+    if (count > g_event_capacity) {
+        count = g_event_capacity;
+    }
+    
+    bool ok = false;
+    FILE *file = fopen(g_capture_path, "w");
+    if (file == NULL) {
+        error_set(ERR_IO_ERROR, "無法建立追蹤輸出檔案: %s", g_capture_path);
+    } else {
+        /* 時間以微秒表示，相對於開始記錄的時間 */
+        fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        for (size_t i = 0; i < count; i++) {
+            const trace_event_t *event = &events[i];
+            uint64_t start = (event->start > g_capture_start) ? event->start - g_capture_start : 0;
+            fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"yun-fs\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                    "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}\n",
+                    (i > 0) ? "," : "", g_probe_names[event->probe], (unsigned)event->tid,
+                    (unsigned long long)(start / 1000), (unsigned long long)(start % 1000),
+                    (unsigned long long)(event->duration / 1000),
+                    (unsigned long long)(event->duration % 1000));
+        }
+        fprintf(file, "]}\n");
+        ok = (fclose(file) == 0);
+        if (!ok) {
+            error_set(ERR_IO_ERROR, "寫入追蹤輸出檔案失敗: %s", g_capture_path);
+        }
+    }
+    
+    safe_free(events);
+    safe_free(g_capture_path);
+    g_capture_path = NULL;
+    g_event_capacity = 0;
+    return ok;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file trace.h
+ * @brief 效能追蹤模組標頭檔
+ *
+ * 本模組量測主要進入點的耗時，提供：
+ * - 區塊計時：TRACE_SCOPE 在所在區塊結束時自動記錄耗時
+ * - 以單調時鐘量測的耗時分佈（對數分桶直方圖），可查詢百分位數
+ * - Chrome trace 記錄：將工作階段內的每個事件輸出為 chrome://tracing 可讀取的 JSON
+ *
+ * @note 設計考量：
+ *   - 探針為固定的列舉，統計存放於靜態陣列，記錄時只做 relaxed 原子累加，不需鎖
+ *   - 直方圖每個 2 的冪次區間再分 8 格，百分位數的相對誤差不超過 1/8
+ *   - 以 -DNO_TRACE 編譯（make TRACE=0）時 TRACE_SCOPE 展開為空，不留任何成本
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * 型別定義
+ * ============================================================================ */
+
+/**
+ * @brief 追蹤探針
+ */
+typedef enum {
+    TRACE_VFS_RESOLVE,           /**< 路徑解析 */
+    TRACE_VFS_READ,              /**< 讀取檔案內容 */
+    TRACE_VFS_WRITE,             /**< 寫入檔案內容 */
+    TRACE_VFS_CREATE,            /**< 建立檔案或目錄 */
+    TRACE_VFS_DELETE,            /**< 刪除節點 */
+    TRACE_PERSIST_SAVE,          /**< 序列化並儲存映像檔 */
+    TRACE_PERSIST_LOAD,          /**< 載入映像檔 */
+    TRACE_PERSIST_FETCH,         /**< 延遲載入時從映像檔讀取內容 */
+    TRACE_CHACHA20,              /**< ChaCha20 加解密 */
+    TRACE_SCREEN_REFRESH,        /**< 編輯器畫面重繪 */
+    TRACE_VIM_SEARCH,            /**< 編輯器搜尋 */
+    TRACE_VIM_UNDO,              /**< 編輯器撤銷與重做 */
+    TRACE_PROBE_COUNT            /**< 探針數量 */
+} trace_probe_t;
+
+/**
+ * @brief 進行中的計時區段
+ */
+typedef struct {
+    trace_probe_t probe;         /**< 探針 */
+    uint64_t start;              /**< 開始時間（奈秒） */
+} trace_span_t;
+
+/**
+ * @brief 一個探針的統計摘要（時間皆為奈秒）
+ */
+typedef struct {
+    uint64_t count;              /**< 記錄次數 */
+    uint64_t total;              /**< 總耗時 */
+    uint64_t max;                /**< 最大耗時 */
+    uint64_t p50;                /**< 中位數 */
+    uint64_t p90;                /**< 第 90 百分位數 */
+    uint64_t p99;                /**< 第 99 百分位數 */
+} trace_summary_t;
+
+/** Chrome trace 預設最多記錄的事件數 */
+#define TRACE_DEFAULT_EVENTS (1u << 20)
+
+/* ============================================================================
+ * 計時函式
+ * ============================================================================ */
+
+/**
+ * @brief 目前的單調時鐘時間（奈秒）
+ */
+uint64_t trace_now(void);
+
+/**
+ * @brief 開始一個計時區段
+ */
+trace_span_t trace_begin(trace_probe_t probe);
+
+/**
+ * @brief 結束計時區段並記錄耗時（TRACE_SCOPE 於區塊結束時呼叫）
+ */
+void trace_end(const trace_span_t *span);
+
+/**
+ * @brief 記錄一次已量測的耗時
+ *
+ * @param probe    探針
+ * @param start    開始時間（trace_now 的值）
+ * @param duration 耗時（奈秒）
+ */
+void trace_record(trace_probe_t probe, uint64_t start, uint64_t duration);
+
+/* ============================================================================
+ * 統計查詢
+ * ============================================================================ */
+
+/**
+ * @brief 探針的顯示名稱
+ */
+const char *trace_probe_name(trace_probe_t probe);
+
+/**
+ * @brief 取得探針的統計摘要
+ *
+ * 各欄位分別讀取，其他執行緒同時記錄時數值之間可能略有落差。
+ */
+trace_summary_t trace_summary(trace_probe_t probe);
+
+/**
+ * @brief 清除所有探針的統計（不影響 Chrome trace 記錄）
+ */
+void trace_reset(void);
+
+/* ============================================================================
+ * Chrome trace 記錄
+ * ============================================================================ */
+
+/**
+ * @brief 開始記錄事件
+ *
+ * @param path       結束時寫出的 JSON 檔案路徑
+ * @param max_events 最多記錄的事件數（0 表示 TRACE_DEFAULT_EVENTS），超過的事件只計入統計
+ * @return 成功回傳 true，失敗回傳 false 並設定錯誤訊息
+ */
+bool trace_capture_start(const char *path, size_t max_events);
+
+/**
+ * @brief 是否正在記錄事件
+ */
+bool trace_capturing(void);
+
+/**
+ * @brief 停止記錄並寫出 JSON 檔案
+ *
+ * 需在其他執行緒不再記錄事件時呼叫（通常於程式結束前）。
+ *
+ * @return 成功（或未在記錄）回傳 true，寫入失敗回傳 false 並設定錯誤訊息
+ */
+bool trace_capture_finish(void);
+
+/* ============================================================================
+ * 計時巨集
+ * ============================================================================ */
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/**
+ * @brief 量測所在區塊的耗時（宣告一個區塊結束時自動呼叫 trace_end 的區段）
+ */
+#if defined(NO_TRACE) || !defined(__GNUC__)
+#define TRACE_SCOPE(probe) ((void)0)
+#else
+#define TRACE_SCOPE(probe) \
+    trace_span_t TRACE_CONCAT(trace_span_, __LINE__) __attribute__((cleanup(trace_end))) = trace_begin(probe)
+#endif
+
+#endif // TRACE_H
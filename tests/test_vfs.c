@@ -0,0 +1,154 @@
+/**
+ * @file test_vfs.c
+ * @brief VFS 節點操作測試
+ *
+ * 每個測試建立獨立的 VFS，檢查失敗的操作不會改變樹的結構。
+ *
+ * @author Yun
+ * @date 2025
+ */
+
+#include "vfs.h"
+#include "vfs_persist.h"
+#include "memory.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/** 測試用映像檔（測試結束時刪除） */
+#define TEST_IMAGE "test_vfs.img"
+#define TEST_KEY "test-key"
+
+/** 失敗的檢查數 */
+static int g_failures = 0;
+
+/**
+ * @brief 檢查條件，失敗時印出位置並計數
+ */
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: 檢查失敗: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+/**
+ * @brief 建立測試用 VFS：/a/b/c 目錄與 /a/f、/x/f 檔案
+ */
+static vfs_t *make_tree(void) {
+    vfs_t *vfs = vfs_init();
+    if (vfs == NULL) {
+        fprintf(stderr, "vfs_init 失敗\n");
+        exit(1);
+    }
+    if (vfs_create_dir(vfs, "/a") == NULL ||
+        vfs_create_dir(vfs, "/a/b") == NULL ||
+        vfs_create_dir(vfs, "/a/b/c") == NULL ||
+        vfs_create_dir(vfs, "/x") == NULL ||
+        vfs_create_file(vfs, "/a/f", "abc", 3) == NULL ||
+        vfs_create_file(vfs, "/x/f", "xyz", 3) == NULL) {
+        fprintf(stderr, "建立測試樹失敗\n");
+        exit(1);
+    }
+    return vfs;
+}
+
+/**
+ * @brief 移到自身或子孫目錄下應被拒絕，且不建立任何目錄
+ */
+static void test_move_into_descendant(void) {
+    vfs_t *vfs = make_tree();
+    size_t nodes = vfs->total_nodes;
+    vfs_node_t *a = vfs_find_node(vfs, "/a");
+    
+    CHECK(!vfs_move_node(vfs, "/a", "/a/b/c"));
+    CHECK(error_get().code == ERR_INVALID_INPUT);
+    CHECK(!vfs_move_node(vfs, "/a", "/a/b"));
+    CHECK(!vfs_move_node(vfs, "/a", "/a/new/dir"));
+    CHECK(!vfs_move_node(vfs, "/a/b", "/a/b/c/d"));
+    
+    CHECK(vfs_find_node(vfs, "/a") == a);
+    CHECK(a->parent == vfs->root);
+    CHECK(vfs_find_node(vfs, "/a/b/c") != NULL);
+    CHECK(vfs_find_node(vfs, "/a/new") == NULL);
+    CHECK(vfs->total_nodes == nodes);
+    
+    /* 移到兄弟目錄仍可進行 */
+    CHECK(vfs_move_node(vfs, "/a/b/c", "/a/c"));
+    CHECK(vfs_find_node(vfs, "/a/c") != NULL);
+    CHECK(vfs->total_nodes == nodes);
+    
+    vfs_destroy(vfs);
+}
+
+/**
+ * @brief 目標已有同名節點時，來源節點應以原名稱留在原目錄
+ */
+static void test_move_collision_restores(void) {
+    vfs_t *vfs = make_tree();
+    size_t nodes = vfs->total_nodes;
+    size_t bytes = vfs->total_size;
+    vfs_node_t *f = vfs_find_node(vfs, "/a/f");
+    vfs_node_t *a = vfs_find_node(vfs, "/a");
+    size_t a_children = a->size;
+    
+    CHECK(!vfs_move_node(vfs, "/a/f", "/x/f"));
+    CHECK(vfs_find_node(vfs, "/a/f") == f);
+    CHECK(f->parent == a);
+    CHECK(a->size == a_children);
+    CHECK(vfs_find_node(vfs, "/x/f") != f);
+    CHECK(vfs->total_nodes == nodes);
+    CHECK(vfs->total_size == bytes);
+    
+    /* 目錄移到已存在的同名目錄上也應放回原處 */
+    CHECK(vfs_create_dir(vfs, "/x/b") != NULL);
+    nodes = vfs->total_nodes;
+    CHECK(!vfs_move_node(vfs, "/a/b", "/x/b"));
+    CHECK(vfs_find_node(vfs, "/a/b/c") != NULL);
+    CHECK(vfs->total_nodes == nodes);
+    
+    vfs_destroy(vfs);
+}
+
+/**
+ * @brief 載入後的大型目錄應已建立雜湊索引，查詢時不再修改目錄
+ */
+static void test_load_indexes_large_dirs(void) {
+    vfs_t *vfs = make_tree();
+    char path[64];
+    for (int i = 0; i < VFS_CHILD_INDEX_THRESHOLD * 2; i++) {
+        snprintf(path, sizeof(path), "/x/file%d", i);
+        CHECK(vfs_create_file(vfs, path, NULL, 0) != NULL);
+    }
+    CHECK(vfs_save_encrypted(vfs, TEST_IMAGE, TEST_KEY));
+    vfs_destroy(vfs);
+    
+    vfs = vfs_load_encrypted(TEST_IMAGE, TEST_KEY);
+    remove(TEST_IMAGE);
+    CHECK(vfs != NULL);
+    if (vfs == NULL) {
+        return;
+    }
+    
+    vfs_node_t *x = vfs_find_node(vfs, "/x");
+    CHECK(x != NULL && x->child_index != NULL);
+    CHECK(vfs_find_node(vfs, "/a")->child_index == NULL);
+    snprintf(path, sizeof(path), "/x/file%d", VFS_CHILD_INDEX_THRESHOLD);
+    CHECK(vfs_find_node(vfs, path) != NULL);
+    CHECK(vfs_find_node(vfs, "/x/missing") == NULL);
+    
+    vfs_destroy(vfs);
+}
+
+int main(void) {
+    test_move_into_descendant();
+    test_move_collision_restores();
+    test_load_indexes_large_dirs();
+    
+    if (g_failures != 0) {
+        fprintf(stderr, "test_vfs: %d 項檢查失敗\n", g_failures);
+        return 1;
+    }
+    printf("test_vfs: 全部通過\n");
+    return 0;
+}